@@ -25,6 +25,20 @@
 
 #import <Foundation/Foundation.h>
 
+// Length prefixes of the length-delimited sections, the length counts the bytes after the prefix
+typedef enum _PSYLengthPrefix
+{
+    PSYLengthPrefixInt8,
+    PSYLengthPrefixLittleEndianInt16,
+    PSYLengthPrefixLittleEndianInt32,
+    PSYLengthPrefixLittleEndianInt64,
+    PSYLengthPrefixBigEndianInt16,
+    PSYLengthPrefixBigEndianInt32,
+    PSYLengthPrefixBigEndianInt64,
+    PSYLengthPrefixVarint,       // the shortest varint of the length
+    PSYLengthPrefixPaddedVarint, // a varint padded to 5 bytes, the longest 32-bit varint
+} PSYLengthPrefix;
+
 @interface NSMutableData (PSYDataWriter)
 
 - (void)appendInt8:(uint8_t)value;
@@ -73,6 +87,33 @@
 - (void)appendSwappedFloat:(float)value;
 - (void)appendSwappedDouble:(double)value;
 
+// Append count consecutive values, the data grows once for all of them
+- (void)appendInt8Array:(const uint8_t *)values count:(NSUInteger)count;
+
+- (void)appendLittleEndianInt16Array:(const uint16_t *)values count:(NSUInteger)count;
+- (void)appendLittleEndianInt32Array:(const uint32_t *)values count:(NSUInteger)count;
+- (void)appendLittleEndianInt64Array:(const uint64_t *)values count:(NSUInteger)count;
+
+- (void)appendBigEndianInt16Array:(const uint16_t *)values count:(NSUInteger)count;
+- (void)appendBigEndianInt32Array:(const uint32_t *)values count:(NSUInteger)count;
+- (void)appendBigEndianInt64Array:(const uint64_t *)values count:(NSUInteger)count;
+
+- (void)appendSInt8Array:(const int8_t *)values count:(NSUInteger)count;
+
+- (void)appendLittleEndianSInt16Array:(const int16_t *)values count:(NSUInteger)count;
+- (void)appendLittleEndianSInt32Array:(const int32_t *)values count:(NSUInteger)count;
+- (void)appendLittleEndianSInt64Array:(const int64_t *)values count:(NSUInteger)count;
+
+- (void)appendBigEndianSInt16Array:(const int16_t *)values count:(NSUInteger)count;
+- (void)appendBigEndianSInt32Array:(const int32_t *)values count:(NSUInteger)count;
+- (void)appendBigEndianSInt64Array:(const int64_t *)values count:(NSUInteger)count;
+
+- (void)appendFloatArray:(const float *)values count:(NSUInteger)count;
+- (void)appendDoubleArray:(const double *)values count:(NSUInteger)count;
+
+- (void)appendSwappedFloatArray:(const float *)values count:(NSUInteger)count;
+- (void)appendSwappedDoubleArray:(const double *)values count:(NSUInteger)count;
+
 - (void)appendString:(NSString *)value usingEncoding:(NSStringEncoding)encoding;
 - (void)appendNullTerminatedString:(NSString *)value usingEncoding:(NSStringEncoding)encoding;
 
@@ -109,4 +150,13 @@
 - (void)replaceBytesInRange:(NSRange)range withString:(NSString *)value usingEncoding:(NSStringEncoding)encoding;
 - (void)replaceBytesInRange:(NSRange)range withNullTerminatedString:(NSString *)value usingEncoding:(NSStringEncoding)encoding;
 
+// The body of a length-delimited section is appended in place after room reserved for its prefix,
+// the length is written over that room by -endSection, sections can be nested
+// Varint prefixes reserve 5 bytes, the bytes a shorter varint didn't need are
+// removed in a single pass once the outermost section ends, the offsets in the data aren't final until then
+// Padded varints keep all their bytes, nothing has to move
+// -endSection raises an NSRangeException when the length doesn't fit the prefix
+- (void)beginLengthDelimitedSectionWithPrefix:(PSYLengthPrefix)prefix;
+- (void)endSection;
+
 @end
@@ -26,6 +26,85 @@
 #import "NSMutableData+PSYDataWriter.h"
 #import "PSYDataScanner.h"
 #import "PSYUtilities.h"
+#import "PSYByteSwap.h"
+#import "PSYVarint.h"
+
+#import <objc/runtime.h>
+#include <stdlib.h>
+
+typedef struct _PSYDataWriterSection
+{
+    PSYLengthPrefix prefix;
+    NSUInteger      location;  // where the prefix is reserved
+    NSUInteger      gapLength; // length of the gaps left by the inner sections that ended before this one began
+} PSYDataWriterSection;
+
+// Bytes reserved for a varint that it didn't need
+typedef struct _PSYDataWriterGap { NSUInteger location, length; } PSYDataWriterGap;
+
+// Open sections of a data, associated with it until its outermost section ends
+@interface PSYDataWriterSections : NSObject
+{
+@public
+    PSYDataWriterSection *sections;
+    NSUInteger            sectionCount;
+    NSUInteger            sectionCapacity;
+    PSYDataWriterGap     *gaps;
+    NSUInteger            gapCount;
+    NSUInteger            gapCapacity;
+    NSUInteger            gapLength;
+}
+@end
+
+static char PSYDataWriterSectionsKey;
+
+static void *PSYGrowArray(void *array, NSUInteger *capacity, size_t elementSize)
+{
+    NSUInteger newCapacity = *capacity == 0 ? 8 : *capacity * 2;
+    void      *newArray    = realloc(array, newCapacity * elementSize);
+    
+    if(newArray == NULL) [NSException raise:NSMallocException format:@"*** -[NSMutableData beginLengthDelimitedSectionWithPrefix:]: unable to allocate the sections"];
+    
+    *capacity = newCapacity;
+    return newArray;
+}
+
+static NSUInteger PSYLengthPrefixWidth(PSYLengthPrefix prefix)
+{
+    switch(prefix)
+    {
+        case PSYLengthPrefixInt8              : return sizeof(uint8_t);
+        case PSYLengthPrefixLittleEndianInt16 :
+        case PSYLengthPrefixBigEndianInt16    : return sizeof(uint16_t);
+        case PSYLengthPrefixLittleEndianInt32 :
+        case PSYLengthPrefixBigEndianInt32    : return sizeof(uint32_t);
+        case PSYLengthPrefixLittleEndianInt64 :
+        case PSYLengthPrefixBigEndianInt64    : return sizeof(uint64_t);
+        case PSYLengthPrefixVarint            :
+        case PSYLengthPrefixPaddedVarint      : return PSYVarint32MaximumLength;
+    }
+    
+    return 0;
+}
+
+static unsigned long long PSYLengthPrefixMaximum(PSYLengthPrefix prefix)
+{
+    switch(PSYLengthPrefixWidth(prefix))
+    {
+        case sizeof(uint8_t)  : return UINT8_MAX;
+        case sizeof(uint16_t) : return UINT16_MAX;
+        case sizeof(uint64_t) : return UINT64_MAX;
+        default               : return UINT32_MAX;
+    }
+}
+
+static int PSYCompareGaps(const void *a, const void *b)
+{
+    NSUInteger locationA = ((const PSYDataWriterGap *)a)->location;
+    NSUInteger locationB = ((const PSYDataWriterGap *)b)->location;
+    
+    return locationA < locationB ? -1 : locationA > locationB;
+}
 
 @implementation NSMutableData (PSYDataWriter)
 
@@ -70,19 +149,12 @@ APPEND_METHOD(Big, 64)
 
 #undef APPEND_METHOD
 
-#define APPEND_VARINT_METHOD(endian, size)                                                 \
-- (void)append ## endian ## EndianVarint ## size:(uint ## size ## _t)value                 \
-{                                                                                          \
-    uint8_t buff[10];                                                                      \
-    uint8_t idx = 0;                                                                       \
-    value = CFSwapInt ## size ## HostTo ## endian(value);                                  \
-    while(value != 0x0)                                                                    \
-    {                                                                                      \
-        buff[idx] = value & 0xffffffffffffff80 ? (0x80 | (value & 0x7f)) : (uint8_t)value; \
-        value = value >> 7;                                                                \
-        idx++;                                                                             \
-    }                                                                                      \
-    [self appendBytes:buff length:idx];                                                    \
+#define APPEND_VARINT_METHOD(endian, size)                                           \
+- (void)append ## endian ## EndianVarint ## size:(uint ## size ## _t)value           \
+{                                                                                    \
+    uint8_t buff[PSYVarint64MaximumLength];                                          \
+    value = CFSwapInt ## size ## HostTo ## endian(value);                            \
+    [self appendBytes:buff length:PSYEncodeVarint ## size(buff, value)];             \
 }
 
 APPEND_VARINT_METHOD(Little, 32)
@@ -105,11 +177,10 @@ APPEND_VARINT_METHOD(Big, 64)
 
 #undef APPEND_VARINT_METHOD
 
-#define APPEND_VARINT_METHOD(endian, size)                                       \
-- (void)append ## endian ## EndianZigZagVarint ## size:(int ## size ## _t)value  \
-{                                                                                \
-    value = (value << 1) ^ (value >> (size - 1));                                 \
-    [self append ##endian ##EndianVarint ## size:*(uint ## size ## _t *)&value]; \
+#define APPEND_VARINT_METHOD(endian, size)                                        \
+- (void)append ## endian ## EndianZigZagVarint ## size:(int ## size ## _t)value   \
+{                                                                                 \
+    [self append ##endian ##EndianVarint ## size:PSYZigZagEncode ## size(value)]; \
 }
 
 APPEND_VARINT_METHOD(Little, 32)
@@ -141,6 +212,59 @@ APPEND_VARINT_METHOD(Big, 64)
     [self appendBytes:&v length:sizeof(value)];
 }
 
+- (void)PSY_appendArray:(const void *)values count:(NSUInteger)count width:(NSUInteger)width swap:(BOOL)swap;
+{
+    if(count == 0) return;
+    if(count > NSUIntegerMax / width) [NSException raise:NSInvalidArgumentException format:@"*** -[NSMutableData(PSYDataWriter) %@]: count too large", NSStringFromSelector(_cmd)];
+    
+    NSUInteger length = count * width;
+    
+    if(!swap)
+    {
+        [self appendBytes:values length:length];
+        return;
+    }
+    
+    NSUInteger offset = [self length];
+    [self increaseLengthBy:length];
+    
+    PSYCopyElements((uint8_t *)[self mutableBytes] + offset, values, count, width, YES);
+}
+
+#define APPEND_ARRAY_METHOD(name, type, swap)                                               \
+- (void)append ## name ## Array:(const type *)values count:(NSUInteger)count                \
+{                                                                                           \
+    [self PSY_appendArray:values count:count width:sizeof(type) swap:swap];                 \
+}
+
+APPEND_ARRAY_METHOD(Int8, uint8_t, NO)
+
+APPEND_ARRAY_METHOD(LittleEndianInt16, uint16_t, PSY_SWAP_LITTLE_ENDIAN)
+APPEND_ARRAY_METHOD(LittleEndianInt32, uint32_t, PSY_SWAP_LITTLE_ENDIAN)
+APPEND_ARRAY_METHOD(LittleEndianInt64, uint64_t, PSY_SWAP_LITTLE_ENDIAN)
+
+APPEND_ARRAY_METHOD(BigEndianInt16, uint16_t, PSY_SWAP_BIG_ENDIAN)
+APPEND_ARRAY_METHOD(BigEndianInt32, uint32_t, PSY_SWAP_BIG_ENDIAN)
+APPEND_ARRAY_METHOD(BigEndianInt64, uint64_t, PSY_SWAP_BIG_ENDIAN)
+
+APPEND_ARRAY_METHOD(SInt8, int8_t, NO)
+
+APPEND_ARRAY_METHOD(LittleEndianSInt16, int16_t, PSY_SWAP_LITTLE_ENDIAN)
+APPEND_ARRAY_METHOD(LittleEndianSInt32, int32_t, PSY_SWAP_LITTLE_ENDIAN)
+APPEND_ARRAY_METHOD(LittleEndianSInt64, int64_t, PSY_SWAP_LITTLE_ENDIAN)
+
+APPEND_ARRAY_METHOD(BigEndianSInt16, int16_t, PSY_SWAP_BIG_ENDIAN)
+APPEND_ARRAY_METHOD(BigEndianSInt32, int32_t, PSY_SWAP_BIG_ENDIAN)
+APPEND_ARRAY_METHOD(BigEndianSInt64, int64_t, PSY_SWAP_BIG_ENDIAN)
+
+APPEND_ARRAY_METHOD(Float, float, NO)
+APPEND_ARRAY_METHOD(Double, double, NO)
+
+APPEND_ARRAY_METHOD(SwappedFloat, float, PSY_SWAP_BIG_ENDIAN)
+APPEND_ARRAY_METHOD(SwappedDouble, double, PSY_SWAP_BIG_ENDIAN)
+
+#undef APPEND_ARRAY_METHOD
+
 - (void)appendString:(NSString *)value usingEncoding:(NSStringEncoding)encoding;
 {
     [self appendData:[value dataUsingEncoding:encoding]];
@@ -234,4 +358,115 @@ REPLACE_METHOD(Big, 64)
     RELEASE(data);
 }
 
+- (void)beginLengthDelimitedSectionWithPrefix:(PSYLengthPrefix)prefix;
+{
+    PSYDataWriterSections *state = objc_getAssociatedObject(self, &PSYDataWriterSectionsKey);
+    
+    if(state == nil)
+    {
+        state = AUTORELEASE([[PSYDataWriterSections alloc] init]);
+        objc_setAssociatedObject(self, &PSYDataWriterSectionsKey, state, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+    }
+    
+    if(state->sectionCount == state->sectionCapacity)
+        state->sections = PSYGrowArray(state->sections, &state->sectionCapacity, sizeof(PSYDataWriterSection));
+    
+    state->sections[state->sectionCount++] = (PSYDataWriterSection){ prefix, [self length], state->gapLength };
+    
+    [self increaseLengthBy:PSYLengthPrefixWidth(prefix)];
+}
+
+- (void)endSection;
+{
+    PSYDataWriterSections *state = objc_getAssociatedObject(self, &PSYDataWriterSectionsKey);
+    
+    if(state == nil || state->sectionCount == 0)
+        [NSException raise:NSInternalInconsistencyException format:@"*** -[NSMutableData %@]: no section was begun", NSStringFromSelector(_cmd)];
+    
+    PSYDataWriterSection section = state->sections[state->sectionCount - 1];
+    NSUInteger           width   = PSYLengthPrefixWidth(section.prefix);
+    NSRange              range   = NSMakeRange(section.location, width);
+    
+    // The bytes the varints of the inner sections didn't need are still in the data
+    unsigned long long length = [self length] - NSMaxRange(range) - (state->gapLength - section.gapLength);
+    
+    if(length > PSYLengthPrefixMaximum(section.prefix))
+        [NSException raise:NSRangeException format:@"*** -[NSMutableData %@]: the length %llu of the section doesn't fit its prefix", NSStringFromSelector(_cmd), length];
+    
+    state->sectionCount--;
+    
+    switch(section.prefix)
+    {
+        case PSYLengthPrefixInt8              : [self replaceBytesInRange:range withInt8:(uint8_t)length];                 break;
+        case PSYLengthPrefixLittleEndianInt16 : [self replaceBytesInRange:range withLittleEndianInt16:(uint16_t)length]; break;
+        case PSYLengthPrefixLittleEndianInt32 : [self replaceBytesInRange:range withLittleEndianInt32:(uint32_t)length]; break;
+        case PSYLengthPrefixLittleEndianInt64 : [self replaceBytesInRange:range withLittleEndianInt64:length];           break;
+        case PSYLengthPrefixBigEndianInt16    : [self replaceBytesInRange:range withBigEndianInt16:(uint16_t)length];    break;
+        case PSYLengthPrefixBigEndianInt32    : [self replaceBytesInRange:range withBigEndianInt32:(uint32_t)length];    break;
+        case PSYLengthPrefixBigEndianInt64    : [self replaceBytesInRange:range withBigEndianInt64:length];              break;
+        case PSYLengthPrefixPaddedVarint      :
+        {
+            uint8_t buff[PSYVarint32MaximumLength];
+            [self replaceBytesInRange:range withBytes:buff length:PSYEncodePaddedVarint32(buff, (uint32_t)length)];
+            break;
+        }
+        case PSYLengthPrefixVarint            :
+        {
+            uint8_t    buff[PSYVarint32MaximumLength];
+            NSUInteger used = PSYEncodeVarint32(buff, (uint32_t)length);
+            
+            [self replaceBytesInRange:NSMakeRange(section.location, used) withBytes:buff length:used];
+            
+            if(used < width)
+            {
+                if(state->gapCount == state->gapCapacity)
+                    state->gaps = PSYGrowArray(state->gaps, &state->gapCapacity, sizeof(PSYDataWriterGap));
+                
+                state->gaps[state->gapCount++] = (PSYDataWriterGap){ section.location + used, width - used };
+                state->gapLength += width - used;
+            }
+            break;
+        }
+    }
+    
+    if(state->sectionCount > 0) return;
+    
+    // The outermost section ended, the bytes between the gaps are moved once to close all of them
+    if(state->gapCount > 0)
+    {
+        qsort(state->gaps, state->gapCount, sizeof(PSYDataWriterGap), PSYCompareGaps);
+        
+        uint8_t    *bytes       = [self mutableBytes];
+        NSUInteger  dataLength  = [self length];
+        NSUInteger  destination = state->gaps[0].location;
+        
+        for(NSUInteger i = 0; i < state->gapCount; i++)
+        {
+            NSUInteger source = state->gaps[i].location + state->gaps[i].length;
+            NSUInteger next   = i + 1 < state->gapCount ? state->gaps[i + 1].location : dataLength;
+            
+            memmove(bytes + destination, bytes + source, next - source);
+            destination += next - source;
+        }
+        
+        [self setLength:destination];
+    }
+    
+    objc_setAssociatedObject(self, &PSYDataWriterSectionsKey, nil, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+}
+
+@end
+
+@implementation PSYDataWriterSections
+
+- (void)dealloc
+{
+    free(sections);
+    free(gaps);
+    
+#if !__has_feature(objc_arc)
+    [super dealloc];
+#endif
+}
+
 @end
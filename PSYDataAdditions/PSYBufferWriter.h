@@ -0,0 +1,189 @@
+/*
+ PSYBufferWriter.h
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+typedef enum _PSYBufferWriterOverflowPolicy
+{
+    // A value that doesn't fit is dropped, the writer is marked as overflowed
+    // and drops every following value until it's reset
+    PSYBufferWriterOverflowFail,
+    
+    // The writer moves to a larger buffer of the pool
+    PSYBufferWriterOverflowGrow
+} PSYBufferWriterOverflowPolicy;
+
+// Writes the encodings of NSMutableData+PSYDataWriter into a plain buffer, either memory
+// provided by the caller or a buffer taken from a pool kept by the current thread
+// Appending only checks the room left, -reset keeps the buffer so encoding one message
+// after the other with the same writer doesn't allocate anything once the buffer is large enough,
+// a writer that is deallocated gives its buffer back to the pool of the thread that releases it
+@interface PSYBufferWriter : NSObject
+
++ (id)writer;
++ (id)writerWithCapacity:(NSUInteger)capacity;
++ (id)writerWithBytesNoCopy:(void *)bytes capacity:(NSUInteger)capacity;
+
+// The buffer comes from the pool, the writer grows by default
+- (id)initWithCapacity:(NSUInteger)capacity;
+
+// The writer fails by default, if it is made to grow the bytes are copied into a buffer of the pool
+- (id)initWithBytesNoCopy:(void *)bytes capacity:(NSUInteger)capacity;
+
+// Frees the buffers kept by the pool of the current thread
++ (void)emptyBufferPool;
+
+@property(nonatomic)                                 PSYBufferWriterOverflowPolicy  overflowPolicy;
+@property(readonly, nonatomic)                       const void                    *bytes;
+@property(readonly, nonatomic)                       void                          *mutableBytes;
+@property(readonly, nonatomic)                       NSUInteger                     length;
+@property(readonly, nonatomic)                       NSUInteger                     capacity;
+@property(readonly, nonatomic, getter=hasOverflowed) BOOL                           overflowed;
+
+// Makes room for length more bytes, returns NO if they don't fit in a writer that fails
+- (BOOL)reserveCapacity:(NSUInteger)length;
+
+// Empties the writer and clears its overflow, the buffer is kept
+- (void)reset;
+
+// Returns a copy of the bytes written
+- (NSData *)data;
+
+- (void)appendBytes:(const void *)bytes length:(NSUInteger)length;
+- (void)appendData:(NSData *)value;
+
+- (void)appendInt8:(uint8_t)value;
+
+- (void)appendLittleEndianInt16:(uint16_t)value;
+- (void)appendLittleEndianInt32:(uint32_t)value;
+- (void)appendLittleEndianInt64:(uint64_t)value;
+
+- (void)appendBigEndianInt16:(uint16_t)value;
+- (void)appendBigEndianInt32:(uint32_t)value;
+- (void)appendBigEndianInt64:(uint64_t)value;
+
+- (void)appendSInt8:(int8_t)value;
+
+- (void)appendLittleEndianSInt16:(int16_t)value;
+- (void)appendLittleEndianSInt32:(int32_t)value;
+- (void)appendLittleEndianSInt64:(int64_t)value;
+
+- (void)appendBigEndianSInt16:(int16_t)value;
+- (void)appendBigEndianSInt32:(int32_t)value;
+- (void)appendBigEndianSInt64:(int64_t)value;
+
+- (void)appendLittleEndianVarint32:(uint32_t)value;
+- (void)appendLittleEndianVarint64:(uint64_t)value;
+
+- (void)appendBigEndianVarint32:(uint32_t)value;
+- (void)appendBigEndianVarint64:(uint64_t)value;
+
+- (void)appendLittleEndianSVarint32:(int32_t)value;
+- (void)appendLittleEndianSVarint64:(int64_t)value;
+
+- (void)appendBigEndianSVarint32:(int32_t)value;
+- (void)appendBigEndianSVarint64:(int64_t)value;
+
+- (void)appendLittleEndianZigZagVarint32:(int32_t)value;
+- (void)appendLittleEndianZigZagVarint64:(int64_t)value;
+
+- (void)appendBigEndianZigZagVarint32:(int32_t)value;
+- (void)appendBigEndianZigZagVarint64:(int64_t)value;
+
+// These methods append floating point values depending on the architecture of your processor
+// they're usually not appropriate for network transmission
+- (void)appendFloat:(float)value;
+- (void)appendDouble:(double)value;
+
+- (void)appendSwappedFloat:(float)value;
+- (void)appendSwappedDouble:(double)value;
+
+- (void)appendInt8Array:(const uint8_t *)values count:(NSUInteger)count;
+
+- (void)appendLittleEndianInt16Array:(const uint16_t *)values count:(NSUInteger)count;
+- (void)appendLittleEndianInt32Array:(const uint32_t *)values count:(NSUInteger)count;
+- (void)appendLittleEndianInt64Array:(const uint64_t *)values count:(NSUInteger)count;
+
+- (void)appendBigEndianInt16Array:(const uint16_t *)values count:(NSUInteger)count;
+- (void)appendBigEndianInt32Array:(const uint32_t *)values count:(NSUInteger)count;
+- (void)appendBigEndianInt64Array:(const uint64_t *)values count:(NSUInteger)count;
+
+- (void)appendSInt8Array:(const int8_t *)values count:(NSUInteger)count;
+
+- (void)appendLittleEndianSInt16Array:(const int16_t *)values count:(NSUInteger)count;
+- (void)appendLittleEndianSInt32Array:(const int32_t *)values count:(NSUInteger)count;
+- (void)appendLittleEndianSInt64Array:(const int64_t *)values count:(NSUInteger)count;
+
+- (void)appendBigEndianSInt16Array:(const int16_t *)values count:(NSUInteger)count;
+- (void)appendBigEndianSInt32Array:(const int32_t *)values count:(NSUInteger)count;
+- (void)appendBigEndianSInt64Array:(const int64_t *)values count:(NSUInteger)count;
+
+- (void)appendFloatArray:(const float *)values count:(NSUInteger)count;
+- (void)appendDoubleArray:(const double *)values count:(NSUInteger)count;
+
+- (void)appendSwappedFloatArray:(const float *)values count:(NSUInteger)count;
+- (void)appendSwappedDoubleArray:(const double *)values count:(NSUInteger)count;
+
+// The string is converted straight into the buffer
+- (void)appendString:(NSString *)value usingEncoding:(NSStringEncoding)encoding;
+- (void)appendNullTerminatedString:(NSString *)value usingEncoding:(NSStringEncoding)encoding;
+
+// Like -[NSMutableData replaceBytesInRange:withBytes:length:], the bytes after the range are moved
+// if the length differs, range must be within the bytes written
+- (void)replaceBytesInRange:(NSRange)range withBytes:(const void *)bytes length:(NSUInteger)length;
+- (void)replaceBytesInRange:(NSRange)range withData:(NSData *)value;
+
+- (void)replaceBytesInRange:(NSRange)range withInt8:(uint8_t)value;
+
+- (void)replaceBytesInRange:(NSRange)range withLittleEndianInt16:(uint16_t)value;
+- (void)replaceBytesInRange:(NSRange)range withLittleEndianInt32:(uint32_t)value;
+- (void)replaceBytesInRange:(NSRange)range withLittleEndianInt64:(uint64_t)value;
+
+- (void)replaceBytesInRange:(NSRange)range withBigEndianInt16:(uint16_t)value;
+- (void)replaceBytesInRange:(NSRange)range withBigEndianInt32:(uint32_t)value;
+- (void)replaceBytesInRange:(NSRange)range withBigEndianInt64:(uint64_t)value;
+
+- (void)replaceBytesInRange:(NSRange)range withSInt8:(int8_t)value;
+
+- (void)replaceBytesInRange:(NSRange)range withLittleEndianSInt16:(int16_t)value;
+- (void)replaceBytesInRange:(NSRange)range withLittleEndianSInt32:(int32_t)value;
+- (void)replaceBytesInRange:(NSRange)range withLittleEndianSInt64:(int64_t)value;
+
+- (void)replaceBytesInRange:(NSRange)range withBigEndianSInt16:(int16_t)value;
+- (void)replaceBytesInRange:(NSRange)range withBigEndianSInt32:(int32_t)value;
+- (void)replaceBytesInRange:(NSRange)range withBigEndianSInt64:(int64_t)value;
+
+// These methods append floating point values depending on the architecture of your processor
+// they're usually not appropriate for network transmission
+- (void)replaceBytesInRange:(NSRange)range withFloat:(float)value;
+- (void)replaceBytesInRange:(NSRange)range withDouble:(double)value;
+
+- (void)replaceBytesInRange:(NSRange)range withSwappedFloat:(float)value;
+- (void)replaceBytesInRange:(NSRange)range withSwappedDouble:(double)value;
+
+- (void)replaceBytesInRange:(NSRange)range withString:(NSString *)value usingEncoding:(NSStringEncoding)encoding;
+- (void)replaceBytesInRange:(NSRange)range withNullTerminatedString:(NSString *)value usingEncoding:(NSStringEncoding)encoding;
+
+@end
@@ -0,0 +1,592 @@
+/*
+ PSYBufferWriter.m
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import "PSYBufferWriter.h"
+#import "PSYDataScanner.h"
+#import "PSYUtilities.h"
+#import "PSYByteSwap.h"
+#import "PSYVarint.h"
+
+// The pool keeps buffers of powers of 2 from 256 bytes to 1MB, larger buffers are freed
+#define POOL_MIN_SHIFT       8
+#define POOL_MAX_SHIFT       20
+#define POOL_CLASS_COUNT     (POOL_MAX_SHIFT - POOL_MIN_SHIFT + 1)
+#define POOL_BUFFERS_PER_CLASS 8
+
+#define DEFAULT_CAPACITY     256
+
+static NSString *const PSYBufferPoolThreadKey = @"PSYBufferPool";
+
+@interface PSYBufferPool : NSObject
+{
+@public
+    void       *buffers[POOL_CLASS_COUNT][POOL_BUFFERS_PER_CLASS];
+    NSUInteger  counts[POOL_CLASS_COUNT];
+}
+- (void)empty;
+@end
+
+static PSYBufferPool *PSYCurrentBufferPool(void)
+{
+    NSMutableDictionary *threadDictionary = [[NSThread currentThread] threadDictionary];
+    PSYBufferPool       *pool             = [threadDictionary objectForKey:PSYBufferPoolThreadKey];
+    
+    if(pool == nil)
+    {
+        pool = [[PSYBufferPool alloc] init];
+        [threadDictionary setObject:pool forKey:PSYBufferPoolThreadKey];
+        RELEASE(pool);
+        pool = [threadDictionary objectForKey:PSYBufferPoolThreadKey];
+    }
+    
+    return pool;
+}
+
+// Size class of a buffer of at least capacity bytes, POOL_CLASS_COUNT for buffers too large to be kept
+static NSUInteger PSYBufferPoolClass(NSUInteger capacity)
+{
+    NSUInteger shift = POOL_MIN_SHIFT;
+    while(shift <= POOL_MAX_SHIFT && (1UL << shift) < capacity) shift++;
+    
+    return shift - POOL_MIN_SHIFT;
+}
+
+// Returns a buffer of at least capacity bytes and sets *actualCapacity to its size
+static uint8_t *PSYBufferPoolTake(NSUInteger capacity, NSUInteger *actualCapacity)
+{
+    NSUInteger sizeClass = PSYBufferPoolClass(capacity);
+    uint8_t   *buffer    = NULL;
+    
+    if(sizeClass < POOL_CLASS_COUNT)
+    {
+        PSYBufferPool *pool = PSYCurrentBufferPool();
+        
+        capacity = 1UL << (sizeClass + POOL_MIN_SHIFT);
+        if(pool->counts[sizeClass] > 0) buffer = pool->buffers[sizeClass][--pool->counts[sizeClass]];
+    }
+    
+    if(buffer == NULL) buffer = malloc(capacity);
+    if(buffer == NULL) [NSException raise:NSMallocException format:@"*** PSYBufferWriter: unable to allocate %lu bytes", (unsigned long)capacity];
+    
+    *actualCapacity = capacity;
+    return buffer;
+}
+
+static void PSYBufferPoolGive(uint8_t *buffer, NSUInteger capacity)
+{
+    NSUInteger sizeClass = PSYBufferPoolClass(capacity);
+    
+    if(sizeClass < POOL_CLASS_COUNT && capacity == 1UL << (sizeClass + POOL_MIN_SHIFT))
+    {
+        PSYBufferPool *pool = PSYCurrentBufferPool();
+        
+        if(pool->counts[sizeClass] < POOL_BUFFERS_PER_CLASS)
+        {
+            pool->buffers[sizeClass][pool->counts[sizeClass]++] = buffer;
+            return;
+        }
+    }
+    
+    free(buffer);
+}
+
+@implementation PSYBufferPool
+
+- (void)empty;
+{
+    for(NSUInteger i = 0; i < POOL_CLASS_COUNT; i++)
+    {
+        while(counts[i] > 0) free(buffers[i][--counts[i]]);
+    }
+}
+
+- (void)dealloc
+{
+    [self empty];
+    
+#if !__has_feature(objc_arc)
+    [super dealloc];
+#endif
+}
+
+@end
+
+@implementation PSYBufferWriter
+{
+    uint8_t                       *_bytes;
+    NSUInteger                     _length;
+    NSUInteger                     _capacity;
+    
+    // Bytes that can be written, the capacity or the length once the writer overflowed
+    NSUInteger                     _limit;
+    BOOL                           _overflowed;
+    
+    // NO while writing into the memory of the caller
+    BOOL                           _ownsBytes;
+    PSYBufferWriterOverflowPolicy  _overflowPolicy;
+}
+@synthesize overflowPolicy = _overflowPolicy, length = _length, capacity = _capacity;
+
++ (id)writer
+{
+    return AUTORELEASE([[self alloc] init]);
+}
+
++ (id)writerWithCapacity:(NSUInteger)capacity;
+{
+    return AUTORELEASE([[self alloc] initWithCapacity:capacity]);
+}
+
++ (id)writerWithBytesNoCopy:(void *)bytes capacity:(NSUInteger)capacity;
+{
+    return AUTORELEASE([[self alloc] initWithBytesNoCopy:bytes capacity:capacity]);
+}
+
++ (void)emptyBufferPool;
+{
+    [PSYCurrentBufferPool() empty];
+}
+
+- (id)init
+{
+    return [self initWithCapacity:DEFAULT_CAPACITY];
+}
+
+- (id)initWithCapacity:(NSUInteger)capacity;
+{
+    if((self = [super init]))
+    {
+        _bytes          = PSYBufferPoolTake(MAX(capacity, 1), &_capacity);
+        _limit          = _capacity;
+        _ownsBytes      = YES;
+        _overflowPolicy = PSYBufferWriterOverflowGrow;
+    }
+    return self;
+}
+
+- (id)initWithBytesNoCopy:(void *)bytes capacity:(NSUInteger)capacity;
+{
+    if((self = [super init]))
+    {
+        _bytes          = bytes;
+        _capacity       = capacity;
+        _limit          = capacity;
+        _overflowPolicy = PSYBufferWriterOverflowFail;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    if(_ownsBytes) PSYBufferPoolGive(_bytes, _capacity);
+    
+#if !__has_feature(objc_arc)
+    [super dealloc];
+#endif
+}
+
+- (const void *)bytes
+{
+    return _bytes;
+}
+
+- (void *)mutableBytes
+{
+    return _bytes;
+}
+
+- (BOOL)hasOverflowed
+{
+    return _overflowed;
+}
+
+- (void)reset;
+{
+    _length     = 0;
+    _limit      = _capacity;
+    _overflowed = NO;
+}
+
+- (NSData *)data;
+{
+    return [NSData dataWithBytes:_bytes length:_length];
+}
+
+// Nothing more can be written until the writer is reset
+static BOOL PSYBufferWriterOverflow(PSYBufferWriter *writer)
+{
+    writer->_overflowed = YES;
+    writer->_limit      = writer->_length;
+    return NO;
+}
+
+// Makes room for length more bytes in a writer that grows, or marks the writer as overflowed
+static BOOL PSYBufferWriterMakeRoom(PSYBufferWriter *writer, NSUInteger length)
+{
+    if(writer->_overflowed || writer->_overflowPolicy == PSYBufferWriterOverflowFail) return PSYBufferWriterOverflow(writer);
+    
+    if(length > NSUIntegerMax / 2 - writer->_length) [NSException raise:NSInvalidArgumentException format:@"*** -[PSYBufferWriter reserveCapacity:]: length too large"];
+    
+    NSUInteger  capacity = 0;
+    uint8_t    *bytes    = PSYBufferPoolTake(MAX(writer->_length + length, writer->_capacity * 2), &capacity);
+    
+    memcpy(bytes, writer->_bytes, writer->_length);
+    if(writer->_ownsBytes) PSYBufferPoolGive(writer->_bytes, writer->_capacity);
+    
+    writer->_bytes     = bytes;
+    writer->_capacity  = capacity;
+    writer->_limit     = capacity;
+    writer->_ownsBytes = YES;
+    
+    return YES;
+}
+
+// Returns where to write length bytes and moves the length after them, or NULL if they don't fit
+static inline uint8_t *PSYBufferWriterAdvance(PSYBufferWriter *writer, NSUInteger length)
+{
+    if(__builtin_expect(writer->_limit - writer->_length < length, 0) && !PSYBufferWriterMakeRoom(writer, length)) return NULL;
+    
+    uint8_t *bytes = writer->_bytes + writer->_length;
+    writer->_length += length;
+    
+    return bytes;
+}
+
+- (BOOL)reserveCapacity:(NSUInteger)length;
+{
+    return _limit - _length >= length || PSYBufferWriterMakeRoom(self, length);
+}
+
+- (void)appendBytes:(const void *)bytes length:(NSUInteger)length;
+{
+    uint8_t *target = PSYBufferWriterAdvance(self, length);
+    if(target != NULL && length > 0) memcpy(target, bytes, length);
+}
+
+- (void)appendData:(NSData *)value;
+{
+    [self appendBytes:[value bytes] length:[value length]];
+}
+
+#define APPEND_VALUE(self, value)                                                 \
+do {                                                                             \
+    uint8_t *target = PSYBufferWriterAdvance(self, sizeof(value));               \
+    if(target != NULL) memcpy(target, &value, sizeof(value));                    \
+} while(NO)
+
+- (void)appendInt8:(uint8_t)value;
+{
+    APPEND_VALUE(self, value);
+}
+
+#define APPEND_METHOD(endian, size)                                      \
+- (void)append ## endian ## EndianInt ## size:(uint ## size ## _t)value \
+{                                                                        \
+    value = CFSwapInt ## size ## HostTo ## endian(value);                \
+    APPEND_VALUE(self, value);                                           \
+}
+
+APPEND_METHOD(Little, 16)
+APPEND_METHOD(Little, 32)
+APPEND_METHOD(Little, 64)
+APPEND_METHOD(Big, 16)
+APPEND_METHOD(Big, 32)
+APPEND_METHOD(Big, 64)
+
+#undef APPEND_METHOD
+
+- (void)appendSInt8:(int8_t)value;
+{
+    [self appendInt8:*(uint8_t *)&value];
+}
+
+#define APPEND_METHOD(endian, size)                                             \
+- (void)append ## endian ## EndianSInt ## size:(int ## size ## _t)value         \
+{                                                                               \
+    [self append ## endian ## EndianInt ## size:*(uint ## size ## _t *)&value]; \
+}
+
+APPEND_METHOD(Little, 16)
+APPEND_METHOD(Little, 32)
+APPEND_METHOD(Little, 64)
+APPEND_METHOD(Big, 16)
+APPEND_METHOD(Big, 32)
+APPEND_METHOD(Big, 64)
+
+#undef APPEND_METHOD
+
+#define APPEND_VARINT_METHOD(endian, size)                                           \
+- (void)append ## endian ## EndianVarint ## size:(uint ## size ## _t)value           \
+{                                                                                    \
+    uint8_t buff[PSYVarint64MaximumLength];                                          \
+    value = CFSwapInt ## size ## HostTo ## endian(value);                            \
+    [self appendBytes:buff length:PSYEncodeVarint ## size(buff, value)];             \
+}
+
+APPEND_VARINT_METHOD(Little, 32)
+APPEND_VARINT_METHOD(Little, 64)
+APPEND_VARINT_METHOD(Big, 32)
+APPEND_VARINT_METHOD(Big, 64)
+
+#undef APPEND_VARINT_METHOD
+
+#define APPEND_VARINT_METHOD(endian, size)                                       \
+- (void)append ## endian ## EndianSVarint ## size:(int ## size ## _t)value       \
+{                                                                                \
+    [self append ##endian ##EndianVarint ## size:*(uint ## size ## _t *)&value]; \
+}
+
+APPEND_VARINT_METHOD(Little, 32)
+APPEND_VARINT_METHOD(Little, 64)
+APPEND_VARINT_METHOD(Big, 32)
+APPEND_VARINT_METHOD(Big, 64)
+
+#undef APPEND_VARINT_METHOD
+
+#define APPEND_VARINT_METHOD(endian, size)                                        \
+- (void)append ## endian ## EndianZigZagVarint ## size:(int ## size ## _t)value   \
+{                                                                                 \
+    [self append ##endian ##EndianVarint ## size:PSYZigZagEncode ## size(value)]; \
+}
+
+APPEND_VARINT_METHOD(Little, 32)
+APPEND_VARINT_METHOD(Little, 64)
+APPEND_VARINT_METHOD(Big, 32)
+APPEND_VARINT_METHOD(Big, 64)
+
+#undef APPEND_VARINT_METHOD
+
+- (void)appendFloat:(float)value;
+{
+    APPEND_VALUE(self, value);
+}
+
+- (void)appendDouble:(double)value;
+{
+    APPEND_VALUE(self, value);
+}
+
+- (void)appendSwappedFloat:(float)value;
+{
+    CFSwappedFloat32 v = CFConvertFloatHostToSwapped(value);
+    APPEND_VALUE(self, v);
+}
+
+- (void)appendSwappedDouble:(double)value;
+{
+    CFSwappedFloat64 v = CFConvertDoubleHostToSwapped(value);
+    APPEND_VALUE(self, v);
+}
+
+#undef APPEND_VALUE
+
+- (void)PSY_appendArray:(const void *)values count:(NSUInteger)count width:(NSUInteger)width swap:(BOOL)swap;
+{
+    if(count == 0) return;
+    if(count > NSUIntegerMax / width) [NSException raise:NSInvalidArgumentException format:@"*** -[PSYBufferWriter %@]: count too large", NSStringFromSelector(_cmd)];
+    
+    uint8_t *target = PSYBufferWriterAdvance(self, count * width);
+    if(target != NULL) PSYCopyElements(target, values, count, width, swap);
+}
+
+#define APPEND_ARRAY_METHOD(name, type, swap)                                               \
+- (void)append ## name ## Array:(const type *)values count:(NSUInteger)count                \
+{                                                                                           \
+    [self PSY_appendArray:values count:count width:sizeof(type) swap:swap];                 \
+}
+
+APPEND_ARRAY_METHOD(Int8, uint8_t, NO)
+
+APPEND_ARRAY_METHOD(LittleEndianInt16, uint16_t, PSY_SWAP_LITTLE_ENDIAN)
+APPEND_ARRAY_METHOD(LittleEndianInt32, uint32_t, PSY_SWAP_LITTLE_ENDIAN)
+APPEND_ARRAY_METHOD(LittleEndianInt64, uint64_t, PSY_SWAP_LITTLE_ENDIAN)
+
+APPEND_ARRAY_METHOD(BigEndianInt16, uint16_t, PSY_SWAP_BIG_ENDIAN)
+APPEND_ARRAY_METHOD(BigEndianInt32, uint32_t, PSY_SWAP_BIG_ENDIAN)
+APPEND_ARRAY_METHOD(BigEndianInt64, uint64_t, PSY_SWAP_BIG_ENDIAN)
+
+APPEND_ARRAY_METHOD(SInt8, int8_t, NO)
+
+APPEND_ARRAY_METHOD(LittleEndianSInt16, int16_t, PSY_SWAP_LITTLE_ENDIAN)
+APPEND_ARRAY_METHOD(LittleEndianSInt32, int32_t, PSY_SWAP_LITTLE_ENDIAN)
+APPEND_ARRAY_METHOD(LittleEndianSInt64, int64_t, PSY_SWAP_LITTLE_ENDIAN)
+
+APPEND_ARRAY_METHOD(BigEndianSInt16, int16_t, PSY_SWAP_BIG_ENDIAN)
+APPEND_ARRAY_METHOD(BigEndianSInt32, int32_t, PSY_SWAP_BIG_ENDIAN)
+APPEND_ARRAY_METHOD(BigEndianSInt64, int64_t, PSY_SWAP_BIG_ENDIAN)
+
+APPEND_ARRAY_METHOD(Float, float, NO)
+APPEND_ARRAY_METHOD(Double, double, NO)
+
+APPEND_ARRAY_METHOD(SwappedFloat, float, PSY_SWAP_BIG_ENDIAN)
+APPEND_ARRAY_METHOD(SwappedDouble, double, PSY_SWAP_BIG_ENDIAN)
+
+#undef APPEND_ARRAY_METHOD
+
+// Encodings whose -dataUsingEncoding: starts with a byte order mark go through a data
+static BOOL PSYEncodingHasByteOrderMark(NSStringEncoding encoding)
+{
+    return encoding == NSUnicodeStringEncoding || encoding == NSUTF32StringEncoding;
+}
+
+- (void)appendString:(NSString *)value usingEncoding:(NSStringEncoding)encoding;
+{
+    if(PSYEncodingHasByteOrderMark(encoding))
+    {
+        [self appendData:[value dataUsingEncoding:encoding]];
+        return;
+    }
+    
+    // A writer that fails converts into the room it has left, a string that doesn't fit overflows it
+    NSUInteger maximum   = [value maximumLengthOfBytesUsingEncoding:encoding];
+    NSUInteger used      = 0;
+    NSRange    remaining = NSMakeRange(0, 0);
+    
+    if(_limit - _length < maximum && _overflowPolicy == PSYBufferWriterOverflowGrow && ![self reserveCapacity:maximum]) return;
+    
+    [value getBytes:_bytes + _length maxLength:_limit - _length usedLength:&used encoding:encoding
+            options:0 range:NSMakeRange(0, [value length]) remainingRange:&remaining];
+    
+    // The conversion also stops at a character the encoding can't represent, nothing is appended then
+    // like with NSMutableData, the writer only overflows when the converted string needs more room
+    if(remaining.length > 0)
+    {
+        NSUInteger needed = [value lengthOfBytesUsingEncoding:encoding];
+        
+        if(needed > _limit - _length) PSYBufferWriterOverflow(self);
+        return;
+    }
+    
+    _length += used;
+}
+
+- (void)appendNullTerminatedString:(NSString *)value usingEncoding:(NSStringEncoding)encoding;
+{
+    NSUInteger width = (encoding == NSUTF8StringEncoding || encoding == NSASCIIStringEncoding ? 1 : [PSYNullTerminatorDataForEncoding(encoding) length]);
+    
+    [self appendString:value usingEncoding:encoding];
+    
+    uint8_t *target = PSYBufferWriterAdvance(self, width);
+    if(target != NULL) memset(target, 0, width);
+}
+
+- (void)replaceBytesInRange:(NSRange)range withBytes:(const void *)bytes length:(NSUInteger)length;
+{
+    if(range.location > _length || range.length > _length - range.location)
+        [NSException raise:NSRangeException format:@"*** -[PSYBufferWriter %@]: range %@ out of bounds", NSStringFromSelector(_cmd), NSStringFromRange(range)];
+    
+    if(length > range.length && ![self reserveCapacity:length - range.length]) return;
+    
+    NSUInteger tail = _length - NSMaxRange(range);
+    
+    if(length != range.length) memmove(_bytes + range.location + length, _bytes + NSMaxRange(range), tail);
+    if(length > 0) memcpy(_bytes + range.location, bytes, length);
+    
+    _length = range.location + length + tail;
+}
+
+- (void)replaceBytesInRange:(NSRange)range withData:(NSData *)value;
+{
+    [self replaceBytesInRange:range withBytes:[value bytes] length:[value length]];
+}
+
+- (void)replaceBytesInRange:(NSRange)range withInt8:(uint8_t)value;
+{
+    [self replaceBytesInRange:range withBytes:&value length:sizeof(value)];
+}
+
+#define REPLACE_METHOD(endian, size)                                      \
+- (void)replaceBytesInRange:(NSRange)range with ## endian ## EndianInt ## size:(uint ## size ## _t)value; \
+{                                                                           \
+    value = CFSwapInt ## size ## HostTo ## endian(value);                   \
+    [self replaceBytesInRange:range withBytes:&value length:sizeof(value)]; \
+}
+
+REPLACE_METHOD(Little, 16)
+REPLACE_METHOD(Little, 32)
+REPLACE_METHOD(Little, 64)
+REPLACE_METHOD(Big, 16)
+REPLACE_METHOD(Big, 32)
+REPLACE_METHOD(Big, 64)
+
+#undef REPLACE_METHOD
+
+- (void)replaceBytesInRange:(NSRange)range withSInt8:(int8_t)value;
+{
+    [self replaceBytesInRange:range withInt8:*(uint8_t *)&value];
+}
+
+#define REPLACE_METHOD(endian, size)                                      \
+- (void)replaceBytesInRange:(NSRange)range with ## endian ## EndianSInt ## size:(int ## size ## _t)value; \
+{                                                                           \
+    [self replaceBytesInRange:range with ## endian ## EndianInt ## size:*(uint ## size ## _t *)&value]; \
+}
+
+REPLACE_METHOD(Little, 16)
+REPLACE_METHOD(Little, 32)
+REPLACE_METHOD(Little, 64)
+REPLACE_METHOD(Big, 16)
+REPLACE_METHOD(Big, 32)
+REPLACE_METHOD(Big, 64)
+
+#undef REPLACE_METHOD
+
+- (void)replaceBytesInRange:(NSRange)range withFloat:(float)value;
+{
+    [self replaceBytesInRange:range withBytes:&value length:sizeof(value)];
+}
+
+- (void)replaceBytesInRange:(NSRange)range withDouble:(double)value;
+{
+    [self replaceBytesInRange:range withBytes:&value length:sizeof(value)];
+}
+
+- (void)replaceBytesInRange:(NSRange)range withSwappedFloat:(float)value;
+{
+    CFSwappedFloat32 v = CFConvertFloatHostToSwapped(value);
+    [self replaceBytesInRange:range withBytes:&v length:sizeof(value)];
+}
+
+- (void)replaceBytesInRange:(NSRange)range withSwappedDouble:(double)value;
+{
+    CFSwappedFloat64 v = CFConvertDoubleHostToSwapped(value);
+    [self replaceBytesInRange:range withBytes:&v length:sizeof(value)];
+}
+
+- (void)replaceBytesInRange:(NSRange)range withString:(NSString *)value usingEncoding:(NSStringEncoding)encoding;
+{
+    [self replaceBytesInRange:range withData:[value dataUsingEncoding:encoding]];
+}
+
+- (void)replaceBytesInRange:(NSRange)range withNullTerminatedString:(NSString *)value usingEncoding:(NSStringEncoding)encoding
+{
+    NSMutableData *data = [PSYNullTerminatorDataForEncoding(encoding) mutableCopy];
+    [data replaceBytesInRange:NSMakeRange(0, 0) withData:[value dataUsingEncoding:encoding]];
+    
+    [self replaceBytesInRange:range withData:data];
+    RELEASE(data);
+}
+
+@end
@@ -0,0 +1,43 @@
+/*
+ PSYByteSwap.h
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+#if defined(__BIG_ENDIAN__) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define PSY_HOST_IS_BIG_ENDIAN 1
+#else
+#define PSY_HOST_IS_BIG_ENDIAN 0
+#endif
+
+// Whether little endian, big endian and swapped (big endian floating point) values
+// have to be byte swapped to be converted from or to the host byte order
+#define PSY_SWAP_LITTLE_ENDIAN  PSY_HOST_IS_BIG_ENDIAN
+#define PSY_SWAP_BIG_ENDIAN     (!PSY_HOST_IS_BIG_ENDIAN)
+
+// Copies count elements of width bytes from source to destination, reversing the bytes
+// of each element when swap is YES, destination and source may be the same buffer
+// The byte reversal uses shuffles of 32 bytes with AVX2, 16 bytes with SSSE3 or NEON,
+// elements that are not byte swapped are copied with memmove
+void PSYCopyElements(void *destination, const void *source, NSUInteger count, NSUInteger width, BOOL swap);
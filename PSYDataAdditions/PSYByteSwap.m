@@ -0,0 +1,144 @@
+/*
+ PSYByteSwap.m
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import "PSYByteSwap.h"
+
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+#define PSY_SWAP_KERNEL(size)                                                                 \
+static void PSYSwapElements ## size(uint8_t *destination, const uint8_t *source, NSUInteger count) \
+{                                                                                             \
+    NSUInteger       i     = 0;                                                               \
+    const NSUInteger width = size / 8;                                                        \
+    PSY_SWAP_VECTOR_LOOP ## size                                                              \
+    for(; i < count; i++)                                                                     \
+    {                                                                                         \
+        uint ## size ## _t value;                                                             \
+        memcpy(&value, source + i * width, width);                                            \
+        value = PSY_BSWAP ## size(value);                                                     \
+        memcpy(destination + i * width, &value, width);                                       \
+    }                                                                                         \
+}
+
+#define PSY_BSWAP16(value) __builtin_bswap16(value)
+#define PSY_BSWAP32(value) __builtin_bswap32(value)
+#define PSY_BSWAP64(value) __builtin_bswap64(value)
+
+#if defined(__AVX2__)
+
+// Reverses the bytes of each element within each 16-byte lane
+#define PSY_SHUFFLE_MASK16 _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14, 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14)
+#define PSY_SHUFFLE_MASK32 _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12)
+#define PSY_SHUFFLE_MASK64 _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8)
+
+#define PSY_SWAP_VECTOR_LOOP(size)                                                         \
+    const __m256i mask = PSY_SHUFFLE_MASK ## size;                                         \
+    for(; (i + 32 / width) <= count; i += 32 / width)                                      \
+    {                                                                                      \
+        __m256i block = _mm256_loadu_si256((const __m256i *)(source + i * width));         \
+        _mm256_storeu_si256((__m256i *)(destination + i * width), _mm256_shuffle_epi8(block, mask)); \
+    }
+
+#elif defined(__SSSE3__)
+
+#define PSY_SHUFFLE_MASK16 _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14)
+#define PSY_SHUFFLE_MASK32 _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12)
+#define PSY_SHUFFLE_MASK64 _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8)
+
+#define PSY_SWAP_VECTOR_LOOP(size)                                                         \
+    const __m128i mask = PSY_SHUFFLE_MASK ## size;                                         \
+    for(; (i + 16 / width) <= count; i += 16 / width)                                      \
+    {                                                                                      \
+        __m128i block = _mm_loadu_si128((const __m128i *)(source + i * width));            \
+        _mm_storeu_si128((__m128i *)(destination + i * width), _mm_shuffle_epi8(block, mask)); \
+    }
+
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+#define PSY_NEON_REVERSE16(block) vrev16q_u8(block)
+#define PSY_NEON_REVERSE32(block) vrev32q_u8(block)
+#define PSY_NEON_REVERSE64(block) vrev64q_u8(block)
+
+#define PSY_SWAP_VECTOR_LOOP(size)                                                         \
+    for(; (i + 16 / width) <= count; i += 16 / width)                                      \
+    {                                                                                      \
+        uint8x16_t block = vld1q_u8(source + i * width);                                   \
+        vst1q_u8(destination + i * width, PSY_NEON_REVERSE ## size(block));                \
+    }
+
+#else
+
+#define PSY_SWAP_VECTOR_LOOP(size)
+
+#endif
+
+#define PSY_SWAP_VECTOR_LOOP16 PSY_SWAP_VECTOR_LOOP(16)
+#define PSY_SWAP_VECTOR_LOOP32 PSY_SWAP_VECTOR_LOOP(32)
+#define PSY_SWAP_VECTOR_LOOP64 PSY_SWAP_VECTOR_LOOP(64)
+
+PSY_SWAP_KERNEL(16)
+PSY_SWAP_KERNEL(32)
+PSY_SWAP_KERNEL(64)
+
+void PSYCopyElements(void *destination, const void *source, NSUInteger count, NSUInteger width, BOOL swap)
+{
+    if(count == 0) return;
+    
+    if(!swap || width == 1)
+    {
+        if(destination != source) memmove(destination, source, count * width);
+        return;
+    }
+    
+    switch(width)
+    {
+        case 2 : PSYSwapElements16(destination, source, count); break;
+        case 4 : PSYSwapElements32(destination, source, count); break;
+        case 8 : PSYSwapElements64(destination, source, count); break;
+        default :
+        {
+            // Generic widths are reversed byte by byte
+            const uint8_t *src = source;
+            uint8_t       *dst = destination;
+            
+            for(NSUInteger i = 0; i < count; i++, src += width, dst += width)
+                for(NSUInteger j = 0; j < (width + 1) / 2; j++)
+                {
+                    uint8_t tmp = src[j];
+                    dst[j] = src[width - 1 - j];
+                    dst[width - 1 - j] = tmp;
+                }
+            break;
+        }
+    }
+}
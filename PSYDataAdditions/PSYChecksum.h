@@ -0,0 +1,39 @@
+/*
+ PSYChecksum.h
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+// The checksums the scanners and the writers can compute over their bytes
+typedef enum _PSYChecksumAlgorithm
+{
+    PSYChecksumNone,
+    PSYChecksumCRC32C,
+} PSYChecksumAlgorithm;
+
+// Updates a CRC-32C (Castagnoli) with length bytes and returns it
+// A checksum starts at 0 and the result of each call is passed to the next one, like zlib's crc32()
+// The SSE4.2 or ARMv8 CRC instructions are used when the processor has them,
+// otherwise 8 bytes are folded at a time through tables
+uint32_t PSYCRC32CUpdate(uint32_t crc, const void *bytes, size_t length);
@@ -0,0 +1,163 @@
+/*
+ PSYChecksum.m
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import "PSYChecksum.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define PSY_HAS_SSE42_KERNEL 1
+#endif
+
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+// Reflected Castagnoli polynomial
+#define CRC32C_POLYNOMIAL 0x82F63B78u
+
+static uint32_t PSYCRC32CTable[8][256];
+
+static void PSYCRC32CInitializeTable(void)
+{
+    for(uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t crc = i;
+        for(int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (CRC32C_POLYNOMIAL & (0u - (crc & 1)));
+        PSYCRC32CTable[0][i] = crc;
+    }
+    
+    // Table k advances a byte through k more zero bytes, which lets the loop fold 8 bytes independently
+    for(uint32_t i = 0; i < 256; i++)
+        for(int k = 1; k < 8; k++)
+            PSYCRC32CTable[k][i] = (PSYCRC32CTable[k - 1][i] >> 8) ^ PSYCRC32CTable[0][PSYCRC32CTable[k - 1][i] & 0xff];
+}
+
+static uint32_t PSYCRC32CSoftware(uint32_t crc, const uint8_t *bytes, size_t length)
+{
+    for(; length > 0 && ((uintptr_t)bytes & 7) != 0; length--)
+        crc = (crc >> 8) ^ PSYCRC32CTable[0][(crc ^ *bytes++) & 0xff];
+    
+    for(; length >= 8; length -= 8, bytes += 8)
+    {
+        uint32_t low, high;
+        memcpy(&low, bytes, sizeof(low));
+        memcpy(&high, bytes + 4, sizeof(high));
+        low = NSSwapHostIntToLittle(low) ^ crc;
+        high = NSSwapHostIntToLittle(high);
+        
+        crc = (PSYCRC32CTable[7][ low         & 0xff] ^ PSYCRC32CTable[6][(low  >>  8) & 0xff] ^
+               PSYCRC32CTable[5][(low  >> 16) & 0xff] ^ PSYCRC32CTable[4][ low  >> 24        ] ^
+               PSYCRC32CTable[3][ high        & 0xff] ^ PSYCRC32CTable[2][(high >>  8) & 0xff] ^
+               PSYCRC32CTable[1][(high >> 16) & 0xff] ^ PSYCRC32CTable[0][ high >> 24        ]);
+    }
+    
+    while(length-- > 0)
+        crc = (crc >> 8) ^ PSYCRC32CTable[0][(crc ^ *bytes++) & 0xff];
+    
+    return crc;
+}
+
+#if defined(PSY_HAS_SSE42_KERNEL)
+__attribute__((target("sse4.2")))
+static uint32_t PSYCRC32CSSE42(uint32_t crc, const uint8_t *bytes, size_t length)
+{
+    for(; length > 0 && ((uintptr_t)bytes & 7) != 0; length--)
+        crc = _mm_crc32_u8(crc, *bytes++);
+        
+#if defined(__x86_64__)
+    uint64_t crc64 = crc;
+    for(; length >= 8; length -= 8, bytes += 8)
+    {
+        uint64_t word;
+        memcpy(&word, bytes, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+    crc = (uint32_t)crc64;
+#endif
+    
+    for(; length >= 4; length -= 4, bytes += 4)
+    {
+        uint32_t word;
+        memcpy(&word, bytes, sizeof(word));
+        crc = _mm_crc32_u32(crc, word);
+    }
+    
+    while(length-- > 0)
+        crc = _mm_crc32_u8(crc, *bytes++);
+    
+    return crc;
+}
+#endif
+
+#if defined(__ARM_FEATURE_CRC32)
+static uint32_t PSYCRC32CARM(uint32_t crc, const uint8_t *bytes, size_t length)
+{
+    for(; length > 0 && ((uintptr_t)bytes & 7) != 0; length--)
+        crc = __crc32cb(crc, *bytes++);
+    
+    for(; length >= 8; length -= 8, bytes += 8)
+    {
+        uint64_t word;
+        memcpy(&word, bytes, sizeof(word));
+        crc = __crc32cd(crc, word);
+    }
+    
+    while(length-- > 0)
+        crc = __crc32cb(crc, *bytes++);
+    
+    return crc;
+}
+#endif
+
+typedef uint32_t (*PSYCRC32CKernel)(uint32_t crc, const uint8_t *bytes, size_t length);
+
+static PSYCRC32CKernel PSYCRC32CSelectKernel(void)
+{
+#if defined(__ARM_FEATURE_CRC32)
+    return PSYCRC32CARM;
+#else
+#if defined(PSY_HAS_SSE42_KERNEL)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("sse4.2")) return PSYCRC32CSSE42;
+#endif
+    
+    PSYCRC32CInitializeTable();
+    return PSYCRC32CSoftware;
+#endif
+}
+
+uint32_t PSYCRC32CUpdate(uint32_t crc, const void *bytes, size_t length)
+{
+    static PSYCRC32CKernel kernel;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        kernel = PSYCRC32CSelectKernel();
+    });
+    
+    return ~kernel(~crc, bytes, length);
+}
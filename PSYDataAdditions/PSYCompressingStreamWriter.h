@@ -0,0 +1,38 @@
+/*
+ PSYCompressingStreamWriter.h
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import "PSYStreamWriter.h"
+#import "PSYCompression.h"
+
+// The windowBits argument given to zlib for a format
+extern int PSYCompressionWindowBits(PSYCompressionFormat format);
+
+// Deflates the writes into a fixed output buffer handed to the target writer whenever it fills up,
+// a group is flushed when it ends so the peer can inflate it as soon as it's received
+@interface PSYCompressingStreamWriter : PSYStreamWriter
+
+- (id)initWithStreamWriter:(PSYStreamWriter *)writer compressionFormat:(PSYCompressionFormat)format level:(int)level;
+
+@end
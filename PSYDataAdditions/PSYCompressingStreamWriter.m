@@ -0,0 +1,238 @@
+/*
+ PSYCompressingStreamWriter.m
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import "PSYCompressingStreamWriter.h"
+#import "PSYUtilities.h"
+
+#include <zlib.h>
+#include <limits.h>
+
+// The compressed bytes are handed to the target writer in pieces of at most this many bytes,
+// with zlib's own window it's all the memory a compressing writer uses
+#define OUTPUT_BUFFER_SIZE       (32 * 1024)
+#define INPUT_STREAM_BUFFER_SIZE (16 * 1024)
+
+int PSYCompressionWindowBits(PSYCompressionFormat format)
+{
+    switch(format)
+    {
+        case PSYCompressionFormatDeflate : return -MAX_WBITS;
+        case PSYCompressionFormatZlib    : return MAX_WBITS;
+        case PSYCompressionFormatGzip    : return MAX_WBITS + 16;
+    }
+    
+    return MAX_WBITS;
+}
+
+@implementation PSYCompressingStreamWriter
+{
+    PSYStreamWriter *_targetWriter;
+    PSYStreamWriter *_outputWriter; // the target writer or the group of the target being written
+    z_stream         _stream;
+    uint8_t         *_outputBuffer;
+    BOOL             _finished;
+    
+    // The checksum of a compressing writer covers the uncompressed bytes,
+    // the checksum of the target writer covers the compressed ones
+    PSYChecksumAlgorithm _checksumAlgorithm;
+    uint32_t             _checksum;
+}
+
+- (id)initWithStreamWriter:(PSYStreamWriter *)writer compressionFormat:(PSYCompressionFormat)format level:(int)level;
+{
+    if(writer == nil)
+    {
+        RELEASE(self);
+        return nil;
+    }
+    
+    if((self = [super init]))
+    {
+        _outputBuffer = malloc(OUTPUT_BUFFER_SIZE);
+        
+        if(_outputBuffer == NULL || deflateInit2(&_stream, level, Z_DEFLATED, PSYCompressionWindowBits(format), 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            // The stream is only ended once it was initialized
+            _finished = YES;
+            RELEASE(self);
+            return nil;
+        }
+        
+        _targetWriter = RETAIN(writer);
+        _outputWriter = _targetWriter;
+    }
+    
+    return self;
+}
+
+- (void)dealloc
+{
+    if(!_finished) deflateEnd(&_stream);
+    free(_outputBuffer);
+    
+#if !__has_feature(objc_arc)
+    [_targetWriter release];
+    [super dealloc];
+#endif
+}
+
+- (id<PSYStreamWriterDelegate>)delegate                { return [_targetWriter delegate];   }
+- (void)setDelegate:(id<PSYStreamWriterDelegate>)value { [_targetWriter setDelegate:value]; }
+
+- (BOOL)collectsStatistics                  { return [_targetWriter collectsStatistics];   }
+- (void)setCollectsStatistics:(BOOL)value   { [_targetWriter setCollectsStatistics:value]; }
+- (PSYStreamWriterStatistics)statistics     { return [_targetWriter statistics];           }
+- (void)resetStatistics                     { [_targetWriter resetStatistics];             }
+
+- (PSYChecksumAlgorithm)checksumAlgorithm                { return _checksumAlgorithm;           }
+- (void)setChecksumAlgorithm:(PSYChecksumAlgorithm)value { _checksumAlgorithm = value; _checksum = 0; }
+- (uint32_t)checksum                                     { return _checksum;                    }
+- (void)resetChecksum                                    { _checksum = 0;                       }
+
+- (NSUInteger)highWaterMark                 { return [_targetWriter highWaterMark];        }
+- (NSUInteger)lowWaterMark                  { return [_targetWriter lowWaterMark];         }
+- (BOOL)hasSpaceAvailable                   { return [_targetWriter hasSpaceAvailable];    }
+
+- (void)setHighWaterMark:(NSUInteger)high lowWaterMark:(NSUInteger)low;
+{
+    [_targetWriter setHighWaterMark:high lowWaterMark:low];
+}
+
+// Compresses length bytes and writes whatever zlib outputs, flush is Z_NO_FLUSH, Z_SYNC_FLUSH or Z_FINISH
+- (void)PSY_deflateBytes:(const uint8_t *)buffer length:(NSUInteger)length flush:(int)flush;
+{
+    if(_finished) [NSException raise:NSInternalInconsistencyException format:@"*** -[PSYStreamWriter %@]: the compressed stream is already finished", NSStringFromSelector(_cmd)];
+    
+    _stream.next_in = (Bytef *)buffer;
+    
+    do {
+        // zlib counts its input with an unsigned int
+        uInt chunk = (uInt)MIN(length, (NSUInteger)UINT_MAX);
+        length -= chunk;
+        
+        _stream.avail_in = chunk;
+        
+        // The input is consumed once zlib leaves room in the output buffer
+        do {
+            _stream.next_out  = _outputBuffer;
+            _stream.avail_out = OUTPUT_BUFFER_SIZE;
+            
+            if(deflate(&_stream, length > 0 ? Z_NO_FLUSH : flush) == Z_STREAM_ERROR)
+                [NSException raise:NSInternalInconsistencyException format:@"*** -[PSYStreamWriter %@]: the compressed stream is corrupted", NSStringFromSelector(_cmd)];
+            
+            NSUInteger produced = OUTPUT_BUFFER_SIZE - _stream.avail_out;
+            if(produced > 0) [_outputWriter writeBytes:_outputBuffer ofLength:produced];
+        } while(_stream.avail_out == 0);
+    } while(length > 0);
+}
+
+- (void)writeBytes:(const uint8_t *)buffer ofLength:(NSUInteger)length
+{
+    if(length == 0) return;
+    
+    @synchronized(self)
+    {
+        if(_checksumAlgorithm != PSYChecksumNone) _checksum = PSYCRC32CUpdate(_checksum, buffer, length);
+        
+        [self PSY_deflateBytes:buffer length:length flush:Z_NO_FLUSH];
+    }
+}
+
+- (void)writeData:(NSData *)value
+{
+    [self writeBytes:[value bytes] ofLength:[value length]];
+}
+
+// The input stream has to be compressed in the order of the writes, it's read to its end right away
+// A completion is queued on the target writer after the stream is flushed, so it's called once its bytes are written
+- (void)writeInputStream:(NSInputStream *)aStream completion:(void (^)(void))completion;
+{
+    if(aStream == nil) return;
+    
+    uint8_t buffer[INPUT_STREAM_BUFFER_SIZE];
+    
+    @synchronized(self)
+    {
+        if([aStream streamStatus] == NSStreamStatusNotOpen) [aStream open];
+        
+        NSInteger read;
+        while((read = [aStream read:buffer maxLength:INPUT_STREAM_BUFFER_SIZE]) > 0)
+            [self PSY_deflateBytes:buffer length:read flush:Z_NO_FLUSH];
+        
+        [aStream close];
+        
+        if(read < 0)
+        {
+            if([[self delegate] respondsToSelector:@selector(streamWriter:didReceiveError:)])
+                [[self delegate] streamWriter:self didReceiveError:[aStream streamError]];
+            return;
+        }
+        
+        if(completion != nil)
+        {
+            [self PSY_deflateBytes:NULL length:0 flush:Z_SYNC_FLUSH];
+            [_outputWriter groupWrites:^(PSYStreamWriter *group) {} completion:completion];
+        }
+    }
+}
+
+// The writes of the group are compressed into a group of the target writer and flushed at its end,
+// the group keeps the compressor to itself until its block returns
+- (void)groupWrites:(void (^)(PSYStreamWriter *))writes completion:(void (^)(void))completion
+{
+    if(writes == nil) return;
+    
+    @synchronized(self)
+    {
+        PSYStreamWriter *outerWriter = _outputWriter;
+        
+        [outerWriter groupWrites:^(PSYStreamWriter *group) {
+            _outputWriter = group;
+            
+            @try
+            {
+                writes(self);
+                [self PSY_deflateBytes:NULL length:0 flush:Z_SYNC_FLUSH];
+            }
+            @finally
+            {
+                _outputWriter = outerWriter;
+            }
+        } completion:completion];
+    }
+}
+
+- (void)finishCompression;
+{
+    @synchronized(self)
+    {
+        [self PSY_deflateBytes:NULL length:0 flush:Z_FINISH];
+        
+        deflateEnd(&_stream);
+        _finished = YES;
+    }
+}
+
+@end
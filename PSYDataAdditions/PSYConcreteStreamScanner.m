@@ -0,0 +1,699 @@
+/*
+ PSYConcreteStreamScanner.m
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import "PSYConcreteStreamScanner.h"
+#import "PSYDataScanner.h"
+#import "PSYDataSlice.h"
+#import "PSYUtilities.h"
+#import "PSYTimerWheel.h"
+
+#define MIN_BUFFER_CAPACITY (16 * 1024)
+#define MIN_READ_LENGTH     (4 * 1024)
+
+// Aho-Corasick automaton over the start and stop data of the active messages,
+// the missing transitions are resolved when it's built so each byte costs a single lookup
+// whatever the number of messages
+typedef struct _PSYPatternState
+{
+    int32_t    next[256];
+    NSUInteger depth;
+    NSInteger  pattern;    // Index of the pattern ending on this state, -1 if none
+    NSUInteger outputLink; // Closest state on the failure path ending a pattern, 0 if none
+} PSYPatternState;
+
+static PSYPatternState *PSYCreatePatternAutomaton(NSArray *patterns)
+{
+    NSUInteger capacity = 1;
+    for(NSData *pattern in patterns) capacity += [pattern length];
+    
+    PSYPatternState *states = malloc(capacity * sizeof(PSYPatternState));
+    int32_t         *fail   = malloc(capacity * sizeof(int32_t));
+    int32_t         *queue  = malloc(capacity * sizeof(int32_t));
+    NSUInteger       count  = 1;
+    
+    memset(states[0].next, 0xff, sizeof(states[0].next));
+    states[0].depth      = 0;
+    states[0].pattern    = -1;
+    states[0].outputLink = 0;
+    
+    // Build the trie of the patterns
+    NSInteger index = 0;
+    for(NSData *pattern in patterns)
+    {
+        const uint8_t *bytes = [pattern bytes];
+        NSUInteger     state = 0;
+        
+        for(NSUInteger i = 0, length = [pattern length]; i < length; i++)
+        {
+            if(states[state].next[bytes[i]] < 0)
+            {
+                memset(states[count].next, 0xff, sizeof(states[count].next));
+                states[count].depth      = states[state].depth + 1;
+                states[count].pattern    = -1;
+                states[count].outputLink = 0;
+                states[state].next[bytes[i]] = (int32_t)count++;
+            }
+            
+            state = states[state].next[bytes[i]];
+        }
+        
+        states[state].pattern = index++;
+    }
+    
+    // Compute the failure links breadth-first, a state's failure is always resolved before its children
+    NSUInteger head = 0, tail = 0;
+    
+    for(NSUInteger c = 0; c < 256; c++)
+    {
+        int32_t child = states[0].next[c];
+        
+        if(child < 0) states[0].next[c] = 0;
+        else
+        {
+            fail[child]   = 0;
+            queue[tail++] = child;
+        }
+    }
+    
+    while(head < tail)
+    {
+        int32_t state   = queue[head++];
+        int32_t failure = fail[state];
+        
+        states[state].outputLink = states[failure].pattern >= 0 ? (NSUInteger)failure : states[failure].outputLink;
+        
+        for(NSUInteger c = 0; c < 256; c++)
+        {
+            int32_t child = states[state].next[c];
+            
+            if(child < 0) states[state].next[c] = states[failure].next[c];
+            else
+            {
+                fail[child]   = states[failure].next[c];
+                queue[tail++] = child;
+            }
+        }
+    }
+    
+    free(fail);
+    free(queue);
+    
+    return states;
+}
+
+@interface PSYConcreteStreamScanner () <NSStreamDelegate>
+{
+    NSInputStream       *inputStream;
+    BOOL                 closeOnDealloc;
+    BOOL                 reachedEnd;
+    
+    NSMutableDictionary *messages;
+    NSArray             *defaultMessages;
+    NSArray             *expectedMessages;
+    
+    // Messages currently matched and their automaton, rebuilt when the expectations change
+    NSArray             *activeMessages;
+    PSYPatternState     *automaton;
+    NSInteger           *startPatterns;
+    NSInteger           *stopPatterns;
+    NSUInteger           unanchoredCount;
+    BOOL                 needsRebuild;
+    
+    // Messages that may still match the bytes after messageStart
+    BOOL                *candidates;
+    NSUInteger           candidateCount;
+    NSUInteger           startLength;
+    NSUInteger           lengthLimit;
+    NSUInteger           fixedLength;
+    NSUInteger           greedyCount;
+    
+    // The bytes are read once in a block that is only ever appended to,
+    // so the matched messages are slices of it, bytes before consumedLength are not needed anymore
+    NSData              *bufferData;
+    uint8_t             *buffer;
+    NSUInteger           bufferCapacity;
+    NSUInteger           bufferLength;
+    NSUInteger           consumedLength;
+    NSUInteger           scannedLength;
+    NSUInteger           messageStart;
+    NSUInteger           currentState;
+    
+    PSYDataScanner      *messageScanner;
+    BOOL                 processing;
+    
+    // Timeouts of the expected messages and of the message being matched
+    PSYTimerWheelEntry   overallTimer;
+    PSYTimerWheelEntry   partialTimer;
+    NSUInteger           overallTimeoutIndex;
+    NSUInteger           partialTimeoutIndex;
+    NSTimeInterval       partialTimeoutInterval;
+}
+- (void)PSY_timerDidFire:(PSYTimerWheelEntry *)timer;
+@end
+
+static void PSYStreamScannerTimerDidFire(PSYTimerWheelEntry *entry, void *context)
+{
+    [(__bridge PSYConcreteStreamScanner *)context PSY_timerDidFire:entry];
+}
+
+@implementation PSYConcreteStreamScanner
+
+- (id)initWithInputStream:(NSInputStream *)aStream closeOnDealloc:(BOOL)close
+{
+    if(aStream == nil)
+    {
+        RELEASE(self);
+        return nil;
+    }
+    
+    if((self = [super init]))
+    {
+        inputStream = RETAIN(aStream);
+        [inputStream setDelegate:self];
+        closeOnDealloc = close;
+        messages       = [[NSMutableDictionary alloc] init];
+        messageStart   = NSNotFound;
+        
+        PSYTimerWheelEntryInit(&overallTimer, PSYStreamScannerTimerDidFire, (__bridge void *)self);
+        PSYTimerWheelEntryInit(&partialTimer, PSYStreamScannerTimerDidFire, (__bridge void *)self);
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [inputStream setDelegate:nil];
+    if(closeOnDealloc) [inputStream close];
+    
+    PSYTimerWheelCancel(&overallTimer);
+    PSYTimerWheelCancel(&partialTimer);
+    
+    free(automaton);
+    free(startPatterns);
+    free(stopPatterns);
+    free(candidates);
+    
+#if !__has_feature(objc_arc)
+    [inputStream release];
+    [messages release];
+    [defaultMessages release];
+    [expectedMessages release];
+    [activeMessages release];
+    [bufferData release];
+    [messageScanner release];
+    [super dealloc];
+#endif
+}
+
+- (NSArray *)defaultMessages
+{
+    return defaultMessages;
+}
+
+- (void)setDefaultMessages:(NSArray *)value
+{
+    if(defaultMessages == value) return;
+    
+    RELEASE(defaultMessages);
+    defaultMessages = [value copy];
+    
+    [self PSY_activeMessagesDidChange];
+}
+
+- (PSYStreamScannerMessage *)messageForIdentifier:(NSString *)identifier;
+{
+    return [messages objectForKey:identifier];
+}
+
+- (void)setMessage:(PSYStreamScannerMessage *)aMessage forIdentifier:(NSString *)identifier;
+{
+    if(aMessage == nil) [messages removeObjectForKey:identifier];
+    else [messages setObject:AUTORELEASE([aMessage copy]) forKey:identifier];
+}
+
+- (void)expectMessagesInArray:(NSArray *)array;
+{
+    RELEASE(expectedMessages);
+    expectedMessages = [array copy];
+    
+    // The earliest overall timeout applies
+    NSTimeInterval timeout = 0;
+    
+    PSYTimerWheelCancel(&overallTimer);
+    
+    for(NSUInteger i = 0, count = [expectedMessages count]; i < count; i++)
+    {
+        NSTimeInterval interval = [[expectedMessages objectAtIndex:i] overallTimeoutInterval];
+        
+        if(interval > 0 && (timeout == 0 || interval < timeout))
+        {
+            timeout             = interval;
+            overallTimeoutIndex = i;
+        }
+    }
+    
+    if(timeout > 0) PSYTimerWheelSchedule(&overallTimer, timeout);
+    
+    [self PSY_activeMessagesDidChange];
+}
+
+- (void)removeExpectations;
+{
+    if(expectedMessages == nil) return;
+    
+    RELEASE(expectedMessages);
+    PSYTimerWheelCancel(&overallTimer);
+    
+    [self PSY_activeMessagesDidChange];
+}
+
+- (PSYDataScanner *)PSY_messageScanner;
+{
+    return messageScanner;
+}
+
+- (BOOL)isFinished;
+{
+    return reachedEnd;
+}
+
+- (void)PSY_activeMessagesDidChange;
+{
+    needsRebuild = YES;
+    
+    if([inputStream streamStatus] == NSStreamStatusNotOpen) [inputStream open];
+    
+    // Bytes that are already buffered are matched against the new expectations right away,
+    // from a callback block they are matched once the block returns
+    [self PSY_processBufferedData];
+}
+
+- (void)PSY_rebuildAutomaton;
+{
+    NSArray *active = [expectedMessages count] > 0 ? expectedMessages : defaultMessages;
+    
+    needsRebuild   = NO;
+    scannedLength  = consumedLength;
+    messageStart   = NSNotFound;
+    currentState   = 0;
+    
+    PSYTimerWheelCancel(&partialTimer);
+    
+    if(activeMessages == active || [activeMessages isEqualToArray:active]) return;
+    
+    RELEASE(activeMessages);
+    activeMessages = [active copy];
+    
+    free(automaton);
+    free(startPatterns);
+    free(stopPatterns);
+    free(candidates);
+    
+    NSUInteger      count    = [activeMessages count];
+    NSMutableArray *patterns = [[NSMutableArray alloc] initWithCapacity:count * 2];
+    
+    startPatterns   = malloc(count * sizeof(NSInteger));
+    stopPatterns    = malloc(count * sizeof(NSInteger));
+    candidates      = calloc(count, sizeof(BOOL));
+    unanchoredCount = 0;
+    
+    // Messages sharing a start or stop data share the pattern
+    NSInteger (^patternIndex)(NSData *) = ^ NSInteger (NSData *data)
+    {
+        if([data length] == 0) return -1;
+        
+        NSUInteger index = [patterns indexOfObject:data];
+        if(index != NSNotFound) return (NSInteger)index;
+        
+        [patterns addObject:data];
+        return (NSInteger)[patterns count] - 1;
+    };
+    
+    for(NSUInteger i = 0; i < count; i++)
+    {
+        PSYStreamScannerMessage *message = [activeMessages objectAtIndex:i];
+        
+        startPatterns[i] = patternIndex([message startData]);
+        stopPatterns[i]  = patternIndex([message stopData]);
+        
+        if(startPatterns[i] < 0) unanchoredCount++;
+    }
+    
+    automaton = PSYCreatePatternAutomaton(patterns);
+    
+    RELEASE(patterns);
+}
+
+// Makes room for at least MIN_READ_LENGTH bytes at the end of the buffer
+// The current block may be referenced by delivered messages so it's never modified,
+// the bytes still needed are moved to a new block
+- (void)PSY_reserveBufferSpace;
+{
+    if(bufferCapacity - bufferLength >= MIN_READ_LENGTH) return;
+    
+    NSUInteger pending  = bufferLength - consumedLength;
+    NSUInteger capacity = MIN_BUFFER_CAPACITY;
+    
+    while(capacity < pending + MIN_READ_LENGTH) capacity *= 2;
+    
+    uint8_t *bytes = malloc(capacity);
+    if(pending > 0) memcpy(bytes, buffer + consumedLength, pending);
+    
+    RELEASE(bufferData);
+    bufferData     = [[NSData alloc] initWithBytesNoCopy:bytes length:capacity freeWhenDone:YES];
+    buffer         = bytes;
+    bufferCapacity = capacity;
+    
+    bufferLength  -= consumedLength;
+    scannedLength -= consumedLength;
+    if(messageStart != NSNotFound) messageStart -= consumedLength;
+    consumedLength = 0;
+}
+
+- (void)PSY_readAvailableBytes;
+{
+    while([inputStream hasBytesAvailable])
+    {
+        [self PSY_reserveBufferSpace];
+        
+        NSInteger read = [inputStream read:buffer + bufferLength maxLength:bufferCapacity - bufferLength];
+        if(read <= 0) break;
+        
+        bufferLength += read;
+        
+        // Progress on the message being matched pushes its partial timeout back
+        if(PSYTimerWheelEntryIsScheduled(&partialTimer))
+            PSYTimerWheelSchedule(&partialTimer, partialTimeoutInterval);
+        
+        // Matching as we go keeps the buffer to the size of the longest message
+        [self PSY_processBufferedData];
+    }
+}
+
+- (void)PSY_processBufferedData;
+{
+    if(processing) return;
+    
+    processing = YES;
+    
+    while(YES)
+    {
+        if(needsRebuild) [self PSY_rebuildAutomaton];
+        
+        // Nothing is expected, the data is ignored
+        if([activeMessages count] == 0)
+        {
+            consumedLength = scannedLength = bufferLength;
+            break;
+        }
+        
+        NSUInteger index = [self PSY_scanBufferedData];
+        if(index == NSNotFound) break;
+        
+        [self PSY_deliverMessageAtIndex:index];
+    }
+    
+    processing = NO;
+}
+
+// Messages without stop data complete at a fixed length, the minimum partial length or the start data's,
+// those with neither start, stop nor length take whatever is available
+- (void)PSY_addLimitsOfCandidate:(PSYStreamScannerMessage *)message atIndex:(NSUInteger)index;
+{
+    if([message maximumLength] > 0) lengthLimit = MIN(lengthLimit, [message maximumLength]);
+    
+    if(stopPatterns[index] >= 0) return;
+    
+    NSUInteger length = MAX([message minimumPartialLength], startLength);
+    
+    if(length == 0) greedyCount++;
+    else fixedLength = MIN(fixedLength, length);
+}
+
+- (void)PSY_beginMessageWithPattern:(NSInteger)pattern length:(NSUInteger)length;
+{
+    NSUInteger count = [activeMessages count];
+    
+    messageStart   = scannedLength - length;
+    consumedLength = messageStart;
+    startLength    = length;
+    candidateCount = 0;
+    lengthLimit    = NSUIntegerMax;
+    fixedLength    = NSUIntegerMax;
+    greedyCount    = 0;
+    
+    partialTimeoutInterval = 0;
+    
+    for(NSUInteger i = 0; i < count; i++)
+    {
+        candidates[i] = startPatterns[i] == pattern;
+        if(!candidates[i]) continue;
+        
+        PSYStreamScannerMessage *message  = [activeMessages objectAtIndex:i];
+        NSTimeInterval           interval = [message partialTimeoutInterval];
+        
+        candidateCount++;
+        [self PSY_addLimitsOfCandidate:message atIndex:i];
+        
+        if(interval > 0 && (partialTimeoutInterval == 0 || interval < partialTimeoutInterval))
+        {
+            partialTimeoutInterval = interval;
+            partialTimeoutIndex    = i;
+        }
+    }
+    
+    if(partialTimeoutInterval > 0) PSYTimerWheelSchedule(&partialTimer, partialTimeoutInterval);
+    else PSYTimerWheelCancel(&partialTimer);
+    
+    // Stop data is searched after the start data only
+    currentState = 0;
+}
+
+// Removes the candidates that can't complete within length bytes, returns NO if none is left
+- (BOOL)PSY_dropCandidatesLongerThan:(NSUInteger)length;
+{
+    NSUInteger count = [activeMessages count];
+    
+    lengthLimit = NSUIntegerMax;
+    fixedLength = NSUIntegerMax;
+    greedyCount = 0;
+    
+    for(NSUInteger i = 0; i < count; i++)
+    {
+        if(!candidates[i]) continue;
+        
+        PSYStreamScannerMessage *message = [activeMessages objectAtIndex:i];
+        NSUInteger               maximum = [message maximumLength];
+        
+        if(maximum > 0 && maximum < length)
+        {
+            candidates[i] = NO;
+            candidateCount--;
+            continue;
+        }
+        
+        [self PSY_addLimitsOfCandidate:message atIndex:i];
+    }
+    
+    if(candidateCount > 0) return YES;
+    
+    // The message is too long, skip it entirely
+    consumedLength = scannedLength;
+    messageStart   = NSNotFound;
+    currentState   = 0;
+    
+    PSYTimerWheelCancel(&partialTimer);
+    
+    return NO;
+}
+
+// Returns the first candidate without stop data that is complete with length bytes
+- (NSUInteger)PSY_fixedMessageCompletedWithLength:(NSUInteger)length;
+{
+    NSUInteger count = [activeMessages count];
+    
+    for(NSUInteger i = 0; i < count; i++)
+    {
+        if(!candidates[i] || stopPatterns[i] >= 0) continue;
+        
+        NSUInteger target = MAX([[activeMessages objectAtIndex:i] minimumPartialLength], startLength);
+        
+        if(target == 0 ? scannedLength == bufferLength && length > 0 : length >= target)
+            return i;
+    }
+    
+    return NSNotFound;
+}
+
+// Returns the first candidate whose stop data is the pattern that just ended
+- (NSUInteger)PSY_messageStoppedByPattern:(NSInteger)pattern length:(NSUInteger)length;
+{
+    NSUInteger count = [activeMessages count];
+    
+    for(NSUInteger i = 0; i < count; i++)
+    {
+        if(!candidates[i] || stopPatterns[i] != pattern) continue;
+        
+        PSYStreamScannerMessage *message = [activeMessages objectAtIndex:i];
+        
+        if(length >= [message minimumPartialLength] && ([message maximumLength] == 0 || length <= [message maximumLength]))
+            return i;
+    }
+    
+    return NSNotFound;
+}
+
+// Feeds the bytes that weren't scanned yet to the automaton,
+// returns the index of the first active message to complete or NSNotFound
+- (NSUInteger)PSY_scanBufferedData;
+{
+    while(YES)
+    {
+        if(messageStart == NSNotFound && unanchoredCount > 0)
+            [self PSY_beginMessageWithPattern:-1 length:0];
+        
+        if(messageStart != NSNotFound)
+        {
+            NSUInteger length = scannedLength - messageStart;
+            
+            if(length > lengthLimit && ![self PSY_dropCandidatesLongerThan:length])
+                continue;
+            
+            if(length >= fixedLength || (greedyCount > 0 && scannedLength == bufferLength && length > 0))
+            {
+                NSUInteger index = [self PSY_fixedMessageCompletedWithLength:length];
+                if(index != NSNotFound) return index;
+            }
+        }
+        
+        if(scannedLength == bufferLength) return NSNotFound;
+        
+        currentState = automaton[currentState].next[buffer[scannedLength++]];
+        
+        NSUInteger state = automaton[currentState].pattern >= 0 ? currentState : automaton[currentState].outputLink;
+        
+        if(messageStart == NSNotFound)
+        {
+            // Only the bytes of a partial start data are kept while looking for a message
+            consumedLength = scannedLength - automaton[currentState].depth;
+            
+            // The longest start data ending here wins
+            for(; state != 0; state = automaton[state].outputLink)
+            {
+                NSInteger pattern = automaton[state].pattern;
+                
+                for(NSUInteger i = 0, count = [activeMessages count]; i < count; i++)
+                {
+                    if(startPatterns[i] != pattern) continue;
+                    
+                    [self PSY_beginMessageWithPattern:pattern length:automaton[state].depth];
+                    break;
+                }
+                
+                if(messageStart != NSNotFound) break;
+            }
+        }
+        else
+        {
+            for(; state != 0; state = automaton[state].outputLink)
+            {
+                NSUInteger index = [self PSY_messageStoppedByPattern:automaton[state].pattern length:scannedLength - messageStart];
+                if(index != NSNotFound) return index;
+            }
+        }
+    }
+}
+
+- (void)PSY_deliverMessageAtIndex:(NSUInteger)index;
+{
+    PSYStreamScannerMessage *message = RETAIN([activeMessages objectAtIndex:index]);
+    PSYDataSlice            *slice   = [[PSYDataSlice alloc] initWithData:bufferData range:NSMakeRange(messageStart, scannedLength - messageStart)];
+    
+    consumedLength = scannedLength;
+    messageStart   = NSNotFound;
+    currentState   = 0;
+    
+    PSYTimerWheelCancel(&partialTimer);
+    
+    // Matching a message removes the expectations, the callback usually sets the next ones
+    RELEASE(expectedMessages);
+    PSYTimerWheelCancel(&overallTimer);
+    needsRebuild = YES;
+    
+    messageScanner = [[PSYDataScanner alloc] initWithData:slice];
+    
+    void(^callback)(PSYStreamScanner *) = [message callbackBlock];
+    if(callback != nil) callback(self);
+    
+    RELEASE(messageScanner);
+    
+#if !__has_feature(objc_arc)
+    [slice release];
+    [message release];
+#endif
+}
+
+- (void)PSY_timerDidFire:(PSYTimerWheelEntry *)timer;
+{
+    PSYStreamScannerMessage *message = (timer == &overallTimer
+                                        ? [expectedMessages objectAtIndex:overallTimeoutIndex]
+                                        : [activeMessages objectAtIndex:partialTimeoutIndex]);
+    
+    RETAIN(message);
+    
+    // The bytes of the message being matched are skipped, the following ones are matched again
+    if(messageStart != NSNotFound)
+    {
+        consumedLength = scannedLength;
+        messageStart   = NSNotFound;
+        currentState   = 0;
+        
+        PSYTimerWheelCancel(&partialTimer);
+    }
+    
+    RELEASE(expectedMessages);
+    PSYTimerWheelCancel(&overallTimer);
+    needsRebuild = YES;
+    
+    void(^timeout)(PSYStreamScanner *) = [message timeoutBlock];
+    if(timeout != nil) timeout(self);
+    
+#if !__has_feature(objc_arc)
+    [message release];
+#endif
+    
+    [self PSY_processBufferedData];
+}
+
+- (void)stream:(NSStream *)aStream handleEvent:(NSStreamEvent)eventCode
+{
+    if(eventCode & NSStreamEventHasBytesAvailable)
+        [self PSY_readAvailableBytes];
+    
+    if(eventCode & (NSStreamEventEndEncountered | NSStreamEventErrorOccurred))
+        reachedEnd = YES;
+}
+
+@end
@@ -26,11 +26,85 @@
 #import "PSYConcreteStreamWriter.h"
 #import "PSYUtilities.h"
 
+#include <sys/uio.h>
+#include <errno.h>
+
 @class PSYStreamWriterHelper, PSYStreamWriterHelperGroup, PSYStreamWriterHelperUnit;
 
+// Statistics and checksum of a writer, the helpers retain them too in case they outlive the writer
+// Units of different groups can be written from different threads, the counters are updated atomically
+@interface PSYStreamWriterCounters : NSObject
+{
+@public
+    volatile BOOL              enabled;
+    PSYStreamWriterStatistics  statistics;
+    PSYChecksumAlgorithm       checksumAlgorithm;
+    uint32_t                   checksum;
+}
+@end
+
+#define PSY_RAISE_HIGH_WATER_MARK(counters, field, value) do { if(__builtin_expect((counters)->enabled, 0)) PSYRaiseHighWaterMark(&(counters)->statistics.field, (unsigned long long)(value)); } while(NO)
+
+static void PSYRaiseHighWaterMark(unsigned long long *mark, unsigned long long value)
+{
+    unsigned long long current = *mark;
+    
+    while(value > current && !__sync_bool_compare_and_swap(mark, current, value))
+        current = *mark;
+}
+
+// Adds the bytes handed to a unit to the checksum of the writer, if it computes one
+// The units written from different threads take turns so the bytes are added one write at a time
+static void PSYChecksumQueuedBytes(PSYStreamWriterCounters *counters, const void *bytes, NSUInteger length)
+{
+    if(__builtin_expect(counters->checksumAlgorithm == PSYChecksumNone, 1)) return;
+    
+    @synchronized(counters) { counters->checksum = PSYCRC32CUpdate(counters->checksum, bytes, length); }
+}
+
+// Counts length bytes handed to a unit, copied into its buffer unless it references the data
+static void PSYCountQueuedBytes(PSYStreamWriterCounters *counters, NSUInteger length, BOOL copied)
+{
+    if(__builtin_expect(!counters->enabled, 1)) return;
+    
+    if(copied) __sync_fetch_and_add(&counters->statistics.bytesCopied, (unsigned long long)length);
+    
+    unsigned long long queued  = __sync_add_and_fetch(&counters->statistics.bytesQueued, (unsigned long long)length);
+    unsigned long long written = counters->statistics.bytesWritten;
+    
+    if(queued > written) PSYRaiseHighWaterMark(&counters->statistics.pendingBytesHighWaterMark, queued - written);
+}
+
+// Counts a write of length bytes that returned written
+static void PSYCountWrite(PSYStreamWriterCounters *counters, NSInteger written, NSUInteger length)
+{
+    if(__builtin_expect(!counters->enabled, 1)) return;
+    
+    __sync_fetch_and_add(&counters->statistics.writeCount, 1ULL);
+    
+    if(written < 0) return;
+    
+    __sync_fetch_and_add(&counters->statistics.bytesWritten, (unsigned long long)written);
+    if((NSUInteger)written < length) __sync_fetch_and_add(&counters->statistics.shortWriteCount, 1ULL);
+}
+
+@interface PSYStreamWriter (PSYStreamWriterCounters)
+// The counters of the root writer, shared by all its helpers
+- (PSYStreamWriterCounters *)PSY_counters;
+@end
+
 @interface PSYStreamWriterHelper : PSYStreamWriter
+{
+    PSYStreamWriterCounters *counters;
+}
 - (id)initWithParentStreamWriter:(PSYStreamWriter *)parent;
-- (BOOL)writeDataToStream:(NSOutputStream *)aStream;
+// fileDescriptor is the descriptor of a socket stream without TLS or -1, helpers then write to it
+// directly with writev(2) instead of going through the stream and wait for its next event for the rest
+- (BOOL)writeDataToStream:(NSOutputStream *)aStream fileDescriptor:(int)fileDescriptor;
+
+// Errors other than EPIPE are handed to the delegate of the writer, EPIPE ends the stream
+- (void)PSY_reportError:(NSError *)error;
+- (void)PSY_reportErrorNumber:(int)errorNumber;
 
 @property(nonatomic, assign) PSYStreamWriter *parentStreamWriter;
 @end
@@ -52,7 +126,10 @@
 {
     NSOutputStream             *outputStream;
     PSYStreamWriterHelperGroup *rootGroup;
+    PSYStreamWriterCounters    *counters;
     BOOL                        closeOnDealloc;
+    BOOL                        resolvedFileDescriptor;
+    int                         fileDescriptor;
 }
 @property(nonatomic, assign) id<PSYStreamWriterDelegate> delegate;
 @end
@@ -67,6 +144,8 @@
         outputStream = RETAIN(aStream);
         [outputStream setDelegate:self];
         closeOnDealloc = close;
+        fileDescriptor = -1;
+        counters       = [[PSYStreamWriterCounters alloc] init];
         
         rootGroup = [[PSYStreamWriterHelperGroup alloc] initWithParentStreamWriter:self];
     }
@@ -80,6 +159,7 @@
 #if !__has_feature(objc_arc)
     [outputStream release];
     [rootGroup release];
+    [counters release];
     [super dealloc];
 #endif
 }
@@ -89,10 +169,102 @@
     [rootGroup groupWrites:writes completion:completion];
 }
 
+- (PSYStreamWriterCounters *)PSY_counters;
+{
+    return counters;
+}
+
+- (BOOL)collectsStatistics
+{
+    return counters->enabled;
+}
+
+- (void)setCollectsStatistics:(BOOL)value
+{
+    counters->enabled = value;
+    
+    if(!value) [self resetStatistics];
+}
+
+- (PSYStreamWriterStatistics)statistics
+{
+    PSYStreamWriterStatistics statistics = counters->statistics;
+    
+    // The counters may be updated while they're copied, the pending bytes are never negative
+    statistics.pendingBytes = statistics.bytesQueued > statistics.bytesWritten ? statistics.bytesQueued - statistics.bytesWritten : 0;
+    
+    return statistics;
+}
+
+- (void)resetStatistics;
+{
+    memset(&counters->statistics, 0, sizeof(PSYStreamWriterStatistics));
+}
+
+- (PSYChecksumAlgorithm)checksumAlgorithm
+{
+    return counters->checksumAlgorithm;
+}
+
+- (void)setChecksumAlgorithm:(PSYChecksumAlgorithm)value
+{
+    @synchronized(counters)
+    {
+        counters->checksumAlgorithm = value;
+        counters->checksum          = 0;
+    }
+}
+
+- (uint32_t)checksum
+{
+    @synchronized(counters) { return counters->checksum; }
+}
+
+- (void)resetChecksum;
+{
+    @synchronized(counters) { counters->checksum = 0; }
+}
+
+// Socket streams expose their descriptor once they are open, other streams are written through NSOutputStream
+// A stream with TLS encrypts what it's given, so its descriptor must never be written directly
+- (int)PSY_fileDescriptor;
+{
+    if(!resolvedFileDescriptor)
+    {
+        id      securityLevel = [outputStream propertyForKey:NSStreamSocketSecurityLevelKey];
+        id      sslSettings   = [outputStream propertyForKey:(NSString *)kCFStreamPropertySSLSettings];
+        NSData *handle        = [outputStream propertyForKey:(NSString *)kCFStreamPropertySocketNativeHandle];
+        
+        BOOL plaintext = sslSettings == nil && (securityLevel == nil || [securityLevel isEqual:NSStreamSocketSecurityLevelNone]);
+        
+        if(plaintext && [handle length] == sizeof(CFSocketNativeHandle))
+            fileDescriptor = *(const CFSocketNativeHandle *)[handle bytes];
+        
+        resolvedFileDescriptor = YES;
+    }
+    
+    return fileDescriptor;
+}
+
+- (BOOL)PSY_writePendingData;
+{
+    return [rootGroup writeDataToStream:outputStream fileDescriptor:[self PSY_fileDescriptor]];
+}
+
 - (void)writeBytes:(const uint8_t *)buffer ofLength:(NSUInteger)length
 {
     [rootGroup writeBytes:buffer ofLength:length];
-    
+    [self PSY_writeAfterAppending];
+}
+
+- (void)writeData:(NSData *)value
+{
+    [rootGroup writeData:value];
+    [self PSY_writeAfterAppending];
+}
+
+- (void)PSY_writeAfterAppending;
+{
     switch([outputStream streamStatus])
     {
         case NSStreamStatusNotOpen :
@@ -102,7 +274,7 @@
             break;
         case NSStreamStatusOpen :
             // The stream is open, attempt to write whatever we have
-            if([rootGroup writeDataToStream:outputStream] &&
+            if([self PSY_writePendingData] &&
                [[self delegate] respondsToSelector:@selector(streamWriterDidFinishWriting:)])
                 [[self delegate] streamWriterDidFinishWriting:self];
             break;
@@ -135,7 +307,7 @@
 - (void)stream:(NSStream *)aStream handleEvent:(NSStreamEvent)eventCode
 {
     if(eventCode & NSStreamEventHasSpaceAvailable)
-        [rootGroup writeDataToStream:outputStream];
+        [self PSY_writePendingData];
     
     if(eventCode & NSStreamEventErrorOccurred &&
        [[self delegate] respondsToSelector:@selector(streamWriterDidEncounterEnd:)])
@@ -167,15 +339,67 @@
     if((self = [super init]))
     {
         [self setParentStreamWriter:parent];
+        counters = RETAIN([parent PSY_counters]);
     }
     
     return self;
 }
 
+#if !__has_feature(objc_arc)
+- (void)dealloc
+{
+    [counters release];
+    [super dealloc];
+}
+#endif
+
+- (PSYStreamWriterCounters *)PSY_counters;
+{
+    return counters;
+}
+
 - (id<PSYStreamWriterDelegate>)delegate                { return [parentStreamWriter delegate];   }
 - (void)setDelegate:(id<PSYStreamWriterDelegate>)value { [parentStreamWriter setDelegate:value]; }
 
-- (BOOL)writeDataToStream:(NSOutputStream *)aStream;
+// The writer the delegate knows, the helpers are private
+- (PSYStreamWriter *)PSY_rootStreamWriter;
+{
+    PSYStreamWriter *writer = parentStreamWriter;
+    
+    while([writer isKindOfClass:[PSYStreamWriterHelper class]])
+        writer = [(PSYStreamWriterHelper *)writer parentStreamWriter];
+    
+    return writer;
+}
+
+- (void)PSY_reportError:(NSError *)error;
+{
+    if([[self delegate] respondsToSelector:@selector(streamWriter:didReceiveError:)])
+        [[self delegate] streamWriter:[self PSY_rootStreamWriter] didReceiveError:error];
+}
+
+// A peer closing the socket ends the stream, the other errors are passed on
+- (void)PSY_reportErrorNumber:(int)errorNumber;
+{
+    if(errorNumber == EPIPE)
+    {
+        if([[self delegate] respondsToSelector:@selector(streamWriterDidEncounterEnd:)])
+            [[self delegate] streamWriterDidEncounterEnd:[self PSY_rootStreamWriter]];
+    }
+    else [self PSY_reportError:[NSError errorWithDomain:NSPOSIXErrorDomain code:errorNumber userInfo:nil]];
+}
+
+- (BOOL)collectsStatistics                  { return [parentStreamWriter collectsStatistics];   }
+- (void)setCollectsStatistics:(BOOL)value   { [parentStreamWriter setCollectsStatistics:value]; }
+- (PSYStreamWriterStatistics)statistics     { return [parentStreamWriter statistics];           }
+- (void)resetStatistics                     { [parentStreamWriter resetStatistics];             }
+
+- (PSYChecksumAlgorithm)checksumAlgorithm                { return [parentStreamWriter checksumAlgorithm];   }
+- (void)setChecksumAlgorithm:(PSYChecksumAlgorithm)value { [parentStreamWriter setChecksumAlgorithm:value]; }
+- (uint32_t)checksum                                     { return [parentStreamWriter checksum];            }
+- (void)resetChecksum                                    { [parentStreamWriter resetChecksum];              }
+
+- (BOOL)writeDataToStream:(NSOutputStream *)aStream fileDescriptor:(int)fileDescriptor;
 {
     PSYRequestConcreteImplementation([self class], _cmd, [self class] != [PSYStreamWriterHelper class]);
     return YES;
@@ -183,21 +407,61 @@
 
 @end
 
+// The unit stores its pending bytes in a list of chunks,
+// writes are copied into the tail chunk and the stream is written from the head chunk
+// Chunks start small and double up to MAX_CHUNK_CAPACITY,
+// the ones that have been written are kept around and reused for the next writes
+// Data of at least MIN_SEGMENT_LENGTH bytes are not copied, the chunk references the data object instead
+#define MIN_CHUNK_CAPACITY  256
+#define MAX_CHUNK_CAPACITY  (16 * 1024)
+#define MAX_SPARE_CHUNKS    4
+#define MIN_SEGMENT_LENGTH  MAX_CHUNK_CAPACITY
+#define MAX_IOVEC_COUNT     64
+
+typedef struct PSYStreamWriterChunk
+{
+    struct PSYStreamWriterChunk *next;
+    const uint8_t               *bytes;
+    CFTypeRef                    data;
+    NSUInteger                   start;
+    NSUInteger                   end;
+    NSUInteger                   capacity;
+    uint8_t                      storage[];
+} PSYStreamWriterChunk;
+
+static void PSYFreeChunk(PSYStreamWriterChunk *chunk)
+{
+    if(chunk->data != NULL) CFRelease(chunk->data);
+    free(chunk);
+}
+
+static void PSYFreeChunkList(PSYStreamWriterChunk *chunk)
+{
+    while(chunk != NULL)
+    {
+        PSYStreamWriterChunk *next = chunk->next;
+        PSYFreeChunk(chunk);
+        chunk = next;
+    }
+}
+
 @implementation PSYStreamWriterHelperUnit
 {
-    NSMutableData *pendingQueue;
-    NSData        *lockedQueue;
-    NSUInteger     writeLocation;
+    PSYStreamWriterChunk *head;
+    PSYStreamWriterChunk *tail;
+    PSYStreamWriterChunk *spareChunks;
+    NSUInteger            spareCount;
 }
 
-#if !__has_feature(objc_arc)
 - (void)dealloc
 {
-    [pendingQueue release];
-    [lockedQueue release];
+    PSYFreeChunkList(head);
+    PSYFreeChunkList(spareChunks);
+    
+#if !__has_feature(objc_arc)
     [super dealloc];
-}
 #endif
+}
 
 - (void)writeInputStream:(NSInputStream *)aStream completion:(void (^)(void))completion;
 {
@@ -209,59 +473,220 @@
     [[self parentStreamWriter] groupWrites:writes completion:completion];
 }
 
+- (PSYStreamWriterChunk *)PSY_newChunkForLength:(NSUInteger)length;
+{
+    PSYStreamWriterChunk *chunk = spareChunks;
+    
+    if(chunk != NULL)
+    {
+        spareChunks = chunk->next;
+        spareCount--;
+    }
+    else
+    {
+        NSUInteger capacity = tail != NULL ? MIN(tail->capacity * 2, MAX_CHUNK_CAPACITY) : MIN_CHUNK_CAPACITY;
+        capacity = MAX(capacity, MIN(length, MAX_CHUNK_CAPACITY));
+        
+        chunk = malloc(sizeof(PSYStreamWriterChunk) + capacity);
+        if(chunk == NULL) [NSException raise:NSMallocException format:@"*** -[PSYStreamWriter %@]: unable to allocate a write buffer", NSStringFromSelector(_cmd)];
+        
+        chunk->bytes    = chunk->storage;
+        chunk->data     = NULL;
+        chunk->capacity = capacity;
+    }
+    
+    chunk->next  = NULL;
+    chunk->start = 0;
+    chunk->end   = 0;
+    
+    return chunk;
+}
+
+- (void)PSY_recycleChunk:(PSYStreamWriterChunk *)chunk;
+{
+    if(chunk->data != NULL || spareCount >= MAX_SPARE_CHUNKS)
+    {
+        PSYFreeChunk(chunk);
+        return;
+    }
+    
+    chunk->next = spareChunks;
+    spareChunks = chunk;
+    spareCount++;
+}
+
+- (void)PSY_appendChunk:(PSYStreamWriterChunk *)chunk;
+{
+    if(tail == NULL) head = tail = chunk;
+    else             tail = tail->next = chunk;
+}
+
 - (void)writeBytes:(const uint8_t *)buffer ofLength:(NSUInteger)length
 {
+    PSYCountQueuedBytes(counters, length, YES);
+    
     @synchronized(self)
     {
-        if(pendingQueue == nil) pendingQueue = [[NSMutableData alloc] initWithCapacity:length];
+        PSYChecksumQueuedBytes(counters, buffer, length);
         
-        [pendingQueue appendBytes:buffer length:length];
+        while(length > 0)
+        {
+            if(tail == NULL || tail->end == tail->capacity)
+                [self PSY_appendChunk:[self PSY_newChunkForLength:length]];
+            
+            NSUInteger toCopy = MIN(length, tail->capacity - tail->end);
+            memcpy(tail->storage + tail->end, buffer, toCopy);
+            
+            tail->end += toCopy;
+            buffer    += toCopy;
+            length    -= toCopy;
+        }
     }
 }
 
-- (BOOL)writeDataToStream:(NSOutputStream *)aStream;
+- (void)writeData:(NSData *)value
 {
-    if(![aStream hasSpaceAvailable]) return NO;
+    NSUInteger length = [value length];
+    
+    if(length < MIN_SEGMENT_LENGTH)
+    {
+        [self writeBytes:[value bytes] ofLength:length];
+        return;
+    }
+    
+    // Copying immutable data only retains it, the segment is full so the next writes go to a new chunk
+    NSData *segmentData = [value copy];
+    
+    PSYStreamWriterChunk *chunk = malloc(sizeof(PSYStreamWriterChunk));
+    if(chunk == NULL)
+    {
+        RELEASE(segmentData);
+        [NSException raise:NSMallocException format:@"*** -[PSYStreamWriter %@]: unable to allocate a write buffer", NSStringFromSelector(_cmd)];
+    }
+    
+    chunk->next     = NULL;
+    chunk->bytes    = [segmentData bytes];
+    chunk->data     = CFRetain((__bridge CFTypeRef)segmentData);
+    chunk->start    = 0;
+    chunk->end      = length;
+    chunk->capacity = length;
+    
+    // Mutable data had to be copied
+    PSYCountQueuedBytes(counters, length, segmentData != value);
+    
+    RELEASE(segmentData);
     
     @synchronized(self)
     {
-        if(lockedQueue == nil)
+        PSYChecksumQueuedBytes(counters, chunk->bytes, length);
+        [self PSY_appendChunk:chunk];
+    }
+}
+
+// Moves the head past written bytes and returns YES if every pending chunk has been written
+- (BOOL)PSY_consumeWrittenLength:(NSUInteger)written;
+{
+    while(head != NULL)
+    {
+        NSUInteger toConsume = MIN(written, head->end - head->start);
+        
+        head->start += toConsume;
+        written     -= toConsume;
+        
+        if(head->start < head->end) return NO;
+        
+        // The last buffer chunk is rewound and stays in place for the next writes
+        if(head == tail && head->data == NULL)
         {
-            writeLocation = 0;
-            lockedQueue   = [pendingQueue copy];
-            RELEASE(pendingQueue);
+            head->start = head->end = 0;
+            return YES;
         }
+        
+        PSYStreamWriterChunk *finished = head;
+        head = head->next;
+        if(head == NULL) tail = NULL;
+        
+        [self PSY_recycleChunk:finished];
+    }
     
-        NSUInteger length  = [lockedQueue length];
-        NSInteger  toWrite = length - writeLocation;
+    return YES;
+}
+
+- (BOOL)PSY_writeDataToFileDescriptor:(int)fileDescriptor;
+{
+    while(head != NULL)
+    {
+        struct iovec vectors[MAX_IOVEC_COUNT];
+        int          count = 0;
+        NSUInteger   total = 0;
         
-        if(toWrite <= 0)
+        for(PSYStreamWriterChunk *chunk = head; chunk != NULL && count < MAX_IOVEC_COUNT; chunk = chunk->next)
         {
-            RELEASE(lockedQueue);
-            writeLocation = 0;
-            return YES;
+            if(chunk->end == chunk->start) continue;
+            
+            vectors[count].iov_base = (void *)(chunk->bytes + chunk->start);
+            vectors[count].iov_len  = chunk->end - chunk->start;
+            total += vectors[count].iov_len;
+            count++;
         }
         
-        const uint8_t *buffer  = [lockedQueue bytes];
-        NSInteger      written = [aStream write:buffer + writeLocation maxLength:toWrite];
+        if(count == 0) return [self PSY_consumeWrittenLength:0];
+        
+        ssize_t written = writev(fileDescriptor, vectors, count);
+        PSYCountWrite(counters, written, total);
+        
+        if(written < 0 && errno == EINTR) continue;
         
         if(written < 0)
         {
-            // TODO: Error handling here!
+            // A full descriptor waits for the next space available event, other errors are reported
+            if(errno != EAGAIN && errno != EWOULDBLOCK) [self PSY_reportErrorNumber:errno];
+            return NO;
         }
-        else if(written == toWrite)
+        
+        if(![self PSY_consumeWrittenLength:written] && (NSUInteger)written < total) return NO;
+    }
+    
+    return YES;
+}
+
+- (BOOL)writeDataToStream:(NSOutputStream *)aStream fileDescriptor:(int)fileDescriptor;
+{
+    @synchronized(self)
+    {
+        // What the descriptor doesn't take stays queued until the stream has space available again
+        if(fileDescriptor >= 0) return [self PSY_writeDataToFileDescriptor:fileDescriptor];
+        
+        while(head != NULL)
         {
-            RELEASE(lockedQueue);
-            writeLocation = 0;
-            // This can only be called twice,
-            // 1. already lockData has been sent,
-            // 2. pendingData has been sent,
-            // 3. nothing else to send
-            return [self writeDataToStream:aStream];
+            NSUInteger toWrite = head->end - head->start;
+            
+            if(toWrite > 0)
+            {
+                if(![aStream hasSpaceAvailable]) return NO;
+                
+                NSInteger written = [aStream write:head->bytes + head->start maxLength:toWrite];
+                PSYCountWrite(counters, written, toWrite);
+                
+                if(written < 0)
+                {
+                    [self PSY_reportError:[aStream streamError]];
+                    return NO;
+                }
+                
+                if(written == 0)
+                {
+                    if([[self delegate] respondsToSelector:@selector(streamWriterDidEncounterEnd:)])
+                        [[self delegate] streamWriterDidEncounterEnd:[self PSY_rootStreamWriter]];
+                    return NO;
+                }
+                
+                if(![self PSY_consumeWrittenLength:written] && (NSUInteger)written < toWrite) return NO;
+            }
+            else if([self PSY_consumeWrittenLength:0]) break;
         }
-        else writeLocation += written;
         
-        return NO;
+        return YES;
     }
 }
 
@@ -297,7 +722,7 @@
 }
 #endif
 
-- (BOOL)writeDataToStream:(NSOutputStream *)aStream
+- (BOOL)writeDataToStream:(NSOutputStream *)aStream fileDescriptor:(int)fileDescriptor
 {
     BOOL stop = NO;
     do {
@@ -314,44 +739,83 @@
             helper = RETAIN([helperQueue objectAtIndex:0]);
         }
         
-        if([helper writeDataToStream:aStream])
-            @synchronized(self) { [helperQueue removeObjectAtIndex:0]; }
+        BOOL drained = NO;
+        
+        if([helper writeDataToStream:aStream fileDescriptor:fileDescriptor])
+        {
+            @synchronized(self)
+            {
+                // A data unit at the end of the queue is kept so its buffer is reused by the next writes
+                if([helperQueue count] == 1 && [helper isKindOfClass:[PSYStreamWriterHelperUnit class]])
+                    drained = YES;
+                else
+                    [helperQueue removeObjectAtIndex:0];
+            }
+        }
         else
             stop = YES;
         
         RELEASE(helper);
+        
+        if(drained)
+        {
+            if(completionBlock != nil) completionBlock();
+            return YES;
+        }
     } while(!stop);
     
     return NO;
 }
 
-- (void)writeBytes:(const uint8_t *)buffer ofLength:(NSUInteger)length
+- (void)PSY_queueHelper:(PSYStreamWriterHelper *)helper;
+{
+    @synchronized(self)
+    {
+        [helperQueue addObject:helper];
+        PSY_RAISE_HIGH_WATER_MARK(counters, queueDepthHighWaterMark, [helperQueue count]);
+    }
+}
+
+// Returns the unit at the end of the queue, retained, a new one is queued if the last helper isn't a unit
+- (PSYStreamWriterHelperUnit *)PSY_retainedLastUnit;
 {
-    PSYStreamWriterHelperUnit *writer = nil;
     @synchronized(self)
     {
         PSYStreamWriterHelperUnit *temp = RETAIN([helperQueue lastObject]);
         if(![temp isKindOfClass:[PSYStreamWriterHelperUnit class]])
         {
             RELEASE(temp);
-            temp = [[PSYStreamWriterHelperUnit alloc] init];
-            [helperQueue addObject:temp];
+            temp = [[PSYStreamWriterHelperUnit alloc] initWithParentStreamWriter:self];
+            [self PSY_queueHelper:temp];
         }
         
-        writer = temp;
+        return temp;
     }
+}
+
+- (void)writeBytes:(const uint8_t *)buffer ofLength:(NSUInteger)length
+{
+    PSYStreamWriterHelperUnit *writer = [self PSY_retainedLastUnit];
     
     [writer writeBytes:buffer ofLength:length];
     RELEASE(writer);
 }
 
+- (void)writeData:(NSData *)value
+{
+    PSYStreamWriterHelperUnit *writer = [self PSY_retainedLastUnit];
+    
+    [writer writeData:value];
+    RELEASE(writer);
+}
+
 - (void)groupWrites:(void (^)(PSYStreamWriter *))writes completion:(void (^)(void))completion
 {
     if(writes == nil) return;
     
     PSYStreamWriterHelperGroup *group = [[PSYStreamWriterHelperGroup alloc] initWithParentStreamWriter:self completionBlock:completion];
     
-    @synchronized(self) { [helperQueue addObject:group]; }
+    [self PSY_queueHelper:group];
     
     writes(group);
     RELEASE(group);
@@ -363,7 +827,7 @@
     
     PSYStreamWriterHelperInputStream *writer = [[PSYStreamWriterHelperInputStream alloc] initWithInputStream:aStream parentStreamWriter:self completionBlock:completion];
     
-    @synchronized(self) { [helperQueue addObject:writer]; }
+    [self PSY_queueHelper:writer];
     
     RELEASE(writer);
 }
@@ -428,6 +892,11 @@
     [[self parentStreamWriter] writeBytes:buffer ofLength:length];
 }
 
+- (void)writeData:(NSData *)value;
+{
+    [[self parentStreamWriter] writeData:value];
+}
+
 // Returns YES if we can continue to read more data
 - (BOOL)PSY_readDataBuffer;
 {
@@ -443,10 +912,10 @@
     return read == BUFFER_SIZE;
 }
 
-- (BOOL)writeDataToStream:(NSOutputStream *)aStream;
+- (BOOL)writeDataToStream:(NSOutputStream *)aStream fileDescriptor:(int)fileDescriptor;
 {
     //Write whatever we already accumulated
-    BOOL finished = [dataHelper writeDataToStream:aStream];
+    BOOL finished = [dataHelper writeDataToStream:aStream fileDescriptor:fileDescriptor];
     
     // The helper couldn't write everything it stored, stop here
     if(!finished) return NO;
@@ -489,7 +958,7 @@
         [self PSY_readDataBuffer];
         
         // Attempt to write the data, if return NO we're done for now
-        continueReading = [dataHelper writeDataToStream:aStream];
+        continueReading = [dataHelper writeDataToStream:aStream fileDescriptor:fileDescriptor];
     }
     
     return NO;
@@ -509,3 +978,6 @@
 }
 
 @end
+
+@implementation PSYStreamWriterCounters
+@end
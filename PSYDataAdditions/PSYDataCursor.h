@@ -0,0 +1,170 @@
+/*
+ PSYDataCursor.h
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+#import "PSYDataScanner.h"
+#import "PSYVarint.h"
+
+// A cursor reads directly from the bytes of a scanner without sending any message,
+// each read is a bounds check, a load and a byte swap
+// The cursor covers a window of the scanned data starting at the scan location of the scanner,
+// for a file handle scanner that window is the part of the file currently cached
+// The scanner must not be used until the cursor is released with -releaseCursor:,
+// which moves its scan location after the bytes read with the cursor
+typedef struct _PSYDataCursor
+{
+    const uint8_t                      *start;
+    const uint8_t                      *current;
+    const uint8_t                      *end;
+    unsigned long long                  startLocation;
+    __unsafe_unretained PSYDataScanner *scanner;
+} PSYDataCursor;
+
+@interface PSYDataScanner (PSYDataCursor)
+
+// The window contains at least minimumLength bytes unless the data ends before
+- (PSYDataCursor)cursorWithMinimumLength:(unsigned long long)minimumLength;
+- (void)releaseCursor:(PSYDataCursor *)cursor;
+
+@end
+
+static inline NSUInteger PSYDataCursorRemainingLength(const PSYDataCursor *cursor)
+{
+    return (NSUInteger)(cursor->end - cursor->current);
+}
+
+static inline unsigned long long PSYDataCursorLocation(const PSYDataCursor *cursor)
+{
+    return cursor->startLocation + (unsigned long long)(cursor->current - cursor->start);
+}
+
+static inline BOOL PSYDataCursorSkip(PSYDataCursor *cursor, NSUInteger length)
+{
+    if(PSYDataCursorRemainingLength(cursor) < length) return NO;
+    
+    cursor->current += length;
+    return YES;
+}
+
+static inline BOOL PSYDataCursorReadBytes(PSYDataCursor *cursor, void *buffer, NSUInteger length)
+{
+    if(PSYDataCursorRemainingLength(cursor) < length) return NO;
+    
+    if(buffer != NULL) memcpy(buffer, cursor->current, length);
+    
+    cursor->current += length;
+    return YES;
+}
+
+#define PSY_NO_SWAP(value) (value)
+
+#define PSY_CURSOR_READ_METHOD(name, type, rawType, swap)                       \
+static inline BOOL PSYDataCursorRead ## name(PSYDataCursor *cursor, type *value) \
+{                                                                               \
+    if(PSYDataCursorRemainingLength(cursor) < sizeof(rawType)) return NO;       \
+                                                                                \
+    if(value != NULL)                                                           \
+    {                                                                           \
+        rawType raw;                                                            \
+        memcpy(&raw, cursor->current, sizeof(raw));                             \
+        *value = (type)swap(raw);                                               \
+    }                                                                           \
+                                                                                \
+    cursor->current += sizeof(rawType);                                         \
+    return YES;                                                                 \
+}
+
+PSY_CURSOR_READ_METHOD(Int8, uint8_t, uint8_t, PSY_NO_SWAP)
+
+PSY_CURSOR_READ_METHOD(LittleEndianInt16, uint16_t, uint16_t, CFSwapInt16LittleToHost)
+PSY_CURSOR_READ_METHOD(LittleEndianInt32, uint32_t, uint32_t, CFSwapInt32LittleToHost)
+PSY_CURSOR_READ_METHOD(LittleEndianInt64, uint64_t, uint64_t, CFSwapInt64LittleToHost)
+
+PSY_CURSOR_READ_METHOD(BigEndianInt16, uint16_t, uint16_t, CFSwapInt16BigToHost)
+PSY_CURSOR_READ_METHOD(BigEndianInt32, uint32_t, uint32_t, CFSwapInt32BigToHost)
+PSY_CURSOR_READ_METHOD(BigEndianInt64, uint64_t, uint64_t, CFSwapInt64BigToHost)
+
+PSY_CURSOR_READ_METHOD(SInt8, int8_t, uint8_t, PSY_NO_SWAP)
+
+PSY_CURSOR_READ_METHOD(LittleEndianSInt16, int16_t, uint16_t, CFSwapInt16LittleToHost)
+PSY_CURSOR_READ_METHOD(LittleEndianSInt32, int32_t, uint32_t, CFSwapInt32LittleToHost)
+PSY_CURSOR_READ_METHOD(LittleEndianSInt64, int64_t, uint64_t, CFSwapInt64LittleToHost)
+
+PSY_CURSOR_READ_METHOD(BigEndianSInt16, int16_t, uint16_t, CFSwapInt16BigToHost)
+PSY_CURSOR_READ_METHOD(BigEndianSInt32, int32_t, uint32_t, CFSwapInt32BigToHost)
+PSY_CURSOR_READ_METHOD(BigEndianSInt64, int64_t, uint64_t, CFSwapInt64BigToHost)
+
+// Floating point values in the byte order of the processor
+PSY_CURSOR_READ_METHOD(Float, float, float, PSY_NO_SWAP)
+PSY_CURSOR_READ_METHOD(Double, double, double, PSY_NO_SWAP)
+
+PSY_CURSOR_READ_METHOD(SwappedFloat, float, CFSwappedFloat32, CFConvertFloatSwappedToHost)
+PSY_CURSOR_READ_METHOD(SwappedDouble, double, CFSwappedFloat64, CFConvertDoubleSwappedToHost)
+
+#undef PSY_CURSOR_READ_METHOD
+
+// Varints are decoded like the matching PSYDataScanner methods,
+// a varint that does not end within the window is not read
+#define PSY_CURSOR_VARINT_METHOD(name, type, size, transform)                    \
+static inline BOOL PSYDataCursorRead ## name(PSYDataCursor *cursor, type *value) \
+{                                                                                \
+    uint ## size ## _t raw       = 0;                                            \
+    NSUInteger         remaining = PSYDataCursorRemainingLength(cursor);         \
+    NSUInteger         read      = PSYDecodeVarint ## size(cursor->current,      \
+                                                           remaining, &raw);     \
+    if(read == 0) return NO;                                                     \
+                                                                                 \
+    if(value != NULL) *value = (type)transform(raw);                             \
+                                                                                 \
+    cursor->current += read;                                                     \
+    return YES;                                                                  \
+}
+
+#define PSY_LITTLE_ZIGZAG32(value) PSYZigZagDecode32(CFSwapInt32LittleToHost(value))
+#define PSY_LITTLE_ZIGZAG64(value) PSYZigZagDecode64(CFSwapInt64LittleToHost(value))
+#define PSY_BIG_ZIGZAG32(value)    PSYZigZagDecode32(CFSwapInt32BigToHost(value))
+#define PSY_BIG_ZIGZAG64(value)    PSYZigZagDecode64(CFSwapInt64BigToHost(value))
+
+PSY_CURSOR_VARINT_METHOD(LittleEndianVarint32, uint32_t, 32, CFSwapInt32LittleToHost)
+PSY_CURSOR_VARINT_METHOD(LittleEndianVarint64, uint64_t, 64, CFSwapInt64LittleToHost)
+PSY_CURSOR_VARINT_METHOD(BigEndianVarint32, uint32_t, 32, CFSwapInt32BigToHost)
+PSY_CURSOR_VARINT_METHOD(BigEndianVarint64, uint64_t, 64, CFSwapInt64BigToHost)
+
+PSY_CURSOR_VARINT_METHOD(LittleEndianSVarint32, int32_t, 32, CFSwapInt32LittleToHost)
+PSY_CURSOR_VARINT_METHOD(LittleEndianSVarint64, int64_t, 64, CFSwapInt64LittleToHost)
+PSY_CURSOR_VARINT_METHOD(BigEndianSVarint32, int32_t, 32, CFSwapInt32BigToHost)
+PSY_CURSOR_VARINT_METHOD(BigEndianSVarint64, int64_t, 64, CFSwapInt64BigToHost)
+
+PSY_CURSOR_VARINT_METHOD(LittleEndianZigZagVarint32, int32_t, 32, PSY_LITTLE_ZIGZAG32)
+PSY_CURSOR_VARINT_METHOD(LittleEndianZigZagVarint64, int64_t, 64, PSY_LITTLE_ZIGZAG64)
+PSY_CURSOR_VARINT_METHOD(BigEndianZigZagVarint32, int32_t, 32, PSY_BIG_ZIGZAG32)
+PSY_CURSOR_VARINT_METHOD(BigEndianZigZagVarint64, int64_t, 64, PSY_BIG_ZIGZAG64)
+
+#undef PSY_LITTLE_ZIGZAG32
+#undef PSY_LITTLE_ZIGZAG64
+#undef PSY_BIG_ZIGZAG32
+#undef PSY_BIG_ZIGZAG64
+#undef PSY_CURSOR_VARINT_METHOD
+#undef PSY_NO_SWAP
@@ -0,0 +1,58 @@
+/*
+ PSYDataCursor.m
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import "PSYDataCursor.h"
+#import "PSYDataScanner_Private.h"
+
+@implementation PSYDataScanner (PSYDataCursor)
+
+- (PSYDataCursor)cursorWithMinimumLength:(unsigned long long)minimumLength;
+{
+    unsigned long long  available = 0;
+    unsigned long long  loc       = [self scanLocation];
+    const uint8_t      *bytes     = [self PSY_bytesAtScanLocationWithMinimumLength:minimumLength availableLength:&available];
+    
+    // The window of a cursor is addressed with pointers, it can't be larger than the address space
+    available = MIN(available, (unsigned long long)NSUIntegerMax);
+    
+    return (PSYDataCursor){
+        .start         = bytes,
+        .current       = bytes,
+        .end           = bytes + (NSUInteger)available,
+        .startLocation = loc,
+        .scanner       = self,
+    };
+}
+
+- (void)releaseCursor:(PSYDataCursor *)cursor;
+{
+    if(cursor == NULL || cursor->scanner != self) return;
+    
+    if(cursor->current != cursor->start) [self setScanLocation:PSYDataCursorLocation(cursor)];
+    
+    *cursor = (PSYDataCursor){ 0 };
+}
+
+@end
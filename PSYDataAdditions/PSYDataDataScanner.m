@@ -24,7 +24,10 @@
  */
 
 #import "PSYDataDataScanner.h"
+#import "PSYDataScanner_Private.h"
 #import "PSYUtilities.h"
+#import "PSYDataSearch.h"
+#import "PSYMappedFileScanner.h"
 
 @implementation PSYDataDataScanner
 @synthesize data = _scannedData, scanLocation = _scanLocation, dataLength = _dataLength;
@@ -61,15 +64,49 @@
     if(value > [_scannedData length])
         [NSException raise:NSRangeException format:@"*** -[PSYDataScanner setScanLocation:]: Range or index out of bounds"];
     
+    if(value > _scanLocation)
+    {
+        PSYDataScannerCount(bytesScanned, value - _scanLocation);
+        PSYDataScannerChecksum(_scanLocation, (const uint8_t *)[_scannedData bytes] + _scanLocation, value - _scanLocation);
+    }
+    
     _scanLocation = value;
 }
 
+// Subdata of a mapping are slices of it, other data copy their bytes
+- (NSData *)PSY_subdataWithRange:(NSRange)range;
+{
+    if(_statistics != NULL && ![_scannedData isKindOfClass:[PSYMappedData class]]) _statistics->bytesCopied += range.length;
+    
+    return [_scannedData subdataWithRange:range];
+}
+
+- (PSYDataScanner *)scannerByCloningAtLocation:(unsigned long long)location
+{
+    PSYDataDataScanner *clone = [[[self class] alloc] initWithData:_scannedData];
+    [clone setScanLocation:location];
+    [clone setStringInterningCapacity:[self stringInterningCapacity]];
+    
+    return AUTORELEASE(clone);
+}
+
+- (NSData *)PSY_dataForEnumeration;
+{
+    return _scannedData;
+}
+
+- (const uint8_t *)PSY_bytesAtScanLocationWithMinimumLength:(unsigned long long)minimumLength availableLength:(unsigned long long *)availableLength;
+{
+    *availableLength = _dataLength - _scanLocation;
+    return (const uint8_t *)[_scannedData bytes] + _scanLocation;
+}
+
 - (BOOL)scanData:(NSData **)data ofLength:(unsigned long long)length
 {
     unsigned long long loc = [self scanLocation];
     if(loc + length > [self dataLength]) return NO;
     
-    if(data != NULL) *data = [[self data] subdataWithRange:NSMakeRange(loc, length)];
+    if(data != NULL) *data = [self PSY_subdataWithRange:NSMakeRange(loc, length)];
     
     [self setScanLocation:loc + length];
     
@@ -83,7 +120,7 @@
     
     if(length > 0)
     {
-        NSData *subdata = [_scannedData subdataWithRange:NSMakeRange(_scanLocation, length)];
+        NSData *subdata = [self PSY_subdataWithRange:NSMakeRange(_scanLocation, length)];
         
         if([subdata isEqualToData:data])
         {
@@ -103,6 +140,15 @@
 }
 
 - (BOOL)scanUpToData:(NSData *)stopData intoData:(NSData **)dataValue options:(PSYDataScannerOptions)options;
+{
+    unsigned long long loc = _scanLocation;
+    
+    return [self PSY_scanUpToData:stopData options:options bytesHandler:dataValue == NULL ? nil : ^(const uint8_t *bytes, NSUInteger length) {
+        *dataValue = [self PSY_subdataWithRange:NSMakeRange(loc, length)];
+    }];
+}
+
+- (BOOL)PSY_scanUpToData:(NSData *)stopData options:(PSYDataScannerOptions)options bytesHandler:(void (^)(const uint8_t *bytes, NSUInteger length))bytesHandler;
 {
     unsigned long long length = [stopData length];
     
@@ -113,58 +159,39 @@
     else
     {
         const unsigned char *scannedBuffer = [_scannedData bytes];
-        const unsigned char *stopBuffer    = [stopData bytes];
-        unsigned long long   stopLoc       = 0;
+        NSUInteger           found         = PSYFindBytes(scannedBuffer + _scanLocation, (NSUInteger)(_dataLength - _scanLocation), [stopData bytes], (NSUInteger)length);
         
-        for(unsigned long long scannedLoc = _scanLocation; scannedLoc + (length - stopLoc) <= _dataLength; scannedLoc++)
-        {
-            // If the current stopBuffer byte is equal to the current scanned byte,
-            // increment the stop location to scan check the next bytes in both buffer
-            // otherwise, reset the stop location so the next scanned byte is compared with the first stop byte
-            if(scannedBuffer[scannedLoc] == stopBuffer[stopLoc])
-                stopLoc++;
-            else
-            {
-                dataLocation.location = scannedLoc + 1;
-                stopLoc = 0;
-            }
-            
-            // If the stop location is equal to the length of the stopData
-            // it means we fully matched the data, break out of the loop
-            if(stopLoc >= length)
-            {
-                dataLocation.length = length;
-                break;
-            }
-        }
-        
-        if(stopLoc < length) dataLocation.location = _dataLength;
+        if(found != NSNotFound) dataLocation = NSMakeRange(_scanLocation + found, length);
+        else                    dataLocation.location = _dataLength;
     }
     
     if((options & PSYDataScannerRequireStopData) && dataLocation.length != length) return NO;
     else if(!(options & PSYDataScannerRequireStopData) && dataLocation.location == _scanLocation) return NO;
     
-    if(dataValue != NULL) *dataValue = [[self data] subdataWithRange:NSMakeRange(_scanLocation, dataLocation.location - _scanLocation)];
+    if(bytesHandler != nil) bytesHandler((const uint8_t *)[_scannedData bytes] + _scanLocation, dataLocation.location - _scanLocation);
     
-    _scanLocation = (options & PSYDataScannerMoveAfterStopData ? NSMaxRange(dataLocation) : dataLocation.location);
+    unsigned long long location = (options & PSYDataScannerMoveAfterStopData ? NSMaxRange(dataLocation) : dataLocation.location);
+    
+    PSYDataScannerCount(bytesScanned, location - _scanLocation);
+    PSYDataScannerChecksum(_scanLocation, (const uint8_t *)[_scannedData bytes] + _scanLocation, location - _scanLocation);
+    _scanLocation = location;
     
     return YES;
 }
 
 - (BOOL)scanNullTerminatedString:(NSString **)value withEncoding:(NSStringEncoding)encoding;
 {
-    NSData *terminator = PSYNullTerminatorDataForEncoding(encoding);
-    
-    NSRange termRange = [_scannedData rangeOfData:terminator options:0 range:NSMakeRange(_scanLocation, [_scannedData length] - _scanLocation)];
+    NSUInteger width = [PSYNullTerminatorDataForEncoding(encoding) length];
+    NSUInteger found = PSYFindNullTerminator((const uint8_t *)[_scannedData bytes] + _scanLocation, (NSUInteger)(_dataLength - _scanLocation), width);
     
-    if(termRange.location != NSNotFound)
+    if(found != NSNotFound)
     {
-        if(value != NULL)
-        {
-            NSData *subData = [_scannedData subdataWithRange:NSMakeRange(_scanLocation, termRange.location - _scanLocation)];
-            *value = AUTORELEASE([[NSString alloc] initWithData:subData encoding:encoding]);
-        }
+        NSRange termRange = NSMakeRange(_scanLocation + found, width);
+        
+        if(value != NULL) *value = [self PSY_stringWithBytes:(const uint8_t *)[_scannedData bytes] + _scanLocation length:termRange.location - _scanLocation encoding:encoding];
         
+        PSYDataScannerCount(bytesScanned, NSMaxRange(termRange) - _scanLocation);
+        PSYDataScannerChecksum(_scanLocation, (const uint8_t *)[_scannedData bytes] + _scanLocation, NSMaxRange(termRange) - _scanLocation);
         _scanLocation = NSMaxRange(termRange);
         return YES;
     }
@@ -24,6 +24,8 @@
  */
 
 #import <Foundation/Foundation.h>
+#import "PSYCompression.h"
+#import "PSYChecksum.h"
 
 typedef enum _PSYDataScannerLocation
 {
@@ -38,6 +40,30 @@ typedef enum _PSYDataScannerOptions
     PSYDataScannerMoveAfterStopData = 0x2
 } PSYDataScannerOptions;
 
+typedef enum _PSYDataScannerEnumerationOptions
+{
+    PSYDataScannerEnumerationConcurrent      = 0x1,
+    PSYDataScannerEnumerationPreservingOrder = 0x2
+} PSYDataScannerEnumerationOptions;
+
+// Counters of a scanner that collects statistics, the scanners that don't read
+// a file or a stream leave the read counters at 0
+typedef struct _PSYDataScannerStatistics
+{
+    unsigned long long bytesScanned;    // bytes the scan location moved forward over
+    unsigned long long bytesCopied;     // bytes copied into scanned data or to keep the cache contiguous
+    unsigned long long bytesRead;       // bytes read from the file or the stream by the scanner
+    unsigned long long refillCount;     // times the scanner had to read more bytes to scan
+    unsigned long long readCount;       // read system calls, including the ones done ahead of the scanner
+    unsigned long long cacheHitCount;   // blocks found in the block cache
+    unsigned long long cacheMissCount;  // blocks read from the file
+    unsigned long long stringHitCount;  // scanned strings found in the string interning cache
+    unsigned long long stringMissCount; // scanned strings created and added to the string interning cache
+} PSYDataScannerStatistics;
+
+// Longest string in bytes that the string interning cache of a scanner keeps
+#define PSYDataScannerInternedStringMaximumLength 48
+
 @interface PSYDataScanner : NSObject
 
 + (id)scannerWithData:(NSData *)dataToScan;
@@ -46,12 +72,93 @@ typedef enum _PSYDataScannerOptions
 + (id)scannerWithFileHandle:(NSFileHandle *)fileToScan;
 - (id)initWithFileHandle:(NSFileHandle *)fileToScan;
 
+// Reads the file ahead with pread on a background queue while the bytes already read are scanned,
+// depth windows of windowSize bytes are kept in flight, 0 picks the default values
+// The buffers are recycled, the scanner swaps them with its cache instead of copying them
++ (id)scannerWithFileHandle:(NSFileHandle *)fileToScan readAheadWindowSize:(NSUInteger)windowSize depth:(NSUInteger)depth;
+- (id)initWithFileHandle:(NSFileHandle *)fileToScan readAheadWindowSize:(NSUInteger)windowSize depth:(NSUInteger)depth;
+
+// Keeps the blocks of the file in a least recently used cache of memoryBudget bytes,
+// seeking back into a block still in the cache doesn't read it again, 0 picks the default values
+// The cache points directly into the blocks, bytes are only copied when a scan straddles two blocks
++ (id)scannerWithFileHandle:(NSFileHandle *)fileToScan blockSize:(NSUInteger)blockSize memoryBudget:(NSUInteger)memoryBudget;
+- (id)initWithFileHandle:(NSFileHandle *)fileToScan blockSize:(NSUInteger)blockSize memoryBudget:(NSUInteger)memoryBudget;
+
+// Maps the file in memory, data scanned from the file are not copied
++ (id)scannerWithContentsOfMappedFile:(NSString *)path;
+- (id)initWithContentsOfMappedFile:(NSString *)path;
+
+// Scans a pipe or a socket without ever blocking, the handle's descriptor is made non-blocking
+// The data is kept in a ring buffer of capacity bytes, rounded up to a power of two,
+// so a single scan can't be longer than the capacity
+// Handles that can't seek get such a scanner from +scannerWithFileHandle: too
++ (id)scannerWithStreamFileHandle:(NSFileHandle *)fileToScan bufferCapacity:(NSUInteger)capacity;
+- (id)initWithStreamFileHandle:(NSFileHandle *)fileToScan bufferCapacity:(NSUInteger)capacity;
+
+// Scans the decompressed bytes of a compressed pipe, socket or file like a stream scanner,
+// -readAvailableData inflates what the descriptor has into the ring buffer
++ (id)scannerWithCompressedFileHandle:(NSFileHandle *)fileToScan format:(PSYCompressionFormat)format bufferCapacity:(NSUInteger)capacity;
+- (id)initWithCompressedFileHandle:(NSFileHandle *)fileToScan format:(PSYCompressionFormat)format bufferCapacity:(NSUInteger)capacity;
+
 @property(readonly, copy, nonatomic) NSData             *data;
 @property(readonly, nonatomic)       unsigned long long  dataLength;
 @property(nonatomic)                 unsigned long long  scanLocation;
 
 - (BOOL)isAtEnd;
 
+// Returns a new scanner of the same data with its own scan location set to location,
+// or nil if the scanner can't be cloned, like the scanners of pipes and sockets
+// The file-handle scanners never move the offset of their handle, they read with pread,
+// so a scanner and its clones can be used from different threads at the same time,
+// they share the file descriptor and the block cache, the lookups in the cache are synchronized
+- (PSYDataScanner *)scannerByCloningAtLocation:(unsigned long long)location;
+
+// Stream scanners only see the bytes read with -readAvailableData,
+// call it when the descriptor is readable, from a dispatch read source for instance
+// Returns the number of bytes read, 0 if nothing could be read and -1 on error
+// Other scanners read their data as needed and return 0
+- (NSInteger)readAvailableData;
+
+// YES if the last scan failed because the bytes it needs haven't been read yet,
+// the scan may succeed after -readAvailableData, it is always NO for other scanners
+@property(readonly, nonatomic) BOOL needsMoreData;
+
+// Number of read-ahead windows the scanner went through, and how many times and how long
+// it had to wait for a window that wasn't read yet, always 0 for scanners that don't read ahead
+@property(readonly, nonatomic) NSUInteger     readAheadWindowCount;
+@property(readonly, nonatomic) NSUInteger     readAheadWaitCount;
+@property(readonly, nonatomic) NSTimeInterval readAheadWaitDuration;
+
+// Number of blocks found in the block cache and read from the file,
+// always 0 for scanners that don't use a block cache
+@property(readonly, nonatomic) NSUInteger     blockCacheHitCount;
+@property(readonly, nonatomic) NSUInteger     blockCacheMissCount;
+
+// The statistics are only counted while collectsStatistics is YES, otherwise
+// the scanner only tests whether it collects them, turning it off resets the counters
+@property(nonatomic)           BOOL                     collectsStatistics;
+@property(readonly, nonatomic) PSYDataScannerStatistics statistics;
+
+- (void)resetStatistics;
+
+// Running checksum of the scanned bytes, PSYChecksumNone, the default, doesn't compute any
+// The bytes are added as the scan location moves past them, those skipped by -setScanLocation:
+// included, and bytes scanned again after a rollback aren't added twice
+// Setting the algorithm or -resetChecksum starts a new checksum at the scan location,
+// usually at a frame boundary, to compare the checksum with the one at the end of the frame
+@property(nonatomic)           PSYChecksumAlgorithm     checksumAlgorithm;
+@property(readonly, nonatomic) uint32_t                 checksum;
+
+- (void)resetChecksum;
+
+// Scanned strings are decoded from the bytes of the scanner without an intermediate data
+// A scanner with a stringInterningCapacity keeps up to that many strings of at most
+// PSYDataScannerInternedStringMaximumLength bytes, keyed by their bytes and encoding,
+// scanning the same bytes again returns the same string without allocating anything
+// The cache is direct mapped, a string replaces the one with the same slot, it should be
+// a few times larger than the number of recurring strings, 0, the default, disables it
+@property(nonatomic)           NSUInteger               stringInterningCapacity;
+
 // Returns NO if the computed range is outside of the range of the data
 - (BOOL)setScanLocation:(NSInteger)relativeLocation relativeTo:(PSYDataScannerLocation)startPoint;
 
@@ -93,6 +200,26 @@ typedef enum _PSYDataScannerOptions
 - (BOOL)scanBigEndianZigZagVarint32:(int32_t *)value;
 - (BOOL)scanBigEndianZigZagVarint64:(int64_t *)value;
 
+// Scan count consecutive varints, values can be NULL to skip them
+// If count varints cannot be scanned, NO is returned and the scan location is left unchanged
+- (BOOL)scanLittleEndianVarint32Array:(uint32_t *)values count:(NSUInteger)count;
+- (BOOL)scanLittleEndianVarint64Array:(uint64_t *)values count:(NSUInteger)count;
+
+- (BOOL)scanBigEndianVarint32Array:(uint32_t *)values count:(NSUInteger)count;
+- (BOOL)scanBigEndianVarint64Array:(uint64_t *)values count:(NSUInteger)count;
+
+- (BOOL)scanLittleEndianSVarint32Array:(int32_t *)values count:(NSUInteger)count;
+- (BOOL)scanLittleEndianSVarint64Array:(int64_t *)values count:(NSUInteger)count;
+
+- (BOOL)scanBigEndianSVarint32Array:(int32_t *)values count:(NSUInteger)count;
+- (BOOL)scanBigEndianSVarint64Array:(int64_t *)values count:(NSUInteger)count;
+
+- (BOOL)scanLittleEndianZigZagVarint32Array:(int32_t *)values count:(NSUInteger)count;
+- (BOOL)scanLittleEndianZigZagVarint64Array:(int64_t *)values count:(NSUInteger)count;
+
+- (BOOL)scanBigEndianZigZagVarint32Array:(int32_t *)values count:(NSUInteger)count;
+- (BOOL)scanBigEndianZigZagVarint64Array:(int64_t *)values count:(NSUInteger)count;
+
 // These methods scan floating point values depending on the architecture of your processor
 // they're usually not appropriate for network transmission
 - (BOOL)scanFloat:(float *)value;
@@ -101,15 +228,61 @@ typedef enum _PSYDataScannerOptions
 - (BOOL)scanSwappedFloat:(float *)value;
 - (BOOL)scanSwappedDouble:(double *)value;
 
+// Scan count consecutive values, values can be NULL to skip them
+// If count values cannot be scanned, NO is returned and the scan location is left unchanged
+- (BOOL)scanInt8Array:(uint8_t *)values count:(NSUInteger)count;
+
+- (BOOL)scanLittleEndianInt16Array:(uint16_t *)values count:(NSUInteger)count;
+- (BOOL)scanLittleEndianInt32Array:(uint32_t *)values count:(NSUInteger)count;
+- (BOOL)scanLittleEndianInt64Array:(uint64_t *)values count:(NSUInteger)count;
+
+- (BOOL)scanBigEndianInt16Array:(uint16_t *)values count:(NSUInteger)count;
+- (BOOL)scanBigEndianInt32Array:(uint32_t *)values count:(NSUInteger)count;
+- (BOOL)scanBigEndianInt64Array:(uint64_t *)values count:(NSUInteger)count;
+
+- (BOOL)scanSInt8Array:(int8_t *)values count:(NSUInteger)count;
+
+- (BOOL)scanLittleEndianSInt16Array:(int16_t *)values count:(NSUInteger)count;
+- (BOOL)scanLittleEndianSInt32Array:(int32_t *)values count:(NSUInteger)count;
+- (BOOL)scanLittleEndianSInt64Array:(int64_t *)values count:(NSUInteger)count;
+
+- (BOOL)scanBigEndianSInt16Array:(int16_t *)values count:(NSUInteger)count;
+- (BOOL)scanBigEndianSInt32Array:(int32_t *)values count:(NSUInteger)count;
+- (BOOL)scanBigEndianSInt64Array:(int64_t *)values count:(NSUInteger)count;
+
+- (BOOL)scanFloatArray:(float *)values count:(NSUInteger)count;
+- (BOOL)scanDoubleArray:(double *)values count:(NSUInteger)count;
+
+- (BOOL)scanSwappedFloatArray:(float *)values count:(NSUInteger)count;
+- (BOOL)scanSwappedDoubleArray:(double *)values count:(NSUInteger)count;
+
 - (BOOL)scanData:(NSData **)data ofLength:(unsigned long long)length;
 - (BOOL)scanData:(NSData *)data intoData:(NSData **)dataValue;
 - (BOOL)scanUpToData:(NSData *)stopData intoData:(NSData **)dataValue;
 - (BOOL)scanUpToData:(NSData *)stopData intoData:(NSData **)dataValue options:(PSYDataScannerOptions)options;
+
+// Like -scanData:ofLength: and -scanUpToData:intoData:options: but *bytes points into the buffer of the scanner
+// instead of a new data, nothing is allocated or copied unless the file-handle scanner has to read more
+// The bytes stay valid until the scanner is sent another scan or its scan location is changed,
+// for a stream scanner until -readAvailableData is sent
+- (BOOL)scanBytesNoCopy:(const void **)bytes length:(NSUInteger)length;
+- (BOOL)scanUpToDataNoCopy:(NSData *)stopData bytes:(const void **)bytes length:(NSUInteger *)length options:(PSYDataScannerOptions)options;
 - (BOOL)scanString:(NSString **)value ofLength:(unsigned long long)length usingEncoding:(NSStringEncoding)encoding;
 - (BOOL)scanUpToString:(NSString *)stopString intoString:(NSString **)value usingEncoding:(NSStringEncoding)encoding;
 - (BOOL)scanUpToString:(NSString *)stopString intoString:(NSString **)value usingEncoding:(NSStringEncoding)encoding options:(PSYDataScannerOptions)options;
 - (BOOL)scanNullTerminatedString:(NSString **)value withEncoding:(NSStringEncoding)encoding;
 
+// Calls block with each record from the scan location to the end of the data, the records are
+// the bytes between the separators, an empty record after the last separator is not enumerated
+// The records are slices of the scanned data, the file-handle scanner maps its file to slice it,
+// other scanners scan the records one after the other, the scan location is left unchanged
+// With PSYDataScannerEnumerationConcurrent the data is split in ranges that start after
+// the first separator they contain, which are searched on all cores and the block is called
+// concurrently, with PSYDataScannerEnumerationPreservingOrder too it is called on the calling
+// thread in the order of the records while the following ranges are searched
+// The ranges can only be resynchronized on separators that can't overlap themselves
+- (void)enumerateRecordsSeparatedByData:(NSData *)separator options:(PSYDataScannerEnumerationOptions)options usingBlock:(void (^)(NSData *record, unsigned long long location, BOOL *stop))block;
+
 @end
 
 NSData *PSYNullTerminatorDataForEncoding(NSStringEncoding encoding);
@@ -24,11 +24,137 @@
  */
 
 #import "PSYDataScanner.h"
+#import "PSYDataScanner_Private.h"
 #import "PSYUtilities.h"
+#import "PSYVarint.h"
+#import "PSYByteSwap.h"
+#import "PSYDataSlice.h"
+#import "PSYDataSearch.h"
+
+// Bounds of the length of the ranges searched concurrently for records
+#define MIN_PARTITION_LENGTH (1024 * 64)
+#define MAX_PARTITION_LENGTH (1024 * 1024 * 16)
+
+#define PARTITIONS_PER_CORE 4
+
+typedef struct _PSYInternedString
+{
+    NSUInteger        hash;
+    NSUInteger        length;
+    NSStringEncoding  encoding;
+    NSString         *string; // retained, nil for an empty slot
+    uint8_t           bytes[PSYDataScannerInternedStringMaximumLength];
+} PSYInternedString;
+
+// Direct-mapped table of the strings interned by a scanner
+typedef struct _PSYInternedStringTable
+{
+    NSUInteger         mask;
+    PSYInternedString  slots[];
+} PSYInternedStringTable;
+
+static PSYInternedStringTable *PSYCreateInternedStringTable(NSUInteger capacity)
+{
+    NSUInteger slotCount = 1;
+    while(slotCount < capacity) slotCount <<= 1;
+    
+    PSYInternedStringTable *table = calloc(1, sizeof(PSYInternedStringTable) + slotCount * sizeof(PSYInternedString));
+    if(table != NULL) table->mask = slotCount - 1;
+    
+    return table;
+}
+
+static void PSYFreeInternedStringTable(PSYInternedStringTable *table)
+{
+    if(table == NULL) return;
+    
+    for(NSUInteger i = 0; i <= table->mask; i++) RELEASE(table->slots[i].string);
+    free(table);
+}
+
+// FNV-1a of the bytes, mixed with the encoding
+static inline NSUInteger PSYHashInternedBytes(const uint8_t *bytes, NSUInteger length, NSStringEncoding encoding)
+{
+    uint64_t hash = 14695981039346656037ULL ^ encoding;
+    
+    for(NSUInteger i = 0; i < length; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    
+    return (NSUInteger)(hash ^ (hash >> 32));
+}
 
 @interface PSYPlaceholderDataScanner : PSYDataScanner
 @end
 
+// Ranges of the records found in a partition, they can be read once searched is signaled
+@interface PSYRecordPartition : NSObject
+{
+@public
+    NSMutableData        *records;
+    dispatch_semaphore_t  searched;
+}
+@end
+
+// Returns the range of the records of the partition at index out of count partitions of [start, length)
+// Partitions after the first one start after the first separator following their nominal start
+// and end on the one of the next partition, location is NSNotFound if the partition has no record
+static NSRange PSYRecordPartitionRange(const uint8_t *bytes, NSUInteger start, NSUInteger length, NSUInteger index, NSUInteger count, const void *separator, NSUInteger separatorLength)
+{
+    unsigned long long span           = length - start;
+    NSUInteger         partitionStart = start + (NSUInteger)(span * index / count);
+    NSUInteger         partitionEnd   = start + (NSUInteger)(span * (index + 1) / count);
+    
+    NSUInteger rangeStart = index == 0 ? start : partitionStart;
+    NSUInteger rangeEnd   = length;
+    
+    if(index > 0)
+    {
+        NSUInteger found = PSYFindBytes(bytes + partitionStart, length - partitionStart, separator, separatorLength);
+        rangeStart = found != NSNotFound ? partitionStart + found : length;
+    }
+    
+    if(index < count - 1)
+    {
+        NSUInteger found = PSYFindBytes(bytes + partitionEnd, length - partitionEnd, separator, separatorLength);
+        rangeEnd = found != NSNotFound ? partitionEnd + found : length;
+    }
+    
+    if(index > 0)
+    {
+        // The separator ends an earlier partition or there is none left
+        if(rangeStart >= rangeEnd) return NSMakeRange(NSNotFound, 0);
+        
+        rangeStart += separatorLength;
+    }
+    
+    return NSMakeRange(rangeStart, rangeEnd - rangeStart);
+}
+
+// Calls handler with the range of each record of range, which ends on a separator
+// unless it ends the data, an empty record at the end of the data is then skipped
+static void PSYEnumerateRecordRanges(const uint8_t *bytes, NSRange range, BOOL endsData, const void *separator, NSUInteger separatorLength, volatile BOOL *stopped, void (^handler)(NSRange record))
+{
+    NSUInteger location = range.location;
+    NSUInteger end      = NSMaxRange(range);
+    
+    while(!*stopped)
+    {
+        NSUInteger found = PSYFindBytes(bytes + location, end - location, separator, separatorLength);
+        
+        if(found == NSNotFound)
+        {
+            if(!endsData || location < end) handler(NSMakeRange(location, end - location));
+            return;
+        }
+        
+        handler(NSMakeRange(location, found));
+        location += found + separatorLength;
+    }
+}
+
 @implementation PSYDataScanner
 
 + (id)allocWithZone:(NSZone *)zone
@@ -65,6 +191,71 @@
     return nil;
 }
 
++ (id)scannerWithFileHandle:(NSFileHandle *)fileToScan readAheadWindowSize:(NSUInteger)windowSize depth:(NSUInteger)depth;
+{
+    return AUTORELEASE([[self alloc] initWithFileHandle:fileToScan readAheadWindowSize:windowSize depth:depth]);
+}
+
+- (id)initWithFileHandle:(NSFileHandle *)fileToScan readAheadWindowSize:(NSUInteger)windowSize depth:(NSUInteger)depth;
+{
+#if !__has_feature(objc_arc)
+    [self release];
+#endif
+    return nil;
+}
+
++ (id)scannerWithFileHandle:(NSFileHandle *)fileToScan blockSize:(NSUInteger)blockSize memoryBudget:(NSUInteger)memoryBudget;
+{
+    return AUTORELEASE([[self alloc] initWithFileHandle:fileToScan blockSize:blockSize memoryBudget:memoryBudget]);
+}
+
+- (id)initWithFileHandle:(NSFileHandle *)fileToScan blockSize:(NSUInteger)blockSize memoryBudget:(NSUInteger)memoryBudget;
+{
+#if !__has_feature(objc_arc)
+    [self release];
+#endif
+    return nil;
+}
+
++ (id)scannerWithContentsOfMappedFile:(NSString *)path
+{
+    return AUTORELEASE([[self alloc] initWithContentsOfMappedFile:path]);
+}
+
+- (id)initWithContentsOfMappedFile:(NSString *)path
+{
+#if !__has_feature(objc_arc)
+    [self release];
+#endif
+    return nil;
+}
+
++ (id)scannerWithStreamFileHandle:(NSFileHandle *)fileToScan bufferCapacity:(NSUInteger)capacity;
+{
+    return AUTORELEASE([[self alloc] initWithStreamFileHandle:fileToScan bufferCapacity:capacity]);
+}
+
+- (id)initWithStreamFileHandle:(NSFileHandle *)fileToScan bufferCapacity:(NSUInteger)capacity;
+{
+#if !__has_feature(objc_arc)
+    [self release];
+#endif
+    return nil;
+}
+
++ (id)scannerWithCompressedFileHandle:(NSFileHandle *)fileToScan format:(PSYCompressionFormat)format bufferCapacity:(NSUInteger)capacity;
+{
+    return AUTORELEASE([[self alloc] initWithCompressedFileHandle:fileToScan format:format bufferCapacity:capacity]);
+}
+
+- (id)initWithCompressedFileHandle:(NSFileHandle *)fileToScan format:(PSYCompressionFormat)format bufferCapacity:(NSUInteger)capacity;
+{
+#if !__has_feature(objc_arc)
+    [self release];
+#endif
+    return nil;
+}
+
 - (NSData *)data
 {
     PSYRequestConcreteImplementation([self class], _cmd, [self class] != [PSYDataScanner class]);
@@ -113,6 +304,152 @@
     return [self scanLocation] >= [self dataLength];
 }
 
+- (NSInteger)readAvailableData;
+{
+    return 0;
+}
+
+- (PSYDataScanner *)scannerByCloningAtLocation:(unsigned long long)location
+{
+    return nil;
+}
+
+- (BOOL)needsMoreData
+{
+    return NO;
+}
+
+- (void)dealloc
+{
+    free(_statistics);
+    PSYFreeInternedStringTable(_internedStrings);
+    
+#if !__has_feature(objc_arc)
+    [super dealloc];
+#endif
+}
+
+- (BOOL)collectsStatistics
+{
+    return _statistics != NULL;
+}
+
+- (void)setCollectsStatistics:(BOOL)value
+{
+    if(value == (_statistics != NULL)) return;
+    
+    if(value)
+    {
+        _statistics = calloc(1, sizeof(PSYDataScannerStatistics));
+        if(_statistics == NULL) [NSException raise:NSMallocException format:@"*** -[PSYDataScanner %@]: unable to allocate the statistics", NSStringFromSelector(_cmd)];
+    }
+    else
+    {
+        free(_statistics);
+        _statistics = NULL;
+    }
+}
+
+- (PSYDataScannerStatistics)statistics
+{
+    return _statistics != NULL ? *_statistics : (PSYDataScannerStatistics){ 0 };
+}
+
+- (void)resetStatistics;
+{
+    if(_statistics != NULL) memset(_statistics, 0, sizeof(PSYDataScannerStatistics));
+}
+
+- (PSYChecksumAlgorithm)checksumAlgorithm
+{
+    return _checksumAlgorithm;
+}
+
+- (void)setChecksumAlgorithm:(PSYChecksumAlgorithm)value
+{
+    _checksumAlgorithm = value;
+    [self resetChecksum];
+}
+
+- (uint32_t)checksum
+{
+    return _checksum;
+}
+
+- (void)resetChecksum;
+{
+    _checksum         = 0;
+    _checksumLocation = [self scanLocation];
+}
+
+- (void)PSY_updateChecksumWithBytes:(const uint8_t *)bytes length:(unsigned long long)length atLocation:(unsigned long long)location;
+{
+    if(location + length <= _checksumLocation) return;
+    
+    if(location < _checksumLocation)
+    {
+        unsigned long long skip = _checksumLocation - location;
+        bytes  += skip;
+        length -= skip;
+    }
+    
+    _checksum         = PSYCRC32CUpdate(_checksum, bytes, (size_t)length);
+    _checksumLocation = MAX(location, _checksumLocation) + length;
+}
+
+- (NSUInteger)stringInterningCapacity
+{
+    return _internedStrings != NULL ? _internedStrings->mask + 1 : 0;
+}
+
+- (void)setStringInterningCapacity:(NSUInteger)value
+{
+    PSYFreeInternedStringTable(_internedStrings);
+    _internedStrings = NULL;
+    
+    if(value == 0) return;
+    
+    _internedStrings = PSYCreateInternedStringTable(value);
+    if(_internedStrings == NULL) [NSException raise:NSMallocException format:@"*** -[PSYDataScanner %@]: unable to allocate the string cache", NSStringFromSelector(_cmd)];
+}
+
+- (NSString *)PSY_stringWithBytes:(const uint8_t *)bytes length:(NSUInteger)length encoding:(NSStringEncoding)encoding;
+{
+    if(_internedStrings == NULL || length > PSYDataScannerInternedStringMaximumLength)
+        return AUTORELEASE([[NSString alloc] initWithBytes:bytes length:length encoding:encoding]);
+    
+    NSUInteger         hash = PSYHashInternedBytes(bytes, length, encoding);
+    PSYInternedString *slot = &_internedStrings->slots[hash & _internedStrings->mask];
+    
+    if(slot->string != nil && slot->hash == hash && slot->length == length && slot->encoding == encoding && memcmp(slot->bytes, bytes, length) == 0)
+    {
+        PSYDataScannerCount(stringHitCount, 1);
+        return AUTORELEASE(RETAIN(slot->string));
+    }
+    
+    NSString *string = [[NSString alloc] initWithBytes:bytes length:length encoding:encoding];
+    
+    // Bytes that aren't valid in the encoding are not cached
+    if(string == nil) return nil;
+    
+    PSYDataScannerCount(stringMissCount, 1);
+    
+    RELEASE(slot->string);
+    slot->string   = string;
+    slot->hash     = hash;
+    slot->length   = length;
+    slot->encoding = encoding;
+    memcpy(slot->bytes, bytes, length);
+    
+    return AUTORELEASE(RETAIN(string));
+}
+
+- (NSUInteger)readAheadWindowCount      { return 0; }
+- (NSUInteger)readAheadWaitCount        { return 0; }
+- (NSTimeInterval)readAheadWaitDuration { return 0; }
+- (NSUInteger)blockCacheHitCount        { return 0; }
+- (NSUInteger)blockCacheMissCount       { return 0; }
+
 - (BOOL)scanInt8:(uint8_t *)value
 {
     unsigned long long length = sizeof(*value);
@@ -256,112 +593,67 @@
     return [self scanBigEndianInt64:(uint64_t *)value];
 }
 
-- (BOOL)scanLittleEndianVarint32:(uint32_t *)value
+- (const uint8_t *)PSY_bytesAtScanLocationWithMinimumLength:(unsigned long long)minimumLength availableLength:(unsigned long long *)availableLength;
 {
     unsigned long long loc = [self scanLocation];
     
-    uint32_t result = 0;
+    *availableLength = [self dataLength] - loc;
+    return (const uint8_t *)[[self data] bytes] + loc;
+}
+
+- (BOOL)PSY_scanVarintArray:(void *)values count:(NSUInteger)count is64Bit:(BOOL)is64Bit;
+{
+    unsigned long long loc       = [self scanLocation];
+    NSUInteger         maxLength = is64Bit ? PSYVarint64MaximumLength : PSYVarint32MaximumLength;
+    NSUInteger         decoded   = 0;
     
-    for(uint8_t shift = 0; shift < 32; shift += 7)
+    while(decoded < count)
     {
-        uint8_t currentByte;
-        BOOL success = [self scanInt8:&currentByte];
-        if(!success) break;
+        unsigned long long  available = 0;
+        const uint8_t      *bytes     = [self PSY_bytesAtScanLocationWithMinimumLength:maxLength availableLength:&available];
         
-        result |= (((uint32_t)(currentByte & 0x7f)) << shift);
-        if((currentByte & 0x80) == 0)
-        {
-            if(value != NULL) *value = CFSwapInt32LittleToHost(result);
-            return YES;
-        }
+        NSUInteger length   = (NSUInteger)MIN(available, (unsigned long long)NSUIntegerMax);
+        NSUInteger consumed = 0;
+        NSUInteger read     = (is64Bit
+                               ? PSYDecodeVarint64Array(bytes, length, values != NULL ? (uint64_t *)values + decoded : NULL, count - decoded, &consumed)
+                               : PSYDecodeVarint32Array(bytes, length, values != NULL ? (uint32_t *)values + decoded : NULL, count - decoded, &consumed));
+        
+        // The bytes always hold a complete varint unless the data ends or the varint is too long
+        if(read == 0) break;
+        
+        decoded += read;
+        [self setScanLocation:[self scanLocation] + consumed];
     }
     
-    // If we're here that means scanning failed
-    // reset the scan location to what it was before scanning
-    [self setScanLocation:loc];
+    if(decoded < count)
+    {
+        // If we're here that means scanning failed
+        // reset the scan location to what it was before scanning
+        [self setScanLocation:loc];
+        return NO;
+    }
     
-    return NO;
+    return YES;
 }
 
-- (BOOL)scanLittleEndianVarint64:(uint64_t *)value
+- (BOOL)scanLittleEndianVarint32:(uint32_t *)value
 {
-    unsigned long long loc = [self scanLocation];
-    
-    uint64_t result = 0;
+    return [self scanLittleEndianVarint32Array:value count:1];
+}
 
-    for(uint8_t shift = 0; shift < 64; shift += 7)
-    {
-        uint8_t currentByte;
-        BOOL success = [self scanInt8:&currentByte];
-        if(!success) break;
-        
-        result |= (((uint64_t)(currentByte & 0x7f)) << shift);
-        if((currentByte & 0x80) == 0)
-        {
-            if(value != NULL) *value = CFSwapInt64LittleToHost(result);
-            return YES;
-        }
-    }
-    
-    // If we're here that means scanning failed
-    // reset the scan location to what it was before scanning
-    [self setScanLocation:loc];
-    
-    return NO;
+- (BOOL)scanLittleEndianVarint64:(uint64_t *)value
+{
+    return [self scanLittleEndianVarint64Array:value count:1];
 }
 
 - (BOOL)scanBigEndianVarint32:(uint32_t *)value
 {
-    unsigned long long loc = [self scanLocation];
-    
-    uint32_t result = 0;
-    
-    for(uint8_t shift = 0; shift < 32; shift += 7)
-    {
-        uint8_t currentByte;
-        BOOL success = [self scanInt8:&currentByte];
-        if(!success) break;
-        
-        result |= (((uint32_t)(currentByte & 0x7f)) << shift);
-        if((currentByte & 0x80) == 0)
-        {
-            if(value != NULL) *value = CFSwapInt32BigToHost(result);
-            return YES;
-        }
-    }
-    
-    // If we're here that means scanning failed
-    // reset the scan location to what it was before scanning
-    [self setScanLocation:loc];
-    
-    return NO;
+    return [self scanBigEndianVarint32Array:value count:1];
 }
 
 - (BOOL)scanBigEndianVarint64:(uint64_t *)value
 {
-    unsigned long long loc = [self scanLocation];
-    
-    uint64_t result = 0;
-    
-    for(uint8_t shift = 0; shift < 64; shift += 7)
-    {
-        uint8_t currentByte;
-        BOOL success = [self scanInt8:&currentByte];
-        if(!success) break;
-        
-        result |= (((uint64_t)(currentByte & 0x7f)) << shift);
-        if((currentByte & 0x80) == 0)
-        {
-            if(value != NULL) *value = CFSwapInt64BigToHost(result);
-            return YES;
-        }
-    }
-    
-    // If we're here that means scanning failed
-    // reset the scan location to what it was before scanning
-    [self setScanLocation:loc];
-    
-    return NO;
+    return [self scanBigEndianVarint64Array:value count:1];
 }
 
 - (BOOL)scanLittleEndianSVarint32:(int32_t *)value
@@ -386,80 +678,57 @@
 
 - (BOOL)scanLittleEndianZigZagVarint32:(int32_t *)value
 {
-    uint32_t zzEnc;
-    BOOL success = [self scanLittleEndianVarint32:&zzEnc];
-    if(!success) return NO;
-    
-    if(value != NULL)
-    {
-        if(zzEnc & 0x1)
-        {
-            uint32_t r = (zzEnc >> 1) ^ 0xFFFFFFFF;
-            *value = *(int32_t *)&r;
-        }
-        else *value = (int32_t)zzEnc >> 1;
-    }
-    
-    return YES;
+    return [self scanLittleEndianZigZagVarint32Array:value count:1];
 }
 
 - (BOOL)scanLittleEndianZigZagVarint64:(int64_t *)value
 {
-    uint64_t zzEnc;
-    BOOL success = [self scanLittleEndianVarint64:&zzEnc];
-    if(!success) return NO;
-    
-    if(value != NULL)
-    {
-        if(zzEnc & 0x1)
-        {
-            uint64_t r = (zzEnc >> 1) ^ 0xFFFFFFFFFFFFFFFF;
-            *value = *(int64_t *)&r;
-        }
-        else *value = (int64_t)zzEnc >> 1;
-    }
-    
-    return YES;
+    return [self scanLittleEndianZigZagVarint64Array:value count:1];
 }
 
 - (BOOL)scanBigEndianZigZagVarint32:(int32_t *)value
 {
-    uint32_t zzEnc;
-    BOOL success = [self scanBigEndianVarint32:&zzEnc];
-    if(!success) return NO;
-    
-    if(value != NULL)
-    {
-        if (zzEnc & 0x1)
-        {
-            uint32_t r = (zzEnc >> 1) ^ 0xFFFFFFFF;
-            *value = *(int32_t *)&r;
-        }
-        else *value = (int32_t)zzEnc >> 1;
-    }
-    
-    return YES;
+    return [self scanBigEndianZigZagVarint32Array:value count:1];
 }
 
 - (BOOL)scanBigEndianZigZagVarint64:(int64_t *)value
 {
-    uint64_t zzEnc;
-    BOOL success = [self scanBigEndianVarint64:&zzEnc];
-    if(!success) return NO;
-    
-    if(value != NULL)
-    {
-        if(zzEnc & 0x1)
-        {
-            uint64_t r = (zzEnc >> 1) ^ 0xFFFFFFFFFFFFFFFF;
-            *value = *(int64_t *)&r;
-        }
-        else *value = (int64_t)zzEnc >> 1;
-    }
-    
-    return YES;
+    return [self scanBigEndianZigZagVarint64Array:value count:1];
 }
 
+#define VARINT_ARRAY_METHOD(sel, type, is64Bit, transform)                 \
+- (BOOL)sel:(type *)values count:(NSUInteger)count                         \
+{                                                                          \
+    if(![self PSY_scanVarintArray:values count:count is64Bit:is64Bit])     \
+        return NO;                                                         \
+                                                                           \
+    if(values != NULL)                                                     \
+        for(NSUInteger i = 0; i < count; i++)                              \
+            values[i] = transform(values[i]);                              \
+                                                                           \
+    return YES;                                                            \
+}
+
+#define LITTLE_ZIGZAG32(value) (int32_t)PSYZigZagDecode32(CFSwapInt32LittleToHost(value))
+#define LITTLE_ZIGZAG64(value) (int64_t)PSYZigZagDecode64(CFSwapInt64LittleToHost(value))
+#define BIG_ZIGZAG32(value)    (int32_t)PSYZigZagDecode32(CFSwapInt32BigToHost(value))
+#define BIG_ZIGZAG64(value)    (int64_t)PSYZigZagDecode64(CFSwapInt64BigToHost(value))
+
+VARINT_ARRAY_METHOD(scanLittleEndianVarint32Array, uint32_t, NO, CFSwapInt32LittleToHost)
+VARINT_ARRAY_METHOD(scanLittleEndianVarint64Array, uint64_t, YES, CFSwapInt64LittleToHost)
+VARINT_ARRAY_METHOD(scanBigEndianVarint32Array, uint32_t, NO, CFSwapInt32BigToHost)
+VARINT_ARRAY_METHOD(scanBigEndianVarint64Array, uint64_t, YES, CFSwapInt64BigToHost)
+
+VARINT_ARRAY_METHOD(scanLittleEndianSVarint32Array, int32_t, NO, (int32_t)CFSwapInt32LittleToHost)
+VARINT_ARRAY_METHOD(scanLittleEndianSVarint64Array, int64_t, YES, (int64_t)CFSwapInt64LittleToHost)
+VARINT_ARRAY_METHOD(scanBigEndianSVarint32Array, int32_t, NO, (int32_t)CFSwapInt32BigToHost)
+VARINT_ARRAY_METHOD(scanBigEndianSVarint64Array, int64_t, YES, (int64_t)CFSwapInt64BigToHost)
+
+VARINT_ARRAY_METHOD(scanLittleEndianZigZagVarint32Array, int32_t, NO, LITTLE_ZIGZAG32)
+VARINT_ARRAY_METHOD(scanLittleEndianZigZagVarint64Array, int64_t, YES, LITTLE_ZIGZAG64)
+VARINT_ARRAY_METHOD(scanBigEndianZigZagVarint32Array, int32_t, NO, BIG_ZIGZAG32)
+VARINT_ARRAY_METHOD(scanBigEndianZigZagVarint64Array, int64_t, YES, BIG_ZIGZAG64)
+
 - (BOOL)scanFloat:(float *)value
 {
     unsigned long long length = sizeof(*value);
@@ -518,6 +787,67 @@
     return YES;
 }
 
+- (BOOL)PSY_scanArray:(void *)values count:(NSUInteger)count width:(NSUInteger)width swap:(BOOL)swap;
+{
+    unsigned long long loc = [self scanLocation];
+    if(count > NSUIntegerMax / width || loc + count * width > [self dataLength]) return NO;
+    
+    // The bytes may not be contiguous in the scanner, copy them as they come
+    for(NSUInteger copied = 0; copied < count;)
+    {
+        unsigned long long  available = 0;
+        const uint8_t      *bytes     = [self PSY_bytesAtScanLocationWithMinimumLength:width availableLength:&available];
+        NSUInteger          chunk     = (NSUInteger)MIN(count - copied, available / width);
+        
+        if(chunk == 0)
+        {
+            [self setScanLocation:loc];
+            return NO;
+        }
+        
+        if(values != NULL) PSYCopyElements((uint8_t *)values + copied * width, bytes, chunk, width, swap);
+        
+        copied += chunk;
+        [self setScanLocation:[self scanLocation] + chunk * width];
+    }
+    
+    return YES;
+}
+
+#define SCAN_ARRAY_METHOD(name, type, swap)                                                 \
+- (BOOL)scan ## name ## Array:(type *)values count:(NSUInteger)count                        \
+{                                                                                           \
+    return [self PSY_scanArray:values count:count width:sizeof(type) swap:swap];            \
+}
+
+SCAN_ARRAY_METHOD(Int8, uint8_t, NO)
+
+SCAN_ARRAY_METHOD(LittleEndianInt16, uint16_t, PSY_SWAP_LITTLE_ENDIAN)
+SCAN_ARRAY_METHOD(LittleEndianInt32, uint32_t, PSY_SWAP_LITTLE_ENDIAN)
+SCAN_ARRAY_METHOD(LittleEndianInt64, uint64_t, PSY_SWAP_LITTLE_ENDIAN)
+
+SCAN_ARRAY_METHOD(BigEndianInt16, uint16_t, PSY_SWAP_BIG_ENDIAN)
+SCAN_ARRAY_METHOD(BigEndianInt32, uint32_t, PSY_SWAP_BIG_ENDIAN)
+SCAN_ARRAY_METHOD(BigEndianInt64, uint64_t, PSY_SWAP_BIG_ENDIAN)
+
+SCAN_ARRAY_METHOD(SInt8, int8_t, NO)
+
+SCAN_ARRAY_METHOD(LittleEndianSInt16, int16_t, PSY_SWAP_LITTLE_ENDIAN)
+SCAN_ARRAY_METHOD(LittleEndianSInt32, int32_t, PSY_SWAP_LITTLE_ENDIAN)
+SCAN_ARRAY_METHOD(LittleEndianSInt64, int64_t, PSY_SWAP_LITTLE_ENDIAN)
+
+SCAN_ARRAY_METHOD(BigEndianSInt16, int16_t, PSY_SWAP_BIG_ENDIAN)
+SCAN_ARRAY_METHOD(BigEndianSInt32, int32_t, PSY_SWAP_BIG_ENDIAN)
+SCAN_ARRAY_METHOD(BigEndianSInt64, int64_t, PSY_SWAP_BIG_ENDIAN)
+
+SCAN_ARRAY_METHOD(Float, float, NO)
+SCAN_ARRAY_METHOD(Double, double, NO)
+
+SCAN_ARRAY_METHOD(SwappedFloat, float, PSY_SWAP_BIG_ENDIAN)
+SCAN_ARRAY_METHOD(SwappedDouble, double, PSY_SWAP_BIG_ENDIAN)
+
+#undef SCAN_ARRAY_METHOD
+
 - (BOOL)scanData:(NSData **)data ofLength:(unsigned long long)length
 {
     PSYRequestConcreteImplementation([self class], _cmd, [self class] != [PSYDataScanner class]);
@@ -541,26 +871,63 @@
     return NO;
 }
 
+- (BOOL)scanBytesNoCopy:(const void **)bytes length:(NSUInteger)length;
+{
+    unsigned long long  loc       = [self scanLocation];
+    unsigned long long  available = 0;
+    const uint8_t      *current   = [self PSY_bytesAtScanLocationWithMinimumLength:length availableLength:&available];
+    
+    if(available < length) return NO;
+    
+    if(bytes != NULL) *bytes = current;
+    
+    [self setScanLocation:loc + length];
+    return YES;
+}
+
+- (BOOL)scanUpToDataNoCopy:(NSData *)stopData bytes:(const void **)bytes length:(NSUInteger *)length options:(PSYDataScannerOptions)options;
+{
+    __block const uint8_t *scanned       = NULL;
+    __block NSUInteger     scannedLength = 0;
+    
+    BOOL success = [self PSY_scanUpToData:stopData options:options bytesHandler:^(const uint8_t *found, NSUInteger foundLength) {
+        scanned       = found;
+        scannedLength = foundLength;
+    }];
+    
+    if(success)
+    {
+        if(bytes  != NULL) *bytes  = scanned;
+        if(length != NULL) *length = scannedLength;
+    }
+    
+    return success;
+}
+
 - (BOOL)scanString:(NSString **)value ofLength:(unsigned long long)length usingEncoding:(NSStringEncoding)encoding
 {
     // If the caller does not need the result it's like advancing the scan location by length
     if(value == NULL) return [self scanData:NULL ofLength:length];
     
-    BOOL success = NO;
-    NSString *ret  = nil;
+    unsigned long long  loc       = [self scanLocation];
+    unsigned long long  available = 0;
+    const uint8_t      *bytes     = [self PSY_bytesAtScanLocationWithMinimumLength:length availableLength:&available];
     
-    @autoreleasepool
+    // The string is decoded straight from the bytes of the scanner when they're contiguous
+    // We do not actually care if the data was decoded properly...
+    // We might want to in the future
+    if(length > 0 && available >= length)
     {
-        NSData   *data = nil;
-        success = [self scanData:&data ofLength:length];
-        if(success) ret = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+        *value = [self PSY_stringWithBytes:bytes length:(NSUInteger)length encoding:encoding];
+        [self setScanLocation:loc + length];
+        return YES;
     }
     
-    // We do not actually care if the data was decoded properly...
-    // We might want to in the future
-    if(success) *value = AUTORELEASE(ret);
+    NSData *data = nil;
+    if(![self scanData:&data ofLength:length]) return NO;
     
-    return success;
+    *value = [self PSY_stringWithBytes:[data bytes] length:[data length] encoding:encoding];
+    return YES;
 }
 
 - (BOOL)scanUpToString:(NSString *)stopString intoString:(NSString **)value usingEncoding:(NSStringEncoding)encoding;
@@ -571,17 +938,30 @@
 - (BOOL)scanUpToString:(NSString *)stopString intoString:(NSString **)value usingEncoding:(NSStringEncoding)encoding options:(PSYDataScannerOptions)options;
 {
     NSData *stopData = [stopString dataUsingEncoding:encoding];
-    NSData *readData = nil;
     
-    BOOL success = [self scanUpToData:stopData intoData:value != NULL ? &readData : NULL options:options];
-    if(success)
-    {
-        if(value != NULL) *value = AUTORELEASE([[NSString alloc] initWithData:readData encoding:encoding]);
-    }
+    if(value == NULL) return [self scanUpToData:stopData intoData:NULL options:options];
+    
+    __block NSString *string = nil;
+    
+    BOOL success = [self PSY_scanUpToData:stopData options:options bytesHandler:^(const uint8_t *bytes, NSUInteger length) {
+        string = [self PSY_stringWithBytes:bytes length:length encoding:encoding];
+    }];
+    
+    if(success) *value = string;
     
     return success;
 }
 
+- (BOOL)PSY_scanUpToData:(NSData *)stopData options:(PSYDataScannerOptions)options bytesHandler:(void (^)(const uint8_t *bytes, NSUInteger length))bytesHandler;
+{
+    NSData *data = nil;
+    
+    if(![self scanUpToData:stopData intoData:bytesHandler != nil ? &data : NULL options:options]) return NO;
+    
+    if(bytesHandler != nil) bytesHandler([data bytes], [data length]);
+    
+    return YES;
+}
 
 - (BOOL)scanNullTerminatedString:(NSString **)value withEncoding:(NSStringEncoding)encoding;
 {
@@ -589,6 +969,163 @@
     return NO;
 }
 
+- (NSData *)PSY_dataForEnumeration;
+{
+    return nil;
+}
+
+- (void)PSY_enumerateRecordsSeparatedByData:(NSData *)separator usingBlock:(void (^)(NSData *record, unsigned long long location, BOOL *stop))block;
+{
+    unsigned long long loc    = [self scanLocation];
+    NSData            *record = nil;
+    BOOL               stop   = NO;
+    
+    while(!stop)
+    {
+        unsigned long long location = [self scanLocation];
+        
+        if([self scanUpToData:separator intoData:&record options:PSYDataScannerRequireStopData | PSYDataScannerMoveAfterStopData])
+            block(record, location, &stop);
+        else
+        {
+            // The last record isn't followed by a separator
+            if(![self isAtEnd] && [self scanData:&record ofLength:[self dataLength] - location])
+                block(record, location, &stop);
+            
+            break;
+        }
+    }
+    
+    [self setScanLocation:loc];
+}
+
+- (void)enumerateRecordsSeparatedByData:(NSData *)separator options:(PSYDataScannerEnumerationOptions)options usingBlock:(void (^)(NSData *record, unsigned long long location, BOOL *stop))block;
+{
+    NSUInteger separatorLength = [separator length];
+    
+    if(separatorLength == 0)
+        [NSException raise:NSInvalidArgumentException format:@"*** -[PSYDataScanner enumerateRecordsSeparatedByData:options:usingBlock:]: Empty separator"];
+    
+    NSData *data = [self PSY_dataForEnumeration];
+    
+    if(data == nil)
+    {
+        [self PSY_enumerateRecordsSeparatedByData:separator usingBlock:block];
+        return;
+    }
+    
+    const uint8_t *bytes          = [data bytes];
+    const void    *separatorBytes = [separator bytes];
+    NSUInteger     length         = [data length];
+    NSUInteger     start          = (NSUInteger)MIN([self scanLocation], length);
+    
+    NSUInteger cores           = [[NSProcessInfo processInfo] activeProcessorCount];
+    NSUInteger partitionLength = MIN(MAX((length - start) / (cores * PARTITIONS_PER_CORE), MIN_PARTITION_LENGTH), MAX_PARTITION_LENGTH);
+    NSUInteger count           = options & PSYDataScannerEnumerationConcurrent ? MAX((length - start) / partitionLength, 1) : 1;
+    
+    __block volatile BOOL stopped = NO;
+    
+    // The first block asking to stop stops the enumeration, the records already handed over are still delivered
+    void (^deliver)(NSRange) = ^(NSRange range){
+        @autoreleasepool
+        {
+            PSYDataSlice *record = [[PSYDataSlice alloc] initWithData:data range:range];
+            BOOL          stop   = NO;
+            
+            block(record, range.location, &stop);
+            if(stop) stopped = YES;
+            
+            RELEASE(record);
+        }
+    };
+    
+    if(count == 1 || !(options & PSYDataScannerEnumerationPreservingOrder))
+    {
+        void (^enumeratePartition)(size_t) = ^(size_t index){
+            NSRange range = PSYRecordPartitionRange(bytes, start, length, index, count, separatorBytes, separatorLength);
+            
+            if(range.location != NSNotFound)
+                PSYEnumerateRecordRanges(bytes, range, NSMaxRange(range) == length, separatorBytes, separatorLength, &stopped, deliver);
+        };
+        
+        if(count == 1) enumeratePartition(0);
+        else dispatch_apply(count, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), enumeratePartition);
+        
+        return;
+    }
+    
+    // Only a few partitions are searched ahead of the one being delivered to bound the memory used by their records
+    dispatch_queue_t  queue      = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    dispatch_group_t  group      = dispatch_group_create();
+    NSMutableArray   *partitions = [[NSMutableArray alloc] initWithCapacity:cores * 2];
+    NSUInteger        dispatched = 0;
+    
+    for(NSUInteger index = 0; index < count && !stopped; index++)
+    {
+        for(; dispatched < count && dispatched <= index + cores * 2; dispatched++)
+        {
+            PSYRecordPartition *partition      = [[PSYRecordPartition alloc] init];
+            NSUInteger          partitionIndex = dispatched;
+            
+            [partitions addObject:partition];
+            
+            dispatch_group_async(group, queue, ^{
+                NSRange range = PSYRecordPartitionRange(bytes, start, length, partitionIndex, count, separatorBytes, separatorLength);
+                
+                if(range.location != NSNotFound)
+                    PSYEnumerateRecordRanges(bytes, range, NSMaxRange(range) == length, separatorBytes, separatorLength, &stopped, ^(NSRange record){
+                        [partition->records appendBytes:&record length:sizeof(record)];
+                    });
+                
+                dispatch_semaphore_signal(partition->searched);
+            });
+            
+            RELEASE(partition);
+        }
+        
+        PSYRecordPartition *partition = [partitions objectAtIndex:0];
+        dispatch_semaphore_wait(partition->searched, DISPATCH_TIME_FOREVER);
+        
+        const NSRange *records     = [partition->records bytes];
+        NSUInteger     recordCount = [partition->records length] / sizeof(NSRange);
+        
+        for(NSUInteger i = 0; i < recordCount && !stopped; i++) deliver(records[i]);
+        
+        [partitions removeObjectAtIndex:0];
+    }
+    
+    // The partitions still being searched read the bytes of the data
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+    
+#if !__has_feature(objc_arc)
+    dispatch_release(group);
+#endif
+    RELEASE(partitions);
+}
+
+@end
+
+@implementation PSYRecordPartition
+
+- (id)init
+{
+    if((self = [super init]))
+    {
+        records  = [[NSMutableData alloc] init];
+        searched = dispatch_semaphore_create(0);
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+#if !__has_feature(objc_arc)
+    [records release];
+    dispatch_release(searched);
+    [super dealloc];
+#endif
+}
+
 @end
 
 @implementation PSYPlaceholderDataScanner
@@ -628,6 +1165,31 @@
     return (id)[[NSClassFromString(@"PSYFileHandleScanner") alloc] initWithFileHandle:fileToScan];
 }
 
+- (id)initWithFileHandle:(NSFileHandle *)fileToScan readAheadWindowSize:(NSUInteger)windowSize depth:(NSUInteger)depth
+{
+    return (id)[[NSClassFromString(@"PSYFileHandleScanner") alloc] initWithFileHandle:fileToScan readAheadWindowSize:windowSize depth:depth];
+}
+
+- (id)initWithFileHandle:(NSFileHandle *)fileToScan blockSize:(NSUInteger)blockSize memoryBudget:(NSUInteger)memoryBudget
+{
+    return (id)[[NSClassFromString(@"PSYFileHandleScanner") alloc] initWithFileHandle:fileToScan blockSize:blockSize memoryBudget:memoryBudget];
+}
+
+- (id)initWithContentsOfMappedFile:(NSString *)path
+{
+    return (id)[[NSClassFromString(@"PSYMappedFileScanner") alloc] initWithContentsOfMappedFile:path];
+}
+
+- (id)initWithStreamFileHandle:(NSFileHandle *)fileToScan bufferCapacity:(NSUInteger)capacity
+{
+    return (id)[[NSClassFromString(@"PSYStreamFileHandleScanner") alloc] initWithStreamFileHandle:fileToScan bufferCapacity:capacity];
+}
+
+- (id)initWithCompressedFileHandle:(NSFileHandle *)fileToScan format:(PSYCompressionFormat)format bufferCapacity:(NSUInteger)capacity
+{
+    return (id)[[NSClassFromString(@"PSYInflatingFileHandleScanner") alloc] initWithCompressedFileHandle:fileToScan format:format bufferCapacity:capacity];
+}
+
 @end
 
 NSData *PSYNullTerminatorDataForEncoding(NSStringEncoding encoding)
@@ -0,0 +1,75 @@
+/*
+ PSYDataScanner_Private.h
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import "PSYDataScanner.h"
+
+// Adds value to a counter of the scanner's statistics, if they're collected
+#define PSYDataScannerCount(counter, value) do { if(__builtin_expect(_statistics != NULL, 0)) _statistics->counter += (value); } while(NO)
+
+// Feeds the bytes that start at location in the scanned stream to the checksum, if the scanner computes one
+#define PSYDataScannerChecksum(location, bytes, length) do { if(__builtin_expect(_checksumAlgorithm != PSYChecksumNone, 0)) [self PSY_updateChecksumWithBytes:(bytes) length:(length) atLocation:(location)]; } while(NO)
+
+@interface PSYDataScanner ()
+{
+    // NULL unless the scanner collects statistics
+    PSYDataScannerStatistics *_statistics;
+    
+    // NULL unless the scanner interns strings
+    struct _PSYInternedStringTable *_internedStrings;
+    
+    // The checksum covers the bytes from where it was last reset up to _checksumLocation,
+    // bytes before _checksumLocation aren't added again when a failed scan rolled back over them
+    PSYChecksumAlgorithm            _checksumAlgorithm;
+    uint32_t                        _checksum;
+    unsigned long long              _checksumLocation;
+}
+
+// Returns an autoreleased string decoded from bytes, or the interned string of the same bytes
+- (NSString *)PSY_stringWithBytes:(const uint8_t *)bytes length:(NSUInteger)length encoding:(NSStringEncoding)encoding;
+
+// Adds the part of the bytes past _checksumLocation to the checksum, the concrete scanners call it
+// through PSYDataScannerChecksum() with the bytes they move the scan location over
+- (void)PSY_updateChecksumWithBytes:(const uint8_t *)bytes length:(unsigned long long)length atLocation:(unsigned long long)location;
+
+// Returns a pointer to the bytes at the scan location and sets *availableLength
+// to the number of contiguous bytes that can be read from it, which is at least
+// minimumLength unless the end of the data is reached
+// The pointer stays valid until the scanner is sent another message
+- (const uint8_t *)PSY_bytesAtScanLocationWithMinimumLength:(unsigned long long)minimumLength availableLength:(unsigned long long *)availableLength;
+
+// The array scans read through the method above, they restore the scan location and return NO on failure
+- (BOOL)PSY_scanArray:(void *)values count:(NSUInteger)count width:(NSUInteger)width swap:(BOOL)swap;
+- (BOOL)PSY_scanVarintArray:(void *)values count:(NSUInteger)count is64Bit:(BOOL)is64Bit;
+
+// Scans like -scanUpToData:intoData:options:, bytesHandler, if not nil, is called with the bytes
+// scanned before the scan location moves, they're only valid during the call
+// The default implementation scans a data, the concrete scanners hand their own bytes
+- (BOOL)PSY_scanUpToData:(NSData *)stopData options:(PSYDataScannerOptions)options bytesHandler:(void (^)(const uint8_t *bytes, NSUInteger length))bytesHandler;
+
+// Returns the whole scanned data as a single immutable data that can be sliced from several threads,
+// or nil if the scanner can't provide it, records are then enumerated with the scan methods
+- (NSData *)PSY_dataForEnumeration;
+
+@end
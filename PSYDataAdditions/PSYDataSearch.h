@@ -0,0 +1,37 @@
+/*
+ PSYDataSearch.h
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+// Returns the offset of the first occurrence of needle in haystack, or NSNotFound
+// Single byte needles use memchr, short needles are filtered 16 bytes at a time
+// on their first and last bytes, long needles use Boyer-Moore-Horspool skipping
+NSUInteger PSYFindBytes(const void *haystack, NSUInteger haystackLength, const void *needle, NSUInteger needleLength);
+
+// Returns the offset of the first null terminator of width bytes, or NSNotFound
+// Only offsets that are multiples of width are considered so that
+// the trailing zero of a UTF-16 character followed by the leading zero
+// of the next one is not mistaken for a terminator
+NSUInteger PSYFindNullTerminator(const void *haystack, NSUInteger haystackLength, NSUInteger width);
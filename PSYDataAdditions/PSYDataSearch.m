@@ -0,0 +1,211 @@
+/*
+ PSYDataSearch.m
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import "PSYDataSearch.h"
+
+#include <string.h>
+#include <limits.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Needles longer than this are searched with Horspool,
+// below that the skip table costs more than it saves
+#define HORSPOOL_THRESHOLD 32
+
+static NSUInteger PSYFindBytesShort(const uint8_t *haystack, NSUInteger haystackLength, const uint8_t *needle, NSUInteger needleLength)
+{
+    const NSUInteger lastIndex = needleLength - 1;
+    const uint8_t    first     = needle[0];
+    const uint8_t    last      = needle[lastIndex];
+    NSUInteger       loc       = 0;
+    
+#if defined(__SSE2__)
+    // Compare the first and last bytes of 16 candidates at once,
+    // only the candidates that match both are compared completely
+    const __m128i firstBytes = _mm_set1_epi8((char)first);
+    const __m128i lastBytes  = _mm_set1_epi8((char)last);
+    
+    for(; loc + lastIndex + 16 <= haystackLength; loc += 16)
+    {
+        __m128i blockFirst = _mm_loadu_si128((const __m128i *)(haystack + loc));
+        __m128i blockLast  = _mm_loadu_si128((const __m128i *)(haystack + loc + lastIndex));
+        
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(blockFirst, firstBytes),
+                                                                          _mm_cmpeq_epi8(blockLast, lastBytes)));
+        while(mask != 0)
+        {
+            unsigned int bit = (unsigned int)__builtin_ctz(mask);
+            
+            if(memcmp(haystack + loc + bit + 1, needle + 1, needleLength - 2) == 0)
+                return loc + bit;
+            
+            mask &= mask - 1;
+        }
+    }
+#endif
+    
+    // Let memchr find the candidates for whatever is left
+    while(loc + lastIndex < haystackLength)
+    {
+        const uint8_t *candidate = memchr(haystack + loc, first, haystackLength - lastIndex - loc);
+        if(candidate == NULL) break;
+        
+        loc = (NSUInteger)(candidate - haystack);
+        
+        if(haystack[loc + lastIndex] == last && memcmp(haystack + loc + 1, needle + 1, lastIndex) == 0)
+            return loc;
+        
+        loc++;
+    }
+    
+    return NSNotFound;
+}
+
+static NSUInteger PSYFindBytesHorspool(const uint8_t *haystack, NSUInteger haystackLength, const uint8_t *needle, NSUInteger needleLength)
+{
+    const NSUInteger lastIndex = needleLength - 1;
+    const uint8_t    last      = needle[lastIndex];
+    NSUInteger       skip[UCHAR_MAX + 1];
+    
+    for(NSUInteger i = 0; i <= UCHAR_MAX; i++) skip[i] = needleLength;
+    for(NSUInteger i = 0; i < lastIndex; i++)  skip[needle[i]] = lastIndex - i;
+    
+    for(NSUInteger loc = 0; loc + lastIndex < haystackLength;)
+    {
+        uint8_t current = haystack[loc + lastIndex];
+        
+        if(current == last && memcmp(haystack + loc, needle, lastIndex) == 0)
+            return loc;
+        
+        loc += skip[current];
+    }
+    
+    return NSNotFound;
+}
+
+NSUInteger PSYFindBytes(const void *haystack, NSUInteger haystackLength, const void *needle, NSUInteger needleLength)
+{
+    if(needleLength == 0) return 0;
+    if(needleLength > haystackLength) return NSNotFound;
+    
+    if(needleLength == 1)
+    {
+        const uint8_t *found = memchr(haystack, *(const uint8_t *)needle, haystackLength);
+        return found != NULL ? (NSUInteger)(found - (const uint8_t *)haystack) : NSNotFound;
+    }
+    
+    if(needleLength > HORSPOOL_THRESHOLD)
+        return PSYFindBytesHorspool(haystack, haystackLength, needle, needleLength);
+    
+    return PSYFindBytesShort(haystack, haystackLength, needle, needleLength);
+}
+
+static NSUInteger PSYFindNullTerminator16(const uint8_t *haystack, NSUInteger haystackLength)
+{
+    NSUInteger loc = 0;
+    
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    
+    for(; loc + 16 <= haystackLength; loc += 16)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i *)(haystack + loc));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi16(block, zero));
+        
+        if(mask != 0) return loc + (NSUInteger)__builtin_ctz(mask);
+    }
+#else
+    // Word at a time, a 16-bit lane is zero if subtracting one borrows into its top bit
+    for(; loc + 8 <= haystackLength; loc += 8)
+    {
+        uint64_t word;
+        memcpy(&word, haystack + loc, sizeof(word));
+        
+        if(((word - 0x0001000100010001ULL) & ~word & 0x8000800080008000ULL) != 0) break;
+    }
+#endif
+    
+    for(; loc + 2 <= haystackLength; loc += 2)
+        if(haystack[loc] == 0 && haystack[loc + 1] == 0) return loc;
+    
+    return NSNotFound;
+}
+
+static NSUInteger PSYFindNullTerminator32(const uint8_t *haystack, NSUInteger haystackLength)
+{
+    NSUInteger loc = 0;
+    
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    
+    for(; loc + 16 <= haystackLength; loc += 16)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i *)(haystack + loc));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi32(block, zero));
+        
+        if(mask != 0) return loc + (NSUInteger)__builtin_ctz(mask);
+    }
+#else
+    for(; loc + 8 <= haystackLength; loc += 8)
+    {
+        uint64_t word;
+        memcpy(&word, haystack + loc, sizeof(word));
+        
+        if(((word - 0x0000000100000001ULL) & ~word & 0x8000000080000000ULL) != 0) break;
+    }
+#endif
+    
+    for(; loc + 4 <= haystackLength; loc += 4)
+        if((haystack[loc] | haystack[loc + 1] | haystack[loc + 2] | haystack[loc + 3]) == 0) return loc;
+    
+    return NSNotFound;
+}
+
+NSUInteger PSYFindNullTerminator(const void *haystack, NSUInteger haystackLength, NSUInteger width)
+{
+    switch(width)
+    {
+        case 0 : return 0;
+        case 1 :
+        {
+            const uint8_t *found = memchr(haystack, 0, haystackLength);
+            return found != NULL ? (NSUInteger)(found - (const uint8_t *)haystack) : NSNotFound;
+        }
+        case 2 : return PSYFindNullTerminator16(haystack, haystackLength);
+        case 4 : return PSYFindNullTerminator32(haystack, haystackLength);
+        default : break;
+    }
+    
+    for(NSUInteger loc = 0; loc + width <= haystackLength; loc += width)
+    {
+        NSUInteger i = 0;
+        while(i < width && ((const uint8_t *)haystack)[loc + i] == 0) i++;
+        if(i == width) return loc;
+    }
+    
+    return NSNotFound;
+}
@@ -0,0 +1,80 @@
+/*
+ PSYDataSlice.m
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import "PSYDataSlice.h"
+#import "PSYUtilities.h"
+
+@implementation PSYDataSlice
+
+- (id)initWithData:(NSData *)parentData range:(NSRange)range
+{
+    if(NSMaxRange(range) > [parentData length])
+    {
+        RELEASE(self);
+        [NSException raise:NSRangeException format:@"*** -[PSYDataSlice initWithData:range:]: Range %@ out of bounds for data of length %lu", NSStringFromRange(range), (unsigned long)[parentData length]];
+    }
+    
+    if((self = [super init]))
+    {
+        // Slicing a slice references the original data directly
+        if([parentData isKindOfClass:[PSYDataSlice class]])
+        {
+            PSYDataSlice *slice = (PSYDataSlice *)parentData;
+            _parentData = RETAIN(slice->_parentData);
+            _bytes      = slice->_bytes + range.location;
+        }
+        else
+        {
+            _parentData = [parentData copy];
+            _bytes      = (const uint8_t *)[_parentData bytes] + range.location;
+        }
+        
+        _length = range.length;
+    }
+    return self;
+}
+
+#if !__has_feature(objc_arc)
+- (void)dealloc
+{
+    [_parentData release];
+    [super dealloc];
+}
+#endif
+
+- (NSUInteger)length     { return _length; }
+- (const void *)bytes    { return _bytes;  }
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    return RETAIN(self);
+}
+
+- (NSData *)subdataWithRange:(NSRange)range
+{
+    return AUTORELEASE([[PSYDataSlice alloc] initWithData:self range:range]);
+}
+
+@end
@@ -0,0 +1,830 @@
+/*
+ PSYDispatchStreamWriter.m
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import "PSYDispatchStreamWriter.h"
+#import "PSYUtilities.h"
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Every write is queued as a node on the list of its group
+// Producers push the nodes newest first with a compare and swap, the writer's queue swaps the whole list out
+// and reverses it, so the nodes keep the order in which their pushes succeeded
+// The list is only ever pushed to or emptied at once, it can't suffer from ABA
+// Bytes shorter than MIN_SEGMENT_LENGTH are copied into their node, larger data are referenced
+// The drain copies consecutive nodes of up to MAX_STAGED_LENGTH bytes into a staging buffer,
+// so the values written one by one go out as a single vector instead of one vector each
+#define MIN_SEGMENT_LENGTH       (16 * 1024)
+#define MAX_IOVEC_COUNT          64
+#define MAX_STAGED_LENGTH        1024
+#define STAGING_BUFFER_SIZE      (64 * 1024)
+#define INPUT_STREAM_BUFFER_SIZE (16 * 1024)
+#define DEFAULT_HIGH_WATER_MARK  (1024 * 1024)
+#define DEFAULT_LOW_WATER_MARK   (256 * 1024)
+
+typedef enum _PSYDispatchWriteNodeKind
+{
+    PSYDispatchWriteNodeBytes,
+    PSYDispatchWriteNodeGroup,
+    PSYDispatchWriteNodeInputStream,
+    PSYDispatchWriteNodeCompletion,
+} PSYDispatchWriteNodeKind;
+
+typedef struct _PSYDispatchWriteNode
+{
+    struct _PSYDispatchWriteNode *next;
+    PSYDispatchWriteNodeKind      kind;
+    const uint8_t                *bytes;
+    NSUInteger                    start;
+    NSUInteger                    end;
+    CFTypeRef                     object;     // the referenced data, the group or the input stream
+    CFTypeRef                     completion; // the copied completion block
+    uint8_t                       storage[];
+} PSYDispatchWriteNode;
+
+static PSYDispatchWriteNode *PSYDispatchWriteNodeCreate(PSYDispatchWriteNodeKind kind, NSUInteger length, SEL _cmd)
+{
+    PSYDispatchWriteNode *node = malloc(sizeof(PSYDispatchWriteNode) + length);
+    if(node == NULL) [NSException raise:NSMallocException format:@"*** -[PSYStreamWriter %@]: unable to allocate a write buffer", NSStringFromSelector(_cmd)];
+    
+    node->next       = NULL;
+    node->kind       = kind;
+    node->bytes      = node->storage;
+    node->start      = 0;
+    node->end        = length;
+    node->object     = NULL;
+    node->completion = NULL;
+    
+    return node;
+}
+
+static void PSYDispatchWriteNodeFree(PSYDispatchWriteNode *node)
+{
+    if(node->kind == PSYDispatchWriteNodeInputStream) [(__bridge NSInputStream *)node->object close];
+    
+    if(node->object     != NULL) CFRelease(node->object);
+    if(node->completion != NULL) CFRelease(node->completion);
+    free(node);
+}
+
+static void PSYDispatchWriteNodeFreeList(PSYDispatchWriteNode *node)
+{
+    while(node != NULL)
+    {
+        PSYDispatchWriteNode *next = node->next;
+        PSYDispatchWriteNodeFree(node);
+        node = next;
+    }
+}
+
+@class PSYDispatchStreamWriterGroup;
+
+@interface PSYDispatchStreamWriter ()
+{
+@public
+    int                            fileDescriptor;
+    int                            originalFlags; // the flags of the descriptor before O_NONBLOCK was added, or -1
+    BOOL                           closeOnDealloc;
+    dispatch_queue_t               queue;
+    dispatch_source_t              writeSource;
+    PSYDispatchStreamWriterGroup  *rootGroup;
+    
+    volatile int32_t               drainScheduled;
+    volatile unsigned long long    pendingLength;
+    volatile int32_t               aboveHighWaterMark;
+    NSUInteger                     highWaterMark;
+    NSUInteger                     lowWaterMark;
+    
+    volatile BOOL                  collectsStatistics;
+    PSYStreamWriterStatistics      statistics;
+    
+    PSYChecksumAlgorithm           checksumAlgorithm;
+    uint32_t                       checksum;
+    
+    // Only touched from the queue
+    NSMutableArray                *openGroups;  // the groups being written, innermost last
+    PSYDispatchWriteNode          *writeHead;   // the nodes ready to be written in order
+    PSYDispatchWriteNode          *writeTail;
+    uint8_t                       *stagingBuffer;
+    BOOL                           writeSourceSuspended;
+    BOOL                           failed;
+}
+@property(nonatomic, assign) id<PSYStreamWriterDelegate> delegate;
+- (void)PSY_drain;
+@end
+
+// The writer given to the blocks of groupWrites:completion:, and the root group of the writer
+// The group takes its place among the writes of its parent before its block runs,
+// the writer's queue writes the group's nodes as they come and only moves past the group once it's sealed
+@interface PSYDispatchStreamWriterGroup : PSYStreamWriter
+{
+@public
+    PSYDispatchStreamWriter       *writer;      // not retained, the groups don't outlive their writer
+    PSYDispatchWriteNode *volatile queuedNodes; // pushed by the producers, newest first
+    PSYDispatchWriteNode          *head;        // taken by the writer's queue, oldest first
+    PSYDispatchWriteNode          *tail;
+    volatile BOOL                  sealed;      // set once the block of the group returned
+    void (^completionBlock)(void);
+}
+- (id)initWithStreamWriter:(PSYDispatchStreamWriter *)aWriter completionBlock:(void(^)(void))completion;
+@end
+
+#define PSY_COUNT_STATISTIC(writer, field, value) do { if(__builtin_expect((writer)->collectsStatistics, 0)) __sync_fetch_and_add(&(writer)->statistics.field, (unsigned long long)(value)); } while(NO)
+
+static void PSYRaiseHighWaterMark(volatile unsigned long long *mark, unsigned long long value)
+{
+    unsigned long long current = *mark;
+    
+    while(value > current && !__sync_bool_compare_and_swap(mark, current, value))
+        current = *mark;
+}
+
+// Counts length bytes handed to the writer, the producer that takes the pending bytes
+// to the high water mark tells the delegate
+static void PSYDispatchStreamWriterCountQueuedBytes(PSYDispatchStreamWriter *writer, NSUInteger length, BOOL copied)
+{
+    if(length == 0) return;
+    
+    unsigned long long pending = __sync_add_and_fetch(&writer->pendingLength, (unsigned long long)length);
+    
+    if(__builtin_expect(writer->collectsStatistics, 0))
+    {
+        if(copied) __sync_fetch_and_add(&writer->statistics.bytesCopied, (unsigned long long)length);
+        __sync_fetch_and_add(&writer->statistics.bytesQueued, (unsigned long long)length);
+        PSYRaiseHighWaterMark(&writer->statistics.pendingBytesHighWaterMark, pending);
+    }
+    
+    if(pending >= writer->highWaterMark && __sync_bool_compare_and_swap(&writer->aboveHighWaterMark, 0, 1) &&
+       [[writer delegate] respondsToSelector:@selector(streamWriterDidReachHighWaterMark:)])
+        [[writer delegate] streamWriterDidReachHighWaterMark:writer];
+}
+
+
+static void PSYDispatchStreamWriterDrain(void *context)
+{
+    PSYDispatchStreamWriter *writer = (__bridge PSYDispatchStreamWriter *)context;
+    
+    // Cleared before the nodes are taken, a push the drain misses schedules another one
+    __sync_bool_compare_and_swap(&writer->drainScheduled, 1, 0);
+    
+    [writer PSY_drain];
+    
+    CFRelease(context);
+}
+
+// Producers schedule a drain after every push, only the first one since the last drain started dispatches it
+static void PSYDispatchStreamWriterScheduleDrain(PSYDispatchStreamWriter *writer)
+{
+    if(!__sync_bool_compare_and_swap(&writer->drainScheduled, 0, 1)) return;
+    
+    dispatch_async_f(writer->queue, (void *)CFRetain((__bridge CFTypeRef)writer), PSYDispatchStreamWriterDrain);
+}
+
+static void PSYDispatchStreamWriterSpaceAvailable(void *context)
+{
+    PSYDispatchStreamWriter *writer = (__bridge PSYDispatchStreamWriter *)context;
+    
+    dispatch_suspend(writer->writeSource);
+    writer->writeSourceSuspended = YES;
+    
+    [writer PSY_drain];
+    
+    // Balances the retain taken when the source was resumed
+    CFRelease(context);
+}
+
+static void PSYDispatchStreamWriterGroupPush(PSYDispatchStreamWriterGroup *group, PSYDispatchWriteNode *node)
+{
+    PSYDispatchWriteNode *top;
+    
+    do {
+        top        = group->queuedNodes;
+        node->next = top;
+    } while(!__sync_bool_compare_and_swap(&group->queuedNodes, top, node));
+}
+
+// Pushes a node and adds its bytes to the checksum of the writer, if it computes one
+// The producers take turns so the bytes are added in the order the nodes are pushed
+static void PSYDispatchStreamWriterGroupChecksumAndPush(PSYDispatchStreamWriterGroup *group, PSYDispatchWriteNode *node)
+{
+    PSYDispatchStreamWriter *writer = group->writer;
+    
+    if(__builtin_expect(writer->checksumAlgorithm == PSYChecksumNone, 1) || node->kind != PSYDispatchWriteNodeBytes)
+    {
+        PSYDispatchStreamWriterGroupPush(group, node);
+        return;
+    }
+    
+    @synchronized(writer)
+    {
+        writer->checksum = PSYCRC32CUpdate(writer->checksum, node->bytes, node->end);
+        PSYDispatchStreamWriterGroupPush(group, node);
+    }
+}
+
+// Moves the nodes pushed since the last call to the end of the group's own list
+static void PSYDispatchStreamWriterGroupTakeNodes(PSYDispatchStreamWriterGroup *group)
+{
+    PSYDispatchWriteNode *node = __sync_lock_test_and_set(&group->queuedNodes, (PSYDispatchWriteNode *)NULL);
+    if(node == NULL) return;
+    
+    PSYDispatchWriteNode *first = NULL;
+    PSYDispatchWriteNode *last  = node;
+    NSUInteger            count = 0;
+    
+    while(node != NULL)
+    {
+        PSYDispatchWriteNode *next = node->next;
+        node->next = first;
+        first      = node;
+        node       = next;
+        count++;
+    }
+    
+    if(group->tail == NULL) group->head       = first;
+    else                    group->tail->next = first;
+    group->tail = last;
+    
+    PSYDispatchStreamWriter *writer = group->writer;
+    if(__builtin_expect(writer->collectsStatistics, 0)) PSYRaiseHighWaterMark(&writer->statistics.queueDepthHighWaterMark, count);
+}
+
+@implementation PSYDispatchStreamWriter
+@synthesize delegate;
+
+- (id)initWithFileDescriptor:(int)aFileDescriptor closeOnDealloc:(BOOL)shouldClose
+{
+    if(aFileDescriptor < 0)
+    {
+        RELEASE(self);
+        return nil;
+    }
+    
+    if((self = [super init]))
+    {
+        fileDescriptor = aFileDescriptor;
+        closeOnDealloc = shouldClose;
+        highWaterMark  = DEFAULT_HIGH_WATER_MARK;
+        lowWaterMark   = DEFAULT_LOW_WATER_MARK;
+        queue          = dispatch_queue_create("PSYDataAdditions.PSYDispatchStreamWriter", DISPATCH_QUEUE_SERIAL);
+        rootGroup      = [[PSYDispatchStreamWriterGroup alloc] initWithStreamWriter:self completionBlock:nil];
+        openGroups     = [[NSMutableArray alloc] initWithObjects:rootGroup, nil];
+        
+        // The queue never blocks on the descriptor, a full descriptor resumes the write source instead
+        // The descriptor gets its flags back when the writer is deallocated without closing it
+        int flags = fcntl(fileDescriptor, F_GETFL);
+        originalFlags = -1;
+        if(flags >= 0 && (flags & O_NONBLOCK) == 0 && fcntl(fileDescriptor, F_SETFL, flags | O_NONBLOCK) == 0) originalFlags = flags;
+        
+#ifdef SO_NOSIGPIPE
+        // A socket closed by its peer fails the write with EPIPE instead of raising SIGPIPE
+        int noSigPipe = 1;
+        setsockopt(fileDescriptor, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+#endif
+        
+        // Sources are created suspended, the writer is retained while its source is resumed
+        writeSource          = dispatch_source_create(DISPATCH_SOURCE_TYPE_WRITE, fileDescriptor, 0, queue);
+        writeSourceSuspended = YES;
+        dispatch_set_context(writeSource, (__bridge void *)self);
+        dispatch_source_set_event_handler_f(writeSource, PSYDispatchStreamWriterSpaceAvailable);
+        
+        if(closeOnDealloc)
+        {
+            int descriptor = fileDescriptor;
+            dispatch_source_set_cancel_handler(writeSource, ^{ close(descriptor); });
+        }
+    }
+    
+    return self;
+}
+
+- (void)dealloc
+{
+    // The drains and the resumed source retain the writer, nothing is left running for it on the queue
+    dispatch_source_cancel(writeSource);
+    dispatch_resume(writeSource);
+    
+    if(!closeOnDealloc && originalFlags >= 0) fcntl(fileDescriptor, F_SETFL, originalFlags);
+    
+    PSYDispatchWriteNodeFreeList(writeHead);
+    free(stagingBuffer);
+    
+#if !__has_feature(objc_arc)
+    dispatch_release(writeSource);
+    dispatch_release(queue);
+    [openGroups release];
+    [rootGroup release];
+    [super dealloc];
+#endif
+}
+
+- (void)groupWrites:(void (^)(PSYStreamWriter *))writes completion:(void (^)(void))completion
+{
+    [rootGroup groupWrites:writes completion:completion];
+}
+
+- (void)writeBytes:(const uint8_t *)buffer ofLength:(NSUInteger)length
+{
+    [rootGroup writeBytes:buffer ofLength:length];
+}
+
+- (void)writeData:(NSData *)value
+{
+    [rootGroup writeData:value];
+}
+
+- (void)writeInputStream:(NSInputStream *)aStream completion:(void (^)(void))completion;
+{
+    [rootGroup writeInputStream:aStream completion:completion];
+}
+
+- (NSUInteger)highWaterMark
+{
+    return highWaterMark;
+}
+
+- (NSUInteger)lowWaterMark
+{
+    return lowWaterMark;
+}
+
+- (void)setHighWaterMark:(NSUInteger)high lowWaterMark:(NSUInteger)low;
+{
+    if(low > high) [NSException raise:NSInvalidArgumentException format:@"*** -[PSYStreamWriter %@]: the low water mark %lu is above the high water mark %lu", NSStringFromSelector(_cmd), (unsigned long)low, (unsigned long)high];
+    
+    highWaterMark = high;
+    lowWaterMark  = low;
+    
+    // The next drain compares the pending bytes to the new low water mark
+    PSYDispatchStreamWriterScheduleDrain(self);
+}
+
+- (BOOL)hasSpaceAvailable
+{
+    return aboveHighWaterMark == 0;
+}
+
+- (BOOL)collectsStatistics
+{
+    return collectsStatistics;
+}
+
+- (void)setCollectsStatistics:(BOOL)value
+{
+    collectsStatistics = value;
+    
+    if(!value) [self resetStatistics];
+}
+
+- (PSYStreamWriterStatistics)statistics
+{
+    PSYStreamWriterStatistics result = statistics;
+    
+    result.pendingBytes = result.bytesQueued > result.bytesWritten ? result.bytesQueued - result.bytesWritten : 0;
+    
+    return result;
+}
+
+- (void)resetStatistics;
+{
+    memset(&statistics, 0, sizeof(PSYStreamWriterStatistics));
+}
+
+- (PSYChecksumAlgorithm)checksumAlgorithm
+{
+    return checksumAlgorithm;
+}
+
+- (void)setChecksumAlgorithm:(PSYChecksumAlgorithm)value
+{
+    @synchronized(self)
+    {
+        checksumAlgorithm = value;
+        checksum          = 0;
+    }
+}
+
+- (uint32_t)checksum
+{
+    @synchronized(self) { return checksum; }
+}
+
+- (void)resetChecksum;
+{
+    @synchronized(self) { checksum = 0; }
+}
+
+- (void)PSY_appendWriteNode:(PSYDispatchWriteNode *)node;
+{
+    node->next = NULL;
+    
+    if(writeTail == NULL) writeHead = writeTail = node;
+    else                  writeTail = writeTail->next = node;
+}
+
+- (void)PSY_removeWriteHead;
+{
+    writeHead = writeHead->next;
+    if(writeHead == NULL) writeTail = NULL;
+}
+
+// Moves the nodes of the open groups to the write list in order
+// A group is entered when it's reached and left once it's sealed and all its nodes were taken,
+// the nodes queued after a group that is still open wait for it
+- (void)PSY_takeQueuedNodes;
+{
+    PSYDispatchStreamWriterGroup *group = nil;
+    
+    while((group = [openGroups lastObject]) != nil)
+    {
+        // The flag is read before the nodes are taken, every write of a sealed group has been pushed by then
+        BOOL isSealed = group->sealed;
+        __sync_synchronize();
+        
+        PSYDispatchStreamWriterGroupTakeNodes(group);
+        
+        PSYDispatchWriteNode *node = group->head;
+        
+        if(node == NULL)
+        {
+            // The root group is never sealed
+            if(!isSealed) break;
+            
+            // The completion runs once the bytes written before it have been taken by the descriptor
+            if(group->completionBlock != nil)
+            {
+                PSYDispatchWriteNode *completion = PSYDispatchWriteNodeCreate(PSYDispatchWriteNodeCompletion, 0, _cmd);
+                completion->completion = (__bridge_retained CFTypeRef)[group->completionBlock copy];
+                [self PSY_appendWriteNode:completion];
+            }
+            
+            [openGroups removeLastObject];
+            continue;
+        }
+        
+        group->head = node->next;
+        if(group->head == NULL) group->tail = NULL;
+        
+        if(node->kind == PSYDispatchWriteNodeGroup)
+        {
+            [openGroups addObject:(__bridge PSYDispatchStreamWriterGroup *)node->object];
+            PSYDispatchWriteNodeFree(node);
+        }
+        else [self PSY_appendWriteNode:node];
+    }
+}
+
+- (void)PSY_discardWriteNodes;
+{
+    unsigned long long discarded = 0;
+    
+    for(PSYDispatchWriteNode *node = writeHead; node != NULL; node = node->next)
+        if(node->kind == PSYDispatchWriteNodeBytes) discarded += node->end - node->start;
+    
+    __sync_sub_and_fetch(&pendingLength, discarded);
+    
+    PSYDispatchWriteNodeFreeList(writeHead);
+    writeHead = writeTail = NULL;
+}
+
+// Stops writing for good, the nodes queued afterward are discarded
+- (void)PSY_failWithErrorNumber:(int)errorNumber;
+{
+    failed = YES;
+    [self PSY_discardWriteNodes];
+    
+    if(errorNumber == EPIPE)
+    {
+        if([[self delegate] respondsToSelector:@selector(streamWriterDidEncounterEnd:)])
+            [[self delegate] streamWriterDidEncounterEnd:self];
+    }
+    else if([[self delegate] respondsToSelector:@selector(streamWriter:didReceiveError:)])
+        [[self delegate] streamWriter:self didReceiveError:[NSError errorWithDomain:NSPOSIXErrorDomain code:errorNumber userInfo:nil]];
+}
+
+- (void)PSY_waitForSpaceAvailable;
+{
+    if(!writeSourceSuspended) return;
+    
+    // The writer stays alive until the descriptor has taken the rest of its writes
+    CFRetain((__bridge CFTypeRef)self);
+    writeSourceSuspended = NO;
+    dispatch_resume(writeSource);
+}
+
+// Reads the next buffer of the input stream at the head of the write list and puts it in front of the stream
+// The stream is read on the writer's queue, a stream that blocks delays the writes queued after it
+- (void)PSY_readInputStreamNode:(PSYDispatchWriteNode *)streamNode;
+{
+    NSInputStream *stream = (__bridge NSInputStream *)streamNode->object;
+    
+    if([stream streamStatus] == NSStreamStatusNotOpen) [stream open];
+    
+    PSYDispatchWriteNode *node = PSYDispatchWriteNodeCreate(PSYDispatchWriteNodeBytes, INPUT_STREAM_BUFFER_SIZE, _cmd);
+    NSInteger             read = [stream read:node->storage maxLength:INPUT_STREAM_BUFFER_SIZE];
+    
+    if(read > 0)
+    {
+        node->end  = read;
+        node->next = streamNode;
+        writeHead  = node;
+        
+        PSYDispatchStreamWriterCountQueuedBytes(self, read, YES);
+        return;
+    }
+    
+    PSYDispatchWriteNodeFree(node);
+    [self PSY_removeWriteHead];
+    
+    if(read < 0)
+    {
+        if([[self delegate] respondsToSelector:@selector(streamWriter:didReceiveError:)])
+            [[self delegate] streamWriter:self didReceiveError:[stream streamError]];
+    }
+    else if(streamNode->completion != NULL) ((__bridge void (^)(void))streamNode->completion)();
+    
+    PSYDispatchWriteNodeFree(streamNode);
+}
+
+// Writes the write list until it's empty or the descriptor is full
+- (void)PSY_writePendingNodes;
+{
+    BOOL wroteBytes = NO;
+    
+    while(writeHead != NULL)
+    {
+        if(writeHead->kind == PSYDispatchWriteNodeCompletion)
+        {
+            PSYDispatchWriteNode *node = writeHead;
+            [self PSY_removeWriteHead];
+            
+            ((__bridge void (^)(void))node->completion)();
+            PSYDispatchWriteNodeFree(node);
+            continue;
+        }
+        
+        if(writeHead->kind == PSYDispatchWriteNodeInputStream)
+        {
+            [self PSY_readInputStreamNode:writeHead];
+            continue;
+        }
+        
+        if(stagingBuffer == NULL)
+        {
+            stagingBuffer = malloc(STAGING_BUFFER_SIZE);
+            if(stagingBuffer == NULL) [NSException raise:NSMallocException format:@"*** -[PSYStreamWriter %@]: unable to allocate a write buffer", NSStringFromSelector(_cmd)];
+        }
+        
+        struct iovec vectors[MAX_IOVEC_COUNT];
+        int          count  = 0;
+        NSUInteger   total  = 0;
+        NSUInteger   staged = 0;
+        
+        // Small nodes are copied after each other into the staging buffer and share its vector,
+        // the bytes are consumed node by node afterward whatever vector they were written from
+        for(PSYDispatchWriteNode *node = writeHead; node != NULL && node->kind == PSYDispatchWriteNodeBytes; node = node->next)
+        {
+            NSUInteger length = node->end - node->start;
+            
+            if(length <= MAX_STAGED_LENGTH && staged + length <= STAGING_BUFFER_SIZE)
+            {
+                BOOL extendsVector = count > 0 && (uint8_t *)vectors[count - 1].iov_base + vectors[count - 1].iov_len == stagingBuffer + staged;
+                
+                if(!extendsVector)
+                {
+                    if(count == MAX_IOVEC_COUNT) break;
+                    
+                    vectors[count].iov_base = stagingBuffer + staged;
+                    vectors[count].iov_len  = 0;
+                    count++;
+                }
+                
+                memcpy(stagingBuffer + staged, node->bytes + node->start, length);
+                vectors[count - 1].iov_len += length;
+                staged += length;
+            }
+            else
+            {
+                if(count == MAX_IOVEC_COUNT) break;
+                
+                vectors[count].iov_base = (void *)(node->bytes + node->start);
+                vectors[count].iov_len  = length;
+                count++;
+            }
+            
+            total += length;
+        }
+        
+        ssize_t written = writev(fileDescriptor, vectors, count);
+        
+        PSY_COUNT_STATISTIC(self, writeCount, 1);
+        
+        if(written < 0)
+        {
+            if(errno == EINTR) continue;
+            
+            if(errno == EAGAIN || errno == EWOULDBLOCK) [self PSY_waitForSpaceAvailable];
+            else                                        [self PSY_failWithErrorNumber:errno];
+            
+            return;
+        }
+        
+        wroteBytes = YES;
+        __sync_sub_and_fetch(&pendingLength, (unsigned long long)written);
+        PSY_COUNT_STATISTIC(self, bytesWritten, written);
+        
+        for(NSUInteger consumed = written; consumed > 0;)
+        {
+            PSYDispatchWriteNode *node = writeHead;
+            NSUInteger toConsume = MIN(consumed, node->end - node->start);
+            
+            node->start += toConsume;
+            consumed    -= toConsume;
+            
+            if(node->start == node->end)
+            {
+                [self PSY_removeWriteHead];
+                PSYDispatchWriteNodeFree(node);
+            }
+        }
+        
+        // The descriptor took what it could, the rest waits for the write source
+        if((NSUInteger)written < total)
+        {
+            PSY_COUNT_STATISTIC(self, shortWriteCount, 1);
+            [self PSY_waitForSpaceAvailable];
+            return;
+        }
+    }
+    
+    if(wroteBytes && [[self delegate] respondsToSelector:@selector(streamWriterDidFinishWriting:)])
+        [[self delegate] streamWriterDidFinishWriting:self];
+}
+
+- (void)PSY_drain;
+{
+    [self PSY_takeQueuedNodes];
+    
+    if(failed) [self PSY_discardWriteNodes];
+    else       [self PSY_writePendingNodes];
+    
+    // Every push schedules a drain after it counted its bytes, so a producer that reached the high water mark
+    // while this drain went below the low one is followed by a drain that sees it
+    if(pendingLength <= lowWaterMark && __sync_bool_compare_and_swap(&aboveHighWaterMark, 1, 0) &&
+       [[self delegate] respondsToSelector:@selector(streamWriterDidDrainToLowWaterMark:)])
+        [[self delegate] streamWriterDidDrainToLowWaterMark:self];
+}
+
+@end
+
+@implementation PSYDispatchStreamWriterGroup
+
+- (id)initWithStreamWriter:(PSYDispatchStreamWriter *)aWriter completionBlock:(void (^)(void))completion;
+{
+    if((self = [super init]))
+    {
+        writer          = aWriter;
+        completionBlock = [completion copy];
+    }
+    
+    return self;
+}
+
+- (void)dealloc
+{
+    PSYDispatchWriteNodeFreeList(head);
+    PSYDispatchWriteNodeFreeList(queuedNodes);
+    
+#if !__has_feature(objc_arc)
+    [completionBlock release];
+    [super dealloc];
+#endif
+}
+
+- (id<PSYStreamWriterDelegate>)delegate                { return [writer delegate];   }
+- (void)setDelegate:(id<PSYStreamWriterDelegate>)value { [writer setDelegate:value]; }
+
+- (BOOL)collectsStatistics                  { return [writer collectsStatistics];   }
+- (void)setCollectsStatistics:(BOOL)value   { [writer setCollectsStatistics:value]; }
+- (PSYStreamWriterStatistics)statistics     { return [writer statistics];           }
+- (void)resetStatistics                     { [writer resetStatistics];             }
+
+- (PSYChecksumAlgorithm)checksumAlgorithm                { return [writer checksumAlgorithm];   }
+- (void)setChecksumAlgorithm:(PSYChecksumAlgorithm)value { [writer setChecksumAlgorithm:value]; }
+- (uint32_t)checksum                                     { return [writer checksum];            }
+- (void)resetChecksum                                    { [writer resetChecksum];              }
+
+- (NSUInteger)highWaterMark                 { return [writer highWaterMark];        }
+- (NSUInteger)lowWaterMark                  { return [writer lowWaterMark];         }
+- (BOOL)hasSpaceAvailable                   { return [writer hasSpaceAvailable];    }
+
+- (void)setHighWaterMark:(NSUInteger)high lowWaterMark:(NSUInteger)low;
+{
+    [writer setHighWaterMark:high lowWaterMark:low];
+}
+
+- (void)PSY_queueNode:(PSYDispatchWriteNode *)node length:(NSUInteger)length copied:(BOOL)copied;
+{
+    // The writer has moved past a sealed group, late writes go to the end of the writer
+    PSYDispatchStreamWriterGroup *group = sealed ? writer->rootGroup : self;
+    
+    PSYDispatchStreamWriterCountQueuedBytes(writer, length, copied);
+    PSYDispatchStreamWriterGroupChecksumAndPush(group, node);
+    PSYDispatchStreamWriterScheduleDrain(writer);
+}
+
+- (void)writeBytes:(const uint8_t *)buffer ofLength:(NSUInteger)length
+{
+    if(length == 0) return;
+    
+    PSYDispatchWriteNode *node = PSYDispatchWriteNodeCreate(PSYDispatchWriteNodeBytes, length, _cmd);
+    memcpy(node->storage, buffer, length);
+    
+    [self PSY_queueNode:node length:length copied:YES];
+}
+
+- (void)writeData:(NSData *)value
+{
+    NSUInteger length = [value length];
+    
+    if(length < MIN_SEGMENT_LENGTH)
+    {
+        [self writeBytes:[value bytes] ofLength:length];
+        return;
+    }
+    
+    // Copying immutable data only retains it
+    PSYDispatchWriteNode *node = PSYDispatchWriteNodeCreate(PSYDispatchWriteNodeBytes, 0, _cmd);
+    node->object = (__bridge_retained CFTypeRef)[value copy];
+    node->bytes  = [(__bridge NSData *)node->object bytes];
+    node->end    = length;
+    
+    // Mutable data had to be copied
+    [self PSY_queueNode:node length:length copied:(__bridge NSData *)node->object != value];
+}
+
+- (void)writeInputStream:(NSInputStream *)aStream completion:(void (^)(void))completion;
+{
+    if(aStream == nil) return;
+    
+    PSYDispatchWriteNode *node = PSYDispatchWriteNodeCreate(PSYDispatchWriteNodeInputStream, 0, _cmd);
+    node->object = CFRetain((__bridge CFTypeRef)aStream);
+    if(completion != nil) node->completion = (__bridge_retained CFTypeRef)[completion copy];
+    
+    [self PSY_queueNode:node length:0 copied:NO];
+}
+
+- (void)groupWrites:(void (^)(PSYStreamWriter *))writes completion:(void (^)(void))completion
+{
+    if(writes == nil) return;
+    
+    PSYDispatchStreamWriterGroup *group = [[PSYDispatchStreamWriterGroup alloc] initWithStreamWriter:writer completionBlock:completion];
+    
+    PSYDispatchWriteNode *node = PSYDispatchWriteNodeCreate(PSYDispatchWriteNodeGroup, 0, _cmd);
+    node->object = CFRetain((__bridge CFTypeRef)group);
+    
+    // The group takes its place before its block runs, its writes are written there
+    // whatever the other threads write meanwhile
+    [self PSY_queueNode:node length:0 copied:NO];
+    
+    @try
+    {
+        writes(group);
+    }
+    @finally
+    {
+        // Every write of the block is pushed before the group is sealed
+        __sync_synchronize();
+        group->sealed = YES;
+        PSYDispatchStreamWriterScheduleDrain(writer);
+        
+        RELEASE(group);
+    }
+}
+
+@end
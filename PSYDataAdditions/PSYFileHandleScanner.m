@@ -24,7 +24,13 @@
  */
 
 #import "PSYFileHandleScanner.h"
+#import "PSYDataScanner_Private.h"
 #import "PSYUtilities.h"
+#import "PSYDataSearch.h"
+#import "PSYMappedFileScanner.h"
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
 
 #if __LP64__
 #define CHUNK_SIZE (1024 * 512)
@@ -32,6 +38,16 @@
 #define CHUNK_SIZE 4096
 #endif
 
+#define DEFAULT_READ_AHEAD_DEPTH 2
+
+#define DEFAULT_BLOCK_SIZE          (1024 * 64)
+#define DEFAULT_BLOCK_CACHE_BUDGET  (1024 * 1024 * 16)
+
+// Bytes skipped past the cache are read on the stack to compute the checksum
+#define CHECKSUM_READ_SIZE (1024 * 16)
+
+#define PSYNotFoundLocation ULLONG_MAX
+
 typedef struct _PSYRange { unsigned long long location, length; } PSYRange;
 
 static PSYRange PSYRangeMake(unsigned long long loc, unsigned long long len)
@@ -49,26 +65,150 @@ static BOOL PSYLocationInRange(PSYRange range, unsigned long long loc)
     return range.location <= loc && loc < PSYRangeMax(range);
 }
 
+// Reads length bytes at offset without moving the offset of the descriptor, which is shared by the clones
+// Returns the number of bytes read, less than length at the end of the file or on error,
+// the number of pread calls is added to *callCount
+static NSUInteger PSYReadFileBytes(int fileDescriptor, uint8_t *bytes, NSUInteger length, unsigned long long offset, NSUInteger *callCount)
+{
+    NSUInteger read = 0;
+    
+    while(read < length)
+    {
+        ssize_t result = pread(fileDescriptor, bytes + read, length - read, (off_t)(offset + read));
+        (*callCount)++;
+        
+        if(result > 0) read += result;
+        else if(result < 0 && errno == EINTR) continue;
+        else break;
+    }
+    
+    return read;
+}
+
+// Window of the file read in the background, its data is ready once filled is signaled
+@interface PSYReadAheadWindow : NSObject
+{
+@public
+    NSMutableData        *data;
+    unsigned long long    offset;
+    NSUInteger            readCount;
+    dispatch_semaphore_t  filled;
+}
+@end
+
+// Keeps depth windows of the file being read with pread on a serial queue,
+// ahead of the offset the scanner consumes, the buffers are handed to the scanner
+// and given back once it's done with them so no memory is allocated while reading
+@interface PSYFileReadAhead : NSObject
+{
+@public
+    NSUInteger      windowCount;
+    NSUInteger      waitCount;
+    NSTimeInterval  waitDuration;
+}
+
+- (id)initWithFileDescriptor:(int)fileDescriptor fileLength:(unsigned long long)fileLength windowSize:(NSUInteger)windowSize depth:(NSUInteger)depth;
+
+@property(readonly, nonatomic) NSUInteger windowSize;
+@property(readonly, nonatomic) NSUInteger depth;
+
+// Returns the bytes of the file starting at offset, blocking until they're read,
+// the data is shorter than the window size at the end of the file
+// Reading ahead restarts from offset if it isn't where the previous window ended
+// The number of pread calls that read the window is added to *readCount
+- (NSMutableData *)dequeueDataAtOffset:(unsigned long long)offset readCount:(NSUInteger *)readCount NS_RETURNS_RETAINED;
+
+// Gives a buffer to fill with the next window
+- (void)enqueueData:(NSMutableData *)data;
+
+@end
+
+// Block of the file linked from the most to the least recently used
+@interface PSYFileBlock : NSObject
+{
+@public
+    unsigned long long                 index;
+    NSData                            *data;
+    __unsafe_unretained PSYFileBlock  *previous;
+    __unsafe_unretained PSYFileBlock  *next;
+}
+@end
+
+// Least recently used cache of the blocks of the file, read with pread on a miss
+// The blocks are aligned on the block size, only the last one of the file is shorter
+// Clones of a scanner share its cache, the lookups are synchronized but the reads are not
+@interface PSYFileBlockCache : NSObject
+{
+@public
+    NSUInteger  blockSize;
+    NSUInteger  hitCount;
+    NSUInteger  missCount;
+}
+
+- (id)initWithFileDescriptor:(int)fileDescriptor fileLength:(unsigned long long)fileLength blockSize:(NSUInteger)blockSize memoryBudget:(NSUInteger)memoryBudget;
+
+// Returns the block at index, nil past the end of the file or if the block couldn't be read
+// Evicted blocks are only released, the data remains valid for as long as it's retained
+// The number of pread calls is added to *readCount, it is left unchanged when the block was in the cache
+- (NSData *)blockAtIndex:(unsigned long long)index readCount:(NSUInteger *)readCount;
+
+@end
+
 @interface PSYFileHandleScanner ()
 {
     NSFileHandle       *_fileHandle;
     unsigned long long  _fileLength;
+    PSYFileReadAhead   *_readAhead;
+    PSYFileBlockCache  *_blockCache;
     
-    NSMutableData      *_cacheData;
+    // Mutable unless it's a block of the block cache
+    NSData             *_cacheData;
     PSYRange            _cacheRange;
     unsigned long long  _cacheScanLocation;
     
     unsigned int        _useCacheOffset:1;
+    unsigned int        _cacheIsBlock:1;
+    unsigned int        _readsThroughFileHandle:1; // the handle has no descriptor pread works with
 }
 
 - (BOOL)PSY_cacheIsAtEnd;
-- (void)PSY_resetCachedData;
+
+// Empties the cache, the next chunk is read at location
+- (void)PSY_resetCachedDataAtLocation:(unsigned long long)location;
+
+// Removes the bytes before the scan location from the cache
+- (void)PSY_discardScannedCache;
+
+// Reads length bytes at offset with pread, the offset of the file handle is never used
+// Handles without a descriptor that pread can read, like subclasses of NSFileHandle, are read
+// with -readDataOfLength: after seeking to offset instead
+// Returns the number of bytes read, the number of reads is added to *callCount
+- (NSUInteger)PSY_readBytes:(uint8_t *)bytes length:(NSUInteger)length atOffset:(unsigned long long)offset callCount:(NSUInteger *)callCount;
+
+// Reads up to CHUNK_SIZE bytes following the cache and appends them to the cache
+// Returns the number of bytes read, 0 means the end of the file was reached
+- (NSUInteger)PSY_appendNextChunk;
+
+// Takes the next read-ahead window, it replaces the cache if it was entirely scanned
+- (NSUInteger)PSY_appendNextWindow;
+
+// Takes the block following the cache from the block cache, the block becomes the cache
+// if it was entirely scanned, otherwise the rest of the cache and the block are stitched together
+- (NSUInteger)PSY_appendNextBlock;
 
 // Reads CHUNK_SIZE and update the cache if length is out of the bounds of the cache
 // If the file handle can't return enough data in one shot,
 // it will attempt to read more until the length parameter is covered
 - (void)PSY_readAndCacheDataOfLength:(unsigned long long)length;
 
+// Searches the bytes from the scan location and returns their location in the file or PSYNotFoundLocation
+// The cache is extended chunk by chunk so matches straddling two chunks are found,
+// if discard is YES the bytes that cannot be part of a match anymore are dropped as the cache grows,
+// which moves the scan location forward, the caller has to set the scan location afterward
+// When searching for a null terminator, only the locations that are a multiple
+// of the terminator length from the scan location are considered
+- (unsigned long long)PSY_locationOfBytes:(const void *)bytes length:(NSUInteger)length nullTerminator:(BOOL)isNullTerminator discardingScannedData:(BOOL)discard;
+
 @end
 
 @implementation PSYFileHandleScanner
@@ -80,60 +220,334 @@ static BOOL PSYLocationInRange(PSYRange range, unsigned long long loc)
         _fileHandle = RETAIN(fileToScan);
         _cacheData  = [[NSMutableData alloc] init];
         
-        unsigned long long loc = [_fileHandle offsetInFile];
-        _fileLength = [_fileHandle seekToEndOfFile];
+        int         fileDescriptor = [_fileHandle fileDescriptor];
+        struct stat status;
         
-        [_fileHandle seekToFileOffset:loc];
+        // The offset of the handle is only moved for a handle without a descriptor
+        if(fileDescriptor >= 0 && fstat(fileDescriptor, &status) == 0 && S_ISREG(status.st_mode))
+            _fileLength = (unsigned long long)status.st_size;
+        else
+        {
+            unsigned long long loc = [_fileHandle offsetInFile];
+            _fileLength = [_fileHandle seekToEndOfFile];
+            
+            [_fileHandle seekToFileOffset:loc];
+        }
+        
+        _readsThroughFileHandle = fileDescriptor < 0;
+    }
+    return self;
+}
+
+- (id)initWithFileHandle:(NSFileHandle *)fileToScan readAheadWindowSize:(NSUInteger)windowSize depth:(NSUInteger)depth;
+{
+    // The windows are read with pread, a handle without a descriptor is read chunk by chunk
+    if((self = [self initWithFileHandle:fileToScan]) && !_readsThroughFileHandle)
+    {
+        _readAhead = [[PSYFileReadAhead alloc] initWithFileDescriptor:[_fileHandle fileDescriptor]
+                                                           fileLength:_fileLength
+                                                           windowSize:windowSize > 0 ? windowSize : CHUNK_SIZE
+                                                                depth:depth > 0 ? depth : DEFAULT_READ_AHEAD_DEPTH];
     }
     return self;
 }
 
+- (id)initWithFileHandle:(NSFileHandle *)fileToScan blockSize:(NSUInteger)blockSize memoryBudget:(NSUInteger)memoryBudget;
+{
+    // The blocks are read with pread, a handle without a descriptor is read chunk by chunk
+    if((self = [self initWithFileHandle:fileToScan]) && !_readsThroughFileHandle)
+    {
+        _blockCache = [[PSYFileBlockCache alloc] initWithFileDescriptor:[_fileHandle fileDescriptor]
+                                                             fileLength:_fileLength
+                                                              blockSize:blockSize > 0 ? blockSize : DEFAULT_BLOCK_SIZE
+                                                           memoryBudget:memoryBudget > 0 ? memoryBudget : DEFAULT_BLOCK_CACHE_BUDGET];
+    }
+    return self;
+}
+
+// Clones share the file handle and the block cache, they get their own read-ahead
+- (id)PSY_initWithScanner:(PSYFileHandleScanner *)scanner;
+{
+    if((self = [super init]))
+    {
+        _fileHandle = RETAIN(scanner->_fileHandle);
+        _fileLength = scanner->_fileLength;
+        _blockCache = RETAIN(scanner->_blockCache);
+        _cacheData  = [[NSMutableData alloc] init];
+        
+        _readsThroughFileHandle = scanner->_readsThroughFileHandle;
+        
+        if(scanner->_readAhead != nil)
+            _readAhead = [[PSYFileReadAhead alloc] initWithFileDescriptor:[_fileHandle fileDescriptor]
+                                                               fileLength:_fileLength
+                                                               windowSize:[scanner->_readAhead windowSize]
+                                                                    depth:[scanner->_readAhead depth]];
+    }
+    return self;
+}
+
+- (PSYDataScanner *)scannerByCloningAtLocation:(unsigned long long)location
+{
+    PSYFileHandleScanner *clone = [[PSYFileHandleScanner alloc] PSY_initWithScanner:self];
+    [clone setScanLocation:location];
+    [clone setStringInterningCapacity:[self stringInterningCapacity]];
+    
+    return AUTORELEASE(clone);
+}
+
 #if !__has_feature(objc_arc)
 - (void)dealloc
 {
     [_fileHandle release];
     [_cacheData release];
+    [_readAhead release];
+    [_blockCache release];
     [super dealloc];
 }
 #endif
 
+- (NSUInteger)readAheadWindowCount      { return _readAhead != nil ? _readAhead->windowCount  : 0; }
+- (NSUInteger)readAheadWaitCount        { return _readAhead != nil ? _readAhead->waitCount    : 0; }
+- (NSTimeInterval)readAheadWaitDuration { return _readAhead != nil ? _readAhead->waitDuration : 0; }
+- (NSUInteger)blockCacheHitCount        { return _blockCache != nil ? _blockCache->hitCount    : 0; }
+- (NSUInteger)blockCacheMissCount       { return _blockCache != nil ? _blockCache->missCount   : 0; }
+
 - (BOOL)PSY_cacheIsAtEnd;
 {
     return PSYRangeMax(_cacheRange) >= _fileLength;
 }
 
-- (void)PSY_resetCachedData;
+- (void)PSY_resetCachedDataAtLocation:(unsigned long long)location;
 {
-    [_cacheData setLength:0];
+    // A block is never modified, it is simply replaced by the next one
+    if(!_cacheIsBlock) [(NSMutableData *)_cacheData setLength:0];
     
-    _cacheRange.location = [_fileHandle offsetInFile];
+    _cacheRange.location = location;
     _cacheRange.length   = 0;
     _cacheScanLocation   = 0;
 }
 
-- (void)PSY_readAndCacheDataOfLength:(unsigned long long)length;
+- (void)PSY_discardScannedCache;
 {
-    length = MIN(length, CHUNK_SIZE);
+    // The bytes of a block are dropped when it's stitched with the next one
+    if(_cacheScanLocation == 0 || _cacheIsBlock) return;
     
-    if(_cacheScanLocation + length <= _cacheRange.length) return;
+    // The bytes left in the cache are moved to its beginning
+    PSYDataScannerCount(bytesCopied, _cacheRange.length - _cacheScanLocation);
     
-    // We cached the data at the end of the file we can't go further
-    if(PSYRangeMax(_cacheRange) >= _fileLength) return;
-    
-    // Remove the cache that we already read to avoid caching too much memory
-    [_cacheData replaceBytesInRange:NSMakeRange(0, _cacheScanLocation) withBytes:NULL length:0];
+    [(NSMutableData *)_cacheData replaceBytesInRange:NSMakeRange(0, (NSUInteger)_cacheScanLocation) withBytes:NULL length:0];
     _cacheRange.location += _cacheScanLocation;
     _cacheRange.length   -= _cacheScanLocation;
     _cacheScanLocation    = 0;
+}
+
+- (NSUInteger)PSY_readBytes:(uint8_t *)bytes length:(NSUInteger)length atOffset:(unsigned long long)offset callCount:(NSUInteger *)callCount;
+{
+    NSUInteger read = 0;
+    
+    if(!_readsThroughFileHandle)
+    {
+        errno = 0;
+        read  = PSYReadFileBytes([_fileHandle fileDescriptor], bytes, length, offset, callCount);
+        
+        // Pipes and handles that don't read a descriptor of their own fail right away
+        if(read == length || (errno != EBADF && errno != ESPIPE)) return read;
+        
+        _readsThroughFileHandle = YES;
+    }
     
-    // Prepare to read from the location after what we already cached
-    [_fileHandle seekToFileOffset:PSYRangeMax(_cacheRange)];
+    [_fileHandle seekToFileOffset:offset + read];
+    
+    while(read < length)
+    {
+        NSData *data = [_fileHandle readDataOfLength:length - read];
+        (*callCount)++;
+        
+        if([data length] == 0) break;
+        
+        [data getBytes:bytes + read length:[data length]];
+        read += [data length];
+    }
+    
+    return read;
+}
+
+- (NSUInteger)PSY_appendNextChunk;
+{
+    // We cached the data at the end of the file we can't go further
+    if(PSYRangeMax(_cacheRange) >= _fileLength) return 0;
+    
+    PSYDataScannerCount(refillCount, 1);
+    
+    if(_readAhead  != nil) return [self PSY_appendNextWindow];
+    if(_blockCache != nil) return [self PSY_appendNextBlock];
+    
+    // Read from the location after what we already cached straight into the cache
+    NSMutableData      *cacheData = (NSMutableData *)_cacheData;
+    NSUInteger          cached    = [cacheData length];
+    unsigned long long  offset    = PSYRangeMax(_cacheRange);
+    NSUInteger          length    = (NSUInteger)MIN(CHUNK_SIZE, _fileLength - offset);
+    
+    [cacheData setLength:cached + length];
+    
+    NSUInteger calls = 0;
+    NSUInteger read  = [self PSY_readBytes:(uint8_t *)[cacheData mutableBytes] + cached length:length atOffset:offset callCount:&calls];
+    if(read < length) [cacheData setLength:cached + read];
+    
+    PSYDataScannerCount(readCount, calls);
+    PSYDataScannerCount(bytesRead, read);
+    
+    _cacheRange.length += read;
+    return read;
+}
+
+- (NSUInteger)PSY_appendNextWindow;
+{
+    NSUInteger     calls  = 0;
+    NSMutableData *window = [_readAhead dequeueDataAtOffset:PSYRangeMax(_cacheRange) readCount:&calls];
+    NSUInteger     read   = [window length];
+    
+    PSYDataScannerCount(readCount, calls);
+    PSYDataScannerCount(bytesRead, read);
+    
+    if(_cacheScanLocation == _cacheRange.length)
+    {
+        // Nothing is left to scan in the cache, swap it with the window instead of copying the window
+        [_readAhead enqueueData:(NSMutableData *)_cacheData];
+        RELEASE(_cacheData);
+        _cacheData = window;
+        
+        _cacheRange.location += _cacheRange.length;
+        _cacheRange.length    = read;
+        _cacheScanLocation    = 0;
+    }
+    else
+    {
+        // A value straddles the two windows, they have to be contiguous
+        [(NSMutableData *)_cacheData appendData:window];
+        _cacheRange.length += read;
+        
+        PSYDataScannerCount(bytesCopied, read);
+        
+        [_readAhead enqueueData:window];
+        RELEASE(window);
+    }
+    
+    return read;
+}
+
+- (NSUInteger)PSY_appendNextBlock;
+{
+    unsigned long long  offset = PSYRangeMax(_cacheRange);
+    unsigned long long  index  = offset / _blockCache->blockSize;
+    NSUInteger          calls  = 0;
+    NSData             *block  = [_blockCache blockAtIndex:index readCount:&calls];
+    
+    if(calls > 0)
+    {
+        PSYDataScannerCount(cacheMissCount, 1);
+        PSYDataScannerCount(readCount, calls);
+        PSYDataScannerCount(bytesRead, [block length]);
+    }
+    else if(block != nil)
+        PSYDataScannerCount(cacheHitCount, 1);
+    
+    // The cache starts in the middle of the block after a seek
+    NSUInteger skip = (NSUInteger)(offset - index * _blockCache->blockSize);
+    NSUInteger read = [block length] > skip ? [block length] - skip : 0;
+    
+    if(read == 0) return 0;
+    
+    if(_cacheScanLocation == _cacheRange.length)
+    {
+        // Nothing is left to scan in the cache, the block becomes the cache without being copied
+        if(_cacheData != block)
+        {
+            RELEASE(_cacheData);
+            _cacheData = RETAIN(block);
+        }
+        
+        _cacheIsBlock      = YES;
+        _cacheRange        = PSYRangeMake(offset - skip, [block length]);
+        _cacheScanLocation = skip;
+    }
+    else
+    {
+        // A value straddles the two blocks, the rest of the cache is copied with the block
+        if(_cacheIsBlock)
+        {
+            NSUInteger     rest     = (NSUInteger)(_cacheRange.length - _cacheScanLocation);
+            NSMutableData *stitched = [[NSMutableData alloc] initWithCapacity:rest + read];
+            
+            [stitched appendBytes:(const uint8_t *)[_cacheData bytes] + _cacheScanLocation length:rest];
+            PSYDataScannerCount(bytesCopied, rest);
+            RELEASE(_cacheData);
+            _cacheData    = stitched;
+            _cacheIsBlock = NO;
+            
+            _cacheRange.location += _cacheScanLocation;
+            _cacheRange.length    = rest;
+            _cacheScanLocation    = 0;
+        }
+        
+        [(NSMutableData *)_cacheData appendBytes:(const uint8_t *)[block bytes] + skip length:read];
+        _cacheRange.length += read;
+        
+        PSYDataScannerCount(bytesCopied, read);
+    }
+    
+    return read;
+}
+
+- (void)PSY_readAndCacheDataOfLength:(unsigned long long)length;
+{
+    if(_cacheScanLocation + length <= _cacheRange.length) return;
+    
+    // Remove the cache that we already read to avoid caching too much memory
+    [self PSY_discardScannedCache];
     
     // We assume that the file handle may return less than CHUNK_SIZE
-    while(_cacheRange.length < length)
+    while(_cacheRange.length - _cacheScanLocation < length)
+        if([self PSY_appendNextChunk] == 0) break;
+}
+
+- (unsigned long long)PSY_locationOfBytes:(const void *)bytes length:(NSUInteger)length nullTerminator:(BOOL)isNullTerminator discardingScannedData:(BOOL)discard;
+{
+    // Offset from the scan location where the next search starts
+    unsigned long long searchStart = 0;
+    
+    while(YES)
     {
-        [_cacheData appendData:[_fileHandle readDataOfLength:CHUNK_SIZE - _cacheRange.length]];
-        _cacheRange.length = [_cacheData length];
+        unsigned long long  available = _cacheRange.length - _cacheScanLocation;
+        const uint8_t      *buffer    = (const uint8_t *)[_cacheData bytes] + _cacheScanLocation + searchStart;
+        
+        NSUInteger found = (isNullTerminator
+                            ? PSYFindNullTerminator(buffer, (NSUInteger)(available - searchStart), length)
+                            : PSYFindBytes(buffer, (NSUInteger)(available - searchStart), bytes, length));
+        
+        if(found != NSNotFound) return _cacheRange.location + _cacheScanLocation + searchStart + found;
+        
+        // The last length - 1 bytes may be the beginning of a match that continues in the next chunk
+        if(available >= length)
+        {
+            searchStart = available - length + 1;
+            
+            // Null terminators are only matched on their own alignment
+            if(isNullTerminator) searchStart = (searchStart + length - 1) / length * length;
+        }
+        
+        if(discard && searchStart > 0)
+        {
+            // The discarded bytes are only checksummed once the scan succeeds, they're read again then
+            PSYDataScannerCount(bytesScanned, searchStart);
+            _cacheScanLocation += searchStart;
+            searchStart = 0;
+        }
+        
+        // The scanned bytes are only dropped when a chunk is read so the cache isn't moved for every record
+        [self PSY_discardScannedCache];
+        
+        if([self PSY_appendNextChunk] == 0) return PSYNotFoundLocation;
     }
 }
 
@@ -144,15 +558,60 @@ static BOOL PSYLocationInRange(PSYRange range, unsigned long long loc)
 
 - (void)setScanLocation:(unsigned long long)value
 {
+    if(_statistics != NULL)
+    {
+        unsigned long long location = [self scanLocation];
+        if(value > location) _statistics->bytesScanned += value - location;
+    }
+    
+    if(_checksumAlgorithm != PSYChecksumNone) [self PSY_checksumBytesUpToLocation:_useCacheOffset ? _cacheRange.location + value : value];
+    
+    // The end of the cache is kept too, so the bytes scanned without a copy up to it stay valid
     if(_useCacheOffset)
         _cacheScanLocation = value;
-    else if(PSYLocationInRange(_cacheRange, value))
+    else if(PSYLocationInRange(_cacheRange, value) || value == PSYRangeMax(_cacheRange))
         _cacheScanLocation = value - _cacheRange.location;
     else
     {
         // If the scan location is outside of the cached range, trash the whole cached data
-        [_fileHandle seekToFileOffset:value];
-        [self PSY_resetCachedData];
+        [self PSY_resetCachedDataAtLocation:value];
+    }
+}
+
+// Adds the bytes from the scan location up to location to the checksum before the cache moves,
+// the bytes outside of the cache are read from the file in chunks without being cached, those before it
+// were discarded by a search that went past them
+- (void)PSY_checksumBytesUpToLocation:(unsigned long long)location;
+{
+    unsigned long long current  = _cacheRange.location + _cacheScanLocation;
+    unsigned long long cacheEnd = MIN(location, PSYRangeMax(_cacheRange));
+    
+    if(_checksumLocation < current) [self PSY_checksumFileBytesFromLocation:_checksumLocation toLocation:MIN(current, location)];
+    
+    if(cacheEnd > current)
+    {
+        PSYDataScannerChecksum(current, (const uint8_t *)[_cacheData bytes] + _cacheScanLocation, cacheEnd - current);
+        current = cacheEnd;
+    }
+    
+    [self PSY_checksumFileBytesFromLocation:MAX(current, _checksumLocation) toLocation:location];
+}
+
+- (void)PSY_checksumFileBytesFromLocation:(unsigned long long)current toLocation:(unsigned long long)location;
+{
+    uint8_t buffer[CHECKSUM_READ_SIZE];
+    while(current < location)
+    {
+        NSUInteger calls = 0;
+        NSUInteger read  = [self PSY_readBytes:buffer length:(NSUInteger)MIN(sizeof(buffer), location - current) atOffset:current callCount:&calls];
+        
+        PSYDataScannerCount(readCount, calls);
+        PSYDataScannerCount(bytesRead, read);
+        
+        if(read == 0) break;
+        
+        PSYDataScannerChecksum(current, buffer, read);
+        current += read;
     }
 }
 
@@ -161,6 +620,28 @@ static BOOL PSYLocationInRange(PSYRange range, unsigned long long loc)
     return _useCacheOffset ? _cacheData : nil;
 }
 
+- (unsigned long long)dataLength
+{
+    return _useCacheOffset ? _cacheRange.length : _fileLength;
+}
+
+- (NSData *)PSY_dataForEnumeration;
+{
+    // The records are sliced from a mapping of the file rather than copied out of the cache,
+    // a handle without a descriptor is enumerated through the scanner
+    if(_readsThroughFileHandle) return nil;
+    
+    return AUTORELEASE([[PSYMappedData alloc] initWithFileDescriptor:[_fileHandle fileDescriptor]]);
+}
+
+- (const uint8_t *)PSY_bytesAtScanLocationWithMinimumLength:(unsigned long long)minimumLength availableLength:(unsigned long long *)availableLength;
+{
+    [self PSY_readAndCacheDataOfLength:minimumLength];
+    
+    *availableLength = _cacheRange.length - _cacheScanLocation;
+    return (const uint8_t *)[_cacheData bytes] + _cacheScanLocation;
+}
+
 - (BOOL)scanData:(NSData **)value ofLength:(unsigned long long)length
 {
     unsigned long long loc = _cacheRange.location + _cacheScanLocation;
@@ -168,42 +649,36 @@ static BOOL PSYLocationInRange(PSYRange range, unsigned long long loc)
     
     if(value != NULL)
     {
-        NSMutableData      *data         = [[NSMutableData alloc] initWithCapacity:length];
-        NSData             *cacheData    = [_cacheData copy];
-        PSYRange            cacheRange   = _cacheRange;
-        unsigned long long  cacheScanLoc = _cacheScanLocation;
+        // The bytes are copied chunk by chunk so the cache doesn't grow to the length of the data
+        NSMutableData *data = [[NSMutableData alloc] initWithCapacity:(NSUInteger)length];
         
-        for(unsigned long long read = 0; read < length;)
+        while([data length] < length)
         {
-            if(cacheScanLoc >= cacheRange.length)
+            if(_cacheScanLocation >= _cacheRange.length)
             {
-                @autoreleasepool
+                [self PSY_discardScannedCache];
+                
+                // The file was truncated
+                if([self PSY_appendNextChunk] == 0)
                 {
-                    RELEASE(cacheData);
-                    cacheData = RETAIN([_fileHandle readDataOfLength:CHUNK_SIZE]);
+                    RELEASE(data);
+                    [self setScanLocation:loc];
+                    return NO;
                 }
-                
-                cacheRange.length   = [cacheData length];
-                cacheRange.location = [_fileHandle offsetInFile] - cacheRange.length;
-                cacheScanLoc        = 0;
             }
             
-            unsigned long long availLen = MIN(length - read, cacheRange.length - cacheScanLoc);
+            NSUInteger available = (NSUInteger)MIN(length - [data length], _cacheRange.length - _cacheScanLocation);
             
-            const unsigned char *buf = [cacheData bytes];
-            [data appendBytes:buf + cacheScanLoc length:availLen];
+            [data appendBytes:(const uint8_t *)[_cacheData bytes] + _cacheScanLocation length:available];
+            PSYDataScannerChecksum(_cacheRange.location + _cacheScanLocation, (const uint8_t *)[_cacheData bytes] + _cacheScanLocation, available);
+            _cacheScanLocation += available;
             
-            read         += availLen;
-            cacheScanLoc += availLen;
+            PSYDataScannerCount(bytesScanned, available);
         }
         
+        // The bytes are copied out of the cache and once more by -copy
+        PSYDataScannerCount(bytesCopied, length * 2);
         *value = AUTORELEASE([data copy]);
-        
-        [_cacheData setData:cacheData];
-        _cacheRange        = cacheRange;
-        _cacheScanLocation = cacheScanLoc;
-        
-        RELEASE(cacheData);
         RELEASE(data);
     }
     
@@ -214,283 +689,95 @@ static BOOL PSYLocationInRange(PSYRange range, unsigned long long loc)
 
 - (BOOL)scanData:(NSData *)data intoData:(NSData **)value
 {
-    PSYRange           cacheRange = _cacheRange;
-    unsigned long long length     = [data length];
-    unsigned long long loc        = cacheRange.location + _cacheScanLocation;
+    unsigned long long length = [data length];
+    unsigned long long loc    = _cacheRange.location + _cacheScanLocation;
     if(length == 0 || loc + length > _fileLength) return NO;
     
-    const unsigned char *dataBuffer   = [data bytes];
-    unsigned long long   dataLoc      = 0;
-    unsigned long long   locLimit     = loc + length;
-    
-    NSData              *cacheData    = [_cacheData copy];
-    const unsigned char *cacheBuffer  = [cacheData bytes];
-    
-    BOOL hasFoundData = YES;
-    
-    for(unsigned long long scannedLoc = loc; scannedLoc < locLimit; scannedLoc++)
-    {
-        if(scannedLoc >= PSYRangeMax(cacheRange))
-        {
-            @autoreleasepool
-            {
-                RELEASE(cacheData);
-                cacheData   = RETAIN([_fileHandle readDataOfLength:CHUNK_SIZE]);
-                cacheBuffer = [cacheData bytes];
-            }
-            
-            cacheRange.length   = [cacheData length];
-            cacheRange.location = [_fileHandle offsetInFile] - cacheRange.length;
-        }
-        
-        if(cacheBuffer[scannedLoc - cacheRange.location] == dataBuffer[dataLoc])
-            dataLoc++;
-        else
-        {
-            hasFoundData = NO;
-            break;
-        }
-    }
+    // The compared data is in memory already, the cache can hold as much
+    [self PSY_readAndCacheDataOfLength:length];
     
-    if(hasFoundData)
-    {
-        // A "proper" implementation would extract the data from the actual file
-        // but it doesn't really matter as it is supposed to be equal
-        if(value != NULL) *value = AUTORELEASE([data copy]);
+    if(_cacheRange.length - _cacheScanLocation < length ||
+       memcmp((const uint8_t *)[_cacheData bytes] + _cacheScanLocation, [data bytes], (size_t)length) != 0)
+        return NO;
     
-        [_cacheData setData:cacheData];
-        _cacheRange        = cacheRange;
-        _cacheScanLocation = locLimit - _cacheRange.location;
-    }
+    // A "proper" implementation would extract the data from the actual file
+    // but it doesn't really matter as it is supposed to be equal
+    if(value != NULL) *value = AUTORELEASE([data copy]);
     
-    RELEASE(cacheData);
+    PSYDataScannerCount(bytesScanned, length);
+    PSYDataScannerChecksum(_cacheRange.location + _cacheScanLocation, (const uint8_t *)[_cacheData bytes] + _cacheScanLocation, length);
+    _cacheScanLocation += length;
     
-    return hasFoundData;
+    return YES;
 }
 
 - (BOOL)scanUpToData:(NSData *)stopData intoData:(NSData **)value options:(PSYDataScannerOptions)options
+{
+    return [self PSY_scanUpToData:stopData options:options bytesHandler:value == NULL ? nil : ^(const uint8_t *bytes, NSUInteger length) {
+        *value = [NSData dataWithBytes:bytes length:length];
+        PSYDataScannerCount(bytesCopied, length);
+    }];
+}
+
+- (BOOL)PSY_scanUpToData:(NSData *)stopData options:(PSYDataScannerOptions)options bytesHandler:(void (^)(const uint8_t *bytes, NSUInteger length))bytesHandler;
 {
     unsigned long long length = [stopData length];
-    unsigned long long loc    = [_fileHandle offsetInFile];
-    
-    if(length == 0 || (!(options & PSYDataScannerRequireStopData) && loc + length > _fileLength))
-    {
-        if(value != NULL)
-        {
-            [_fileHandle seekToFileOffset:_cacheRange.location + _cacheScanLocation];
-            *value = [_fileHandle readDataToEndOfFile];
-        }
-        
-        [self setScanLocation:_fileLength];
-        return YES;
-    }
-    else if((options & PSYDataScannerRequireStopData) && loc + length > _fileLength) return NO;
-    
-    NSData              *cacheData    = [_cacheData copy];
-    const unsigned char *cacheBuffer  = [cacheData bytes];
-    PSYRange             cacheRange   = _cacheRange;
-    unsigned long long   cacheScanLoc = _cacheScanLocation;
+    unsigned long long loc    = [self scanLocation];
+    unsigned long long found  = PSYNotFoundLocation;
     
-    const unsigned char *stopBuffer   = [stopData bytes];
-    NSMutableData       *retBuffer    = value != NULL ? [[NSMutableData alloc] init] : nil;
-    PSYRange             dataLocation = PSYRangeMake(loc, 0);
-    unsigned long long   stopLoc      = 0;
+    if(length > 0 && loc + length <= _fileLength)
+        found = [self PSY_locationOfBytes:[stopData bytes] length:(NSUInteger)length nullTerminator:NO discardingScannedData:bytesHandler == nil];
     
-    for(unsigned long long scannedLoc = loc; scannedLoc + (length - stopLoc) <= _fileLength; scannedLoc++)
+    if(found == PSYNotFoundLocation)
     {
-        if(scannedLoc >= PSYRangeMax(cacheRange))
+        if((options & PSYDataScannerRequireStopData) || loc >= _fileLength)
         {
-            if(retBuffer != nil)
-                [retBuffer appendData:(cacheScanLoc == 0
-                                       ? cacheData
-                                       : [cacheData subdataWithRange:NSMakeRange(cacheScanLoc, cacheRange.length - cacheScanLoc)])];
-            @autoreleasepool
-            {
-                RELEASE(cacheData);
-                cacheData   = RETAIN([_fileHandle readDataOfLength:CHUNK_SIZE]);
-                cacheBuffer = [cacheData bytes];
-            }
-            
-            cacheRange.length   = [cacheData length];
-            cacheRange.location = [_fileHandle offsetInFile] - cacheRange.length;
-            cacheScanLoc        = 0;
+            [self setScanLocation:loc];
+            return NO;
         }
         
-        // If the current stopBuffer byte is equal to the current scanned byte,
-        // increment the stop location to scan check the next bytes in both buffer
-        // otherwise, reset the stop location so the next scanned byte is compared with the first stop byte
-        if(cacheBuffer[scannedLoc - cacheRange.location] == stopBuffer[stopLoc])
-            stopLoc++;
-        else
+        // The data was not found, hand the whole rest of the file
+        if(bytesHandler != nil)
         {
-            dataLocation.location = scannedLoc + 1;
-            stopLoc = 0;
+            [self PSY_readAndCacheDataOfLength:_fileLength - loc];
+            bytesHandler((const uint8_t *)[_cacheData bytes] + _cacheScanLocation, (NSUInteger)(_cacheRange.length - _cacheScanLocation));
         }
         
-        // If the stop location is equal to the length of the stopData
-        // it means we fully matched the data, break out of the loop
-        if(stopLoc >= length)
-        {
-            dataLocation.length = length;
-            break;
-        }
-    }
-    
-    if(dataLocation.length == length)
-    {
-        // The beginning of the stop data is in the data we already bufferized
-        if(dataLocation.location < cacheRange.location)
-        {
-            if(value != NULL)
-            {
-                // We need to truncate the bufferized data before sending it back to the caller
-                unsigned long long trashedLength = cacheRange.location - dataLocation.location;
-                [retBuffer replaceBytesInRange:NSMakeRange([retBuffer length] - trashedLength, trashedLength) withBytes:NULL length:0];
-                *value = AUTORELEASE(retBuffer);
-            }
-        }
-        // The beginning of the stop data is in the current buffer, append whatever is missing to the returned value
-        else
-        {
-            if(value != NULL)
-            {
-                [retBuffer appendBytes:cacheBuffer length:dataLocation.location - cacheRange.location];
-                *value = AUTORELEASE(retBuffer);
-            }
-            
-            [_cacheData setData:cacheData];
-            _cacheRange = cacheRange;
-        }
-        
-        [self setScanLocation:(options & PSYDataScannerMoveAfterStopData ? PSYRangeMax(dataLocation) : dataLocation.location)];
-    }
-    else if(options & PSYDataScannerRequireStopData)
-    {
-        RELEASE(cacheData);
-        RELEASE(retBuffer);
-        return NO;
-    }
-    else if(value != NULL)
-    {
-        // The data was not found, put the whole scanned buffer in the value
-        [retBuffer appendData:(cacheScanLoc == 0 ? cacheData
-                               : [cacheData subdataWithRange:NSMakeRange(cacheScanLoc, cacheRange.length - cacheScanLoc)])];
-        *value = AUTORELEASE(retBuffer);
-        
         [self setScanLocation:_fileLength];
+        return YES;
     }
     
-    RELEASE(cacheData);
+    if(!(options & PSYDataScannerRequireStopData) && found == loc) return NO;
+    
+    // When the data was not discarded, the cache starts at the scan location and contains the stop data,
+    // the bytes are handed before moving the scan location as it may empty the cache
+    if(bytesHandler != nil) bytesHandler((const uint8_t *)[_cacheData bytes] + _cacheScanLocation, (NSUInteger)(found - loc));
+    
+    [self setScanLocation:(options & PSYDataScannerMoveAfterStopData ? found + length : found)];
     
     return YES;
 }
 
 - (BOOL)scanNullTerminatedString:(NSString **)value withEncoding:(NSStringEncoding)encoding
 {
-    NSData *stopData = PSYNullTerminatorDataForEncoding(encoding);
-    
-    unsigned long long length = [stopData length];
-    unsigned long long loc    = [_fileHandle offsetInFile];
+    NSUInteger         length = [PSYNullTerminatorDataForEncoding(encoding) length];
+    unsigned long long loc    = [self scanLocation];
     
     if(length == 0 || loc + length > _fileLength) return NO;
-    else
+    
+    unsigned long long found = [self PSY_locationOfBytes:NULL length:length nullTerminator:YES discardingScannedData:value == NULL];
+    
+    if(found == PSYNotFoundLocation)
     {
-        NSData              *cacheData    = [_cacheData copy];
-        const unsigned char *cacheBuffer  = [cacheData bytes];
-        PSYRange             cacheRange   = _cacheRange;
-        unsigned long long   cacheScanLoc = _cacheScanLocation;
-        
-        const unsigned char *stopBuffer   = [stopData bytes];
-        NSMutableData       *retBuffer    = value != NULL ? [[NSMutableData alloc] init] : nil;
-        unsigned long long   stopFoundLoc = loc;
-        unsigned long long   stopLoc      = 0;
-        
-        BOOL hasFoundData = NO;
-        
-        for(unsigned long long scannedLoc = loc; scannedLoc + length <= _fileLength; scannedLoc++)
-        {
-            if(scannedLoc >= PSYRangeMax(cacheRange))
-            {
-                if(retBuffer != nil)
-                    [retBuffer appendData:(cacheScanLoc == 0
-                                           ? cacheData
-                                           : [cacheData subdataWithRange:NSMakeRange(cacheScanLoc, cacheRange.length - cacheScanLoc)])];
-                @autoreleasepool
-                {
-                    RELEASE(cacheData);
-                    cacheData   = RETAIN([_fileHandle readDataOfLength:CHUNK_SIZE]);
-                    cacheBuffer = [cacheData bytes];
-                }
-                
-                cacheRange.length   = [cacheData length];
-                cacheRange.location = [_fileHandle offsetInFile] - cacheRange.length;
-                cacheScanLoc        = 0;
-            }
-            
-            // If the current stopBuffer byte is equal to the current scanned byte,
-            // increment the stop location to scan check the next bytes in both buffer
-            // otherwise, reset the stop location so the next scanned byte is compared with the first stop byte
-            if(cacheBuffer[scannedLoc - cacheRange.location] == stopBuffer[stopLoc])
-                stopLoc++;
-            else
-            {
-                stopFoundLoc = scannedLoc + 1;
-                stopLoc      = 0;
-            }
-            
-            // If the stop location is equal to the length of the stopData
-            // it means we fully matched the data, break out of the loop
-            if(stopLoc >= length)
-            {
-                hasFoundData = YES;
-                break;
-            }
-        }
-        
-        if(hasFoundData)
-        {
-            // The beginning of the stop data is in the data we already bufferized
-            if(stopFoundLoc < cacheRange.location)
-            {
-                if(value != NULL)
-                {
-                    // We need to truncate the bufferized data before sending it back to the caller
-                    unsigned long long trashedLength = cacheRange.location - stopFoundLoc;
-                    [retBuffer replaceBytesInRange:NSMakeRange([retBuffer length] - trashedLength, trashedLength) withBytes:NULL length:0];
-                    *value = AUTORELEASE([[NSString alloc] initWithData:retBuffer encoding:encoding]);
-                    RELEASE(retBuffer);
-                }
-            }
-            // The beginning of the stop data is in the current buffer, append whatever is missing to the returned value
-            else
-            {
-                if(value != NULL)
-                {
-                    [retBuffer appendBytes:cacheBuffer length:stopFoundLoc - cacheRange.location];
-                    *value = AUTORELEASE([[NSString alloc] initWithData:retBuffer encoding:encoding]);
-                    RELEASE(retBuffer);
-                }
-                
-                [_cacheData setData:cacheData];
-                _cacheRange        = cacheRange;
-                _cacheScanLocation = (stopFoundLoc + length) - cacheRange.location;
-            }
-            
-            [self setScanLocation:stopFoundLoc + length];
-        }
-        else
-        {
-            // We didn't find the null terminator so we reset the data to the beginning and return YES
-            RELEASE(cacheData);
-            RELEASE(retBuffer);
-            [self setScanLocation:loc];
-            
-            return NO;
-        }
-        
-        RELEASE(cacheData);
+        // We didn't find the null terminator so we reset the data to the beginning
+        [self setScanLocation:loc];
+        return NO;
     }
     
+    if(value != NULL) *value = [self PSY_stringWithBytes:(const uint8_t *)[_cacheData bytes] + _cacheScanLocation length:(NSUInteger)(found - loc) encoding:encoding];
+    
+    [self setScanLocation:found + length];
+    
     return YES;
 }
 
@@ -522,3 +809,313 @@ SCAN_METHOD(scanSwappedFloat, float)
 SCAN_METHOD(scanSwappedDouble, double)
 
 @end
+
+@implementation PSYReadAheadWindow
+
+- (id)init
+{
+    if((self = [super init]))
+    {
+        filled = dispatch_semaphore_create(0);
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+#if !__has_feature(objc_arc)
+    [data release];
+    dispatch_release(filled);
+    [super dealloc];
+#endif
+}
+
+@end
+
+@implementation PSYFileReadAhead
+{
+    int                 _fileDescriptor;
+    unsigned long long  _fileLength;
+    dispatch_queue_t    _queue;
+    
+    // Windows being read in file order and the buffers waiting to be filled
+    NSMutableArray     *_windows;
+    NSMutableArray     *_spareData;
+    unsigned long long  _nextOffset;
+}
+@synthesize windowSize = _windowSize, depth = _depth;
+
+- (id)initWithFileDescriptor:(int)fileDescriptor fileLength:(unsigned long long)fileLength windowSize:(NSUInteger)windowSize depth:(NSUInteger)depth;
+{
+    if((self = [super init]))
+    {
+        _fileDescriptor = fileDescriptor;
+        _fileLength     = fileLength;
+        _windowSize     = windowSize;
+        _depth          = depth;
+        _queue          = dispatch_queue_create("PSYDataAdditions.PSYFileReadAhead", DISPATCH_QUEUE_SERIAL);
+        _windows        = [[NSMutableArray alloc] initWithCapacity:depth];
+        _spareData      = [[NSMutableArray alloc] initWithCapacity:depth];
+        _nextOffset     = PSYNotFoundLocation;
+        
+        for(NSUInteger i = 0; i < depth; i++)
+            [_spareData addObject:[NSMutableData dataWithLength:windowSize]];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    // The reads in flight write into the buffers
+    [self PSY_cancelWindows];
+    
+#if !__has_feature(objc_arc)
+    dispatch_release(_queue);
+    [_windows release];
+    [_spareData release];
+    [super dealloc];
+#endif
+}
+
+- (void)PSY_cancelWindows;
+{
+    for(PSYReadAheadWindow *window in _windows)
+    {
+        dispatch_semaphore_wait(window->filled, DISPATCH_TIME_FOREVER);
+        [self PSY_recycleData:window->data];
+    }
+    
+    [_windows removeAllObjects];
+}
+
+- (void)PSY_recycleData:(NSMutableData *)data;
+{
+    // Data that was grown by the scanner goes back to the window size, shrinking keeps the capacity
+    if([data length] != _windowSize) [data setLength:_windowSize];
+    
+    [_spareData addObject:data];
+}
+
+// Starts reading a window in each spare buffer
+- (void)PSY_readAhead;
+{
+    while([_spareData count] > 0 && _nextOffset < _fileLength)
+    {
+        PSYReadAheadWindow *window = [[PSYReadAheadWindow alloc] init];
+        window->data   = RETAIN([_spareData lastObject]);
+        window->offset = _nextOffset;
+        
+        [_spareData removeLastObject];
+        [_windows addObject:window];
+        
+        _nextOffset += _windowSize;
+        
+        int        fileDescriptor = _fileDescriptor;
+        NSUInteger length         = (NSUInteger)MIN(_windowSize, _fileLength - window->offset);
+        
+        dispatch_async(_queue, ^{
+            NSUInteger read = PSYReadFileBytes(fileDescriptor, [window->data mutableBytes], length, window->offset, &window->readCount);
+            
+            // Only the last window of the file is shorter
+            if(read != [window->data length]) [window->data setLength:read];
+            
+            dispatch_semaphore_signal(window->filled);
+        });
+        
+        RELEASE(window);
+    }
+}
+
+- (NSMutableData *)dequeueDataAtOffset:(unsigned long long)offset readCount:(NSUInteger *)readCount;
+{
+    PSYReadAheadWindow *window = [_windows count] > 0 ? [_windows objectAtIndex:0] : nil;
+    
+    // The scanner moved somewhere else, the windows in flight are useless
+    if(window == nil || window->offset != offset)
+    {
+        [self PSY_cancelWindows];
+        
+        _nextOffset = offset;
+        [self PSY_readAhead];
+        
+        window = [_windows objectAtIndex:0];
+    }
+    
+    windowCount++;
+    
+    if(dispatch_semaphore_wait(window->filled, DISPATCH_TIME_NOW) != 0)
+    {
+        NSTimeInterval start = [NSDate timeIntervalSinceReferenceDate];
+        
+        dispatch_semaphore_wait(window->filled, DISPATCH_TIME_FOREVER);
+        
+        waitCount++;
+        waitDuration += [NSDate timeIntervalSinceReferenceDate] - start;
+    }
+    
+    NSMutableData *data = RETAIN(window->data);
+    *readCount += window->readCount;
+    [_windows removeObjectAtIndex:0];
+    
+    return data;
+}
+
+- (void)enqueueData:(NSMutableData *)data;
+{
+    [self PSY_recycleData:data];
+    [self PSY_readAhead];
+}
+
+@end
+
+@implementation PSYFileBlock
+
+#if !__has_feature(objc_arc)
+- (void)dealloc
+{
+    [data release];
+    [super dealloc];
+}
+#endif
+
+@end
+
+@implementation PSYFileBlockCache
+{
+    int                                _fileDescriptor;
+    unsigned long long                 _fileLength;
+    NSUInteger                         _capacity;
+    
+    // The dictionary owns the blocks, the list doesn't retain them
+    NSMutableDictionary               *_blocks;
+    __unsafe_unretained PSYFileBlock  *_mostRecent;
+    __unsafe_unretained PSYFileBlock  *_leastRecent;
+}
+
+- (id)initWithFileDescriptor:(int)fileDescriptor fileLength:(unsigned long long)fileLength blockSize:(NSUInteger)size memoryBudget:(NSUInteger)memoryBudget;
+{
+    if((self = [super init]))
+    {
+        _fileDescriptor = fileDescriptor;
+        _fileLength     = fileLength;
+        _capacity       = MAX(memoryBudget / size, 1);
+        _blocks         = [[NSMutableDictionary alloc] initWithCapacity:_capacity];
+        blockSize       = size;
+    }
+    return self;
+}
+
+#if !__has_feature(objc_arc)
+- (void)dealloc
+{
+    [_blocks release];
+    [super dealloc];
+}
+#endif
+
+- (void)PSY_unlinkBlock:(PSYFileBlock *)block;
+{
+    if(block->previous != nil) block->previous->next = block->next;
+    else _mostRecent = block->next;
+    
+    if(block->next != nil) block->next->previous = block->previous;
+    else _leastRecent = block->previous;
+    
+    block->previous = nil;
+    block->next     = nil;
+}
+
+- (void)PSY_linkBlockFirst:(PSYFileBlock *)block;
+{
+    block->next = _mostRecent;
+    
+    if(_mostRecent != nil) _mostRecent->previous = block;
+    else _leastRecent = block;
+    
+    _mostRecent = block;
+}
+
+- (NSData *)PSY_readBlockAtIndex:(unsigned long long)index readCount:(NSUInteger *)readCount;
+{
+    unsigned long long  offset = index * blockSize;
+    NSUInteger          length = (NSUInteger)MIN(blockSize, _fileLength - offset);
+    NSMutableData      *data   = [[NSMutableData alloc] initWithLength:length];
+    
+    // The file was truncated, the block isn't cached
+    if(PSYReadFileBytes(_fileDescriptor, [data mutableBytes], length, offset, readCount) < length)
+    {
+        RELEASE(data);
+        return nil;
+    }
+    
+    return AUTORELEASE(data);
+}
+
+- (NSData *)PSY_cachedBlockAtIndex:(unsigned long long)index;
+{
+    PSYFileBlock *block = [_blocks objectForKey:[NSNumber numberWithUnsignedLongLong:index]];
+    if(block == nil) return nil;
+    
+    if(block != _mostRecent)
+    {
+        [self PSY_unlinkBlock:block];
+        [self PSY_linkBlockFirst:block];
+    }
+    
+    // Another scanner may evict the block as soon as the lock is released
+    return AUTORELEASE(RETAIN(block->data));
+}
+
+- (void)PSY_insertData:(NSData *)data atIndex:(unsigned long long)index;
+{
+    if([_blocks count] >= _capacity)
+    {
+        PSYFileBlock *evicted = _leastRecent;
+        
+        [self PSY_unlinkBlock:evicted];
+        [_blocks removeObjectForKey:[NSNumber numberWithUnsignedLongLong:evicted->index]];
+    }
+    
+    PSYFileBlock *block = [[PSYFileBlock alloc] init];
+    block->index = index;
+    block->data  = RETAIN(data);
+    
+    [_blocks setObject:block forKey:[NSNumber numberWithUnsignedLongLong:index]];
+    [self PSY_linkBlockFirst:block];
+    
+    RELEASE(block);
+}
+
+- (NSData *)blockAtIndex:(unsigned long long)index readCount:(NSUInteger *)readCount;
+{
+    if(index * blockSize >= _fileLength) return nil;
+    
+    NSData *data = nil;
+    
+    @synchronized(self)
+    {
+        data = [self PSY_cachedBlockAtIndex:index];
+        
+        if(data != nil) hitCount++;
+        else missCount++;
+    }
+    
+    if(data != nil) return data;
+    
+    // The block is read outside of the lock so scanners reading other blocks aren't held up
+    data = [self PSY_readBlockAtIndex:index readCount:readCount];
+    if(data == nil) return nil;
+    
+    @synchronized(self)
+    {
+        // Another scanner read the same block in the meantime
+        NSData *cachedData = [self PSY_cachedBlockAtIndex:index];
+        
+        if(cachedData == nil) [self PSY_insertData:data atIndex:index];
+        else data = cachedData;
+    }
+    
+    return data;
+}
+
+@end
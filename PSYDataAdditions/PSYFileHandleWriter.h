@@ -0,0 +1,37 @@
+/*
+ PSYFileHandleWriter.h
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import "PSYStreamWriter.h"
+
+// Writes a regular file through large page-aligned buffers written with pwrite(2) once they're full,
+// the buffers end on multiples of the buffer size in the file so every full buffer is an aligned write
+// The file is preallocated ahead of the writes without changing its length, written bytes can be
+// replaced at their offset, the writes of a background writer are written on a serial queue while
+// the next buffer is filled
+@interface PSYFileHandleWriter : PSYStreamWriter
+
+- (id)initWithFileHandle:(NSFileHandle *)fileHandle bufferSize:(NSUInteger)bufferSize preallocationLength:(unsigned long long)preallocationLength flushesInBackground:(BOOL)background;
+
+@end
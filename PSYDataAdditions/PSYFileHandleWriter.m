@@ -0,0 +1,508 @@
+/*
+ PSYFileHandleWriter.m
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+// fallocate(2) is a GNU extension
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#import "PSYFileHandleWriter.h"
+#import "PSYUtilities.h"
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdlib.h>
+
+#define DEFAULT_BUFFER_SIZE          (1024 * 1024)
+#define DEFAULT_PREALLOCATION_LENGTH (1024 * 1024 * 16)
+#define INPUT_STREAM_BUFFER_SIZE     (16 * 1024)
+
+static uint8_t *PSYAllocateAlignedBuffer(NSUInteger size)
+{
+    void *buffer = NULL;
+    if(posix_memalign(&buffer, (size_t)getpagesize(), size) != 0) return NULL;
+    
+    return buffer;
+}
+
+// Reserves the blocks of length bytes at offset without changing the length of the file,
+// preallocation is only a hint, the writes will allocate whatever it failed to reserve
+static void PSYPreallocateFile(int fileDescriptor, unsigned long long offset, unsigned long long length)
+{
+#if defined(__linux__) && defined(FALLOC_FL_KEEP_SIZE)
+    fallocate(fileDescriptor, FALLOC_FL_KEEP_SIZE, (off_t)offset, (off_t)length);
+#elif defined(F_PREALLOCATE)
+    // The length is counted from the physical end of the file
+    fstore_t store = { F_ALLOCATECONTIG, F_PEOFPOSMODE, 0, (off_t)length, 0 };
+    if(fcntl(fileDescriptor, F_PREALLOCATE, &store) < 0)
+    {
+        store.fst_flags = F_ALLOCATEALL;
+        fcntl(fileDescriptor, F_PREALLOCATE, &store);
+    }
+#endif
+}
+
+static void PSYRaiseHighWaterMark(volatile unsigned long long *mark, unsigned long long value)
+{
+    unsigned long long current = *mark;
+    
+    while(value > current && !__sync_bool_compare_and_swap(mark, current, value))
+        current = *mark;
+}
+
+// Completion block of a group, called once the file has the bytes up to offset
+@interface PSYFileWriteCompletion : NSObject
+{
+@public
+    unsigned long long   offset;
+    void               (^block)(void);
+}
+@end
+
+@implementation PSYFileHandleWriter
+{
+    NSFileHandle                    *_fileHandle;
+    int                              _fileDescriptor;
+    id<PSYStreamWriterDelegate>      _delegate;
+    
+    // The buffer being filled starts at _bufferOffset in the file, it's written once it reaches _bufferLimit
+    // The first buffer is shorter when the writer doesn't start on a multiple of the buffer size
+    uint8_t                         *_buffer;
+    NSUInteger                       _bufferSize;
+    NSUInteger                       _bufferLength;
+    NSUInteger                       _bufferLimit;
+    unsigned long long               _bufferOffset;
+    
+    unsigned long long               _preallocationLength;
+    unsigned long long               _allocatedOffset;
+    
+    // A background writer writes its spare buffer on the queue, the semaphore is signaled once it's written
+    dispatch_queue_t                 _queue;
+    dispatch_semaphore_t             _spareAvailable;
+    uint8_t                         *_spareBuffer;
+    
+    NSMutableArray                  *_completions; // completions of the groups whose bytes aren't written yet, in file order
+    volatile BOOL                    _failed;
+    
+    volatile BOOL                    _collectsStatistics;
+    PSYStreamWriterStatistics        _statistics;
+    
+    PSYChecksumAlgorithm             _checksumAlgorithm;
+    uint32_t                         _checksum;
+}
+@synthesize delegate = _delegate;
+
+- (id)initWithFileHandle:(NSFileHandle *)fileHandle bufferSize:(NSUInteger)bufferSize preallocationLength:(unsigned long long)preallocationLength flushesInBackground:(BOOL)background;
+{
+    if(fileHandle == nil || [fileHandle fileDescriptor] < 0)
+    {
+        RELEASE(self);
+        return nil;
+    }
+    
+    if((self = [super init]))
+    {
+        NSUInteger pageSize = (NSUInteger)getpagesize();
+        
+        if(bufferSize == 0)          bufferSize          = DEFAULT_BUFFER_SIZE;
+        if(preallocationLength == 0) preallocationLength = DEFAULT_PREALLOCATION_LENGTH;
+        
+        _fileHandle          = RETAIN(fileHandle);
+        _fileDescriptor      = [fileHandle fileDescriptor];
+        _bufferSize          = (bufferSize + pageSize - 1) / pageSize * pageSize;
+        _bufferOffset        = [fileHandle offsetInFile];
+        _bufferLimit         = _bufferSize - (NSUInteger)(_bufferOffset % _bufferSize);
+        _preallocationLength = preallocationLength;
+        _allocatedOffset     = _bufferOffset;
+        _completions         = [[NSMutableArray alloc] init];
+        _buffer              = PSYAllocateAlignedBuffer(_bufferSize);
+        
+        if(background)
+        {
+            _queue          = dispatch_queue_create("PSYDataAdditions.PSYFileHandleWriter", DISPATCH_QUEUE_SERIAL);
+            _spareAvailable = dispatch_semaphore_create(1);
+            _spareBuffer    = PSYAllocateAlignedBuffer(_bufferSize);
+        }
+        
+        if(_buffer == NULL || (background && _spareBuffer == NULL))
+        {
+            RELEASE(self);
+            [NSException raise:NSMallocException format:@"*** -[PSYStreamWriter %@]: unable to allocate the write buffers", NSStringFromSelector(_cmd)];
+        }
+    }
+    
+    return self;
+}
+
+- (void)dealloc
+{
+    // The blocks of the queue retain the writer, they're all done by now
+    if(_buffer != NULL && _bufferLength > 0 && !_failed)
+    {
+        if([self PSY_writeBytes:_buffer length:_bufferLength atOffset:_bufferOffset])
+            for(PSYFileWriteCompletion *completion in _completions) completion->block();
+    }
+    
+    free(_buffer);
+    free(_spareBuffer);
+    
+#if !__has_feature(objc_arc)
+    if(_queue != NULL) dispatch_release(_queue);
+    if(_spareAvailable != NULL) dispatch_release(_spareAvailable);
+    [_fileHandle release];
+    [_completions release];
+    [super dealloc];
+#endif
+}
+
+- (BOOL)collectsStatistics
+{
+    return _collectsStatistics;
+}
+
+- (void)setCollectsStatistics:(BOOL)value
+{
+    _collectsStatistics = value;
+    
+    if(!value) [self resetStatistics];
+}
+
+- (PSYStreamWriterStatistics)statistics
+{
+    PSYStreamWriterStatistics result = _statistics;
+    
+    result.pendingBytes = result.bytesQueued > result.bytesWritten ? result.bytesQueued - result.bytesWritten : 0;
+    
+    return result;
+}
+
+- (void)resetStatistics;
+{
+    memset(&_statistics, 0, sizeof(PSYStreamWriterStatistics));
+}
+
+- (PSYChecksumAlgorithm)checksumAlgorithm
+{
+    return _checksumAlgorithm;
+}
+
+- (void)setChecksumAlgorithm:(PSYChecksumAlgorithm)value
+{
+    _checksumAlgorithm = value;
+    _checksum          = 0;
+}
+
+- (uint32_t)checksum
+{
+    return _checksum;
+}
+
+- (void)resetChecksum;
+{
+    _checksum = 0;
+}
+
+- (unsigned long long)writeOffset
+{
+    @synchronized(self)
+    {
+        return _bufferOffset + _bufferLength;
+    }
+}
+
+// Writes length bytes at offset with as many pwrite calls as needed, the failures are reported to the delegate
+// Called on the queue of a background writer, or with the writer locked
+- (BOOL)PSY_writeBytes:(const uint8_t *)bytes length:(NSUInteger)length atOffset:(unsigned long long)offset;
+{
+    NSUInteger written = 0;
+    
+    while(written < length && !_failed)
+    {
+        ssize_t result = pwrite(_fileDescriptor, bytes + written, length - written, (off_t)(offset + written));
+        
+        if(result > 0)
+        {
+            if(__builtin_expect(_collectsStatistics, 0))
+            {
+                __sync_fetch_and_add(&_statistics.writeCount, 1ULL);
+                __sync_fetch_and_add(&_statistics.bytesWritten, (unsigned long long)result);
+                if((NSUInteger)result < length - written) __sync_fetch_and_add(&_statistics.shortWriteCount, 1ULL);
+            }
+            
+            written += result;
+        }
+        else if(result < 0 && errno == EINTR)
+            continue;
+        else
+        {
+            int errorNumber = result < 0 ? errno : EIO;
+            _failed = YES;
+            
+            if([[self delegate] respondsToSelector:@selector(streamWriter:didReceiveError:)])
+                [[self delegate] streamWriter:self didReceiveError:[NSError errorWithDomain:NSPOSIXErrorDomain code:errorNumber userInfo:nil]];
+        }
+    }
+    
+    return !_failed;
+}
+
+// Removes and returns the completions of the groups that end at or before offset
+- (NSArray *)PSY_takeCompletionsUpToOffset:(unsigned long long)offset;
+{
+    NSUInteger count = 0;
+    
+    for(PSYFileWriteCompletion *completion in _completions)
+    {
+        if(completion->offset > offset) break;
+        count++;
+    }
+    
+    if(count == 0) return nil;
+    
+    NSRange  range = NSMakeRange(0, count);
+    NSArray *taken = [_completions subarrayWithRange:range];
+    [_completions removeObjectsInRange:range];
+    
+    return taken;
+}
+
+// Reserves the file ahead of the bytes up to offset, preallocationLength bytes at a time
+- (void)PSY_preallocateUpToOffset:(unsigned long long)offset;
+{
+    if(offset <= _allocatedOffset) return;
+    
+    unsigned long long length = MAX(offset - _allocatedOffset, _preallocationLength);
+    
+    PSYPreallocateFile(_fileDescriptor, _allocatedOffset, length);
+    _allocatedOffset += length;
+}
+
+// Hands the buffer to the file, a background writer swaps it with its spare buffer once that one is written
+- (void)PSY_flushBuffer;
+{
+    if(_bufferLength == 0) return;
+    
+    const uint8_t      *bytes       = _buffer;
+    NSUInteger          length      = _bufferLength;
+    unsigned long long  offset      = _bufferOffset;
+    NSArray            *completions = [self PSY_takeCompletionsUpToOffset:offset + length];
+    
+    [self PSY_preallocateUpToOffset:offset + length];
+    
+    _bufferOffset += _bufferLength;
+    _bufferLength  = 0;
+    _bufferLimit   = _bufferSize - (NSUInteger)(_bufferOffset % _bufferSize);
+    
+    if(_queue == NULL)
+    {
+        if([self PSY_writeBytes:bytes length:length atOffset:offset])
+            for(PSYFileWriteCompletion *completion in completions) completion->block();
+        return;
+    }
+    
+    // Waits for the previous buffer to be written before filling it again
+    dispatch_semaphore_wait(_spareAvailable, DISPATCH_TIME_FOREVER);
+    
+    uint8_t *spare = _spareBuffer;
+    _spareBuffer   = _buffer;
+    _buffer        = spare;
+    
+    dispatch_semaphore_t spareAvailable = _spareAvailable;
+    
+    // The buffer is given back before the completions are called, so they can write without waiting on the writer
+    dispatch_async(_queue, ^{
+        BOOL written = [self PSY_writeBytes:bytes length:length atOffset:offset];
+        dispatch_semaphore_signal(spareAvailable);
+        
+        if(written)
+            for(PSYFileWriteCompletion *completion in completions) completion->block();
+    });
+}
+
+- (void)writeBytes:(const uint8_t *)buffer ofLength:(NSUInteger)length
+{
+    if(length == 0) return;
+    
+    @synchronized(self)
+    {
+        if(_failed) return;
+        
+        if(_checksumAlgorithm != PSYChecksumNone) _checksum = PSYCRC32CUpdate(_checksum, buffer, length);
+        
+        if(__builtin_expect(_collectsStatistics, 0))
+        {
+            unsigned long long queued = __sync_add_and_fetch(&_statistics.bytesQueued, (unsigned long long)length);
+            unsigned long long done   = _statistics.bytesWritten;
+            
+            if(queued > done) PSYRaiseHighWaterMark(&_statistics.pendingBytesHighWaterMark, queued - done);
+        }
+        
+        while(length > 0 && !_failed)
+        {
+            // Whole buffers are written straight from the caller's bytes, they still end on the buffer boundaries
+            if(_bufferLength == 0 && length >= _bufferLimit)
+            {
+                NSUInteger direct = _bufferLimit + (length - _bufferLimit) / _bufferSize * _bufferSize;
+                
+                [self PSY_preallocateUpToOffset:_bufferOffset + direct];
+                [self PSY_writeBytes:buffer length:direct atOffset:_bufferOffset];
+                
+                _bufferOffset += direct;
+                _bufferLimit   = _bufferSize;
+                buffer        += direct;
+                length        -= direct;
+                continue;
+            }
+            
+            NSUInteger toCopy = MIN(length, _bufferLimit - _bufferLength);
+            memcpy(_buffer + _bufferLength, buffer, toCopy);
+            
+            if(__builtin_expect(_collectsStatistics, 0)) __sync_fetch_and_add(&_statistics.bytesCopied, (unsigned long long)toCopy);
+            
+            _bufferLength += toCopy;
+            buffer        += toCopy;
+            length        -= toCopy;
+            
+            if(_bufferLength == _bufferLimit) [self PSY_flushBuffer];
+        }
+    }
+}
+
+// Calls completion once the file has everything written so far
+- (void)PSY_addCompletion:(void (^)(void))completion;
+{
+    if(completion == nil) return;
+    
+    @synchronized(self)
+    {
+        if(_bufferLength > 0)
+        {
+            PSYFileWriteCompletion *pending = [[PSYFileWriteCompletion alloc] init];
+            pending->offset = _bufferOffset + _bufferLength;
+            pending->block  = [completion copy];
+            
+            [_completions addObject:pending];
+            RELEASE(pending);
+            return;
+        }
+        
+        // The bytes are written or being written in the background
+        if(_queue != NULL)
+        {
+            dispatch_async(_queue, completion);
+            return;
+        }
+    }
+    
+    completion();
+}
+
+// The input stream is read to its end right away, into the buffers like any other write
+- (void)writeInputStream:(NSInputStream *)aStream completion:(void (^)(void))completion;
+{
+    if(aStream == nil) return;
+    
+    uint8_t buffer[INPUT_STREAM_BUFFER_SIZE];
+    
+    if([aStream streamStatus] == NSStreamStatusNotOpen) [aStream open];
+    
+    NSInteger read;
+    while((read = [aStream read:buffer maxLength:INPUT_STREAM_BUFFER_SIZE]) > 0)
+        [self writeBytes:buffer ofLength:read];
+    
+    [aStream close];
+    
+    if(read < 0)
+    {
+        if([[self delegate] respondsToSelector:@selector(streamWriter:didReceiveError:)])
+            [[self delegate] streamWriter:self didReceiveError:[aStream streamError]];
+        return;
+    }
+    
+    [self PSY_addCompletion:completion];
+}
+
+// The writes of a group are buffered like the others, its completion is called once they're in the file
+- (void)groupWrites:(void (^)(PSYStreamWriter *))writes completion:(void (^)(void))completion
+{
+    if(writes == nil) return;
+    
+    writes(self);
+    [self PSY_addCompletion:completion];
+}
+
+- (void)replaceBytesAtOffset:(unsigned long long)offset withBytes:(const void *)bytes length:(NSUInteger)length;
+{
+    @synchronized(self)
+    {
+        if(offset + length > _bufferOffset + _bufferLength)
+            [NSException raise:NSRangeException format:@"*** -[PSYStreamWriter %@]: Range or index out of bounds", NSStringFromSelector(_cmd)];
+        
+        // The bytes still in the buffer are replaced in memory
+        if(offset + length > _bufferOffset)
+        {
+            unsigned long long start = MAX(offset, _bufferOffset);
+            
+            memcpy(_buffer + (start - _bufferOffset), (const uint8_t *)bytes + (start - offset), (size_t)(offset + length - start));
+            length = (NSUInteger)(start - offset);
+        }
+        
+        if(length == 0 || _failed) return;
+        
+        // A buffer still being written in the background could overwrite the replaced bytes
+        if(_queue != NULL)
+        {
+            dispatch_semaphore_wait(_spareAvailable, DISPATCH_TIME_FOREVER);
+            dispatch_semaphore_signal(_spareAvailable);
+        }
+        
+        [self PSY_writeBytes:bytes length:length atOffset:offset];
+    }
+}
+
+- (void)flushWrites;
+{
+    @synchronized(self)
+    {
+        [self PSY_flushBuffer];
+    }
+    
+    if(_queue != NULL) dispatch_sync(_queue, ^{});
+}
+
+@end
+
+@implementation PSYFileWriteCompletion
+
+#if !__has_feature(objc_arc)
+- (void)dealloc
+{
+    [block release];
+    [super dealloc];
+}
+#endif
+
+@end
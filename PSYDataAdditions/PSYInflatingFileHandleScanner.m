@@ -0,0 +1,141 @@
+/*
+ PSYInflatingFileHandleScanner.m
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import "PSYInflatingFileHandleScanner.h"
+#import "PSYCompressingStreamWriter.h"
+#import "PSYUtilities.h"
+
+#include <zlib.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+
+// The compressed bytes are read in pieces of this size, with the ring buffer
+// and zlib's own window it's all the memory an inflating scanner uses
+#define INPUT_BUFFER_SIZE (32 * 1024)
+
+@implementation PSYInflatingFileHandleScanner
+{
+    z_stream  _stream;
+    uint8_t  *_inputBuffer;
+    BOOL      _initialized;
+    BOOL      _readEnd;    // the descriptor has no more compressed bytes
+    BOOL      _inflateEnd; // zlib found the end of the compressed stream
+}
+
+- (id)initWithCompressedFileHandle:(NSFileHandle *)fileToScan format:(PSYCompressionFormat)format bufferCapacity:(NSUInteger)capacity;
+{
+    if((self = [super initWithStreamFileHandle:fileToScan bufferCapacity:capacity]))
+    {
+        _inputBuffer = malloc(INPUT_BUFFER_SIZE);
+        _initialized = _inputBuffer != NULL && inflateInit2(&_stream, PSYCompressionWindowBits(format)) == Z_OK;
+        
+        if(!_initialized)
+        {
+            RELEASE(self);
+            return nil;
+        }
+    }
+    
+    return self;
+}
+
+- (void)dealloc
+{
+    if(_initialized) inflateEnd(&_stream);
+    free(_inputBuffer);
+    
+#if !__has_feature(objc_arc)
+    [super dealloc];
+#endif
+}
+
+// Inflates as many bytes as fit in the buffer from the compressed bytes already read and the ones the descriptor has,
+// fails with EAGAIN when the descriptor has nothing yet and with EILSEQ when the compressed bytes are corrupted
+- (ssize_t)PSY_readFromFileDescriptor:(int)fileDescriptor intoBuffer:(uint8_t *)buffer maxLength:(NSUInteger)length;
+{
+    if(_inflateEnd) return 0;
+    
+    _stream.next_out  = buffer;
+    _stream.avail_out = (uInt)MIN(length, (NSUInteger)UINT_MAX);
+    
+    NSUInteger capacity = _stream.avail_out;
+    int        error    = EAGAIN;
+    
+    while(_stream.avail_out > 0)
+    {
+        if(_stream.avail_in == 0)
+        {
+            if(_readEnd) break;
+            
+            ssize_t count = read(fileDescriptor, _inputBuffer, INPUT_BUFFER_SIZE);
+            
+            if(count > 0)
+            {
+                _stream.next_in  = _inputBuffer;
+                _stream.avail_in = (uInt)count;
+            }
+            else if(count == 0)
+            {
+                // A stream cut before its end is scanned up to the last byte that could be inflated
+                _readEnd = YES;
+                break;
+            }
+            else if(errno == EINTR)
+                continue;
+            else
+            {
+                error = errno;
+                break;
+            }
+        }
+        
+        int status = inflate(&_stream, Z_NO_FLUSH);
+        
+        if(status == Z_STREAM_END)
+        {
+            _inflateEnd = YES;
+            break;
+        }
+        
+        if(status != Z_OK && status != Z_BUF_ERROR)
+        {
+            error = EILSEQ;
+            break;
+        }
+    }
+    
+    NSUInteger inflated = capacity - _stream.avail_out;
+    
+    if(inflated > 0) return (ssize_t)inflated;
+    
+    // Nothing was inflated, the end of the compressed stream reads as the end of the file
+    if(_inflateEnd || (_readEnd && error == EAGAIN)) return 0;
+    
+    errno = error;
+    return -1;
+}
+
+@end
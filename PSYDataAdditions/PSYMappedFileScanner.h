@@ -0,0 +1,53 @@
+/*
+ PSYMappedFileScanner.h
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import "PSYDataDataScanner.h"
+
+// Scans a file mapped in memory with mmap(2)
+// The data returned by -scanData:ofLength: and the other data scanning methods
+// are views on the mapping, the bytes are only paged in when they are accessed
+@interface PSYMappedFileScanner : PSYDataDataScanner
+
+- (id)initWithContentsOfMappedFile:(NSString *)path;
+
+@end
+
+// Owns a read-only mapping of a file and unmaps it when deallocated
+// Subdata are slices of the mapping so they keep the whole mapping alive
+@interface PSYMappedData : NSData
+{
+@private
+    void       *_bytes;
+    NSUInteger  _length;
+}
+
+- (id)initWithContentsOfMappedFile:(NSString *)path;
+
+// The descriptor is not closed, the mapping remains valid once it is
+- (id)initWithFileDescriptor:(int)fd;
+
+- (void)adviseWillNeedRange:(NSRange)range;
+
+@end
@@ -0,0 +1,157 @@
+/*
+ PSYMappedFileScanner.m
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import "PSYMappedFileScanner.h"
+#import "PSYDataSlice.h"
+#import "PSYUtilities.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Amount of data the kernel is asked to page in ahead of the scan location
+#define READ_AHEAD_SIZE (1024 * 1024 * 4)
+
+@implementation PSYMappedFileScanner
+{
+    NSUInteger _readAheadLocation;
+}
+
+- (id)initWithContentsOfMappedFile:(NSString *)path
+{
+    PSYMappedData *mappedData = [[PSYMappedData alloc] initWithContentsOfMappedFile:path];
+    
+    if((self = [super initWithData:mappedData]))
+    {
+        [mappedData adviseWillNeedRange:NSMakeRange(0, READ_AHEAD_SIZE)];
+        _readAheadLocation = READ_AHEAD_SIZE / 2;
+    }
+    
+    RELEASE(mappedData);
+    return self;
+}
+
+- (void)setScanLocation:(unsigned long long)value
+{
+    [super setScanLocation:value];
+    
+    // Only bother the kernel once we moved through half of the previous hint
+    if(value >= _readAheadLocation || value + READ_AHEAD_SIZE < _readAheadLocation)
+    {
+        [(PSYMappedData *)[self data] adviseWillNeedRange:NSMakeRange((NSUInteger)value, READ_AHEAD_SIZE)];
+        _readAheadLocation = (NSUInteger)value + READ_AHEAD_SIZE / 2;
+    }
+}
+
+@end
+
+@implementation PSYMappedData
+
+- (id)initWithContentsOfMappedFile:(NSString *)path
+{
+    int fd = path != nil ? open([path fileSystemRepresentation], O_RDONLY) : -1;
+    
+    if(fd < 0)
+    {
+        RELEASE(self);
+        return nil;
+    }
+    
+    self = [self initWithFileDescriptor:fd];
+    
+    // The mapping stays valid once the descriptor is closed
+    close(fd);
+    
+    return self;
+}
+
+- (id)initWithFileDescriptor:(int)fd
+{
+    struct stat info;
+    if(fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || (unsigned long long)info.st_size > NSUIntegerMax)
+    {
+        RELEASE(self);
+        return nil;
+    }
+    
+    if((self = [super init]))
+    {
+        _length = (NSUInteger)info.st_size;
+        
+        // mmap refuses empty mappings, an empty file is just empty data
+        if(_length > 0)
+        {
+            _bytes = mmap(NULL, _length, PROT_READ, MAP_PRIVATE, fd, 0);
+            
+            if(_bytes == MAP_FAILED)
+            {
+                _bytes = NULL;
+                RELEASE(self);
+                return nil;
+            }
+            
+            madvise(_bytes, _length, MADV_SEQUENTIAL);
+        }
+    }
+    
+    return self;
+}
+
+- (void)dealloc
+{
+    if(_bytes != NULL) munmap(_bytes, _length);
+    
+#if !__has_feature(objc_arc)
+    [super dealloc];
+#endif
+}
+
+- (NSUInteger)length  { return _length; }
+- (const void *)bytes { return _bytes;  }
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    return RETAIN(self);
+}
+
+- (NSData *)subdataWithRange:(NSRange)range
+{
+    return AUTORELEASE([[PSYDataSlice alloc] initWithData:self range:range]);
+}
+
+- (void)adviseWillNeedRange:(NSRange)range
+{
+    if(_bytes == NULL || range.location >= _length) return;
+    
+    // madvise requires a page aligned address
+    NSUInteger pageSize = (NSUInteger)getpagesize();
+    NSUInteger location = range.location & ~(pageSize - 1);
+    NSUInteger length   = MIN(NSMaxRange(range), _length) - location;
+    
+    madvise((uint8_t *)_bytes + location, length, MADV_WILLNEED);
+}
+
+@end
@@ -0,0 +1,148 @@
+/*
+ PSYRecordLayout.h
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+#import "PSYDataScanner.h"
+#import "PSYStreamWriter.h"
+
+// Types of the fields of a record, they're encoded like the values of the scanning and writing
+// methods of the same family, signed members use the same types as their bits are the same
+typedef enum _PSYRecordFieldType
+{
+    PSYRecordFieldInt8,
+    
+    PSYRecordFieldLittleEndianInt16,
+    PSYRecordFieldLittleEndianInt32,
+    PSYRecordFieldLittleEndianInt64,
+    
+    PSYRecordFieldBigEndianInt16,
+    PSYRecordFieldBigEndianInt32,
+    PSYRecordFieldBigEndianInt64,
+    
+    PSYRecordFieldFloat,
+    PSYRecordFieldDouble,
+    
+    PSYRecordFieldSwappedFloat,
+    PSYRecordFieldSwappedDouble,
+    
+    PSYRecordFieldLittleEndianVarint32,
+    PSYRecordFieldLittleEndianVarint64,
+    
+    PSYRecordFieldBigEndianVarint32,
+    PSYRecordFieldBigEndianVarint64,
+    
+    PSYRecordFieldLittleEndianZigZagVarint32,
+    PSYRecordFieldLittleEndianZigZagVarint64,
+    
+    PSYRecordFieldBigEndianZigZagVarint32,
+    PSYRecordFieldBigEndianZigZagVarint64,
+    
+    // NSData * and NSString * members preceded by their length in bytes,
+    // the length is encoded with an integer or varint type
+    PSYRecordFieldData,
+    PSYRecordFieldString
+} PSYRecordFieldType;
+
+typedef struct _PSYRecordField
+{
+    PSYRecordFieldType  type;
+    size_t              offset;     // offset of the member in the struct, from offsetof()
+    PSYRecordFieldType  lengthType; // type of the length of data and string fields
+    NSStringEncoding    encoding;   // encoding of string fields
+} PSYRecordField;
+
+static inline PSYRecordField PSYMakeRecordField(PSYRecordFieldType type, size_t offset)
+{
+    return (PSYRecordField){ type, offset, PSYRecordFieldInt8, 0 };
+}
+
+static inline PSYRecordField PSYMakeRecordDataField(PSYRecordFieldType lengthType, size_t offset)
+{
+    return (PSYRecordField){ PSYRecordFieldData, offset, lengthType, 0 };
+}
+
+static inline PSYRecordField PSYMakeRecordStringField(PSYRecordFieldType lengthType, NSStringEncoding encoding, size_t offset)
+{
+    return (PSYRecordField){ PSYRecordFieldString, offset, lengthType, encoding };
+}
+
+// Layout of a binary record decoded into and encoded from a C struct of recordSize bytes
+// The fields are compiled once into a plan: consecutive fields stored in the host byte order
+// that are contiguous in the struct are copied with a single memcpy, the fixed-width fields
+// before the first variable-length one are bounds checked at once, and encoding reserves
+// the room for the whole record or batch of records up front
+// Decoded objects are autoreleased and stored in __unsafe_unretained members, nil members are encoded empty
+@interface PSYRecordLayout : NSObject
+
++ (id)layoutWithFields:(const PSYRecordField *)fields count:(NSUInteger)count recordSize:(size_t)recordSize;
+- (id)initWithFields:(const PSYRecordField *)fields count:(NSUInteger)count recordSize:(size_t)recordSize;
+
+// Size of the struct, records in arrays are recordSize bytes apart
+@property(readonly, nonatomic) size_t     recordSize;
+
+// Encoded length of the fixed-width fields before the first variable-length field,
+// it's the length of every record if the layout only has fixed-width fields
+@property(readonly, nonatomic) NSUInteger fixedLength;
+@property(readonly, nonatomic) BOOL       hasFixedLength;
+
+// Decodes up to count records from bytes, stops at the first record that isn't complete or is invalid
+// Returns the number of records decoded and sets *consumed to the number of bytes they used,
+// *neededLength is set to the length bytes would at least need to decode the next record,
+// or NSNotFound if it can't be decoded, like a varint that's too long or a string that isn't valid
+- (NSUInteger)decodeRecords:(void *)records count:(NSUInteger)count fromBytes:(const void *)bytes length:(NSUInteger)length consumed:(NSUInteger *)consumed neededLength:(NSUInteger *)neededLength;
+
+// Length the records can at most be encoded into
+- (NSUInteger)maximumEncodedLengthOfRecords:(const void *)records count:(NSUInteger)count;
+
+// Encodes count records into bytes, which has room for -maximumEncodedLengthOfRecords:count: bytes
+// Returns the number of bytes written
+- (NSUInteger)encodeRecords:(const void *)records count:(NSUInteger)count intoBytes:(void *)bytes;
+
+@end
+
+@interface PSYDataScanner (PSYRecordLayout)
+
+// Decode records into the structs at records, which are [layout recordSize] bytes apart
+// If any record can't be scanned the scan location is left unchanged and NO is returned,
+// the records before it may have been filled already
+- (BOOL)scanRecord:(void *)record withLayout:(PSYRecordLayout *)layout;
+- (BOOL)scanRecords:(void *)records count:(NSUInteger)count withLayout:(PSYRecordLayout *)layout;
+
+@end
+
+@interface NSMutableData (PSYRecordLayout)
+
+// The data grows once for all the records
+- (void)appendRecord:(const void *)record withLayout:(PSYRecordLayout *)layout;
+- (void)appendRecords:(const void *)records count:(NSUInteger)count withLayout:(PSYRecordLayout *)layout;
+
+@end
+
+@interface PSYStreamWriter (PSYRecordLayout)
+
+- (void)writeRecord:(const void *)record withLayout:(PSYRecordLayout *)layout;
+- (void)writeRecords:(const void *)records count:(NSUInteger)count withLayout:(PSYRecordLayout *)layout;
+
+@end
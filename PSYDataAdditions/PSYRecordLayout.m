@@ -0,0 +1,651 @@
+/*
+ PSYRecordLayout.m
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import "PSYRecordLayout.h"
+#import "PSYDataScanner_Private.h"
+#import "PSYUtilities.h"
+#import "PSYByteSwap.h"
+#import "PSYVarint.h"
+
+typedef enum _PSYRecordStepKind
+{
+    PSYRecordStepCopy,   // bytes in the host byte order, contiguous fields are merged
+    PSYRecordStepSwap,   // value of width bytes to byte swap
+    PSYRecordStepVarint, // varint of a member of width bytes
+    PSYRecordStepData,
+    PSYRecordStepString
+} PSYRecordStepKind;
+
+// Encoding of a value, swap and zigzag only apply to varints, swapped values have their own kind
+typedef struct _PSYRecordScalar
+{
+    PSYRecordStepKind  kind;
+    NSUInteger         width;
+    BOOL               swap;
+    BOOL               zigzag;
+} PSYRecordScalar;
+
+typedef struct _PSYRecordStep
+{
+    PSYRecordStepKind  kind;
+    PSYRecordScalar    value;
+    PSYRecordScalar    length;         // length of data and string fields
+    uint64_t           maximumCount;   // longest data or string the length can encode
+    NSStringEncoding   encoding;
+    size_t             offset;         // in the struct
+    NSUInteger         position;       // in the encoded record, only for the fixed-width prefix
+} PSYRecordStep;
+
+static BOOL PSYRecordScalarForType(PSYRecordFieldType type, PSYRecordScalar *scalar)
+{
+    BOOL swapped = NO;
+    
+    scalar->kind   = PSYRecordStepCopy;
+    scalar->swap   = NO;
+    scalar->zigzag = NO;
+    
+    switch(type)
+    {
+        case PSYRecordFieldInt8              : scalar->width = 1; break;
+        case PSYRecordFieldLittleEndianInt16 : scalar->width = 2; swapped = PSY_SWAP_LITTLE_ENDIAN; break;
+        case PSYRecordFieldLittleEndianInt32 : scalar->width = 4; swapped = PSY_SWAP_LITTLE_ENDIAN; break;
+        case PSYRecordFieldLittleEndianInt64 : scalar->width = 8; swapped = PSY_SWAP_LITTLE_ENDIAN; break;
+        case PSYRecordFieldBigEndianInt16    : scalar->width = 2; swapped = PSY_SWAP_BIG_ENDIAN;    break;
+        case PSYRecordFieldBigEndianInt32    : scalar->width = 4; swapped = PSY_SWAP_BIG_ENDIAN;    break;
+        case PSYRecordFieldBigEndianInt64    : scalar->width = 8; swapped = PSY_SWAP_BIG_ENDIAN;    break;
+        case PSYRecordFieldFloat             : scalar->width = 4; break;
+        case PSYRecordFieldDouble            : scalar->width = 8; break;
+        case PSYRecordFieldSwappedFloat      : scalar->width = 4; swapped = PSY_SWAP_BIG_ENDIAN;    break;
+        case PSYRecordFieldSwappedDouble     : scalar->width = 8; swapped = PSY_SWAP_BIG_ENDIAN;    break;
+        
+        case PSYRecordFieldLittleEndianVarint32       :
+        case PSYRecordFieldLittleEndianVarint64       :
+        case PSYRecordFieldBigEndianVarint32          :
+        case PSYRecordFieldBigEndianVarint64          :
+        case PSYRecordFieldLittleEndianZigZagVarint32 :
+        case PSYRecordFieldLittleEndianZigZagVarint64 :
+        case PSYRecordFieldBigEndianZigZagVarint32    :
+        case PSYRecordFieldBigEndianZigZagVarint64    :
+        {
+            BOOL bigEndian = (type == PSYRecordFieldBigEndianVarint32       || type == PSYRecordFieldBigEndianVarint64 ||
+                              type == PSYRecordFieldBigEndianZigZagVarint32 || type == PSYRecordFieldBigEndianZigZagVarint64);
+            BOOL is64Bit   = (type == PSYRecordFieldLittleEndianVarint64       || type == PSYRecordFieldBigEndianVarint64 ||
+                              type == PSYRecordFieldLittleEndianZigZagVarint64 || type == PSYRecordFieldBigEndianZigZagVarint64);
+            
+            scalar->kind   = PSYRecordStepVarint;
+            scalar->width  = is64Bit ? 8 : 4;
+            scalar->swap   = bigEndian ? PSY_SWAP_BIG_ENDIAN : PSY_SWAP_LITTLE_ENDIAN;
+            scalar->zigzag = type >= PSYRecordFieldLittleEndianZigZagVarint32;
+            break;
+        }
+        
+        default :
+            return NO;
+    }
+    
+    if(swapped) scalar->kind = PSYRecordStepSwap;
+    
+    return YES;
+}
+
+static NSUInteger PSYMaximumEncodedLength(PSYRecordScalar scalar)
+{
+    if(scalar.kind != PSYRecordStepVarint) return scalar.width;
+    
+    return scalar.width == 4 ? PSYVarint32MaximumLength : PSYVarint64MaximumLength;
+}
+
+static inline uint64_t PSYLoadRecordValue(const uint8_t *bytes, NSUInteger width)
+{
+    switch(width)
+    {
+        case 1  : return *bytes;
+        case 2  : { uint16_t value; memcpy(&value, bytes, sizeof(value)); return value; }
+        case 4  : { uint32_t value; memcpy(&value, bytes, sizeof(value)); return value; }
+        default : { uint64_t value; memcpy(&value, bytes, sizeof(value)); return value; }
+    }
+}
+
+static inline void PSYStoreRecordValue(uint8_t *bytes, NSUInteger width, uint64_t value)
+{
+    switch(width)
+    {
+        case 1  : *bytes = (uint8_t)value; break;
+        case 2  : { uint16_t raw = (uint16_t)value; memcpy(bytes, &raw, sizeof(raw)); break; }
+        case 4  : { uint32_t raw = (uint32_t)value; memcpy(bytes, &raw, sizeof(raw)); break; }
+        default : memcpy(bytes, &value, sizeof(value)); break;
+    }
+}
+
+static inline uint64_t PSYSwapRecordValue(uint64_t value, NSUInteger width)
+{
+    switch(width)
+    {
+        case 2  : return CFSwapInt16((uint16_t)value);
+        case 4  : return CFSwapInt32((uint32_t)value);
+        case 8  : return CFSwapInt64(value);
+        default : return value;
+    }
+}
+
+// Reads a value of the record, returns the number of bytes read,
+// 0 if the bytes are too short or the varint is too long
+static inline NSUInteger PSYDecodeRecordScalar(PSYRecordScalar scalar, const uint8_t *bytes, NSUInteger length, uint64_t *value)
+{
+    if(scalar.kind != PSYRecordStepVarint)
+    {
+        if(length < scalar.width) return 0;
+        
+        *value = PSYLoadRecordValue(bytes, scalar.width);
+        if(scalar.kind == PSYRecordStepSwap) *value = PSYSwapRecordValue(*value, scalar.width);
+        
+        return scalar.width;
+    }
+    
+    if(scalar.width == 4)
+    {
+        uint32_t   raw  = 0;
+        NSUInteger read = PSYDecodeVarint32(bytes, length, &raw);
+        
+        if(scalar.swap)   raw = CFSwapInt32(raw);
+        if(scalar.zigzag) raw = PSYZigZagDecode32(raw);
+        
+        *value = raw;
+        return read;
+    }
+    
+    NSUInteger read = PSYDecodeVarint64(bytes, length, value);
+    
+    if(scalar.swap)   *value = CFSwapInt64(*value);
+    if(scalar.zigzag) *value = PSYZigZagDecode64(*value);
+    
+    return read;
+}
+
+// Writes a value of the record and returns the number of bytes written
+static inline NSUInteger PSYEncodeRecordScalar(PSYRecordScalar scalar, uint64_t value, uint8_t *bytes)
+{
+    if(scalar.kind != PSYRecordStepVarint)
+    {
+        if(scalar.kind == PSYRecordStepSwap) value = PSYSwapRecordValue(value, scalar.width);
+        
+        PSYStoreRecordValue(bytes, scalar.width, value);
+        return scalar.width;
+    }
+    
+    if(scalar.width == 4)
+    {
+        uint32_t raw = (uint32_t)value;
+        
+        if(scalar.zigzag) raw = PSYZigZagEncode32((int32_t)raw);
+        if(scalar.swap)   raw = CFSwapInt32(raw);
+        
+        return PSYEncodeVarint32(bytes, raw);
+    }
+    
+    if(scalar.zigzag) value = PSYZigZagEncode64((int64_t)value);
+    if(scalar.swap)   value = CFSwapInt64(value);
+    
+    return PSYEncodeVarint64(bytes, value);
+}
+
+static inline void PSYDecodeFixedStep(const PSYRecordStep *step, uint8_t *record, const uint8_t *bytes)
+{
+    if(step->kind == PSYRecordStepCopy)
+        memcpy(record + step->offset, bytes, step->value.width);
+    else
+        PSYStoreRecordValue(record + step->offset, step->value.width, PSYSwapRecordValue(PSYLoadRecordValue(bytes, step->value.width), step->value.width));
+}
+
+// Decodes a value that couldn't be read, sets *neededLength to the length the record would at least need
+static NSUInteger PSYFailRecordScalar(PSYRecordScalar scalar, NSUInteger position, NSUInteger length, NSUInteger *neededLength)
+{
+    NSUInteger maximum = PSYMaximumEncodedLength(scalar);
+    
+    // A varint without its end in its maximum length is invalid, otherwise it's truncated
+    if(length - position >= maximum)   *neededLength = NSNotFound;
+    else if(scalar.kind != PSYRecordStepVarint) *neededLength = position + maximum;
+    else                               *neededLength = length + 1;
+    
+    return 0;
+}
+
+@implementation PSYRecordLayout
+{
+    PSYRecordStep *_steps;
+    NSUInteger     _stepCount;
+    NSUInteger     _prefixStepCount;
+    
+    // Longest encoding of a record without the bytes of its data and strings
+    NSUInteger     _maximumLength;
+    BOOL           _hasObjects;
+}
+@synthesize recordSize = _recordSize, fixedLength = _fixedLength, hasFixedLength = _hasFixedLength;
+
++ (id)layoutWithFields:(const PSYRecordField *)fields count:(NSUInteger)count recordSize:(size_t)recordSize;
+{
+    return AUTORELEASE([[self alloc] initWithFields:fields count:count recordSize:recordSize]);
+}
+
+- (id)initWithFields:(const PSYRecordField *)fields count:(NSUInteger)count recordSize:(size_t)recordSize;
+{
+    if(recordSize == 0) [NSException raise:NSInvalidArgumentException format:@"*** -[PSYRecordLayout %@]: recordSize can't be 0", NSStringFromSelector(_cmd)];
+    
+    if((self = [super init]))
+    {
+        _recordSize     = recordSize;
+        _hasFixedLength = YES;
+        _steps          = malloc(sizeof(PSYRecordStep) * MAX(count, 1));
+        
+        if(_steps == NULL) [NSException raise:NSMallocException format:@"*** -[PSYRecordLayout %@]: unable to allocate the plan", NSStringFromSelector(_cmd)];
+        
+        for(NSUInteger i = 0; i < count; i++)
+        {
+            PSYRecordField field = fields[i];
+            PSYRecordStep  step  = { 0 };
+            size_t         size  = 0;
+            
+            step.offset   = field.offset;
+            step.encoding = field.encoding;
+            
+            if(field.type == PSYRecordFieldData || field.type == PSYRecordFieldString)
+            {
+                if(!PSYRecordScalarForType(field.lengthType, &step.length))
+                    [NSException raise:NSInvalidArgumentException format:@"*** -[PSYRecordLayout %@]: invalid length type for field %lu", NSStringFromSelector(_cmd), (unsigned long)i];
+                
+                BOOL isSigned = step.length.zigzag;
+                
+                step.kind         = field.type == PSYRecordFieldData ? PSYRecordStepData : PSYRecordStepString;
+                step.maximumCount = (step.length.width == 8 ? (isSigned ? INT64_MAX : UINT64_MAX) :
+                                     ((1ULL << (step.length.width * 8 - (isSigned ? 1 : 0))) - 1));
+                size              = sizeof(id);
+            }
+            else if(PSYRecordScalarForType(field.type, &step.value))
+            {
+                step.kind = step.value.kind;
+                size      = step.value.width;
+            }
+            else
+                [NSException raise:NSInvalidArgumentException format:@"*** -[PSYRecordLayout %@]: invalid type for field %lu", NSStringFromSelector(_cmd), (unsigned long)i];
+            
+            if(field.offset > recordSize || recordSize - field.offset < size)
+                [NSException raise:NSInvalidArgumentException format:@"*** -[PSYRecordLayout %@]: field %lu is outside of the record", NSStringFromSelector(_cmd), (unsigned long)i];
+            
+            if(step.kind == PSYRecordStepCopy || step.kind == PSYRecordStepSwap)
+            {
+                step.position   = _fixedLength;
+                _maximumLength += step.value.width;
+                
+                if(_hasFixedLength) _fixedLength += step.value.width;
+            }
+            else
+            {
+                _hasFixedLength = NO;
+                _hasObjects     = _hasObjects || step.kind != PSYRecordStepVarint;
+                _maximumLength += PSYMaximumEncodedLength(step.kind == PSYRecordStepVarint ? step.value : step.length);
+            }
+            
+            // Steps follow each other in the encoded record, a copy contiguous in the struct
+            // with the previous one is merged into it
+            PSYRecordStep *last = _stepCount > 0 ? &_steps[_stepCount - 1] : NULL;
+            
+            if(step.kind == PSYRecordStepCopy && last != NULL && last->kind == PSYRecordStepCopy &&
+               last->offset + last->value.width == step.offset)
+                last->value.width += step.value.width;
+            else
+                _steps[_stepCount++] = step;
+            
+            if(_hasFixedLength) _prefixStepCount = _stepCount;
+        }
+    }
+    
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_steps);
+    
+#if !__has_feature(objc_arc)
+    [super dealloc];
+#endif
+}
+
+// Returns the length of the record decoded from bytes,
+// or 0 with *neededLength set like -decodeRecords:count:fromBytes:length:consumed:neededLength:
+static NSUInteger PSYDecodeRecord(const PSYRecordStep *steps, NSUInteger stepCount, NSUInteger prefixStepCount, NSUInteger fixedLength, uint8_t *record, const uint8_t *bytes, NSUInteger length, NSUInteger *neededLength)
+{
+    // A single bounds check covers all the fields of the fixed-width prefix
+    if(length < fixedLength)
+    {
+        *neededLength = fixedLength;
+        return 0;
+    }
+    
+    const PSYRecordStep *step      = steps;
+    const PSYRecordStep *prefixEnd = steps + prefixStepCount;
+    const PSYRecordStep *end       = steps + stepCount;
+    
+    for(; step < prefixEnd; step++) PSYDecodeFixedStep(step, record, bytes + step->position);
+    
+    NSUInteger position = fixedLength;
+    
+    for(; step < end; step++)
+    {
+        switch(step->kind)
+        {
+            case PSYRecordStepCopy :
+            case PSYRecordStepSwap :
+                if(length - position < step->value.width) return PSYFailRecordScalar(step->value, position, length, neededLength);
+                
+                PSYDecodeFixedStep(step, record, bytes + position);
+                position += step->value.width;
+                break;
+            
+            case PSYRecordStepVarint :
+            {
+                uint64_t   value = 0;
+                NSUInteger read  = PSYDecodeRecordScalar(step->value, bytes + position, length - position, &value);
+                
+                if(read == 0) return PSYFailRecordScalar(step->value, position, length, neededLength);
+                
+                PSYStoreRecordValue(record + step->offset, step->value.width, value);
+                position += read;
+                break;
+            }
+            
+            case PSYRecordStepData :
+            case PSYRecordStepString :
+            {
+                uint64_t   count = 0;
+                NSUInteger read  = PSYDecodeRecordScalar(step->length, bytes + position, length - position, &count);
+                
+                if(read == 0) return PSYFailRecordScalar(step->length, position, length, neededLength);
+                
+                position += read;
+                
+                if(count > length - position)
+                {
+                    *neededLength = count > NSUIntegerMax - position ? NSNotFound : position + (NSUInteger)count;
+                    return 0;
+                }
+                
+                id object = (step->kind == PSYRecordStepData
+                             ? [[NSData alloc] initWithBytes:bytes + position length:(NSUInteger)count]
+                             : [[NSString alloc] initWithBytes:bytes + position length:(NSUInteger)count encoding:step->encoding]);
+                
+                if(object == nil)
+                {
+                    *neededLength = NSNotFound;
+                    return 0;
+                }
+                
+                *(id __unsafe_unretained *)(record + step->offset) = AUTORELEASE(object);
+                position += (NSUInteger)count;
+                break;
+            }
+        }
+    }
+    
+    return position;
+}
+
+- (NSUInteger)decodeRecords:(void *)records count:(NSUInteger)count fromBytes:(const void *)bytes length:(NSUInteger)length consumed:(NSUInteger *)consumed neededLength:(NSUInteger *)neededLength;
+{
+    uint8_t       *record   = records;
+    const uint8_t *source   = bytes;
+    NSUInteger     decoded  = 0;
+    NSUInteger     position = 0;
+    NSUInteger     needed   = 0;
+    
+    if(_hasFixedLength)
+    {
+        // Records of fixed-width fields are all bounds checked at once
+        NSUInteger fitting = _fixedLength > 0 ? MIN(count, length / _fixedLength) : count;
+        
+        for(; decoded < fitting; decoded++, record += _recordSize, position += _fixedLength)
+            for(NSUInteger i = 0; i < _stepCount; i++)
+                PSYDecodeFixedStep(&_steps[i], record, source + position + _steps[i].position);
+        
+        if(decoded < count) needed = position + _fixedLength;
+    }
+    else
+    {
+        for(; decoded < count; decoded++, record += _recordSize)
+        {
+            NSUInteger read = PSYDecodeRecord(_steps, _stepCount, _prefixStepCount, _fixedLength, record, source + position, length - position, &needed);
+            
+            if(read == 0)
+            {
+                if(needed != NSNotFound) needed += position;
+                break;
+            }
+            
+            position += read;
+        }
+    }
+    
+    if(consumed     != NULL) *consumed     = position;
+    if(neededLength != NULL) *neededLength = needed;
+    
+    return decoded;
+}
+
+- (NSUInteger)maximumEncodedLengthOfRecords:(const void *)records count:(NSUInteger)count;
+{
+    if(_maximumLength > 0 && count > NSUIntegerMax / _maximumLength) [NSException raise:NSInvalidArgumentException format:@"*** -[PSYRecordLayout %@]: count too large", NSStringFromSelector(_cmd)];
+    
+    NSUInteger total = _maximumLength * count;
+    
+    if(!_hasObjects) return total;
+    
+    const uint8_t *record = records;
+    
+    for(NSUInteger i = 0; i < count; i++, record += _recordSize)
+        for(NSUInteger j = 0; j < _stepCount; j++)
+        {
+            const PSYRecordStep *step = &_steps[j];
+            id object = *(id __unsafe_unretained *)(record + step->offset);
+            
+            if(step->kind == PSYRecordStepData)        total += [(NSData *)object length];
+            else if(step->kind == PSYRecordStepString) total += [(NSString *)object maximumLengthOfBytesUsingEncoding:step->encoding];
+        }
+    
+    return total;
+}
+
+- (NSUInteger)encodeRecords:(const void *)records count:(NSUInteger)count intoBytes:(void *)bytes;
+{
+    const uint8_t *record   = records;
+    uint8_t       *target   = bytes;
+    NSUInteger     position = 0;
+    
+    for(NSUInteger i = 0; i < count; i++, record += _recordSize)
+        for(NSUInteger j = 0; j < _stepCount; j++)
+        {
+            const PSYRecordStep *step = &_steps[j];
+            
+            switch(step->kind)
+            {
+                case PSYRecordStepCopy :
+                    memcpy(target + position, record + step->offset, step->value.width);
+                    position += step->value.width;
+                    break;
+                
+                case PSYRecordStepSwap :
+                case PSYRecordStepVarint :
+                    position += PSYEncodeRecordScalar(step->value, PSYLoadRecordValue(record + step->offset, step->value.width), target + position);
+                    break;
+                
+                case PSYRecordStepData :
+                {
+                    NSData     *data   = *(NSData * __unsafe_unretained *)(record + step->offset);
+                    NSUInteger  length = [data length];
+                    
+                    if(length > step->maximumCount) [NSException raise:NSInvalidArgumentException format:@"*** -[PSYRecordLayout %@]: data too long for its length type", NSStringFromSelector(_cmd)];
+                    
+                    position += PSYEncodeRecordScalar(step->length, length, target + position);
+                    
+                    if(length > 0) memcpy(target + position, [data bytes], length);
+                    position += length;
+                    break;
+                }
+                
+                case PSYRecordStepString :
+                {
+                    // The string is converted after the room for the longest length, which is moved against it
+                    NSString   *string     = *(NSString * __unsafe_unretained *)(record + step->offset);
+                    NSUInteger  room       = PSYMaximumEncodedLength(step->length);
+                    NSUInteger  length     = 0;
+                    NSRange     remaining  = NSMakeRange(0, 0);
+                    
+                    [string getBytes:target + position + room maxLength:[string maximumLengthOfBytesUsingEncoding:step->encoding] usedLength:&length
+                            encoding:step->encoding options:0 range:NSMakeRange(0, [string length]) remainingRange:&remaining];
+                    
+                    if(remaining.length > 0) [NSException raise:NSInvalidArgumentException format:@"*** -[PSYRecordLayout %@]: string can't be converted to its encoding", NSStringFromSelector(_cmd)];
+                    if(length > step->maximumCount) [NSException raise:NSInvalidArgumentException format:@"*** -[PSYRecordLayout %@]: string too long for its length type", NSStringFromSelector(_cmd)];
+                    
+                    NSUInteger prefix = PSYEncodeRecordScalar(step->length, length, target + position);
+                    
+                    if(prefix != room) memmove(target + position + prefix, target + position + room, length);
+                    position += prefix + length;
+                    break;
+                }
+            }
+        }
+    
+    return position;
+}
+
+@end
+
+@implementation PSYDataScanner (PSYRecordLayout)
+
+- (BOOL)scanRecord:(void *)record withLayout:(PSYRecordLayout *)layout;
+{
+    return [self scanRecords:record count:1 withLayout:layout];
+}
+
+- (BOOL)scanRecords:(void *)records count:(NSUInteger)count withLayout:(PSYRecordLayout *)layout;
+{
+    unsigned long long loc     = [self scanLocation];
+    size_t             size    = [layout recordSize];
+    NSUInteger         minimum = MAX([layout fixedLength], 1);
+    NSUInteger         decoded = 0;
+    
+    while(decoded < count)
+    {
+        unsigned long long  available = 0;
+        const uint8_t      *bytes     = [self PSY_bytesAtScanLocationWithMinimumLength:minimum availableLength:&available];
+        
+        NSUInteger length   = (NSUInteger)MIN(available, (unsigned long long)NSUIntegerMax);
+        NSUInteger consumed = 0;
+        NSUInteger needed   = 0;
+        NSUInteger read     = [layout decodeRecords:(uint8_t *)records + decoded * size count:count - decoded fromBytes:bytes length:length consumed:&consumed neededLength:&needed];
+        
+        if(read > 0)
+        {
+            decoded += read;
+            minimum  = MAX([layout fixedLength], 1);
+            [self setScanLocation:[self scanLocation] + consumed];
+            continue;
+        }
+        
+        // The record is invalid, or the data ends before it does, or the bytes
+        // couldn't be made any longer, otherwise ask for at least the bytes it needs
+        if(needed == NSNotFound || needed <= minimum || needed > [self dataLength] - [self scanLocation]) break;
+        
+        minimum = needed;
+    }
+    
+    if(decoded < count)
+    {
+        // If we're here that means scanning failed
+        // reset the scan location to what it was before scanning
+        [self setScanLocation:loc];
+        return NO;
+    }
+    
+    return YES;
+}
+
+@end
+
+@implementation NSMutableData (PSYRecordLayout)
+
+- (void)appendRecord:(const void *)record withLayout:(PSYRecordLayout *)layout;
+{
+    [self appendRecords:record count:1 withLayout:layout];
+}
+
+- (void)appendRecords:(const void *)records count:(NSUInteger)count withLayout:(PSYRecordLayout *)layout;
+{
+    if(count == 0) return;
+    
+    NSUInteger offset  = [self length];
+    NSUInteger maximum = [layout maximumEncodedLengthOfRecords:records count:count];
+    
+    [self increaseLengthBy:maximum];
+    
+    @try
+    {
+        NSUInteger written = [layout encodeRecords:records count:count intoBytes:(uint8_t *)[self mutableBytes] + offset];
+        [self setLength:offset + written];
+    }
+    @catch(NSException *exception)
+    {
+        [self setLength:offset];
+        @throw;
+    }
+}
+
+@end
+
+@implementation PSYStreamWriter (PSYRecordLayout)
+
+- (void)writeRecord:(const void *)record withLayout:(PSYRecordLayout *)layout;
+{
+    [self writeRecords:record count:1 withLayout:layout];
+}
+
+- (void)writeRecords:(const void *)records count:(NSUInteger)count withLayout:(PSYRecordLayout *)layout;
+{
+    if(count == 0) return;
+    
+    NSUInteger  maximum = [layout maximumEncodedLengthOfRecords:records count:count];
+    uint8_t    *buffer  = malloc(MAX(maximum, 1));
+    if(buffer == NULL) [NSException raise:NSMallocException format:@"*** -[PSYStreamWriter %@]: unable to allocate %lu bytes", NSStringFromSelector(_cmd), (unsigned long)maximum];
+    
+    @try
+    {
+        [self writeBytes:buffer ofLength:[layout encodeRecords:records count:count intoBytes:buffer]];
+    }
+    @finally
+    {
+        free(buffer);
+    }
+}
+
+@end
@@ -0,0 +1,39 @@
+/*
+ PSYSectionStreamWriter.h
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import "PSYStreamWriter.h"
+
+// Encodes the writes of a length-delimited group into the sections of a single mutable data,
+// the nested length-delimited groups are back-patched in place instead of being copied at each level
+// The groups run their block right away, their completion blocks are called once the data was handed
+// to the target writer, input streams can't be written as their length isn't known in advance
+@interface PSYSectionStreamWriter : PSYStreamWriter
+
+- (id)initWithStreamWriter:(PSYStreamWriter *)writer;
+
+// Writes the data to the target writer in a group whose completion calls the ones of the groups
+- (void)flushSections;
+
+@end
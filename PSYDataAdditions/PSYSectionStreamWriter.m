@@ -0,0 +1,145 @@
+/*
+ PSYSectionStreamWriter.m
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import "PSYSectionStreamWriter.h"
+#import "NSMutableData+PSYDataWriter.h"
+#import "PSYUtilities.h"
+
+@implementation PSYSectionStreamWriter
+{
+    PSYStreamWriter *_targetWriter;
+    NSMutableData   *_data;
+    NSMutableArray  *_completions;
+}
+
+- (id)initWithStreamWriter:(PSYStreamWriter *)writer;
+{
+    if(writer == nil)
+    {
+        RELEASE(self);
+        return nil;
+    }
+    
+    if((self = [super init]))
+    {
+        _targetWriter = RETAIN(writer);
+        _data         = [[NSMutableData alloc] init];
+        _completions  = [[NSMutableArray alloc] init];
+    }
+    
+    return self;
+}
+
+#if !__has_feature(objc_arc)
+- (void)dealloc
+{
+    [_targetWriter release];
+    [_data release];
+    [_completions release];
+    [super dealloc];
+}
+#endif
+
+- (id<PSYStreamWriterDelegate>)delegate                { return [_targetWriter delegate];   }
+- (void)setDelegate:(id<PSYStreamWriterDelegate>)value { [_targetWriter setDelegate:value]; }
+
+- (BOOL)collectsStatistics                  { return [_targetWriter collectsStatistics];   }
+- (void)setCollectsStatistics:(BOOL)value   { [_targetWriter setCollectsStatistics:value]; }
+- (PSYStreamWriterStatistics)statistics     { return [_targetWriter statistics];           }
+- (void)resetStatistics                     { [_targetWriter resetStatistics];             }
+
+- (PSYChecksumAlgorithm)checksumAlgorithm                { return [_targetWriter checksumAlgorithm];   }
+- (void)setChecksumAlgorithm:(PSYChecksumAlgorithm)value { [_targetWriter setChecksumAlgorithm:value]; }
+- (uint32_t)checksum                                     { return [_targetWriter checksum];            }
+- (void)resetChecksum                                    { [_targetWriter resetChecksum];              }
+
+- (NSUInteger)highWaterMark                 { return [_targetWriter highWaterMark];        }
+- (NSUInteger)lowWaterMark                  { return [_targetWriter lowWaterMark];         }
+- (BOOL)hasSpaceAvailable                   { return [_targetWriter hasSpaceAvailable];    }
+
+- (void)setHighWaterMark:(NSUInteger)high lowWaterMark:(NSUInteger)low;
+{
+    [_targetWriter setHighWaterMark:high lowWaterMark:low];
+}
+
+- (void)writeBytes:(const uint8_t *)buffer ofLength:(NSUInteger)length
+{
+    [_data appendBytes:buffer length:length];
+}
+
+- (void)writeData:(NSData *)value
+{
+    [_data appendData:value];
+}
+
+- (void)writeInputStream:(NSInputStream *)aStream completion:(void (^)(void))completion;
+{
+    [NSException raise:NSInvalidArgumentException format:@"*** -[PSYStreamWriter %@]: input streams can't be written in a length-delimited group", NSStringFromSelector(_cmd)];
+}
+
+- (void)PSY_addCompletion:(void (^)(void))completion;
+{
+    if(completion == nil) return;
+    
+    void (^copy)(void) = [completion copy];
+    [_completions addObject:copy];
+    RELEASE(copy);
+}
+
+- (void)groupWrites:(void (^)(PSYStreamWriter *))writes completion:(void (^)(void))completion
+{
+    if(writes == nil) return;
+    
+    writes(self);
+    [self PSY_addCompletion:completion];
+}
+
+- (void)groupLengthDelimitedWrites:(void (^)(PSYStreamWriter *))writes prefix:(PSYLengthPrefix)prefix completion:(void (^)(void))completion;
+{
+    if(writes == nil) return;
+    
+    [_data beginLengthDelimitedSectionWithPrefix:prefix];
+    writes(self);
+    [_data endSection];
+    
+    [self PSY_addCompletion:completion];
+}
+
+- (void)flushSections;
+{
+    // The target writer takes the data in one piece, the completions of the groups follow it, innermost first
+    NSArray *completions = AUTORELEASE([_completions copy]);
+    
+    [_targetWriter groupWrites:^(PSYStreamWriter *group) {
+        [group writeData:_data];
+    } completion:[completions count] == 0 ? nil : ^{
+        for(void (^completion)(void) in completions) completion();
+    }];
+    
+    [_data setLength:0];
+    [_completions removeAllObjects];
+}
+
+@end
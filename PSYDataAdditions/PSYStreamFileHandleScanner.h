@@ -8,6 +8,15 @@
 
 #import "PSYDataScanner.h"
 
+// Scans a pipe or a socket through a fixed-capacity ring buffer
+// The scanner never reads from the descriptor by itself, -readAvailableData
+// does a non-blocking read of whatever the descriptor has, usually from the
+// handler of a dispatch read source, and the scans only see what was read so far
+// Bytes before the scan location are overwritten by the following reads
 @interface PSYStreamFileHandleScanner : PSYDataScanner
 
+// Called by -readAvailableData for each read into the ring buffer, returns like read(2)
+// Subclasses can transform the bytes of the descriptor before they reach the buffer
+- (ssize_t)PSY_readFromFileDescriptor:(int)fileDescriptor intoBuffer:(uint8_t *)buffer maxLength:(NSUInteger)length;
+
 @end
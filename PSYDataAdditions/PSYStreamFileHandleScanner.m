@@ -7,9 +7,464 @@
 //
 
 #import "PSYStreamFileHandleScanner.h"
+#import "PSYDataScanner_Private.h"
 #import "PSYUtilities.h"
+#import "PSYDataSearch.h"
+#import "PSYRecordLayout.h"
+#import "PSYVarint.h"
+
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#define DEFAULT_BUFFER_CAPACITY (64 * 1024)
+
+// The buffer is mapped twice in a row, so bytes that wrap around
+// the end of the buffer can be read and written as one contiguous range
+static uint8_t *PSYCreateMirroredBuffer(NSUInteger capacity)
+{
+    static volatile int32_t counter = 0;
+    
+    char name[32];
+    snprintf(name, sizeof(name), "/PSYRing-%d-%d", (int)getpid(), (int)__sync_fetch_and_add(&counter, 1));
+    
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if(fd < 0) return NULL;
+    
+    // The memory object lives as long as it is mapped
+    shm_unlink(name);
+    
+    uint8_t *buffer = NULL;
+    
+    if(ftruncate(fd, (off_t)capacity) == 0)
+    {
+        buffer = mmap(NULL, capacity * 2, PROT_NONE, MAP_PRIVATE | MAP_ANON, -1, 0);
+        
+        if(buffer == MAP_FAILED)
+            buffer = NULL;
+        else if(mmap(buffer,            capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ||
+                mmap(buffer + capacity, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)
+        {
+            munmap(buffer, capacity * 2);
+            buffer = NULL;
+        }
+    }
+    
+    close(fd);
+    return buffer;
+}
 
-// TODO: Implement a class that can handle pipe or socket NSFileHandles
 @implementation PSYStreamFileHandleScanner
+{
+    NSFileHandle       *_fileHandle;
+    int                 _fileDescriptor;
+    int                 _originalFlags; // the flags of the descriptor before O_NONBLOCK was added, or -1
+    
+    uint8_t            *_buffer;
+    NSUInteger          _capacity;
+    
+    // Locations in the stream, the buffer holds the bytes from _bufferStart to _bufferEnd
+    unsigned long long  _bufferStart;
+    unsigned long long  _bufferEnd;
+    unsigned long long  _scanLocation;
+    
+    BOOL                _reachedEnd;
+    BOOL                _needsMoreData;
+    
+    // A search for _searchedData from _searchScanLocation found no match starting before _searchResumeLocation,
+    // the same search resumes from there after more data was read instead of going over the same bytes again
+    NSData             *_searchedData;
+    unsigned long long  _searchScanLocation;
+    unsigned long long  _searchResumeLocation;
+}
+
+- (id)initWithFileHandle:(NSFileHandle *)fileToScan
+{
+    return [self initWithStreamFileHandle:fileToScan bufferCapacity:DEFAULT_BUFFER_CAPACITY];
+}
+
+- (id)initWithStreamFileHandle:(NSFileHandle *)fileToScan bufferCapacity:(NSUInteger)capacity;
+{
+    if(fileToScan == nil)
+    {
+        RELEASE(self);
+        return nil;
+    }
+    
+    if((self = [super init]))
+    {
+        // The capacity is a power of two so locations are turned into offsets with a mask,
+        // and a multiple of the page size so it can be mapped twice
+        NSUInteger rounded = (NSUInteger)getpagesize();
+        while(rounded < capacity) rounded <<= 1;
+        
+        _capacity = rounded;
+        _buffer   = PSYCreateMirroredBuffer(_capacity);
+        
+        if(_buffer == NULL)
+        {
+            RELEASE(self);
+            return nil;
+        }
+        
+        _fileHandle     = RETAIN(fileToScan);
+        _fileDescriptor = [_fileHandle fileDescriptor];
+        
+        // The descriptor gets its flags back when the scanner is deallocated
+        int flags = fcntl(_fileDescriptor, F_GETFL);
+        _originalFlags = -1;
+        if(flags >= 0 && (flags & O_NONBLOCK) == 0 && fcntl(_fileDescriptor, F_SETFL, flags | O_NONBLOCK) == 0) _originalFlags = flags;
+    }
+    
+    return self;
+}
+
+- (void)dealloc
+{
+    if(_buffer != NULL) munmap(_buffer, _capacity * 2);
+    if(_fileHandle != nil && _originalFlags >= 0) fcntl(_fileDescriptor, F_SETFL, _originalFlags);
+    
+#if !__has_feature(objc_arc)
+    [_searchedData release];
+    [_fileHandle release];
+    [super dealloc];
+#endif
+}
+
+- (NSInteger)readAvailableData;
+{
+    if(_reachedEnd) return 0;
+    
+    // The bytes that were scanned are given back to the buffer
+    _bufferStart = _scanLocation;
+    
+    NSInteger total = 0;
+    
+    PSYDataScannerCount(refillCount, 1);
+    
+    while(YES)
+    {
+        NSUInteger space = _capacity - (NSUInteger)(_bufferEnd - _bufferStart);
+        if(space == 0) break;
+        
+        ssize_t count = [self PSY_readFromFileDescriptor:_fileDescriptor intoBuffer:_buffer + (_bufferEnd & (_capacity - 1)) maxLength:space];
+        PSYDataScannerCount(readCount, 1);
+        
+        if(count > 0)
+        {
+            _bufferEnd += count;
+            total      += count;
+            
+            PSYDataScannerCount(bytesRead, count);
+        }
+        else if(count == 0)
+        {
+            _reachedEnd = YES;
+            break;
+        }
+        else if(errno == EAGAIN || errno == EWOULDBLOCK)
+            break;
+        else if(errno != EINTR)
+            return total > 0 ? total : -1;
+    }
+    
+    return total;
+}
+
+- (ssize_t)PSY_readFromFileDescriptor:(int)fileDescriptor intoBuffer:(uint8_t *)buffer maxLength:(NSUInteger)length;
+{
+    return read(fileDescriptor, buffer, length);
+}
+
+- (BOOL)needsMoreData
+{
+    return _needsMoreData;
+}
+
+- (BOOL)isAtEnd
+{
+    return _reachedEnd && _scanLocation >= _bufferEnd;
+}
+
+- (NSData *)data
+{
+    return nil;
+}
+
+- (unsigned long long)dataLength
+{
+    return _bufferEnd;
+}
+
+- (unsigned long long)scanLocation
+{
+    return _scanLocation;
+}
+
+- (void)setScanLocation:(unsigned long long)value
+{
+    if(value < _bufferStart || value > _bufferEnd)
+        [NSException raise:NSRangeException format:@"*** -[PSYDataScanner setScanLocation:]: Range or index out of bounds"];
+    
+    if(value > _scanLocation)
+    {
+        PSYDataScannerCount(bytesScanned, value - _scanLocation);
+        PSYDataScannerChecksum(_scanLocation, [self PSY_currentBytes], value - _scanLocation);
+    }
+    
+    _scanLocation = value;
+}
+
+- (const uint8_t *)PSY_currentBytes;
+{
+    return _buffer + (_scanLocation & (_capacity - 1));
+}
+
+// A scan that failed because length bytes are not buffered yet may succeed after reading more,
+// unless the stream ended or the buffer can never hold that many bytes
+- (BOOL)PSY_failScanNeedingLength:(unsigned long long)length;
+{
+    _needsMoreData = !_reachedEnd && length <= _capacity;
+    return NO;
+}
+
+- (BOOL)PSY_succeedScanWithLength:(unsigned long long)length;
+{
+    PSYDataScannerCount(bytesScanned, length);
+    
+    // The buffer is mirrored, the bytes are contiguous even when they wrap around
+    PSYDataScannerChecksum(_scanLocation, [self PSY_currentBytes], length);
+    
+    _scanLocation  += length;
+    _needsMoreData  = NO;
+    return YES;
+}
+
+- (const uint8_t *)PSY_bytesAtScanLocationWithMinimumLength:(unsigned long long)minimumLength availableLength:(unsigned long long *)availableLength;
+{
+    *availableLength = _bufferEnd - _scanLocation;
+    return [self PSY_currentBytes];
+}
+
+- (BOOL)PSY_scanArray:(void *)values count:(NSUInteger)count width:(NSUInteger)width swap:(BOOL)swap;
+{
+    if([super PSY_scanArray:values count:count width:width swap:swap])
+    {
+        _needsMoreData = NO;
+        return YES;
+    }
+    
+    return [self PSY_failScanNeedingLength:count > NSUIntegerMax / width ? ULLONG_MAX : (unsigned long long)count * width];
+}
+
+- (BOOL)PSY_scanVarintArray:(void *)values count:(NSUInteger)count is64Bit:(BOOL)is64Bit;
+{
+    if([super PSY_scanVarintArray:values count:count is64Bit:is64Bit])
+    {
+        _needsMoreData = NO;
+        return YES;
+    }
+    
+    // A varint that is too long fails too, more data may only help while the buffer isn't full
+    return [self PSY_failScanNeedingLength:_bufferEnd - _bufferStart < _capacity ? 0 : ULLONG_MAX];
+}
+
+- (BOOL)scanRecords:(void *)records count:(NSUInteger)count withLayout:(PSYRecordLayout *)layout;
+{
+    if([super scanRecords:records count:count withLayout:layout])
+    {
+        _needsMoreData = NO;
+        return YES;
+    }
+    
+    // Like varints the records don't tell how much they are missing, more data may only help while the buffer isn't full
+    return [self PSY_failScanNeedingLength:_bufferEnd - _bufferStart < _capacity ? 0 : ULLONG_MAX];
+}
+
+#define IDENTITY(value) (value)
+
+#define SCAN_METHOD(sel, type, rawType, convert)                                 \
+- (BOOL)sel:(type *)value                                                        \
+{                                                                                \
+    if(_bufferEnd - _scanLocation < sizeof(rawType))                             \
+        return [self PSY_failScanNeedingLength:sizeof(rawType)];                 \
+                                                                                 \
+    if(value != NULL)                                                            \
+    {                                                                            \
+        rawType raw;                                                             \
+        memcpy(&raw, [self PSY_currentBytes], sizeof(raw));                      \
+        *value = convert(raw);                                                   \
+    }                                                                            \
+                                                                                 \
+    return [self PSY_succeedScanWithLength:sizeof(rawType)];                     \
+}
+
+SCAN_METHOD(scanInt8, uint8_t, uint8_t, IDENTITY)
+SCAN_METHOD(scanLittleEndianInt16, uint16_t, uint16_t, CFSwapInt16LittleToHost)
+SCAN_METHOD(scanLittleEndianInt32, uint32_t, uint32_t, CFSwapInt32LittleToHost)
+SCAN_METHOD(scanLittleEndianInt64, uint64_t, uint64_t, CFSwapInt64LittleToHost)
+SCAN_METHOD(scanBigEndianInt16, uint16_t, uint16_t, CFSwapInt16BigToHost)
+SCAN_METHOD(scanBigEndianInt32, uint32_t, uint32_t, CFSwapInt32BigToHost)
+SCAN_METHOD(scanBigEndianInt64, uint64_t, uint64_t, CFSwapInt64BigToHost)
+
+SCAN_METHOD(scanFloat, float, float, IDENTITY)
+SCAN_METHOD(scanDouble, double, double, IDENTITY)
+
+SCAN_METHOD(scanSwappedFloat, float, CFSwappedFloat32, CFConvertFloatSwappedToHost)
+SCAN_METHOD(scanSwappedDouble, double, CFSwappedFloat64, CFConvertDoubleSwappedToHost)
+
+#undef SCAN_METHOD
+#undef IDENTITY
+
+// The buffer is overwritten by the next reads, the scanned data are always copied
+- (BOOL)scanData:(NSData **)data ofLength:(unsigned long long)length
+{
+    if(_bufferEnd - _scanLocation < length) return [self PSY_failScanNeedingLength:length];
+    
+    if(data != NULL)
+    {
+        *data = [NSData dataWithBytes:[self PSY_currentBytes] length:(NSUInteger)length];
+        PSYDataScannerCount(bytesCopied, length);
+    }
+    
+    return [self PSY_succeedScanWithLength:length];
+}
+
+// The bytes are in the buffer until the next read
+- (BOOL)scanBytesNoCopy:(const void **)bytes length:(NSUInteger)length;
+{
+    if(_bufferEnd - _scanLocation < length) return [self PSY_failScanNeedingLength:length];
+    
+    if(bytes != NULL) *bytes = [self PSY_currentBytes];
+    
+    return [self PSY_succeedScanWithLength:length];
+}
+
+// The string is decoded from the buffer without an intermediate data
+- (BOOL)scanString:(NSString **)value ofLength:(unsigned long long)length usingEncoding:(NSStringEncoding)encoding
+{
+    if(_bufferEnd - _scanLocation < length) return [self PSY_failScanNeedingLength:length];
+    
+    if(value != NULL) *value = [self PSY_stringWithBytes:[self PSY_currentBytes] length:(NSUInteger)length encoding:encoding];
+    
+    return [self PSY_succeedScanWithLength:length];
+}
+
+- (BOOL)scanData:(NSData *)data intoData:(NSData **)dataValue
+{
+    NSUInteger length    = [data length];
+    NSUInteger available = (NSUInteger)MIN(_bufferEnd - _scanLocation, (unsigned long long)length);
+    
+    if(length == 0) return NO;
+    
+    // Only a matching prefix can turn into a match once more data arrives
+    if(memcmp([self PSY_currentBytes], [data bytes], available) != 0)
+    {
+        _needsMoreData = NO;
+        return NO;
+    }
+    
+    if(available < length) return [self PSY_failScanNeedingLength:length];
+    
+    if(dataValue != NULL) *dataValue = AUTORELEASE([data copy]);
+    
+    return [self PSY_succeedScanWithLength:length];
+}
+
+// Returns the location from which a search for stopData has to look, bytes before it can't start a match
+- (unsigned long long)PSY_searchStartForStopData:(NSData *)stopData;
+{
+    if(_searchedData != nil && _searchScanLocation == _scanLocation && [_searchedData isEqualToData:stopData])
+        return MAX(_searchResumeLocation, _scanLocation);
+    
+    return _scanLocation;
+}
+
+// Remembers that stopData doesn't start anywhere in the buffer but its last bytes,
+// the matches only start on multiples of width from the scan location
+- (void)PSY_rememberFailedSearchForStopData:(NSData *)stopData width:(NSUInteger)width;
+{
+    NSUInteger         length = [stopData length];
+    unsigned long long resume = _bufferEnd - _scanLocation >= length ? _bufferEnd - length + 1 : _scanLocation;
+    
+    if(_searchedData != stopData)
+    {
+        RELEASE(_searchedData);
+        _searchedData = [stopData copy];
+    }
+    
+    _searchScanLocation   = _scanLocation;
+    _searchResumeLocation = _scanLocation + (resume - _scanLocation) / width * width;
+}
+
+- (BOOL)scanUpToData:(NSData *)stopData intoData:(NSData **)dataValue options:(PSYDataScannerOptions)options;
+{
+    return [self PSY_scanUpToData:stopData options:options bytesHandler:dataValue == NULL ? nil : ^(const uint8_t *bytes, NSUInteger length) {
+        *dataValue = [NSData dataWithBytes:bytes length:length];
+        PSYDataScannerCount(bytesCopied, length);
+    }];
+}
+
+- (BOOL)PSY_scanUpToData:(NSData *)stopData options:(PSYDataScannerOptions)options bytesHandler:(void (^)(const uint8_t *bytes, NSUInteger length))bytesHandler;
+{
+    NSUInteger          length    = [stopData length];
+    unsigned long long  available = _bufferEnd - _scanLocation;
+    const uint8_t      *bytes     = [self PSY_currentBytes];
+    NSUInteger          skipped   = (NSUInteger)([self PSY_searchStartForStopData:stopData] - _scanLocation);
+    NSUInteger          found     = NSNotFound;
+    
+    if(length > 0 && length <= available - skipped)
+        found = PSYFindBytes(bytes + skipped, (NSUInteger)available - skipped, [stopData bytes], length);
+    
+    if(found != NSNotFound) found += skipped;
+    else
+    {
+        // The stop data may still arrive, the bytes scanned so far can't be returned yet
+        if(!_reachedEnd)
+        {
+            if(length > 0) [self PSY_rememberFailedSearchForStopData:stopData width:1];
+            return [self PSY_failScanNeedingLength:available + MAX(length, 1)];
+        }
+        
+        _needsMoreData = NO;
+        if((options & PSYDataScannerRequireStopData) || available == 0) return NO;
+        
+        if(bytesHandler != nil) bytesHandler(bytes, (NSUInteger)available);
+        
+        return [self PSY_succeedScanWithLength:available];
+    }
+    
+    _needsMoreData = NO;
+    if(!(options & PSYDataScannerRequireStopData) && found == 0) return NO;
+    
+    if(bytesHandler != nil) bytesHandler(bytes, found);
+    
+    return [self PSY_succeedScanWithLength:(options & PSYDataScannerMoveAfterStopData ? found + length : found)];
+}
+
+- (BOOL)scanNullTerminatedString:(NSString **)value withEncoding:(NSStringEncoding)encoding;
+{
+    NSData             *terminator = PSYNullTerminatorDataForEncoding(encoding);
+    NSUInteger          width      = [terminator length];
+    unsigned long long  available  = _bufferEnd - _scanLocation;
+    const uint8_t      *bytes      = [self PSY_currentBytes];
+    NSUInteger          skipped    = (NSUInteger)([self PSY_searchStartForStopData:terminator] - _scanLocation);
+    NSUInteger          found      = PSYFindNullTerminator(bytes + skipped, (NSUInteger)available - skipped, width);
+    
+    if(found == NSNotFound)
+    {
+        [self PSY_rememberFailedSearchForStopData:terminator width:width];
+        return [self PSY_failScanNeedingLength:available + width];
+    }
+    
+    found += skipped;
+    
+    if(value != NULL) *value = [self PSY_stringWithBytes:bytes length:found encoding:encoding];
+    
+    return [self PSY_succeedScanWithLength:found + width];
+}
 
 @end
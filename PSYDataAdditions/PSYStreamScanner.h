@@ -45,6 +45,9 @@
 // You need to call this method again if you expect the messages again
 - (void)expectMessagesWithIdentifiers:(NSArray *)identifiers;
 
+// All the start and stop data of the expected messages are searched in a single pass over the bytes,
+// messages without start data are matched from the first byte not used by a previous message
+// Data that is already buffered is matched against the new expectations right away
 - (void)expectMessage:(PSYStreamScannerMessage *)message;
 - (void)expectMessagesInArray:(NSArray *)messages;
 
@@ -62,6 +65,11 @@
 
 @end
 
+// A message starts with its start data, or right away if it has none,
+// and ends with its stop data, once at least minimumPartialLength bytes are buffered
+// A message without stop data is minimumPartialLength bytes long, at least as long as its start data,
+// a message with neither start, stop data nor length takes whatever is buffered
+// A message longer than a non-zero maximumLength is skipped, the bytes are buffered up to that length only
 @interface PSYStreamScannerMessage : NSObject <NSCopying, NSMutableCopying>
 @property(nonatomic, readonly, copy) NSData         *startData;
 @property(nonatomic, readonly, copy) NSData         *stopData;
@@ -74,6 +82,12 @@
 @property(nonatomic, readonly)       NSTimeInterval  partialTimeoutInterval;
 
 @property(nonatomic, readonly, copy) void(^callbackBlock)(PSYStreamScanner *scanner);
+
+// Called instead of the callback block when a timeout expires, a timeout of 0 never expires
+// The overall timeout runs from the moment the message is expected, default messages don't have one,
+// the partial timeout runs from the start of the message and again every time more bytes arrive
+// Like a match, the expiration removes the expectations, the bytes of the partial message are skipped
+@property(nonatomic, readonly, copy) void(^timeoutBlock)(PSYStreamScanner *scanner);
 @end
 
 @interface PSYMutableStreamScannerMessage : PSYStreamScannerMessage
@@ -86,10 +100,15 @@
 @property(nonatomic, readwrite)       NSTimeInterval  partialTimeoutInterval;
 
 @property(nonatomic, readwrite, copy) void(^callbackBlock)(PSYStreamScanner *scanner);
+@property(nonatomic, readwrite, copy) void(^timeoutBlock)(PSYStreamScanner *scanner);
 @end
 
+// From the callback block of a message, these methods scan the bytes of the message
+// including its start and stop data
 @interface PSYStreamScanner (PSYDataScannerAdditions)
 
+// The message being delivered, it points into the scanner's buffer and is never copied
+- (NSData *)data;
 - (NSUInteger)dataLength;
 - (BOOL)isAtEnd;
 - (BOOL)isFinished;
@@ -25,9 +25,22 @@
 
 #import "PSYStreamScanner.h"
 #import "PSYUtilities.h"
+#import "PSYConcreteStreamScanner.h"
+#import "PSYDataScanner.h"
+
+@interface PSYPlaceholderStreamScanner : PSYStreamScanner
+@end
 
 @implementation PSYStreamScanner
 
++ (id)allocWithZone:(NSZone *)zone
+{
+    if(self == [PSYStreamScanner class])
+        return [[PSYPlaceholderStreamScanner alloc] init];
+    
+    return [super allocWithZone:zone];
+}
+
 - (NSArray *)defaultMessages;
 {
     PSYRequestConcreteImplementation([self class], _cmd, [PSYStreamScanner class] != [self class]);
@@ -85,6 +98,170 @@
     PSYRequestConcreteImplementation([self class], _cmd, [PSYStreamScanner class] != [self class]);
 }
 
+- (PSYDataScanner *)PSY_messageScanner;
+{
+    PSYRequestConcreteImplementation([self class], _cmd, [PSYStreamScanner class] != [self class]);
+    return nil;
+}
+
+- (BOOL)isFinished;
+{
+    PSYRequestConcreteImplementation([self class], _cmd, [PSYStreamScanner class] != [self class]);
+    return NO;
+}
+
+@end
+
+@implementation PSYStreamScanner (PSYStreamScannerCreation)
+
++ (id)scannerWithInputStream:(NSInputStream *)aStream;
+{
+    return AUTORELEASE([[self alloc] initWithInputStream:aStream]);
+}
+
+- (id)initWithInputStream:(NSInputStream *)aStream;
+{
+    return [self initWithInputStream:aStream closeOnDealloc:NO];
+}
+
++ (id)scannerWithInputStream:(NSInputStream *)aStream closeOnDealloc:(BOOL)closeOnDealloc;
+{
+    return AUTORELEASE([[self alloc] initWithInputStream:aStream closeOnDealloc:closeOnDealloc]);
+}
+
+- (id)initWithInputStream:(NSInputStream *)aStream closeOnDealloc:(BOOL)closeOnDealloc;
+{
+    RELEASE(self);
+    return nil;
+}
+
+@end
+
+@implementation PSYPlaceholderStreamScanner
+
++ (id)allocWithZone:(NSZone *)zone
+{
+    static PSYPlaceholderStreamScanner *sharedPlaceholder = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedPlaceholder = [[super allocWithZone:zone] init];
+    });
+    
+    return sharedPlaceholder;
+}
+
+- (id)init
+{
+    return self;
+}
+
+- (id)initWithInputStream:(NSInputStream *)aStream closeOnDealloc:(BOOL)closeOnDealloc;
+{
+    return (id)[[PSYConcreteStreamScanner alloc] initWithInputStream:aStream closeOnDealloc:closeOnDealloc];
+}
+
+@end
+
+// The scan methods read the message being delivered to a callback block
+@implementation PSYStreamScanner (PSYDataScannerAdditions)
+
+- (NSData *)data;
+{
+    return [[self PSY_messageScanner] data];
+}
+
+- (NSUInteger)dataLength;
+{
+    return (NSUInteger)[[self PSY_messageScanner] dataLength];
+}
+
+- (BOOL)isAtEnd;
+{
+    PSYDataScanner *scanner = [self PSY_messageScanner];
+    
+    return scanner == nil || [scanner isAtEnd];
+}
+
+#define FORWARD_SCAN_METHOD(name, type)                     \
+- (BOOL)scan ## name:(type *)value;                         \
+{                                                           \
+    return [[self PSY_messageScanner] scan ## name:value];  \
+}
+
+FORWARD_SCAN_METHOD(Int8, uint8_t)
+
+FORWARD_SCAN_METHOD(LittleEndianInt16, uint16_t)
+FORWARD_SCAN_METHOD(LittleEndianInt32, uint32_t)
+FORWARD_SCAN_METHOD(LittleEndianInt64, uint64_t)
+
+FORWARD_SCAN_METHOD(BigEndianInt16, uint16_t)
+FORWARD_SCAN_METHOD(BigEndianInt32, uint32_t)
+FORWARD_SCAN_METHOD(BigEndianInt64, uint64_t)
+
+FORWARD_SCAN_METHOD(SInt8, int8_t)
+
+FORWARD_SCAN_METHOD(LittleEndianSInt16, int16_t)
+FORWARD_SCAN_METHOD(LittleEndianSInt32, int32_t)
+FORWARD_SCAN_METHOD(LittleEndianSInt64, int64_t)
+
+FORWARD_SCAN_METHOD(BigEndianSInt16, int16_t)
+FORWARD_SCAN_METHOD(BigEndianSInt32, int32_t)
+FORWARD_SCAN_METHOD(BigEndianSInt64, int64_t)
+
+FORWARD_SCAN_METHOD(LittleEndianVarint32, uint32_t)
+FORWARD_SCAN_METHOD(LittleEndianVarint64, uint64_t)
+
+FORWARD_SCAN_METHOD(BigEndianVarint32, uint32_t)
+FORWARD_SCAN_METHOD(BigEndianVarint64, uint64_t)
+
+FORWARD_SCAN_METHOD(LittleEndianSVarint32, int32_t)
+FORWARD_SCAN_METHOD(LittleEndianSVarint64, int64_t)
+
+FORWARD_SCAN_METHOD(BigEndianSVarint32, int32_t)
+FORWARD_SCAN_METHOD(BigEndianSVarint64, int64_t)
+
+FORWARD_SCAN_METHOD(LittleEndianZigZagVarint32, int32_t)
+FORWARD_SCAN_METHOD(LittleEndianZigZagVarint64, int64_t)
+
+FORWARD_SCAN_METHOD(BigEndianZigZagVarint32, int32_t)
+FORWARD_SCAN_METHOD(BigEndianZigZagVarint64, int64_t)
+
+FORWARD_SCAN_METHOD(Float, float)
+FORWARD_SCAN_METHOD(Double, double)
+
+FORWARD_SCAN_METHOD(SwappedFloat, float)
+FORWARD_SCAN_METHOD(SwappedDouble, double)
+
+- (BOOL)scanData:(NSData **)data ofLength:(unsigned long long)length;
+{
+    return [[self PSY_messageScanner] scanData:data ofLength:length];
+}
+
+- (BOOL)scanData:(NSData *)data intoData:(NSData **)dataValue;
+{
+    return [[self PSY_messageScanner] scanData:data intoData:dataValue];
+}
+
+- (BOOL)scanUpToData:(NSData *)stopData intoData:(NSData **)dataValue;
+{
+    return [[self PSY_messageScanner] scanUpToData:stopData intoData:dataValue];
+}
+
+- (BOOL)scanString:(NSString **)value ofLength:(unsigned long long)length usingEncoding:(NSStringEncoding)encoding;
+{
+    return [[self PSY_messageScanner] scanString:value ofLength:length usingEncoding:encoding];
+}
+
+- (BOOL)scanUpToString:(NSString *)stopString intoString:(NSString **)value usingEncoding:(NSStringEncoding)encoding;
+{
+    return [[self PSY_messageScanner] scanUpToString:stopString intoString:value usingEncoding:encoding];
+}
+
+- (BOOL)scanNullTerminatedString:(NSString **)value withEncoding:(NSStringEncoding)encoding;
+{
+    return [[self PSY_messageScanner] scanNullTerminatedString:value withEncoding:encoding];
+}
+
 @end
 
 // PSYStreamScannerMessage classes
@@ -103,11 +280,12 @@
 @property(nonatomic, readwrite)       NSTimeInterval  partialTimeoutInterval;
 
 @property(nonatomic, readwrite, copy) void(^callbackBlock)(PSYStreamScanner *scanner);
+@property(nonatomic, readwrite, copy) void(^timeoutBlock)(PSYStreamScanner *scanner);
 
 @end
 
 @implementation PSYStreamScannerMessage
-@synthesize startData, stopData, callbackBlock, maximumLength, minimumPartialLength, overallTimeoutInterval, partialTimeoutInterval;
+@synthesize startData, stopData, callbackBlock, timeoutBlock, maximumLength, minimumPartialLength, overallTimeoutInterval, partialTimeoutInterval;
 
 #if !__has_feature(objc_arc)
 - (void)dealloc
@@ -115,6 +293,7 @@
     [startData release];
     [stopData release];
     [callbackBlock release];
+    [timeoutBlock release];
     [super dealloc];
 }
 #endif
@@ -131,6 +310,7 @@
     [ret setMaximumLength:         [self maximumLength]];
     [ret setMinimumPartialLength:  [self minimumPartialLength]];
     [ret setCallbackBlock:         [self callbackBlock]];
+    [ret setTimeoutBlock:          [self timeoutBlock]];
     
     return ret;
 }
@@ -145,6 +325,7 @@
     [ret setMaximumLength:         [self maximumLength]];
     [ret setMinimumPartialLength:  [self minimumPartialLength]];
     [ret setCallbackBlock:         [self callbackBlock]];
+    [ret setTimeoutBlock:          [self timeoutBlock]];
     
     return ret;
 }
@@ -152,7 +333,7 @@
 @end
 
 @implementation PSYMutableStreamScannerMessage
-@dynamic startData, stopData, callbackBlock, maximumLength, minimumPartialLength, overallTimeoutInterval, partialTimeoutInterval;
+@dynamic startData, stopData, callbackBlock, timeoutBlock, maximumLength, minimumPartialLength, overallTimeoutInterval, partialTimeoutInterval;
 
 - (id)init
 {
@@ -24,9 +24,25 @@
  */
 
 #import <Foundation/Foundation.h>
+#import "PSYCompression.h"
+#import "PSYChecksum.h"
+#import "NSMutableData+PSYDataWriter.h"
 
 @protocol PSYStreamWriterDelegate;
 
+// Counters of a writer that collects statistics
+typedef struct _PSYStreamWriterStatistics
+{
+    unsigned long long bytesQueued;               // bytes handed to the writer
+    unsigned long long bytesCopied;               // bytes copied into the writer's buffers, large data are queued by reference
+    unsigned long long bytesWritten;              // bytes taken by the descriptor or the stream
+    unsigned long long pendingBytes;              // bytes queued and not written yet
+    unsigned long long pendingBytesHighWaterMark; // most bytes that were pending at once
+    unsigned long long writeCount;                // writev system calls and writes to the stream
+    unsigned long long shortWriteCount;           // writes that took fewer bytes than they were given
+    unsigned long long queueDepthHighWaterMark;   // most groups, input streams and buffers queued at once in a group
+} PSYStreamWriterStatistics;
+
 @interface PSYStreamWriter : NSObject
 
 - (void)groupWrites:(void(^)(PSYStreamWriter *writer))writes completion:(void(^)(void))completion;
@@ -35,6 +51,32 @@
 
 @property(nonatomic, assign) id<PSYStreamWriterDelegate> delegate;
 
+// The statistics are only counted while collectsStatistics is YES, otherwise the writes only test
+// a flag, turning it off resets the counters, they're shared by the groups of a writer and updated atomically
+@property(nonatomic)           BOOL                      collectsStatistics;
+@property(readonly, nonatomic) PSYStreamWriterStatistics statistics;
+
+- (void)resetStatistics;
+
+// Running checksum of the bytes handed to -writeBytes:ofLength: and -writeData: by the writer and its groups,
+// PSYChecksumNone, the default, doesn't compute any, the bytes are added as they're queued, before being written,
+// large data included, so they're only read once more, the bytes of input streams aren't part of the checksum
+// The writes from different threads are added one at a time, in the order they're queued
+// Setting the algorithm or -resetChecksum starts a new checksum, usually at a frame boundary
+@property(nonatomic)           PSYChecksumAlgorithm      checksumAlgorithm;
+@property(readonly, nonatomic) uint32_t                  checksum;
+
+- (void)resetChecksum;
+
+// Writers over a file descriptor tell their delegate when their pending bytes reach the high water mark
+// and again once they went down to the low water mark, producers can test hasSpaceAvailable before writing
+// Writers over an NSOutputStream ignore the water marks and always have space available
+@property(readonly, nonatomic) NSUInteger highWaterMark;
+@property(readonly, nonatomic) NSUInteger lowWaterMark;
+@property(readonly, nonatomic) BOOL       hasSpaceAvailable;
+
+- (void)setHighWaterMark:(NSUInteger)highWaterMark lowWaterMark:(NSUInteger)lowWaterMark;
+
 @end
 
 @protocol PSYStreamWriterDelegate <NSObject>
@@ -42,6 +84,8 @@
 - (void)streamWriter:(PSYStreamWriter *)sender didReceiveError:(NSError *)error;
 - (void)streamWriterDidFinishWriting:(PSYStreamWriter *)sender;
 - (void)streamWriterDidEncounterEnd:(PSYStreamWriter *)sender;
+- (void)streamWriterDidReachHighWaterMark:(PSYStreamWriter *)sender;
+- (void)streamWriterDidDrainToLowWaterMark:(PSYStreamWriter *)sender;
 @end
 
 @interface PSYStreamWriter (PSYStreamWriterCreation)
@@ -52,6 +96,80 @@
 - (id)initWithOutputStream:(NSOutputStream *)aStream;
 - (id)initWithOutputStream:(NSOutputStream *)aStream closeOnDealloc:(BOOL)closeOnDealloc;
 
+// Writes to the descriptor from a private dispatch queue, the writes of any thread are queued without a lock
+// The completion blocks and the delegate are called on that queue, except for streamWriterDidReachHighWaterMark:
+// which is called on the thread whose write reached the mark
++ (id)writerWithFileDescriptor:(int)fileDescriptor closeOnDealloc:(BOOL)closeOnDealloc;
+
+- (id)initWithFileDescriptor:(int)fileDescriptor closeOnDealloc:(BOOL)closeOnDealloc;
+
+// Compresses the writes before handing them to writer, the memory used doesn't depend on how much is written
+// Each group is flushed when its block returns, so everything written up to the end of a group can be inflated
+// as soon as the group is received, -finishCompression writes the end of the compressed stream
++ (id)writerWithStreamWriter:(PSYStreamWriter *)writer compressionFormat:(PSYCompressionFormat)format level:(int)level;
+
+- (id)initWithStreamWriter:(PSYStreamWriter *)writer compressionFormat:(PSYCompressionFormat)format level:(int)level;
+
+// Writes a regular file from its current offset through page-aligned buffers of bufferSize bytes written with pwrite(2),
+// the file is preallocated preallocationLength bytes at a time ahead of the writes, 0 picks the defaults, 1MB and 16MB
+// A background writer writes its full buffers on a private dispatch queue while the next one is filled,
+// the completion blocks and the delegate are then called on that queue, otherwise on the writing thread
+// The file handle must stay open as long as the writer, -flushWrites writes what's still buffered
++ (id)writerWithFileHandle:(NSFileHandle *)fileHandle;
++ (id)writerWithFileHandle:(NSFileHandle *)fileHandle bufferSize:(NSUInteger)bufferSize preallocationLength:(unsigned long long)preallocationLength flushesInBackground:(BOOL)background;
+
+- (id)initWithFileHandle:(NSFileHandle *)fileHandle;
+- (id)initWithFileHandle:(NSFileHandle *)fileHandle bufferSize:(NSUInteger)bufferSize preallocationLength:(unsigned long long)preallocationLength flushesInBackground:(BOOL)background;
+
+@end
+
+@interface PSYStreamWriter (PSYStreamWriterCompression)
+
+// Groups the writes of the block compressed as a stream of their own, finished when the block returns
+- (void)groupCompressedWrites:(void(^)(PSYStreamWriter *writer))writes format:(PSYCompressionFormat)format level:(int)level completion:(void(^)(void))completion;
+
+// Writes the end of the compressed stream of a compressing writer, no more bytes can be written afterward
+// Writers that don't compress have nothing to finish
+- (void)finishCompression;
+
+@end
+
+@interface PSYStreamWriter (PSYStreamWriterSections)
+
+// Groups the writes of the block after their length, encoded with prefix, the counterpart of the sections
+// of NSMutableData (PSYDataWriter): the writes are encoded into a single data where the nested
+// length-delimited groups are back-patched in place, and the data is handed to the writer when the block returns
+// The groups of the writer given to the block run right away, their completion blocks are called with completion,
+// input streams can't be written as their length isn't known in advance
+- (void)groupLengthDelimitedWrites:(void(^)(PSYStreamWriter *writer))writes prefix:(PSYLengthPrefix)prefix completion:(void(^)(void))completion;
+
+@end
+
+@interface PSYStreamWriter (PSYStreamWriterFilePositioning)
+
+// Offset in the file of the next byte written, writers that don't write a file at a known offset return 0
+@property(readonly, nonatomic) unsigned long long writeOffset;
+
+// Replaces bytes already written at offset, usually a header or a length written before what follows it was known,
+// bytes that are still buffered are replaced in memory, raises an NSRangeException past writeOffset
+// Only writers of a file can replace bytes, the others raise an NSInvalidArgumentException
+- (void)replaceBytesAtOffset:(unsigned long long)offset withBytes:(const void *)bytes length:(NSUInteger)length;
+- (void)replaceBytesAtOffset:(unsigned long long)offset withData:(NSData *)value;
+
+- (void)replaceInt8AtOffset:(unsigned long long)offset withValue:(uint8_t)value;
+
+- (void)replaceLittleEndianInt16AtOffset:(unsigned long long)offset withValue:(uint16_t)value;
+- (void)replaceLittleEndianInt32AtOffset:(unsigned long long)offset withValue:(uint32_t)value;
+- (void)replaceLittleEndianInt64AtOffset:(unsigned long long)offset withValue:(uint64_t)value;
+
+- (void)replaceBigEndianInt16AtOffset:(unsigned long long)offset withValue:(uint16_t)value;
+- (void)replaceBigEndianInt32AtOffset:(unsigned long long)offset withValue:(uint32_t)value;
+- (void)replaceBigEndianInt64AtOffset:(unsigned long long)offset withValue:(uint64_t)value;
+
+// Writes the buffered bytes and waits until the file has everything written so far, writers without a buffer of their own
+// have nothing to flush
+- (void)flushWrites;
+
 @end
 
 @interface PSYStreamWriter (PSYDataWriterAdditions)
@@ -102,6 +220,35 @@
 - (void)writeSwappedFloat:(float)value;
 - (void)writeSwappedDouble:(double)value;
 
+// Write count consecutive values with a single write
+- (void)writeInt8Array:(const uint8_t *)values count:(NSUInteger)count;
+
+- (void)writeLittleEndianInt16Array:(const uint16_t *)values count:(NSUInteger)count;
+- (void)writeLittleEndianInt32Array:(const uint32_t *)values count:(NSUInteger)count;
+- (void)writeLittleEndianInt64Array:(const uint64_t *)values count:(NSUInteger)count;
+
+- (void)writeBigEndianInt16Array:(const uint16_t *)values count:(NSUInteger)count;
+- (void)writeBigEndianInt32Array:(const uint32_t *)values count:(NSUInteger)count;
+- (void)writeBigEndianInt64Array:(const uint64_t *)values count:(NSUInteger)count;
+
+- (void)writeSInt8Array:(const int8_t *)values count:(NSUInteger)count;
+
+- (void)writeLittleEndianSInt16Array:(const int16_t *)values count:(NSUInteger)count;
+- (void)writeLittleEndianSInt32Array:(const int32_t *)values count:(NSUInteger)count;
+- (void)writeLittleEndianSInt64Array:(const int64_t *)values count:(NSUInteger)count;
+
+- (void)writeBigEndianSInt16Array:(const int16_t *)values count:(NSUInteger)count;
+- (void)writeBigEndianSInt32Array:(const int32_t *)values count:(NSUInteger)count;
+- (void)writeBigEndianSInt64Array:(const int64_t *)values count:(NSUInteger)count;
+
+- (void)writeFloatArray:(const float *)values count:(NSUInteger)count;
+- (void)writeDoubleArray:(const double *)values count:(NSUInteger)count;
+
+- (void)writeSwappedFloatArray:(const float *)values count:(NSUInteger)count;
+- (void)writeSwappedDoubleArray:(const double *)values count:(NSUInteger)count;
+
+// Large data objects are queued by reference instead of being copied,
+// mutable data are copied first so later changes are not written
 - (void)writeData:(NSData *)value;
 
 - (void)writeString:(NSString *)value usingEncoding:(NSStringEncoding)encoding;
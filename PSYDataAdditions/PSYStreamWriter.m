@@ -26,7 +26,13 @@
 #import "PSYStreamWriter.h"
 #import "PSYUtilities.h"
 #import "PSYConcreteStreamWriter.h"
+#import "PSYDispatchStreamWriter.h"
+#import "PSYCompressingStreamWriter.h"
+#import "PSYSectionStreamWriter.h"
+#import "PSYFileHandleWriter.h"
 #import "NSMutableData+PSYDataWriter.h"
+#import "PSYByteSwap.h"
+#import "PSYVarint.h"
 
 @interface PSYPlaceholderStreamWriter : PSYStreamWriter
 @end
@@ -67,6 +73,69 @@
     PSYRequestConcreteImplementation([self class], _cmd, [self class] != [PSYStreamWriter class]);
 }
 
+- (BOOL)collectsStatistics
+{
+    PSYRequestConcreteImplementation([self class], _cmd, [self class] != [PSYStreamWriter class]);
+    return NO;
+}
+
+- (void)setCollectsStatistics:(BOOL)value
+{
+    PSYRequestConcreteImplementation([self class], _cmd, [self class] != [PSYStreamWriter class]);
+}
+
+- (PSYStreamWriterStatistics)statistics
+{
+    PSYRequestConcreteImplementation([self class], _cmd, [self class] != [PSYStreamWriter class]);
+    return (PSYStreamWriterStatistics){ 0 };
+}
+
+- (void)resetStatistics;
+{
+    PSYRequestConcreteImplementation([self class], _cmd, [self class] != [PSYStreamWriter class]);
+}
+
+- (PSYChecksumAlgorithm)checksumAlgorithm
+{
+    PSYRequestConcreteImplementation([self class], _cmd, [self class] != [PSYStreamWriter class]);
+    return PSYChecksumNone;
+}
+
+- (void)setChecksumAlgorithm:(PSYChecksumAlgorithm)value
+{
+    PSYRequestConcreteImplementation([self class], _cmd, [self class] != [PSYStreamWriter class]);
+}
+
+- (uint32_t)checksum
+{
+    PSYRequestConcreteImplementation([self class], _cmd, [self class] != [PSYStreamWriter class]);
+    return 0;
+}
+
+- (void)resetChecksum;
+{
+    PSYRequestConcreteImplementation([self class], _cmd, [self class] != [PSYStreamWriter class]);
+}
+
+- (NSUInteger)highWaterMark
+{
+    return NSUIntegerMax;
+}
+
+- (NSUInteger)lowWaterMark
+{
+    return NSUIntegerMax;
+}
+
+- (BOOL)hasSpaceAvailable
+{
+    return YES;
+}
+
+- (void)setHighWaterMark:(NSUInteger)highWaterMark lowWaterMark:(NSUInteger)lowWaterMark;
+{
+}
+
 @end
 
 @implementation PSYStreamWriter (PSYStreamWriterCreation)
@@ -92,6 +161,139 @@
     return nil;
 }
 
++ (id)writerWithFileDescriptor:(int)fileDescriptor closeOnDealloc:(BOOL)closeOnDealloc;
+{
+    return AUTORELEASE([[self alloc] initWithFileDescriptor:fileDescriptor closeOnDealloc:closeOnDealloc]);
+}
+
+- (id)initWithFileDescriptor:(int)fileDescriptor closeOnDealloc:(BOOL)closeOnDealloc;
+{
+    RELEASE(self);
+    return nil;
+}
+
++ (id)writerWithStreamWriter:(PSYStreamWriter *)writer compressionFormat:(PSYCompressionFormat)format level:(int)level;
+{
+    return AUTORELEASE([[self alloc] initWithStreamWriter:writer compressionFormat:format level:level]);
+}
+
+- (id)initWithStreamWriter:(PSYStreamWriter *)writer compressionFormat:(PSYCompressionFormat)format level:(int)level;
+{
+    RELEASE(self);
+    return nil;
+}
+
++ (id)writerWithFileHandle:(NSFileHandle *)fileHandle;
+{
+    return AUTORELEASE([[self alloc] initWithFileHandle:fileHandle]);
+}
+
+- (id)initWithFileHandle:(NSFileHandle *)fileHandle;
+{
+    return [self initWithFileHandle:fileHandle bufferSize:0 preallocationLength:0 flushesInBackground:NO];
+}
+
++ (id)writerWithFileHandle:(NSFileHandle *)fileHandle bufferSize:(NSUInteger)bufferSize preallocationLength:(unsigned long long)preallocationLength flushesInBackground:(BOOL)background;
+{
+    return AUTORELEASE([[self alloc] initWithFileHandle:fileHandle bufferSize:bufferSize preallocationLength:preallocationLength flushesInBackground:background]);
+}
+
+- (id)initWithFileHandle:(NSFileHandle *)fileHandle bufferSize:(NSUInteger)bufferSize preallocationLength:(unsigned long long)preallocationLength flushesInBackground:(BOOL)background;
+{
+    RELEASE(self);
+    return nil;
+}
+
+@end
+
+@implementation PSYStreamWriter (PSYStreamWriterCompression)
+
+- (void)groupCompressedWrites:(void(^)(PSYStreamWriter *writer))writes format:(PSYCompressionFormat)format level:(int)level completion:(void(^)(void))completion;
+{
+    if(writes == nil) return;
+    
+    [self groupWrites:^(PSYStreamWriter *group) {
+        PSYCompressingStreamWriter *compressor = [[PSYCompressingStreamWriter alloc] initWithStreamWriter:group compressionFormat:format level:level];
+        
+        @try
+        {
+            writes(compressor);
+            [compressor finishCompression];
+        }
+        @finally
+        {
+            RELEASE(compressor);
+        }
+    } completion:completion];
+}
+
+- (void)finishCompression;
+{
+}
+
+@end
+
+@implementation PSYStreamWriter (PSYStreamWriterSections)
+
+- (void)groupLengthDelimitedWrites:(void(^)(PSYStreamWriter *writer))writes prefix:(PSYLengthPrefix)prefix completion:(void(^)(void))completion;
+{
+    if(writes == nil) return;
+    
+    PSYSectionStreamWriter *sectionWriter = [[PSYSectionStreamWriter alloc] initWithStreamWriter:self];
+    
+    @try
+    {
+        [sectionWriter groupLengthDelimitedWrites:writes prefix:prefix completion:completion];
+        [sectionWriter flushSections];
+    }
+    @finally
+    {
+        RELEASE(sectionWriter);
+    }
+}
+
+@end
+
+@implementation PSYStreamWriter (PSYStreamWriterFilePositioning)
+
+- (unsigned long long)writeOffset
+{
+    return 0;
+}
+
+- (void)replaceBytesAtOffset:(unsigned long long)offset withBytes:(const void *)bytes length:(NSUInteger)length;
+{
+    [NSException raise:NSInvalidArgumentException format:@"*** -[PSYStreamWriter %@]: the writer can't replace bytes already written", NSStringFromSelector(_cmd)];
+}
+
+- (void)replaceBytesAtOffset:(unsigned long long)offset withData:(NSData *)value;
+{
+    [self replaceBytesAtOffset:offset withBytes:[value bytes] length:[value length]];
+}
+
+#define REPLACE_METHOD(name, type, convert)                                           \
+- (void)replace ## name ## AtOffset:(unsigned long long)offset withValue:(type)value; \
+{                                                                                     \
+    type raw = convert(value);                                                        \
+    [self replaceBytesAtOffset:offset withBytes:&raw length:sizeof(raw)];             \
+}
+
+REPLACE_METHOD(Int8, uint8_t, (uint8_t))
+
+REPLACE_METHOD(LittleEndianInt16, uint16_t, CFSwapInt16HostToLittle)
+REPLACE_METHOD(LittleEndianInt32, uint32_t, CFSwapInt32HostToLittle)
+REPLACE_METHOD(LittleEndianInt64, uint64_t, CFSwapInt64HostToLittle)
+
+REPLACE_METHOD(BigEndianInt16, uint16_t, CFSwapInt16HostToBig)
+REPLACE_METHOD(BigEndianInt32, uint32_t, CFSwapInt32HostToBig)
+REPLACE_METHOD(BigEndianInt64, uint64_t, CFSwapInt64HostToBig)
+
+#undef REPLACE_METHOD
+
+- (void)flushWrites;
+{
+}
+
 @end
 
 @implementation PSYPlaceholderStreamWriter
@@ -117,68 +319,165 @@
     return (id)[[PSYConcreteStreamWriter alloc] initWithOutputStream:aStream closeOnDealloc:closeOnDealloc];
 }
 
+- (id)initWithFileDescriptor:(int)fileDescriptor closeOnDealloc:(BOOL)closeOnDealloc;
+{
+    return (id)[[PSYDispatchStreamWriter alloc] initWithFileDescriptor:fileDescriptor closeOnDealloc:closeOnDealloc];
+}
+
+- (id)initWithStreamWriter:(PSYStreamWriter *)writer compressionFormat:(PSYCompressionFormat)format level:(int)level;
+{
+    return (id)[[PSYCompressingStreamWriter alloc] initWithStreamWriter:writer compressionFormat:format level:level];
+}
+
+- (id)initWithFileHandle:(NSFileHandle *)fileHandle bufferSize:(NSUInteger)bufferSize preallocationLength:(unsigned long long)preallocationLength flushesInBackground:(BOOL)background;
+{
+    return (id)[[PSYFileHandleWriter alloc] initWithFileHandle:fileHandle bufferSize:bufferSize preallocationLength:preallocationLength flushesInBackground:background];
+}
+
 @end
 
 @implementation PSYStreamWriter (PSYDataWriterAdditions)
 
-#define WRITE_METHOD(name, type, size)                                   \
-- (void)write ## name:(type)value;                                       \
-{                                                                        \
-    NSMutableData *data = [[NSMutableData alloc] initWithCapacity:size]; \
-    [data append ## name:value];                                         \
-    [self writeData:data];                                               \
-    RELEASE(data);                                                       \
+// Values are encoded on the stack and handed to -writeBytes:ofLength:,
+// concrete writers copy them straight into their own buffer
+#define IDENTITY(value) (value)
+
+#define SIMPLE_WRITE_METHOD(name, type, convert)                  \
+- (void)write ## name:(type)value;                                \
+{                                                                 \
+    type raw = convert(value);                                    \
+    [self writeBytes:(const uint8_t *)&raw ofLength:sizeof(raw)]; \
 }
-#define SIMPLE_WRITE_METHOD(name, type) WRITE_METHOD(name, type, sizeof(type))
-#define VAR_WRITE_METHOD(name, type)    WRITE_METHOD(name, type, sizeof(type) + 1)
 
-SIMPLE_WRITE_METHOD(Int8, uint8_t)
+#define VAR_WRITE_METHOD(name, type, size, convert)                         \
+- (void)write ## name:(type)value;                                          \
+{                                                                           \
+    uint8_t buffer[PSYVarint64MaximumLength];                               \
+    uint ## size ## _t raw = convert((uint ## size ## _t)value);            \
+    [self writeBytes:buffer ofLength:PSYEncodeVarint ## size(buffer, raw)]; \
+}
 
-SIMPLE_WRITE_METHOD(LittleEndianInt16, uint16_t)
-SIMPLE_WRITE_METHOD(LittleEndianInt32, uint32_t)
-SIMPLE_WRITE_METHOD(LittleEndianInt64, uint64_t)
+#define ZIGZAG_WRITE_METHOD(name, type, size, convert)                      \
+- (void)write ## name:(type)value;                                          \
+{                                                                           \
+    uint8_t buffer[PSYVarint64MaximumLength];                               \
+    uint ## size ## _t raw = convert(PSYZigZagEncode ## size(value));       \
+    [self writeBytes:buffer ofLength:PSYEncodeVarint ## size(buffer, raw)]; \
+}
+
+SIMPLE_WRITE_METHOD(Int8, uint8_t, IDENTITY)
 
-SIMPLE_WRITE_METHOD(BigEndianInt16, uint16_t)
-SIMPLE_WRITE_METHOD(BigEndianInt32, uint32_t)
-SIMPLE_WRITE_METHOD(BigEndianInt64, uint64_t)
+SIMPLE_WRITE_METHOD(LittleEndianInt16, uint16_t, CFSwapInt16HostToLittle)
+SIMPLE_WRITE_METHOD(LittleEndianInt32, uint32_t, CFSwapInt32HostToLittle)
+SIMPLE_WRITE_METHOD(LittleEndianInt64, uint64_t, CFSwapInt64HostToLittle)
 
-SIMPLE_WRITE_METHOD(SInt8, int8_t)
+SIMPLE_WRITE_METHOD(BigEndianInt16, uint16_t, CFSwapInt16HostToBig)
+SIMPLE_WRITE_METHOD(BigEndianInt32, uint32_t, CFSwapInt32HostToBig)
+SIMPLE_WRITE_METHOD(BigEndianInt64, uint64_t, CFSwapInt64HostToBig)
 
-SIMPLE_WRITE_METHOD(LittleEndianSInt16, int16_t)
-SIMPLE_WRITE_METHOD(LittleEndianSInt32, int32_t)
-SIMPLE_WRITE_METHOD(LittleEndianSInt64, int64_t)
+SIMPLE_WRITE_METHOD(SInt8, int8_t, IDENTITY)
 
-SIMPLE_WRITE_METHOD(BigEndianSInt16, int16_t)
-SIMPLE_WRITE_METHOD(BigEndianSInt32, int32_t)
-SIMPLE_WRITE_METHOD(BigEndianSInt64, int64_t)
+SIMPLE_WRITE_METHOD(LittleEndianSInt16, int16_t, CFSwapInt16HostToLittle)
+SIMPLE_WRITE_METHOD(LittleEndianSInt32, int32_t, CFSwapInt32HostToLittle)
+SIMPLE_WRITE_METHOD(LittleEndianSInt64, int64_t, CFSwapInt64HostToLittle)
 
-VAR_WRITE_METHOD(LittleEndianVarint32, uint32_t)
-VAR_WRITE_METHOD(LittleEndianVarint64, uint64_t)
+SIMPLE_WRITE_METHOD(BigEndianSInt16, int16_t, CFSwapInt16HostToBig)
+SIMPLE_WRITE_METHOD(BigEndianSInt32, int32_t, CFSwapInt32HostToBig)
+SIMPLE_WRITE_METHOD(BigEndianSInt64, int64_t, CFSwapInt64HostToBig)
 
-VAR_WRITE_METHOD(BigEndianVarint32, uint32_t)
-VAR_WRITE_METHOD(BigEndianVarint64, uint64_t)
+VAR_WRITE_METHOD(LittleEndianVarint32, uint32_t, 32, CFSwapInt32HostToLittle)
+VAR_WRITE_METHOD(LittleEndianVarint64, uint64_t, 64, CFSwapInt64HostToLittle)
 
-VAR_WRITE_METHOD(LittleEndianSVarint32, int32_t)
-VAR_WRITE_METHOD(LittleEndianSVarint64, int64_t)
+VAR_WRITE_METHOD(BigEndianVarint32, uint32_t, 32, CFSwapInt32HostToBig)
+VAR_WRITE_METHOD(BigEndianVarint64, uint64_t, 64, CFSwapInt64HostToBig)
 
-VAR_WRITE_METHOD(BigEndianSVarint32, int32_t)
-VAR_WRITE_METHOD(BigEndianSVarint64, int64_t)
+VAR_WRITE_METHOD(LittleEndianSVarint32, int32_t, 32, CFSwapInt32HostToLittle)
+VAR_WRITE_METHOD(LittleEndianSVarint64, int64_t, 64, CFSwapInt64HostToLittle)
 
-VAR_WRITE_METHOD(LittleEndianZigZagVarint32, int32_t)
-VAR_WRITE_METHOD(LittleEndianZigZagVarint64, int64_t)
+VAR_WRITE_METHOD(BigEndianSVarint32, int32_t, 32, CFSwapInt32HostToBig)
+VAR_WRITE_METHOD(BigEndianSVarint64, int64_t, 64, CFSwapInt64HostToBig)
 
-VAR_WRITE_METHOD(BigEndianZigZagVarint32, int32_t)
-VAR_WRITE_METHOD(BigEndianZigZagVarint64, int64_t)
+ZIGZAG_WRITE_METHOD(LittleEndianZigZagVarint32, int32_t, 32, CFSwapInt32HostToLittle)
+ZIGZAG_WRITE_METHOD(LittleEndianZigZagVarint64, int64_t, 64, CFSwapInt64HostToLittle)
 
-SIMPLE_WRITE_METHOD(Float, float)
-SIMPLE_WRITE_METHOD(Double, double)
+ZIGZAG_WRITE_METHOD(BigEndianZigZagVarint32, int32_t, 32, CFSwapInt32HostToBig)
+ZIGZAG_WRITE_METHOD(BigEndianZigZagVarint64, int64_t, 64, CFSwapInt64HostToBig)
 
-SIMPLE_WRITE_METHOD(SwappedFloat, float)
-SIMPLE_WRITE_METHOD(SwappedDouble, double)
+SIMPLE_WRITE_METHOD(Float, float, IDENTITY)
+SIMPLE_WRITE_METHOD(Double, double, IDENTITY)
 
-#undef WRITE_METHOD
 #undef SIMPLE_WRITE_METHOD
 #undef VAR_WRITE_METHOD
+#undef ZIGZAG_WRITE_METHOD
+#undef IDENTITY
+
+- (void)writeSwappedFloat:(float)value;
+{
+    CFSwappedFloat32 raw = CFConvertFloatHostToSwapped(value);
+    [self writeBytes:(const uint8_t *)&raw ofLength:sizeof(raw)];
+}
+
+- (void)writeSwappedDouble:(double)value;
+{
+    CFSwappedFloat64 raw = CFConvertDoubleHostToSwapped(value);
+    [self writeBytes:(const uint8_t *)&raw ofLength:sizeof(raw)];
+}
+
+- (void)PSY_writeArray:(const void *)values count:(NSUInteger)count width:(NSUInteger)width swap:(BOOL)swap;
+{
+    if(count == 0) return;
+    if(count > NSUIntegerMax / width) [NSException raise:NSInvalidArgumentException format:@"*** -[PSYStreamWriter %@]: count too large", NSStringFromSelector(_cmd)];
+    
+    NSUInteger length = count * width;
+    
+    if(!swap)
+    {
+        [self writeBytes:values ofLength:length];
+        return;
+    }
+    
+    uint8_t *buffer = malloc(length);
+    if(buffer == NULL) [NSException raise:NSMallocException format:@"*** -[PSYStreamWriter %@]: unable to allocate %lu bytes", NSStringFromSelector(_cmd), (unsigned long)length];
+    
+    PSYCopyElements(buffer, values, count, width, YES);
+    [self writeBytes:buffer ofLength:length];
+    
+    free(buffer);
+}
+
+#define WRITE_ARRAY_METHOD(name, type, swap)                                                \
+- (void)write ## name ## Array:(const type *)values count:(NSUInteger)count                 \
+{                                                                                           \
+    [self PSY_writeArray:values count:count width:sizeof(type) swap:swap];                  \
+}
+
+WRITE_ARRAY_METHOD(Int8, uint8_t, NO)
+
+WRITE_ARRAY_METHOD(LittleEndianInt16, uint16_t, PSY_SWAP_LITTLE_ENDIAN)
+WRITE_ARRAY_METHOD(LittleEndianInt32, uint32_t, PSY_SWAP_LITTLE_ENDIAN)
+WRITE_ARRAY_METHOD(LittleEndianInt64, uint64_t, PSY_SWAP_LITTLE_ENDIAN)
+
+WRITE_ARRAY_METHOD(BigEndianInt16, uint16_t, PSY_SWAP_BIG_ENDIAN)
+WRITE_ARRAY_METHOD(BigEndianInt32, uint32_t, PSY_SWAP_BIG_ENDIAN)
+WRITE_ARRAY_METHOD(BigEndianInt64, uint64_t, PSY_SWAP_BIG_ENDIAN)
+
+WRITE_ARRAY_METHOD(SInt8, int8_t, NO)
+
+WRITE_ARRAY_METHOD(LittleEndianSInt16, int16_t, PSY_SWAP_LITTLE_ENDIAN)
+WRITE_ARRAY_METHOD(LittleEndianSInt32, int32_t, PSY_SWAP_LITTLE_ENDIAN)
+WRITE_ARRAY_METHOD(LittleEndianSInt64, int64_t, PSY_SWAP_LITTLE_ENDIAN)
+
+WRITE_ARRAY_METHOD(BigEndianSInt16, int16_t, PSY_SWAP_BIG_ENDIAN)
+WRITE_ARRAY_METHOD(BigEndianSInt32, int32_t, PSY_SWAP_BIG_ENDIAN)
+WRITE_ARRAY_METHOD(BigEndianSInt64, int64_t, PSY_SWAP_BIG_ENDIAN)
+
+WRITE_ARRAY_METHOD(Float, float, NO)
+WRITE_ARRAY_METHOD(Double, double, NO)
+
+WRITE_ARRAY_METHOD(SwappedFloat, float, PSY_SWAP_BIG_ENDIAN)
+WRITE_ARRAY_METHOD(SwappedDouble, double, PSY_SWAP_BIG_ENDIAN)
+
+#undef WRITE_ARRAY_METHOD
 
 - (void)writeData:(NSData *)value;
 {
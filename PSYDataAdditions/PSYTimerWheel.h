@@ -0,0 +1,59 @@
+/*
+ PSYTimerWheel.h
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+// Hierarchical timer wheel shared by everything scheduling timeouts from a thread,
+// it's driven by a single timer on the thread's run loop, running only while entries are pending
+// Scheduling and cancelling are O(1), pushing back the deadline of a scheduled entry only updates it,
+// the entry is moved when its former slot expires
+// Entries belong to their clients and must be used from a single thread
+typedef struct _PSYTimerWheelEntry PSYTimerWheelEntry;
+
+typedef void (*PSYTimerWheelFunction)(PSYTimerWheelEntry *entry, void *context);
+
+struct _PSYTimerWheelEntry
+{
+    PSYTimerWheelEntry    *next;
+    PSYTimerWheelEntry   **previousNext;
+    void                  *wheel;
+    uint64_t               deadline;
+    PSYTimerWheelFunction  function;
+    void                  *context;
+};
+
+void PSYTimerWheelEntryInit(PSYTimerWheelEntry *entry, PSYTimerWheelFunction function, void *context);
+
+// Arms or re-arms the entry to fire in interval seconds on the current thread's wheel
+// The resolution of the wheel is 10 milliseconds
+void PSYTimerWheelSchedule(PSYTimerWheelEntry *entry, NSTimeInterval interval);
+void PSYTimerWheelCancel(PSYTimerWheelEntry *entry);
+BOOL PSYTimerWheelEntryIsScheduled(const PSYTimerWheelEntry *entry);
+
+// Fires the entries of the current thread's wheel that are due, the run loop timer calls it on every tick
+void PSYTimerWheelFireExpiredEntries(void);
+
+// Number of entries pending on the current thread's wheel
+NSUInteger PSYTimerWheelScheduledCount(void);
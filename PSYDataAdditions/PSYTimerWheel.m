@@ -0,0 +1,278 @@
+/*
+ PSYTimerWheel.m
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import "PSYTimerWheel.h"
+#import "PSYUtilities.h"
+#include <math.h>
+
+#define WHEEL_LEVELS     4
+#define WHEEL_SLOT_BITS  6
+#define WHEEL_SLOTS      (1 << WHEEL_SLOT_BITS)
+#define WHEEL_SLOT_MASK  (WHEEL_SLOTS - 1)
+#define WHEEL_TICK       0.01
+
+// 4 levels of 64 slots cover 2^24 ticks, about 46 hours,
+// later deadlines wait in the last slot and are linked again when it expires
+#define WHEEL_HORIZON    (1ULL << (WHEEL_LEVELS * WHEEL_SLOT_BITS))
+
+static NSString *const PSYTimerWheelThreadKey = @"PSYTimerWheel";
+
+@interface PSYTimerWheel : NSObject
+{
+@public
+    PSYTimerWheelEntry *slots[WHEEL_LEVELS][WHEEL_SLOTS];
+    NSTimeInterval      startTime;
+    uint64_t            currentTick;
+    NSUInteger          count;
+    NSTimer            *timer;
+    BOOL                firing;
+}
+- (void)PSY_startTimer;
+- (void)PSY_stopTimer;
+@end
+
+static PSYTimerWheel *PSYCurrentTimerWheel(void)
+{
+    NSMutableDictionary *threadDictionary = [[NSThread currentThread] threadDictionary];
+    PSYTimerWheel       *wheel            = [threadDictionary objectForKey:PSYTimerWheelThreadKey];
+    
+    if(wheel == nil)
+    {
+        wheel = [[PSYTimerWheel alloc] init];
+        [threadDictionary setObject:wheel forKey:PSYTimerWheelThreadKey];
+        RELEASE(wheel);
+        wheel = [threadDictionary objectForKey:PSYTimerWheelThreadKey];
+    }
+    
+    return wheel;
+}
+
+static uint64_t PSYTimerWheelNow(PSYTimerWheel *wheel)
+{
+    return (uint64_t)(([[NSProcessInfo processInfo] systemUptime] - wheel->startTime) / WHEEL_TICK);
+}
+
+static void PSYTimerWheelUnlink(PSYTimerWheelEntry *entry)
+{
+    *entry->previousNext = entry->next;
+    if(entry->next != NULL) entry->next->previousNext = entry->previousNext;
+    
+    entry->next         = NULL;
+    entry->previousNext = NULL;
+}
+
+// Links the entry in the slot of the lowest level that can hold its deadline
+static void PSYTimerWheelLink(PSYTimerWheel *wheel, PSYTimerWheelEntry *entry)
+{
+    uint64_t   deadline = MAX(entry->deadline, wheel->currentTick);
+    uint64_t   delta    = deadline - wheel->currentTick;
+    NSUInteger level    = 0;
+    
+    if(delta >= WHEEL_HORIZON)
+    {
+        delta    = WHEEL_HORIZON - 1;
+        deadline = wheel->currentTick + delta;
+    }
+    
+    while(delta >= 1ULL << ((level + 1) * WHEEL_SLOT_BITS)) level++;
+    
+    PSYTimerWheelEntry **slot = &wheel->slots[level][(deadline >> (level * WHEEL_SLOT_BITS)) & WHEEL_SLOT_MASK];
+    
+    entry->next = *slot;
+    if(*slot != NULL) (*slot)->previousNext = &entry->next;
+    entry->previousNext = slot;
+    *slot = entry;
+}
+
+static void PSYTimerWheelAdvance(PSYTimerWheel *wheel, uint64_t now)
+{
+    while(wheel->currentTick < now)
+    {
+        // Nothing to fire on the way, jump straight to now
+        if(wheel->count == 0)
+        {
+            wheel->currentTick = now;
+            break;
+        }
+        
+        uint64_t tick = ++wheel->currentTick;
+        
+        // Move the entries of the higher level slots starting on this tick down,
+        // from the highest level so that the lower levels receive them before being cascaded
+        NSUInteger top = 0;
+        while(top + 1 < WHEEL_LEVELS && (tick & ((1ULL << ((top + 1) * WHEEL_SLOT_BITS)) - 1)) == 0) top++;
+        
+        for(NSUInteger level = top; level > 0; level--)
+        {
+            PSYTimerWheelEntry **slot  = &wheel->slots[level][(tick >> (level * WHEEL_SLOT_BITS)) & WHEEL_SLOT_MASK];
+            PSYTimerWheelEntry  *entry = *slot;
+            
+            *slot = NULL;
+            
+            while(entry != NULL)
+            {
+                PSYTimerWheelEntry *next = entry->next;
+                PSYTimerWheelLink(wheel, entry);
+                entry = next;
+            }
+        }
+        
+        // The slot is detached first, the functions may cancel or schedule any entry
+        PSYTimerWheelEntry **slot    = &wheel->slots[0][tick & WHEEL_SLOT_MASK];
+        PSYTimerWheelEntry  *pending = *slot;
+        
+        *slot = NULL;
+        if(pending != NULL) pending->previousNext = &pending;
+        
+        while(pending != NULL)
+        {
+            PSYTimerWheelEntry *entry = pending;
+            PSYTimerWheelUnlink(entry);
+            
+            // The deadline was pushed back after the entry was linked
+            if(entry->deadline > tick)
+            {
+                PSYTimerWheelLink(wheel, entry);
+                continue;
+            }
+            
+            entry->wheel = NULL;
+            wheel->count--;
+            
+            entry->function(entry, entry->context);
+        }
+    }
+}
+
+void PSYTimerWheelEntryInit(PSYTimerWheelEntry *entry, PSYTimerWheelFunction function, void *context)
+{
+    memset(entry, 0, sizeof(PSYTimerWheelEntry));
+    entry->function = function;
+    entry->context  = context;
+}
+
+BOOL PSYTimerWheelEntryIsScheduled(const PSYTimerWheelEntry *entry)
+{
+    return entry->wheel != NULL;
+}
+
+void PSYTimerWheelSchedule(PSYTimerWheelEntry *entry, NSTimeInterval interval)
+{
+    PSYTimerWheel *wheel = PSYCurrentTimerWheel();
+    uint64_t       now   = PSYTimerWheelNow(wheel);
+    
+    if(wheel->count == 0) wheel->currentTick = MAX(wheel->currentTick, now);
+    
+    uint64_t ticks    = interval > WHEEL_TICK ? (uint64_t)ceil(interval / WHEEL_TICK) : 1;
+    uint64_t deadline = MAX(now, wheel->currentTick) + ticks;
+    
+    // Pushing back a deadline leaves the entry where it is
+    if(entry->wheel == (__bridge void *)wheel && deadline >= entry->deadline)
+    {
+        entry->deadline = deadline;
+        return;
+    }
+    
+    PSYTimerWheelCancel(entry);
+    
+    entry->deadline = deadline;
+    entry->wheel    = (__bridge void *)wheel;
+    PSYTimerWheelLink(wheel, entry);
+    
+    if(wheel->count++ == 0) [wheel PSY_startTimer];
+}
+
+void PSYTimerWheelCancel(PSYTimerWheelEntry *entry)
+{
+    if(entry->wheel == NULL) return;
+    
+    PSYTimerWheel *wheel = (__bridge PSYTimerWheel *)entry->wheel;
+    
+    PSYTimerWheelUnlink(entry);
+    entry->wheel = NULL;
+    
+    if(--wheel->count == 0) [wheel PSY_stopTimer];
+}
+
+void PSYTimerWheelFireExpiredEntries(void)
+{
+    PSYTimerWheel *wheel = PSYCurrentTimerWheel();
+    
+    // An entry's function may run the run loop
+    if(wheel->firing) return;
+    
+    wheel->firing = YES;
+    PSYTimerWheelAdvance(wheel, PSYTimerWheelNow(wheel));
+    wheel->firing = NO;
+    
+    if(wheel->count == 0) [wheel PSY_stopTimer];
+}
+
+NSUInteger PSYTimerWheelScheduledCount(void)
+{
+    return PSYCurrentTimerWheel()->count;
+}
+
+@implementation PSYTimerWheel
+
+- (id)init
+{
+    if((self = [super init]))
+    {
+        startTime = [[NSProcessInfo processInfo] systemUptime];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [timer invalidate];
+    
+#if !__has_feature(objc_arc)
+    [super dealloc];
+#endif
+}
+
+// The timer retains the wheel while entries are pending
+- (void)PSY_startTimer;
+{
+    if(timer != nil) return;
+    
+    timer = [NSTimer timerWithTimeInterval:WHEEL_TICK target:self selector:@selector(PSY_timerDidFire:) userInfo:nil repeats:YES];
+    [[NSRunLoop currentRunLoop] addTimer:timer forMode:NSRunLoopCommonModes];
+}
+
+- (void)PSY_stopTimer;
+{
+    [timer invalidate];
+    timer = nil;
+}
+
+- (void)PSY_timerDidFire:(NSTimer *)aTimer
+{
+    PSYTimerWheelFireExpiredEntries();
+}
+
+@end
@@ -0,0 +1,165 @@
+/*
+ PSYVarint.h
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+#include <string.h>
+
+#define PSYVarint32MaximumLength 5
+#define PSYVarint64MaximumLength 10
+
+// All the decoders return the number of bytes read,
+// 0 means the varint is truncated or longer than its maximum length
+// The values are returned as they were read, the caller applies byte swapping and zigzag decoding
+
+static inline NSUInteger PSYDecodeVarint64Slow(const uint8_t *bytes, NSUInteger length, uint64_t *value)
+{
+    uint64_t result = 0;
+    
+    for(NSUInteger i = 0; i < length && i < PSYVarint64MaximumLength; i++)
+    {
+        result |= ((uint64_t)(bytes[i] & 0x7f)) << (i * 7);
+        if((bytes[i] & 0x80) == 0)
+        {
+            *value = result;
+            return i + 1;
+        }
+    }
+    
+    return 0;
+}
+
+// Reads 8 bytes at once, the end of the varint is the first byte without its continuation bit
+// and the 7-bit groups are packed together with shifts and masks instead of a loop
+// Returns 0 if the varint doesn't end within these 8 bytes
+static inline NSUInteger PSYDecodeVarintWord(const uint8_t *bytes, uint64_t *value)
+{
+    uint64_t word;
+    memcpy(&word, bytes, sizeof(word));
+    word = CFSwapInt64LittleToHost(word);
+    
+    uint64_t stops = ~word & 0x8080808080808080ULL;
+    if(stops == 0) return 0;
+    
+    NSUInteger length = ((NSUInteger)__builtin_ctzll(stops) >> 3) + 1;
+    
+    if(length < 8) word &= (1ULL << (length * 8)) - 1;
+    
+    *value = (( word        & 0x000000000000007fULL) |
+              ((word >> 1)  & 0x0000000000003f80ULL) |
+              ((word >> 2)  & 0x00000000001fc000ULL) |
+              ((word >> 3)  & 0x000000000fe00000ULL) |
+              ((word >> 4)  & 0x00000007f0000000ULL) |
+              ((word >> 5)  & 0x000003f800000000ULL) |
+              ((word >> 6)  & 0x0001fc0000000000ULL) |
+              ((word >> 7)  & 0x00fe000000000000ULL));
+    
+    return length;
+}
+
+static inline NSUInteger PSYDecodeVarint32(const uint8_t *bytes, NSUInteger length, uint32_t *value)
+{
+    uint64_t   result = 0;
+    NSUInteger read   = (length >= sizeof(uint64_t)
+                         ? PSYDecodeVarintWord(bytes, &result)
+                         : PSYDecodeVarint64Slow(bytes, length, &result));
+    
+    if(read == 0 || read > PSYVarint32MaximumLength) return 0;
+    
+    *value = (uint32_t)result;
+    return read;
+}
+
+static inline NSUInteger PSYDecodeVarint64(const uint8_t *bytes, NSUInteger length, uint64_t *value)
+{
+    if(length >= sizeof(uint64_t))
+    {
+        NSUInteger read = PSYDecodeVarintWord(bytes, value);
+        if(read != 0) return read;
+    }
+    
+    return PSYDecodeVarint64Slow(bytes, length, value);
+}
+
+static inline uint32_t PSYZigZagDecode32(uint32_t value)
+{
+    return (value >> 1) ^ (0 - (value & 1));
+}
+
+static inline uint64_t PSYZigZagDecode64(uint64_t value)
+{
+    return (value >> 1) ^ (0 - (value & 1));
+}
+
+static inline uint32_t PSYZigZagEncode32(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static inline uint64_t PSYZigZagEncode64(int64_t value)
+{
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+// Encodes value in buffer and returns the number of bytes written,
+// buffer must be able to hold PSYVarint64MaximumLength bytes
+static inline NSUInteger PSYEncodeVarint64(uint8_t *buffer, uint64_t value)
+{
+    NSUInteger length = 0;
+    
+    while(value >= 0x80)
+    {
+        buffer[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    
+    buffer[length++] = (uint8_t)value;
+    return length;
+}
+
+static inline NSUInteger PSYEncodeVarint32(uint8_t *buffer, uint32_t value)
+{
+    return PSYEncodeVarint64(buffer, value);
+}
+
+// Encodes value on exactly PSYVarint32MaximumLength bytes, the leading groups carry their continuation bit
+// even when they're zero, the decoders read it like any other varint
+static inline NSUInteger PSYEncodePaddedVarint32(uint8_t *buffer, uint32_t value)
+{
+    for(NSUInteger i = 0; i < PSYVarint32MaximumLength - 1; i++)
+    {
+        buffer[i] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    
+    buffer[PSYVarint32MaximumLength - 1] = (uint8_t)value;
+    return PSYVarint32MaximumLength;
+}
+
+// Decodes up to count varints from bytes, stops at the first truncated or invalid varint
+// Returns the number of values decoded and sets *consumed to the number of bytes they used
+// values may be NULL to skip the varints
+NSUInteger PSYDecodeVarint32Array(const uint8_t *bytes, NSUInteger length, uint32_t *values, NSUInteger count, NSUInteger *consumed);
+NSUInteger PSYDecodeVarint64Array(const uint8_t *bytes, NSUInteger length, uint64_t *values, NSUInteger count, NSUInteger *consumed);
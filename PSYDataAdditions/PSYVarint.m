@@ -0,0 +1,118 @@
+/*
+ PSYVarint.m
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import "PSYVarint.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Number of consecutive single-byte varints at the beginning of bytes, checked a block at a time
+// Columnar payloads are mostly made of small values so these runs are copied without decoding
+static inline NSUInteger PSYSingleByteRunLength(const uint8_t *bytes, NSUInteger length, NSUInteger limit)
+{
+    NSUInteger run = 0;
+    
+#if defined(__SSE2__)
+    for(; run + 16 <= length && run + 16 <= limit; run += 16)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i *)(bytes + run));
+        if(_mm_movemask_epi8(block) != 0) break;
+    }
+#endif
+    
+    for(; run + 8 <= length && run + 8 <= limit; run += 8)
+    {
+        uint64_t word;
+        memcpy(&word, bytes + run, sizeof(word));
+        if((word & 0x8080808080808080ULL) != 0) break;
+    }
+    
+    return run;
+}
+
+NSUInteger PSYDecodeVarint32Array(const uint8_t *bytes, NSUInteger length, uint32_t *values, NSUInteger count, NSUInteger *consumed)
+{
+    NSUInteger loc     = 0;
+    NSUInteger decoded = 0;
+    
+    while(decoded < count)
+    {
+        NSUInteger run = PSYSingleByteRunLength(bytes + loc, length - loc, count - decoded);
+        if(run > 0)
+        {
+            if(values != NULL)
+                for(NSUInteger i = 0; i < run; i++) values[decoded + i] = bytes[loc + i];
+            
+            loc     += run;
+            decoded += run;
+            continue;
+        }
+        
+        uint32_t   value = 0;
+        NSUInteger read  = PSYDecodeVarint32(bytes + loc, length - loc, &value);
+        if(read == 0) break;
+        
+        if(values != NULL) values[decoded] = value;
+        
+        loc += read;
+        decoded++;
+    }
+    
+    if(consumed != NULL) *consumed = loc;
+    return decoded;
+}
+
+NSUInteger PSYDecodeVarint64Array(const uint8_t *bytes, NSUInteger length, uint64_t *values, NSUInteger count, NSUInteger *consumed)
+{
+    NSUInteger loc     = 0;
+    NSUInteger decoded = 0;
+    
+    while(decoded < count)
+    {
+        NSUInteger run = PSYSingleByteRunLength(bytes + loc, length - loc, count - decoded);
+        if(run > 0)
+        {
+            if(values != NULL)
+                for(NSUInteger i = 0; i < run; i++) values[decoded + i] = bytes[loc + i];
+            
+            loc     += run;
+            decoded += run;
+            continue;
+        }
+        
+        uint64_t   value = 0;
+        NSUInteger read  = PSYDecodeVarint64(bytes + loc, length - loc, &value);
+        if(read == 0) break;
+        
+        if(values != NULL) values[decoded] = value;
+        
+        loc += read;
+        decoded++;
+    }
+    
+    if(consumed != NULL) *consumed = loc;
+    return decoded;
+}
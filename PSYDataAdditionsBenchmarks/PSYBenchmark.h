@@ -0,0 +1,65 @@
+/*
+ PSYBenchmark.h
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+// Calls block iterations times and prints the throughput of the calls,
+// bytes and operations are the amounts processed by a single call to block
+// The heap allocations per operation are printed too where the allocator can be observed
+void PSYBenchmarkRun(NSString *name, unsigned long long bytes, unsigned long long operations, NSUInteger iterations, void (^block)(void));
+
+// Only the benchmarks whose name contains filter are run, all of them are run if it's nil
+void PSYBenchmarkSetFilter(NSString *filter);
+
+// Writes the results of the benchmarks run so far to path as a JSON object,
+// the results are keyed by benchmark name and hold the values printed for each of them
+BOOL PSYBenchmarkWriteResults(NSString *path);
+
+// Prints how the ns/op of the benchmarks run so far changed from the results written to path
+// Returns the number of benchmarks that got slower by more than tolerance percent,
+// or NSNotFound if the baseline can't be read
+NSUInteger PSYBenchmarkCompareWithBaseline(NSString *path, double tolerance);
+
+// Returns size bytes of random data that never contain the bytes in excluded
+NSData *PSYBenchmarkRandomData(NSUInteger size, NSString *excluded);
+
+// Writes data to a temporary file and returns a file handle to read it
+NSFileHandle *PSYBenchmarkFileHandleWithData(NSData *data);
+
+void PSYRunSearchBenchmarks(void);
+void PSYRunVarintBenchmarks(void);
+void PSYRunScanBenchmarks(void);
+void PSYRunWriterBenchmarks(void);
+void PSYRunTimerBenchmarks(void);
+void PSYRunFamilyBenchmarks(void);
+
+// An always open output stream that drops everything written to it,
+// so the benchmarks measure the writer rather than the destination
+@interface PSYBenchmarkNullOutputStream : NSOutputStream
+{
+    NSStreamStatus       status;
+    id<NSStreamDelegate> delegate;
+}
+@end
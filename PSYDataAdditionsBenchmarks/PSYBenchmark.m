@@ -0,0 +1,247 @@
+/*
+ PSYBenchmark.m
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import "PSYBenchmark.h"
+#import "PSYUtilities.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+#if __APPLE__
+#include <mach/mach_time.h>
+#endif
+
+static unsigned long long PSYBenchmarkAllocations;
+
+static NSString            *PSYBenchmarkFilter;
+static NSMutableArray      *PSYBenchmarkNames;
+static NSMutableDictionary *PSYBenchmarkResults;
+
+// Keys of the results, they are the units printed for each benchmark
+static NSString *const PSYBenchmarkMegabytesPerSecondKey = @"MB/s";
+static NSString *const PSYBenchmarkNanosecondsPerOpKey   = @"ns/op";
+static NSString *const PSYBenchmarkAllocationsPerOpKey   = @"allocs/op";
+
+#if __APPLE__
+// libmalloc reports every allocation to malloc_logger when it is set, this is what Instruments uses
+#define PSY_BENCHMARK_COUNTS_ALLOCATIONS 1
+#define PSY_MALLOC_LOG_TYPE_ALLOCATE 2
+
+typedef void (malloc_logger_t)(uint32_t type, uintptr_t arg1, uintptr_t arg2, uintptr_t arg3, uintptr_t result, uint32_t num_hot_frames_to_skip);
+extern malloc_logger_t *malloc_logger;
+
+static void PSYBenchmarkMallocLogger(uint32_t type, uintptr_t arg1, uintptr_t arg2, uintptr_t arg3, uintptr_t result, uint32_t num_hot_frames_to_skip)
+{
+    if(type & PSY_MALLOC_LOG_TYPE_ALLOCATE) __atomic_fetch_add(&PSYBenchmarkAllocations, 1, __ATOMIC_RELAXED);
+}
+
+static void PSYBenchmarkStartCountingAllocations(void) { malloc_logger = PSYBenchmarkMallocLogger; }
+static void PSYBenchmarkStopCountingAllocations(void)  { malloc_logger = NULL; }
+#else
+// Elsewhere the allocations are left to an instrumented build, such as one run under heaptrack or valgrind
+#define PSY_BENCHMARK_COUNTS_ALLOCATIONS 0
+
+static void PSYBenchmarkStartCountingAllocations(void) { }
+static void PSYBenchmarkStopCountingAllocations(void)  { }
+#endif
+
+static uint64_t PSYBenchmarkNanoseconds(void)
+{
+#if __APPLE__
+    static mach_timebase_info_data_t timebase;
+    if(timebase.denom == 0) mach_timebase_info(&timebase);
+    
+    return mach_absolute_time() * timebase.numer / timebase.denom;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+#endif
+}
+
+void PSYBenchmarkSetFilter(NSString *filter)
+{
+    RELEASE(PSYBenchmarkFilter);
+    PSYBenchmarkFilter = [filter copy];
+}
+
+void PSYBenchmarkRun(NSString *name, unsigned long long bytes, unsigned long long operations, NSUInteger iterations, void (^block)(void))
+{
+    if(PSYBenchmarkFilter != nil && [name rangeOfString:PSYBenchmarkFilter].location == NSNotFound) return;
+    
+    // Warm up the caches and the lazily created objects
+    @autoreleasepool { block(); }
+    
+    uint64_t start = PSYBenchmarkNanoseconds();
+    
+    for(NSUInteger i = 0; i < iterations; i++)
+        @autoreleasepool { block(); }
+    
+    double elapsed = (double)(PSYBenchmarkNanoseconds() - start);
+    
+    double megabytesPerSecond = (double)bytes * iterations / (elapsed / 1e9) / (1024.0 * 1024.0);
+    double nanosecondsPerOp   = operations > 0 ? elapsed / ((double)operations * iterations) : 0.0;
+    
+    // The allocations are counted in a separate pass so the timed pass doesn't pay for the counting
+    PSYBenchmarkAllocations = 0;
+    
+    if(PSY_BENCHMARK_COUNTS_ALLOCATIONS)
+    {
+        PSYBenchmarkStartCountingAllocations();
+        @autoreleasepool { block(); }
+        PSYBenchmarkStopCountingAllocations();
+    }
+    
+    double allocationsPerOp = operations > 0 ? (double)PSYBenchmarkAllocations / operations : 0.0;
+    
+    printf("%-60s %10.1f MB/s %10.2f GB/s %10.2f ns/op", [name UTF8String], megabytesPerSecond, megabytesPerSecond / 1024.0, nanosecondsPerOp);
+    
+    if(PSY_BENCHMARK_COUNTS_ALLOCATIONS) printf(" %10.3f allocs/op", allocationsPerOp);
+    
+    printf("\n");
+    
+    if(PSYBenchmarkResults == nil)
+    {
+        PSYBenchmarkNames   = [[NSMutableArray alloc] init];
+        PSYBenchmarkResults = [[NSMutableDictionary alloc] init];
+    }
+    
+    NSMutableDictionary *result = [NSMutableDictionary dictionaryWithObjectsAndKeys:
+                                   [NSNumber numberWithDouble:megabytesPerSecond], PSYBenchmarkMegabytesPerSecondKey,
+                                   [NSNumber numberWithDouble:nanosecondsPerOp],   PSYBenchmarkNanosecondsPerOpKey, nil];
+    
+    if(PSY_BENCHMARK_COUNTS_ALLOCATIONS) [result setObject:[NSNumber numberWithDouble:allocationsPerOp] forKey:PSYBenchmarkAllocationsPerOpKey];
+    
+    if([PSYBenchmarkResults objectForKey:name] == nil) [PSYBenchmarkNames addObject:name];
+    [PSYBenchmarkResults setObject:result forKey:name];
+}
+
+BOOL PSYBenchmarkWriteResults(NSString *path)
+{
+    NSProcessInfo *info    = [NSProcessInfo processInfo];
+    NSDictionary  *results = [NSDictionary dictionaryWithObjectsAndKeys:
+                              [info operatingSystemVersionString],                              @"system",
+                              [NSNumber numberWithUnsignedInteger:[info activeProcessorCount]], @"processors",
+                              PSYBenchmarkResults != nil ? PSYBenchmarkResults : [NSDictionary dictionary], @"results", nil];
+    
+    NSData *data = [NSJSONSerialization dataWithJSONObject:results options:NSJSONWritingPrettyPrinted error:NULL];
+    
+    return data != nil && [data writeToFile:path atomically:YES];
+}
+
+NSUInteger PSYBenchmarkCompareWithBaseline(NSString *path, double tolerance)
+{
+    NSData       *data     = [NSData dataWithContentsOfFile:path];
+    NSDictionary *baseline = data != nil ? [[NSJSONSerialization JSONObjectWithData:data options:0 error:NULL] objectForKey:@"results"] : nil;
+    
+    if(![baseline isKindOfClass:[NSDictionary class]])
+    {
+        fprintf(stderr, "Can't read the baseline %s\n", [path UTF8String]);
+        return NSNotFound;
+    }
+    
+    NSUInteger regressions = 0;
+    
+    printf("\n%-60s %13s %13s %9s\n", "compared to baseline", "baseline", "current", "change");
+    
+    for(NSString *name in PSYBenchmarkNames)
+    {
+        double current  = [[[PSYBenchmarkResults objectForKey:name] objectForKey:PSYBenchmarkNanosecondsPerOpKey] doubleValue];
+        double previous = [[[baseline objectForKey:name] objectForKey:PSYBenchmarkNanosecondsPerOpKey] doubleValue];
+        
+        // New benchmarks have nothing to be compared to
+        if(previous <= 0.0)
+        {
+            printf("%-60s %13s %10.2f ns %9s\n", [name UTF8String], "-", current, "new");
+            continue;
+        }
+        
+        double change    = (current - previous) / previous * 100.0;
+        BOOL   regressed = change > tolerance;
+        
+        if(regressed) regressions++;
+        
+        printf("%-60s %10.2f ns %10.2f ns %+8.1f%%%s\n", [name UTF8String], previous, current, change, regressed ? " SLOWER" : "");
+    }
+    
+    printf("%lu of %lu benchmarks slower than the baseline by more than %.1f%%\n",
+           (unsigned long)regressions, (unsigned long)[PSYBenchmarkNames count], tolerance);
+    
+    return regressions;
+}
+
+NSData *PSYBenchmarkRandomData(NSUInteger size, NSString *excluded)
+{
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 ,.;:-_=+";
+    
+    NSMutableData *data  = [NSMutableData dataWithLength:size];
+    uint8_t       *bytes = [data mutableBytes];
+    const char    *skip  = [excluded UTF8String];
+    
+    srandom(42);
+    for(NSUInteger i = 0; i < size; i++)
+    {
+        char c;
+        do c = alphabet[random() % (sizeof(alphabet) - 1)]; while(skip != NULL && strchr(skip, c) != NULL);
+        bytes[i] = (uint8_t)c;
+    }
+    
+    return data;
+}
+
+NSFileHandle *PSYBenchmarkFileHandleWithData(NSData *data)
+{
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSString stringWithFormat:@"PSYBenchmark-%d-%lu.bin", getpid(), (unsigned long)[data hash]]];
+    
+    [data writeToFile:path atomically:NO];
+    NSFileHandle *handle = [NSFileHandle fileHandleForReadingAtPath:path];
+    
+    // The handle keeps the file open, the file is gone as soon as it is closed
+    unlink([path fileSystemRepresentation]);
+    
+    return handle;
+}
+
+@implementation PSYBenchmarkNullOutputStream
+
+- (void)open                                 { status = NSStreamStatusOpen;   }
+- (void)close                                { status = NSStreamStatusClosed; }
+- (NSStreamStatus)streamStatus               { return status;                 }
+- (NSError *)streamError                     { return nil;                    }
+- (id<NSStreamDelegate>)delegate             { return delegate;               }
+- (void)setDelegate:(id<NSStreamDelegate>)value { delegate = value;           }
+- (BOOL)hasSpaceAvailable                    { return YES;                    }
+- (id)propertyForKey:(NSString *)key         { return nil;                    }
+- (BOOL)setProperty:(id)property forKey:(NSString *)key { return NO;          }
+- (void)scheduleInRunLoop:(NSRunLoop *)aRunLoop forMode:(NSString *)mode   { }
+- (void)removeFromRunLoop:(NSRunLoop *)aRunLoop forMode:(NSString *)mode   { }
+
+- (NSInteger)write:(const uint8_t *)buffer maxLength:(NSUInteger)len
+{
+    return len;
+}
+
+@end
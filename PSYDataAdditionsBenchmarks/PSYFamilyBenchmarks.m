@@ -0,0 +1,169 @@
+/*
+ PSYFamilyBenchmarks.m
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import "PSYBenchmark.h"
+#import "PSYDataScanner.h"
+#import "PSYStreamWriter.h"
+#import "NSMutableData+PSYDataWriter.h"
+#import "PSYUtilities.h"
+
+#define VALUE_COUNT (1024 * 1024)
+#define RECORD_COUNT (256 * 1024)
+#define ITERATIONS 5
+
+#define STREAM_BUFFER_CAPACITY (1024 * 1024)
+
+// Values of every length, so the varints take 1 to 10 bytes
+static inline uint64_t PSYBenchmarkMixedValue(NSUInteger index)
+{
+    return (index * 0x9E3779B97F4A7C15ULL) >> ((index & 7) * 8);
+}
+
+// Scans count values, the stream scanner reads more of its file whenever it needs to
+static void PSYBenchmarkScanValues(PSYDataScanner *scanner, NSUInteger count, BOOL (^scan)(PSYDataScanner *scanner))
+{
+    NSUInteger scanned = 0;
+    
+    while(scanned < count)
+    {
+        if(scan(scanner)) scanned++;
+        else if(![scanner needsMoreData] || [scanner readAvailableData] <= 0) break;
+    }
+}
+
+// Measures one family of values appended to a mutable data, written to a stream writer
+// and scanned from a data, a file handle and a stream file handle
+static void PSYRunFamilyBenchmark(NSString *family, NSUInteger count, PSYStreamWriter *writer,
+                                  void (^append)(NSMutableData *output, NSUInteger index),
+                                  void (^write)(PSYStreamWriter *streamWriter, NSUInteger index),
+                                  BOOL (^scan)(PSYDataScanner *scanner))
+{
+    NSMutableData *data = [NSMutableData data];
+    for(NSUInteger i = 0; i < count; i++) append(data, i);
+    
+    unsigned long long length = [data length];
+    
+    PSYBenchmarkRun([NSString stringWithFormat:@"%@ append NSMutableData", family], length, count, ITERATIONS, ^{
+        NSMutableData *output = [NSMutableData data];
+        for(NSUInteger i = 0; i < count; i++) append(output, i);
+    });
+    
+    PSYBenchmarkRun([NSString stringWithFormat:@"%@ write PSYStreamWriter", family], length, count, ITERATIONS, ^{
+        for(NSUInteger i = 0; i < count; i++) write(writer, i);
+    });
+    
+    PSYDataScanner *dataScanner = [PSYDataScanner scannerWithData:data];
+    
+    PSYBenchmarkRun([NSString stringWithFormat:@"%@ scan PSYDataDataScanner", family], length, count, ITERATIONS, ^{
+        [dataScanner setScanLocation:0];
+        PSYBenchmarkScanValues(dataScanner, count, scan);
+    });
+    
+    NSFileHandle   *handle      = PSYBenchmarkFileHandleWithData(data);
+    PSYDataScanner *fileScanner = [PSYDataScanner scannerWithFileHandle:handle];
+    
+    PSYBenchmarkRun([NSString stringWithFormat:@"%@ scan PSYFileHandleScanner", family], length, count, ITERATIONS, ^{
+        [fileScanner setScanLocation:0];
+        PSYBenchmarkScanValues(fileScanner, count, scan);
+    });
+    
+    // A stream scanner can't go back, each pass reads the file again with a new one
+    PSYBenchmarkRun([NSString stringWithFormat:@"%@ scan PSYStreamFileHandleScanner", family], length, count, ITERATIONS, ^{
+        [handle seekToFileOffset:0];
+        
+        PSYDataScanner *streamScanner = [[PSYDataScanner alloc] initWithStreamFileHandle:handle bufferCapacity:STREAM_BUFFER_CAPACITY];
+        PSYBenchmarkScanValues(streamScanner, count, scan);
+        RELEASE(streamScanner);
+    });
+}
+
+#define VALUE_FAMILY(name, type, value)                                                                                   \
+    PSYRunFamilyBenchmark(@#name, VALUE_COUNT, writer,                                                                    \
+                          ^(NSMutableData *output, NSUInteger i) { [output append ## name:(type)(value)]; },              \
+                          ^(PSYStreamWriter *streamWriter, NSUInteger i) { [streamWriter write ## name:(type)(value)]; }, \
+                          ^BOOL(PSYDataScanner *scanner) { type scanned; return [scanner scan ## name:&scanned]; })
+
+void PSYRunFamilyBenchmarks(void)
+{
+    PSYBenchmarkNullOutputStream *stream = [[PSYBenchmarkNullOutputStream alloc] init];
+    PSYStreamWriter              *writer = [[PSYStreamWriter alloc] initWithOutputStream:stream];
+    
+    // Opens the stream, the following writes go straight through the writer's buffer
+    [writer writeInt8:0];
+    
+    VALUE_FAMILY(Int8,                 uint8_t,  i);
+    VALUE_FAMILY(LittleEndianInt16,    uint16_t, i);
+    VALUE_FAMILY(BigEndianInt16,       uint16_t, i);
+    VALUE_FAMILY(LittleEndianInt32,    uint32_t, i);
+    VALUE_FAMILY(BigEndianInt32,       uint32_t, i);
+    VALUE_FAMILY(LittleEndianInt64,    uint64_t, i);
+    VALUE_FAMILY(BigEndianInt64,       uint64_t, i);
+    
+    VALUE_FAMILY(Float,                float,    i);
+    VALUE_FAMILY(Double,               double,   i);
+    VALUE_FAMILY(SwappedFloat,         float,    i);
+    VALUE_FAMILY(SwappedDouble,        double,   i);
+    
+    VALUE_FAMILY(LittleEndianVarint32,        uint32_t, PSYBenchmarkMixedValue(i));
+    VALUE_FAMILY(LittleEndianVarint64,        uint64_t, PSYBenchmarkMixedValue(i));
+    VALUE_FAMILY(BigEndianVarint32,           uint32_t, PSYBenchmarkMixedValue(i));
+    VALUE_FAMILY(BigEndianVarint64,           uint64_t, PSYBenchmarkMixedValue(i));
+    VALUE_FAMILY(LittleEndianSVarint32,       int32_t,  PSYBenchmarkMixedValue(i));
+    VALUE_FAMILY(LittleEndianSVarint64,       int64_t,  PSYBenchmarkMixedValue(i));
+    VALUE_FAMILY(LittleEndianZigZagVarint32,  int32_t,  PSYBenchmarkMixedValue(i));
+    VALUE_FAMILY(LittleEndianZigZagVarint64,  int64_t,  PSYBenchmarkMixedValue(i));
+    VALUE_FAMILY(BigEndianZigZagVarint32,     int32_t,  PSYBenchmarkMixedValue(i));
+    VALUE_FAMILY(BigEndianZigZagVarint64,     int64_t,  PSYBenchmarkMixedValue(i));
+    
+    NSString *string = @"sixteen chars ok";
+    
+    PSYRunFamilyBenchmark(@"String", RECORD_COUNT, writer,
+                          ^(NSMutableData *output, NSUInteger i) { [output appendString:string usingEncoding:NSUTF8StringEncoding]; },
+                          ^(PSYStreamWriter *streamWriter, NSUInteger i) { [streamWriter writeString:string usingEncoding:NSUTF8StringEncoding]; },
+                          ^BOOL(PSYDataScanner *scanner) { NSString *scanned; return [scanner scanString:&scanned ofLength:16 usingEncoding:NSUTF8StringEncoding]; });
+    
+    PSYRunFamilyBenchmark(@"NullTerminatedString", RECORD_COUNT, writer,
+                          ^(NSMutableData *output, NSUInteger i) { [output appendNullTerminatedString:string usingEncoding:NSUTF8StringEncoding]; },
+                          ^(PSYStreamWriter *streamWriter, NSUInteger i) { [streamWriter writeNullTerminatedString:string usingEncoding:NSUTF8StringEncoding]; },
+                          ^BOOL(PSYDataScanner *scanner) { NSString *scanned; return [scanner scanNullTerminatedString:&scanned withEncoding:NSUTF8StringEncoding]; });
+    
+    // Records of 64 bytes followed by a delimiter, the delimited search is restarted for every record
+    NSData *record         = PSYBenchmarkRandomData(64, @"\n|");
+    NSData *shortDelimiter = [@"\n" dataUsingEncoding:NSUTF8StringEncoding];
+    NSData *longDelimiter  = [[@"" stringByPaddingToLength:32 withString:@"|boundary" startingAtIndex:0] dataUsingEncoding:NSUTF8StringEncoding];
+    
+    PSYRunFamilyBenchmark(@"UpToData 1 byte delimiter", RECORD_COUNT, writer,
+                          ^(NSMutableData *output, NSUInteger i) { [output appendData:record]; [output appendData:shortDelimiter]; },
+                          ^(PSYStreamWriter *streamWriter, NSUInteger i) { [streamWriter writeData:record]; [streamWriter writeData:shortDelimiter]; },
+                          ^BOOL(PSYDataScanner *scanner) { return [scanner scanUpToData:shortDelimiter intoData:NULL options:PSYDataScannerRequireStopData | PSYDataScannerMoveAfterStopData]; });
+    
+    PSYRunFamilyBenchmark(@"UpToData 32 bytes delimiter", RECORD_COUNT, writer,
+                          ^(NSMutableData *output, NSUInteger i) { [output appendData:record]; [output appendData:longDelimiter]; },
+                          ^(PSYStreamWriter *streamWriter, NSUInteger i) { [streamWriter writeData:record]; [streamWriter writeData:longDelimiter]; },
+                          ^BOOL(PSYDataScanner *scanner) { return [scanner scanUpToData:longDelimiter intoData:NULL options:PSYDataScannerRequireStopData | PSYDataScannerMoveAfterStopData]; });
+    
+    RELEASE(writer);
+    RELEASE(stream);
+}
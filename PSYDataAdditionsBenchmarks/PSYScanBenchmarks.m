@@ -0,0 +1,116 @@
+/*
+ PSYScanBenchmarks.m
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import "PSYBenchmark.h"
+#import "PSYDataScanner.h"
+#import "PSYDataCursor.h"
+#import "NSMutableData+PSYDataWriter.h"
+
+#define VALUE_COUNT (1024 * 1024)
+#define ITERATIONS 10
+
+void PSYRunScanBenchmarks(void)
+{
+    NSData         *data    = PSYBenchmarkRandomData(VALUE_COUNT * sizeof(uint32_t), nil);
+    PSYDataScanner *scanner = [PSYDataScanner scannerWithData:data];
+    
+    __block uint32_t sum = 0;
+    
+    PSYBenchmarkRun(@"scanBigEndianInt32:", [data length], VALUE_COUNT, ITERATIONS, ^{
+        uint32_t value = 0;
+        
+        [scanner setScanLocation:0];
+        while([scanner scanBigEndianInt32:&value]) sum += value;
+    });
+    
+    PSYBenchmarkRun(@"PSYDataCursorReadBigEndianInt32", [data length], VALUE_COUNT, ITERATIONS, ^{
+        uint32_t value = 0;
+        
+        [scanner setScanLocation:0];
+        PSYDataCursor cursor = [scanner cursorWithMinimumLength:[data length]];
+        while(PSYDataCursorReadBigEndianInt32(&cursor, &value)) sum += value;
+        [scanner releaseCursor:&cursor];
+    });
+    
+    uint32_t *values = malloc(VALUE_COUNT * sizeof(*values));
+    
+    PSYBenchmarkRun(@"scanBigEndianInt32Array:count:", [data length], VALUE_COUNT, ITERATIONS, ^{
+        [scanner setScanLocation:0];
+        [scanner scanBigEndianInt32Array:values count:VALUE_COUNT];
+    });
+    
+    PSYBenchmarkRun(@"appendBigEndianInt32:", [data length], VALUE_COUNT, ITERATIONS, ^{
+        NSMutableData *output = [NSMutableData data];
+        for(NSUInteger i = 0; i < VALUE_COUNT; i++) [output appendBigEndianInt32:values[i]];
+    });
+    
+    PSYBenchmarkRun(@"appendBigEndianInt32Array:count:", [data length], VALUE_COUNT, ITERATIONS, ^{
+        NSMutableData *output = [NSMutableData data];
+        [output appendBigEndianInt32Array:values count:VALUE_COUNT];
+    });
+    
+    free(values);
+    
+    double *doubles = malloc(VALUE_COUNT / 2 * sizeof(*doubles));
+    
+    PSYBenchmarkRun(@"scanSwappedDouble:", [data length], VALUE_COUNT / 2, ITERATIONS, ^{
+        [scanner setScanLocation:0];
+        for(NSUInteger i = 0; i < VALUE_COUNT / 2; i++) [scanner scanSwappedDouble:&doubles[i]];
+    });
+    
+    PSYBenchmarkRun(@"scanSwappedDoubleArray:count:", [data length], VALUE_COUNT / 2, ITERATIONS, ^{
+        [scanner setScanLocation:0];
+        [scanner scanSwappedDoubleArray:doubles count:VALUE_COUNT / 2];
+    });
+    
+    free(doubles);
+    
+    // The same values read from a file, synchronously and with read-ahead
+    NSFileHandle   *handle      = PSYBenchmarkFileHandleWithData(data);
+    PSYDataScanner *fileScanner = [PSYDataScanner scannerWithFileHandle:handle];
+    
+    PSYBenchmarkRun(@"scanBigEndianInt32: from a file", [data length], VALUE_COUNT, ITERATIONS, ^{
+        uint32_t value = 0;
+        
+        [fileScanner setScanLocation:0];
+        while([fileScanner scanBigEndianInt32:&value]) sum += value;
+    });
+    
+    PSYDataScanner *readAheadScanner = [PSYDataScanner scannerWithFileHandle:handle readAheadWindowSize:0 depth:0];
+    
+    PSYBenchmarkRun(@"scanBigEndianInt32: from a file with read-ahead", [data length], VALUE_COUNT, ITERATIONS, ^{
+        uint32_t value = 0;
+        
+        [readAheadScanner setScanLocation:0];
+        while([readAheadScanner scanBigEndianInt32:&value]) sum += value;
+    });
+    
+    printf("%-60s %lu windows, %lu waits, %.3f ms waiting\n", "read-ahead",
+           (unsigned long)[readAheadScanner readAheadWindowCount], (unsigned long)[readAheadScanner readAheadWaitCount],
+           [readAheadScanner readAheadWaitDuration] * 1000);
+    
+    // Keeps the compiler from removing the loops
+    if(sum == 42) printf("\n");
+}
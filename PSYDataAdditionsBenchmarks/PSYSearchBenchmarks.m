@@ -0,0 +1,84 @@
+/*
+ PSYSearchBenchmarks.m
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import "PSYBenchmark.h"
+#import "PSYDataScanner.h"
+
+#define DATA_SIZE (1024 * 1024 * 64)
+#define ITERATIONS 10
+
+static void PSYRunStopDataBenchmark(NSString *label, NSData *stopData)
+{
+    // The stop data only appears at the very end so the whole data is searched
+    NSMutableData *data = [PSYBenchmarkRandomData(DATA_SIZE - [stopData length], @"\r\n|") mutableCopy];
+    [data appendData:stopData];
+    
+    PSYDataScanner *dataScanner = [PSYDataScanner scannerWithData:data];
+    PSYBenchmarkRun([NSString stringWithFormat:@"PSYDataDataScanner scanUpToData: %@", label], DATA_SIZE, 1, ITERATIONS, ^{
+        [dataScanner setScanLocation:0];
+        [dataScanner scanUpToData:stopData intoData:NULL options:PSYDataScannerRequireStopData];
+    });
+    
+    PSYDataScanner *fileScanner = [PSYDataScanner scannerWithFileHandle:PSYBenchmarkFileHandleWithData(data)];
+    PSYBenchmarkRun([NSString stringWithFormat:@"PSYFileHandleScanner scanUpToData: %@", label], DATA_SIZE, 1, ITERATIONS, ^{
+        [fileScanner setScanLocation:0];
+        [fileScanner scanUpToData:stopData intoData:NULL options:PSYDataScannerRequireStopData];
+    });
+    
+    [data release];
+}
+
+static void PSYRunNullTerminatorBenchmark(NSString *label, NSStringEncoding encoding)
+{
+    NSData        *terminator = PSYNullTerminatorDataForEncoding(encoding);
+    NSMutableData *data       = [PSYBenchmarkRandomData(DATA_SIZE - [terminator length], nil) mutableCopy];
+    [data appendData:terminator];
+    
+    PSYDataScanner *dataScanner = [PSYDataScanner scannerWithData:data];
+    PSYBenchmarkRun([NSString stringWithFormat:@"PSYDataDataScanner scanNullTerminatedString: %@", label], DATA_SIZE, 1, ITERATIONS, ^{
+        [dataScanner setScanLocation:0];
+        [dataScanner scanNullTerminatedString:NULL withEncoding:encoding];
+    });
+    
+    PSYDataScanner *fileScanner = [PSYDataScanner scannerWithFileHandle:PSYBenchmarkFileHandleWithData(data)];
+    PSYBenchmarkRun([NSString stringWithFormat:@"PSYFileHandleScanner scanNullTerminatedString: %@", label], DATA_SIZE, 1, ITERATIONS, ^{
+        [fileScanner setScanLocation:0];
+        [fileScanner scanNullTerminatedString:NULL withEncoding:encoding];
+    });
+    
+    [data release];
+}
+
+void PSYRunSearchBenchmarks(void)
+{
+    PSYRunStopDataBenchmark(@"1 byte",   [@"\n"   dataUsingEncoding:NSUTF8StringEncoding]);
+    PSYRunStopDataBenchmark(@"2 bytes",  [@"\r\n" dataUsingEncoding:NSUTF8StringEncoding]);
+    PSYRunStopDataBenchmark(@"8 bytes",  [@"|BOUND|\n" dataUsingEncoding:NSUTF8StringEncoding]);
+    PSYRunStopDataBenchmark(@"64 bytes", [[@"" stringByPaddingToLength:63 withString:@"|boundary" startingAtIndex:0] dataUsingEncoding:NSUTF8StringEncoding]);
+    
+    PSYRunNullTerminatorBenchmark(@"UTF-8",  NSUTF8StringEncoding);
+    PSYRunNullTerminatorBenchmark(@"UTF-16", NSUTF16LittleEndianStringEncoding);
+    PSYRunNullTerminatorBenchmark(@"UTF-32", NSUTF32LittleEndianStringEncoding);
+}
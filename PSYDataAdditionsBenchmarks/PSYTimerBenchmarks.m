@@ -0,0 +1,97 @@
+/*
+ PSYTimerBenchmarks.m
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import "PSYBenchmark.h"
+#import "PSYTimerWheel.h"
+#import "PSYUtilities.h"
+
+#define ENTRY_COUNT (20 * 1000)
+#define ITERATIONS 10
+
+static void PSYBenchmarkTimerDidFire(PSYTimerWheelEntry *entry, void *context)
+{
+}
+
+@interface PSYBenchmarkTimerTarget : NSObject
+- (void)timerDidFire:(NSTimer *)timer;
+@end
+
+@implementation PSYBenchmarkTimerTarget
+- (void)timerDidFire:(NSTimer *)timer { }
+@end
+
+// Timeouts of 20k expectations pending at once, as many concurrent streams would have,
+// the deadlines spread over 10 minutes and are pushed back as bytes arrive
+void PSYRunTimerBenchmarks(void)
+{
+    PSYTimerWheelEntry *entries   = calloc(ENTRY_COUNT, sizeof(PSYTimerWheelEntry));
+    NSTimeInterval     *intervals = malloc(ENTRY_COUNT * sizeof(NSTimeInterval));
+    
+    for(NSUInteger i = 0; i < ENTRY_COUNT; i++)
+    {
+        PSYTimerWheelEntryInit(&entries[i], PSYBenchmarkTimerDidFire, NULL);
+        intervals[i] = 1 + (random() % (600 * 1000)) / 1000.0;
+    }
+    
+    // What one timer per expectation costs
+    PSYBenchmarkTimerTarget *target = [[PSYBenchmarkTimerTarget alloc] init];
+    NSMutableArray          *timers = [[NSMutableArray alloc] initWithCapacity:ENTRY_COUNT];
+    
+    PSYBenchmarkRun(@"NSTimer schedule and invalidate", 0, ENTRY_COUNT, ITERATIONS, ^{
+        for(NSUInteger i = 0; i < ENTRY_COUNT; i++)
+        {
+            NSTimer *timer = [NSTimer timerWithTimeInterval:intervals[i] target:target selector:@selector(timerDidFire:) userInfo:nil repeats:NO];
+            [[NSRunLoop currentRunLoop] addTimer:timer forMode:NSDefaultRunLoopMode];
+            [timers addObject:timer];
+        }
+        
+        for(NSTimer *timer in timers) [timer invalidate];
+        [timers removeAllObjects];
+    });
+    
+    RELEASE(timers);
+    RELEASE(target);
+    
+    PSYBenchmarkRun(@"PSYTimerWheelSchedule and cancel", 0, ENTRY_COUNT, ITERATIONS, ^{
+        for(NSUInteger i = 0; i < ENTRY_COUNT; i++) PSYTimerWheelSchedule(&entries[i], intervals[i]);
+        for(NSUInteger i = 0; i < ENTRY_COUNT; i++) PSYTimerWheelCancel(&entries[i]);
+    });
+    
+    for(NSUInteger i = 0; i < ENTRY_COUNT; i++) PSYTimerWheelSchedule(&entries[i], intervals[i]);
+    
+    PSYBenchmarkRun(@"PSYTimerWheelSchedule re-arming 20k pending entries", 0, ENTRY_COUNT, ITERATIONS, ^{
+        for(NSUInteger i = 0; i < ENTRY_COUNT; i++) PSYTimerWheelSchedule(&entries[i], intervals[i]);
+    });
+    
+    // With nothing due, a tick only looks at one slot
+    PSYBenchmarkRun(@"PSYTimerWheelFireExpiredEntries with 20k pending entries", 0, 1, ITERATIONS * 1000, ^{
+        PSYTimerWheelFireExpiredEntries();
+    });
+    
+    for(NSUInteger i = 0; i < ENTRY_COUNT; i++) PSYTimerWheelCancel(&entries[i]);
+    
+    free(entries);
+    free(intervals);
+}
@@ -0,0 +1,62 @@
+/*
+ PSYVarintBenchmarks.m
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import "PSYBenchmark.h"
+#import "PSYDataScanner.h"
+#import "NSMutableData+PSYDataWriter.h"
+
+#define VALUE_COUNT (1024 * 1024)
+#define ITERATIONS 10
+
+static void PSYRunVarintBenchmark(NSString *label, uint32_t maximumValue)
+{
+    NSMutableData *data = [NSMutableData data];
+    
+    srandom(42);
+    for(NSUInteger i = 0; i < VALUE_COUNT; i++)
+        [data appendLittleEndianVarint32:(uint32_t)(random() % maximumValue) + 1];
+    
+    uint32_t       *values  = malloc(VALUE_COUNT * sizeof(*values));
+    PSYDataScanner *scanner = [PSYDataScanner scannerWithData:data];
+    
+    PSYBenchmarkRun([NSString stringWithFormat:@"scanLittleEndianVarint32: %@", label], [data length], VALUE_COUNT, ITERATIONS, ^{
+        [scanner setScanLocation:0];
+        for(NSUInteger i = 0; i < VALUE_COUNT; i++) [scanner scanLittleEndianVarint32:&values[i]];
+    });
+    
+    PSYBenchmarkRun([NSString stringWithFormat:@"scanLittleEndianVarint32Array:count: %@", label], [data length], VALUE_COUNT, ITERATIONS, ^{
+        [scanner setScanLocation:0];
+        [scanner scanLittleEndianVarint32Array:values count:VALUE_COUNT];
+    });
+    
+    free(values);
+}
+
+void PSYRunVarintBenchmarks(void)
+{
+    PSYRunVarintBenchmark(@"1 byte",     0x7f);
+    PSYRunVarintBenchmark(@"1-3 bytes",  0x1fffff);
+    PSYRunVarintBenchmark(@"1-5 bytes",  0xfffffffe);
+}
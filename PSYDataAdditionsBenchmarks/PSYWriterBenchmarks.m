@@ -0,0 +1,67 @@
+/*
+ PSYWriterBenchmarks.m
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import "PSYBenchmark.h"
+#import "PSYStreamWriter.h"
+#import "NSMutableData+PSYDataWriter.h"
+#import "PSYUtilities.h"
+
+#define VALUE_COUNT (1024 * 1024)
+#define ITERATIONS 10
+
+void PSYRunWriterBenchmarks(void)
+{
+    PSYBenchmarkNullOutputStream *stream = [[PSYBenchmarkNullOutputStream alloc] init];
+    PSYStreamWriter              *writer = [[PSYStreamWriter alloc] initWithOutputStream:stream];
+    
+    // Opens the stream, the following writes go straight through the writer's buffer
+    [writer writeInt8:0];
+    
+    // What every typed write used to do: wrap the value in a temporary data object
+    PSYBenchmarkRun(@"writeData: of a temporary NSMutableData", VALUE_COUNT * sizeof(uint32_t), VALUE_COUNT, ITERATIONS, ^{
+        for(NSUInteger i = 0; i < VALUE_COUNT; i++)
+        {
+            NSMutableData *data = [[NSMutableData alloc] initWithCapacity:sizeof(uint32_t)];
+            [data appendBigEndianInt32:(uint32_t)i];
+            [writer writeData:data];
+            RELEASE(data);
+        }
+    });
+    
+    PSYBenchmarkRun(@"writeBigEndianInt32:", VALUE_COUNT * sizeof(uint32_t), VALUE_COUNT, ITERATIONS, ^{
+        for(NSUInteger i = 0; i < VALUE_COUNT; i++) [writer writeBigEndianInt32:(uint32_t)i];
+    });
+    
+    PSYBenchmarkRun(@"writeLittleEndianVarint64:", VALUE_COUNT * 3, VALUE_COUNT, ITERATIONS, ^{
+        for(NSUInteger i = 0; i < VALUE_COUNT; i++) [writer writeLittleEndianVarint64:i];
+    });
+    
+    PSYBenchmarkRun(@"writeLittleEndianZigZagVarint32:", VALUE_COUNT * 3, VALUE_COUNT, ITERATIONS, ^{
+        for(NSUInteger i = 0; i < VALUE_COUNT; i++) [writer writeLittleEndianZigZagVarint32:-(int32_t)i];
+    });
+    
+    RELEASE(writer);
+    RELEASE(stream);
+}
@@ -0,0 +1,82 @@
+/*
+ main.m
+ Created by the PSYDataAdditions contributors on 17/10/2026.
+ 
+ Copyright (c) 2026. Remy "Psy" Demarest and contributors
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+#import "PSYBenchmark.h"
+
+// Runs every benchmark and prints its results, the arguments are read through NSUserDefaults:
+//   -filter <text>      only runs the benchmarks whose name contains text
+//   -output <path>      writes the results to path as JSON, to record a new baseline for instance
+//   -baseline <path>    compares the results to a file written by -output, the results are recorded there
+//                       instead when the file doesn't exist yet, so the first run makes the baseline
+//   -tolerance <value>  percentage of ns/op above the baseline that counts as a regression, 10 by default
+// Returns 1 when a benchmark regressed or an existing baseline can't be read
+int main(int argc, const char *argv[])
+{
+    int status = 0;
+    
+    @autoreleasepool
+    {
+        NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
+        
+        PSYBenchmarkSetFilter([defaults stringForKey:@"filter"]);
+        
+        PSYRunSearchBenchmarks();
+        PSYRunVarintBenchmarks();
+        PSYRunScanBenchmarks();
+        PSYRunWriterBenchmarks();
+        PSYRunTimerBenchmarks();
+        PSYRunFamilyBenchmarks();
+        
+        NSString *output   = [defaults stringForKey:@"output"];
+        NSString *baseline = [defaults stringForKey:@"baseline"];
+        
+        if(output != nil && !PSYBenchmarkWriteResults(output))
+        {
+            fprintf(stderr, "Can't write the results to %s\n", [output UTF8String]);
+            status = 1;
+        }
+        
+        if(baseline != nil && ![[NSFileManager defaultManager] fileExistsAtPath:baseline])
+        {
+            printf("\nNo baseline at %s, recording these results as the baseline\n", [baseline UTF8String]);
+            
+            if(!PSYBenchmarkWriteResults(baseline))
+            {
+                fprintf(stderr, "Can't write the results to %s\n", [baseline UTF8String]);
+                status = 1;
+            }
+        }
+        else if(baseline != nil)
+        {
+            double     tolerance   = [defaults objectForKey:@"tolerance"] != nil ? [defaults doubleForKey:@"tolerance"] : 10.0;
+            NSUInteger regressions = PSYBenchmarkCompareWithBaseline(baseline, tolerance);
+            
+            if(regressions != 0) status = 1;
+        }
+    }
+    
+    return status;
+}
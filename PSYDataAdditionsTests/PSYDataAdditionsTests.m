@@ -26,6 +26,30 @@
 #import "PSYDataAdditionsTests.h"
 #import "PSYDataScanner.h"
 #import "NSMutableData+PSYDataWriter.h"
+#import "PSYDataCursor.h"
+#import "PSYStreamWriter.h"
+#import "PSYStreamScanner.h"
+#import "PSYRecordLayout.h"
+#import "PSYBufferWriter.h"
+
+#include <unistd.h>
+
+static PSYStreamScannerMessage *PSYTestMessage(NSString *start, NSString *stop, NSUInteger minimumLength, NSUInteger maximumLength, void(^callback)(PSYStreamScanner *scanner))
+{
+    PSYMutableStreamScannerMessage *message = [[PSYMutableStreamScannerMessage alloc] init];
+    [message setStartData:[start dataUsingEncoding:NSUTF8StringEncoding]];
+    [message setStopData:[stop dataUsingEncoding:NSUTF8StringEncoding]];
+    [message setMinimumPartialLength:minimumLength];
+    [message setMaximumLength:maximumLength];
+    [message setCallbackBlock:callback];
+    
+    PSYStreamScannerMessage *ret = [message copy];
+#if !__has_feature(objc_arc)
+    [message release];
+    [ret autorelease];
+#endif
+    return ret;
+}
 
 @implementation PSYDataAdditionsTests
 
@@ -468,6 +492,542 @@
     STAssertEqualObjects(data, writtenData, @"The written data should be equal to the hand encoded data.");
 }
 
+- (void)testScanLittleEndianVarint32Array
+{
+    // A run of single byte varints followed by varints of every length
+    uint32_t       values[40];
+    NSMutableData *writtenData = [NSMutableData data];
+    
+    for(NSUInteger i = 0; i < 40; i++)
+    {
+        values[i] = (i < 20 ? (uint32_t)i + 1 : ((uint32_t)1 << ((i - 20) % 5 * 7)) + 1);
+        [writtenData appendLittleEndianVarint32:values[i]];
+    }
+    
+    PSYDataScanner *scanner = [PSYDataScanner scannerWithData:writtenData];
+    uint32_t        scannedValues[40] = { 0 };
+    
+    STAssertTrueNoThrow([scanner scanLittleEndianVarint32Array:scannedValues count:40], @"The scanning of an array of little endian varint 32 should succeed and not throw an exception.");
+    
+    STAssertEquals([scanner scanLocation], (unsigned long long)[writtenData length], @"The scan location should have been advanced to the end of the data.");
+    
+    STAssertTrue(memcmp(values, scannedValues, sizeof(values)) == 0, @"The scanned values should be equal to the varint encoded integers in the data.");
+}
+
+- (void)testScanLittleEndianZigZagVarint64Array
+{
+    NSMutableData *writtenData = [NSMutableData data];
+    [writtenData appendLittleEndianZigZagVarint64:-150];
+    [writtenData appendLittleEndianZigZagVarint64:150];
+    [writtenData appendLittleEndianZigZagVarint64:-1];
+    
+    PSYDataScanner *scanner = [PSYDataScanner scannerWithData:writtenData];
+    int64_t         scannedValues[3] = { 0 };
+    
+    STAssertTrueNoThrow([scanner scanLittleEndianZigZagVarint64Array:scannedValues count:3], @"The scanning of an array of little endian zig zag varint 64 should succeed and not throw an exception.");
+    
+    STAssertEquals([scanner scanLocation], (unsigned long long)[writtenData length], @"The scan location should have been advanced to the end of the data.");
+    
+    STAssertEquals(scannedValues[0], (int64_t)-150, @"The scanned value should be equal to the varint encoded integer in the data.");
+    STAssertEquals(scannedValues[1], (int64_t)150, @"The scanned value should be equal to the varint encoded integer in the data.");
+    STAssertEquals(scannedValues[2], (int64_t)-1, @"The scanned value should be equal to the varint encoded integer in the data.");
+}
+
+- (void)testScanVarintArrayTruncatedData
+{
+    NSData         *data    = [NSData dataWithBytes:(uint8_t[4]){ 0x96, 0x01, 0x05, 0x80 } length:4];
+    PSYDataScanner *scanner = [PSYDataScanner scannerWithData:data];
+    uint32_t        scannedValues[3] = { 0 };
+    
+    STAssertFalseNoThrow([scanner scanLittleEndianVarint32Array:scannedValues count:3], @"The scanning of a truncated array of varints should fail and not throw an exception.");
+    
+    STAssertEquals([scanner scanLocation], (unsigned long long)0, @"The scan location should not have changed.");
+    
+    STAssertTrueNoThrow([scanner scanLittleEndianVarint32Array:scannedValues count:2], @"The scanning of the complete varints should succeed and not throw an exception.");
+    
+    STAssertEquals([scanner scanLocation], (unsigned long long)3, @"The scan location should have been advanced by 3.");
+    
+    STAssertEquals(scannedValues[0], (uint32_t)150, @"The scanned value should be equal to the varint encoded integer in the data.");
+    STAssertEquals(scannedValues[1], (uint32_t)5, @"The scanned value should be equal to the varint encoded integer in the data.");
+}
+
+- (void)testBigEndianInt32Array
+{
+    // Enough values to go through the vector loops and their scalar tail
+    uint32_t       values[37];
+    NSMutableData *expected = [NSMutableData data];
+    
+    for(NSUInteger i = 0; i < 37; i++)
+    {
+        values[i] = 0x01020304 * (uint32_t)(i + 1);
+        [expected appendBigEndianInt32:values[i]];
+    }
+    
+    NSMutableData *writtenData = [NSMutableData dataWithBytes:(uint8_t[1]){ 0xFF } length:1];
+    [writtenData appendBigEndianInt32Array:values count:37];
+    
+    STAssertEqualObjects([writtenData subdataWithRange:NSMakeRange(1, [writtenData length] - 1)], expected, @"The appended array should be equal to the values appended one by one.");
+    
+    PSYDataScanner *scanner = [PSYDataScanner scannerWithData:writtenData];
+    uint32_t        scannedValues[38] = { 0 };
+    
+    [scanner setScanLocation:1];
+    STAssertFalseNoThrow([scanner scanBigEndianInt32Array:scannedValues count:38], @"The scanning of more values than available should fail and not throw an exception.");
+    STAssertEquals([scanner scanLocation], (unsigned long long)1, @"The scan location should not have changed.");
+    
+    STAssertTrueNoThrow([scanner scanBigEndianInt32Array:scannedValues count:37], @"The scanning of an array of big endian uint32_t should succeed and not throw an exception.");
+    STAssertTrue([scanner isAtEnd], @"The scan location should have been advanced to the end of the data.");
+    STAssertTrue(memcmp(values, scannedValues, sizeof(values)) == 0, @"The scanned values should be equal to the appended values.");
+}
+
+- (void)testSwappedDoubleArray
+{
+    double         values[5] = { 0.0, -1.5, 150000.0, 3.14159, 1e300 };
+    NSMutableData *expected  = [NSMutableData data];
+    
+    for(NSUInteger i = 0; i < 5; i++) [expected appendSwappedDouble:values[i]];
+    
+    NSMutableData *writtenData = [NSMutableData data];
+    [writtenData appendSwappedDoubleArray:values count:5];
+    
+    STAssertEqualObjects(writtenData, expected, @"The appended array should be equal to the values appended one by one.");
+    
+    PSYDataScanner *scanner = [PSYDataScanner scannerWithData:writtenData];
+    double          scannedValues[5] = { 0 };
+    
+    STAssertTrueNoThrow([scanner scanSwappedDoubleArray:scannedValues count:5], @"The scanning of an array of swapped doubles should succeed and not throw an exception.");
+    STAssertTrue(memcmp(values, scannedValues, sizeof(values)) == 0, @"The scanned values should be equal to the appended values.");
+}
+
+- (void)testDataCursor
+{
+    NSMutableData *writtenData = [NSMutableData data];
+    [writtenData appendInt8:0x42];
+    [writtenData appendBigEndianInt32:0xDEADBEEF];
+    [writtenData appendLittleEndianInt16:0xCAFE];
+    [writtenData appendSwappedDouble:150000.0];
+    [writtenData appendLittleEndianZigZagVarint32:-150];
+    
+    PSYDataScanner *scanner = [PSYDataScanner scannerWithData:writtenData];
+    [scanner setScanLocation:1];
+    
+    PSYDataCursor cursor = [scanner cursorWithMinimumLength:0];
+    STAssertEquals(PSYDataCursorRemainingLength(&cursor), (NSUInteger)[writtenData length] - 1, @"The cursor should cover the data from the scan location.");
+    
+    uint32_t value32 = 0;
+    STAssertTrue(PSYDataCursorReadBigEndianInt32(&cursor, &value32), @"The reading of big endian uint32_t should succeed.");
+    STAssertEquals(value32, (uint32_t)0xDEADBEEF, @"The read value should be equal to the written value.");
+    
+    uint16_t value16 = 0;
+    STAssertTrue(PSYDataCursorReadLittleEndianInt16(&cursor, &value16), @"The reading of little endian uint16_t should succeed.");
+    STAssertEquals(value16, (uint16_t)0xCAFE, @"The read value should be equal to the written value.");
+    
+    double valueDouble = 0;
+    STAssertTrue(PSYDataCursorReadSwappedDouble(&cursor, &valueDouble), @"The reading of a swapped double should succeed.");
+    STAssertEquals(valueDouble, 150000.0, @"The read value should be equal to the written value.");
+    
+    int32_t valueVarint = 0;
+    STAssertTrue(PSYDataCursorReadLittleEndianZigZagVarint32(&cursor, &valueVarint), @"The reading of a zig zag varint should succeed.");
+    STAssertEquals(valueVarint, (int32_t)-150, @"The read value should be equal to the written value.");
+    
+    STAssertFalse(PSYDataCursorReadInt8(&cursor, NULL), @"The reading past the end of the data should fail.");
+    
+    STAssertEquals([scanner scanLocation], (unsigned long long)1, @"The scan location should not change while the cursor is in use.");
+    [scanner releaseCursor:&cursor];
+    STAssertTrue([scanner isAtEnd], @"The scan location should be after the bytes read with the cursor.");
+}
+
+- (void)testStreamWriterTypedWrites
+{
+    NSOutputStream  *stream   = [NSOutputStream outputStreamToMemory];
+    PSYStreamWriter *writer   = [PSYStreamWriter writerWithOutputStream:stream];
+    NSMutableData   *expected = [NSMutableData data];
+    
+    // The stream is opened by the first write, the array stays pending and spans several buffer chunks
+    uint32_t values[10000];
+    for(NSUInteger i = 0; i < 10000; i++) values[i] = (uint32_t)i * 0x01010101;
+    
+    [writer writeBigEndianInt32Array:values count:10000];
+    [expected appendBigEndianInt32Array:values count:10000];
+    
+    [writer writeInt8:0x42];
+    [expected appendInt8:0x42];
+    [writer writeLittleEndianInt16:0x1234];
+    [expected appendLittleEndianInt16:0x1234];
+    [writer writeBigEndianSInt64:-5];
+    [expected appendBigEndianSInt64:-5];
+    [writer writeLittleEndianVarint32:0];
+    [expected appendLittleEndianVarint32:0];
+    [writer writeLittleEndianVarint64:UINT64_MAX];
+    [expected appendLittleEndianVarint64:UINT64_MAX];
+    [writer writeBigEndianZigZagVarint32:-150];
+    [expected appendBigEndianZigZagVarint32:-150];
+    [writer writeSwappedDouble:3.14159];
+    [expected appendSwappedDouble:3.14159];
+    
+    STAssertEqualObjects([stream propertyForKey:NSStreamDataWrittenToMemoryStreamKey], expected, @"The typed writes should write the same bytes as the NSMutableData appends.");
+}
+
+- (void)testStreamWriterLargeData
+{
+    NSOutputStream  *stream   = [NSOutputStream outputStreamToMemory];
+    PSYStreamWriter *writer   = [PSYStreamWriter writerWithOutputStream:stream];
+    NSMutableData   *blob     = [NSMutableData dataWithLength:100000];
+    NSMutableData   *expected = [NSMutableData data];
+    
+    for(NSUInteger i = 0; i < [blob length]; i++) ((uint8_t *)[blob mutableBytes])[i] = (uint8_t)(i * 7);
+    
+    [expected appendBigEndianInt32:(uint32_t)[blob length]];
+    [expected appendData:blob];
+    [expected appendBigEndianInt32:0xDEADBEEF];
+    
+    [writer writeBigEndianInt32:(uint32_t)[blob length]];
+    [writer writeData:blob];
+    
+    // The writer must have taken its own copy of the mutable data
+    memset([blob mutableBytes], 0, [blob length]);
+    
+    [writer writeBigEndianInt32:0xDEADBEEF];
+    
+    STAssertEqualObjects([stream propertyForKey:NSStreamDataWrittenToMemoryStreamKey], expected, @"The header, the data as it was when it was passed to the writer and the trailer should have been written.");
+}
+
+- (void)testScannerStatistics
+{
+    NSMutableData *data = [NSMutableData data];
+    for(uint32_t i = 0; i < 100; i++) [data appendBigEndianInt32:i];
+    
+    PSYDataScanner *scanner = [PSYDataScanner scannerWithData:data];
+    NSData         *scanned = nil;
+    uint32_t        value   = 0;
+    
+    [scanner scanBigEndianInt32:&value];
+    STAssertEquals([scanner statistics].bytesScanned, (unsigned long long)0, @"Nothing should be counted before the statistics are collected.");
+    
+    [scanner setCollectsStatistics:YES];
+    [scanner scanBigEndianInt32:&value];
+    [scanner scanData:&scanned ofLength:16];
+    [scanner setScanLocation:0];
+    
+    PSYDataScannerStatistics statistics = [scanner statistics];
+    STAssertEquals(statistics.bytesScanned, (unsigned long long)20, @"The bytes the scan location moved over should be counted, moving back should not.");
+    STAssertEquals(statistics.bytesCopied, (unsigned long long)16, @"The bytes of the scanned data should be counted as copied.");
+    STAssertEquals(statistics.readCount, (unsigned long long)0, @"A data scanner should not read anything.");
+    
+    [scanner setCollectsStatistics:NO];
+    [scanner setCollectsStatistics:YES];
+    STAssertEquals([scanner statistics].bytesScanned, (unsigned long long)0, @"Turning the statistics off should reset them.");
+}
+
+- (void)testStringInterning
+{
+    NSMutableData *data = [NSMutableData data];
+    for(NSUInteger i = 0; i < 3; i++)
+    {
+        [data appendNullTerminatedString:@"key" usingEncoding:NSUTF8StringEncoding];
+        [data appendString:@"value;" usingEncoding:NSUTF8StringEncoding];
+    }
+    [data appendString:@"k\u00E9y" usingEncoding:NSUTF16LittleEndianStringEncoding];
+    
+    PSYDataScanner *scanner = [PSYDataScanner scannerWithData:data];
+    NSString       *first   = nil;
+    NSString       *key     = nil;
+    NSString       *value   = nil;
+    
+    [scanner setCollectsStatistics:YES];
+    [scanner setStringInterningCapacity:100];
+    STAssertEquals([scanner stringInterningCapacity], (NSUInteger)128, @"The capacity should be rounded up to a power of 2.");
+    
+    for(NSUInteger i = 0; i < 3; i++)
+    {
+        STAssertTrue([scanner scanNullTerminatedString:&key withEncoding:NSUTF8StringEncoding], @"The key should be scanned.");
+        STAssertTrue([scanner scanUpToString:@";" intoString:&value usingEncoding:NSUTF8StringEncoding options:PSYDataScannerMoveAfterStopData], @"The value should be scanned.");
+        
+        if(first == nil) first = key;
+        STAssertTrue(key == first, @"The same bytes should return the same string.");
+        STAssertEqualObjects(value, @"value", @"The value should be scanned up to its stop string.");
+    }
+    
+    PSYDataScannerStatistics statistics = [scanner statistics];
+    STAssertEquals(statistics.stringMissCount, (unsigned long long)2, @"Only the first key and value should be created.");
+    STAssertEquals(statistics.stringHitCount, (unsigned long long)4, @"The following keys and values should be found in the cache.");
+    
+    // The length-supplied scan decodes with the given encoding
+    STAssertTrue([scanner scanString:&key ofLength:6 usingEncoding:NSUTF16LittleEndianStringEncoding], @"The UTF-16 string should be scanned.");
+    STAssertEqualObjects(key, @"k\u00E9y", @"The string should be decoded with its encoding.");
+    STAssertTrue([scanner isAtEnd], @"The whole data should have been scanned.");
+}
+
+- (void)testBufferWriter
+{
+    PSYBufferWriter *writer   = [PSYBufferWriter writerWithCapacity:16];
+    NSMutableData   *expected = [NSMutableData data];
+    
+    STAssertEquals([writer capacity], (NSUInteger)256, @"The capacity should be rounded to the smallest buffer of the pool.");
+    
+    for(uint32_t i = 0; i < 100; i++)
+    {
+        [writer appendBigEndianInt32:i];
+        [writer appendLittleEndianZigZagVarint64:-(int64_t)i * 1000];
+        [writer appendNullTerminatedString:@"key" usingEncoding:NSUTF8StringEncoding];
+        [expected appendBigEndianInt32:i];
+        [expected appendLittleEndianZigZagVarint64:-(int64_t)i * 1000];
+        [expected appendNullTerminatedString:@"key" usingEncoding:NSUTF8StringEncoding];
+    }
+    
+    [writer replaceBytesInRange:NSMakeRange(0, 4) withLittleEndianInt16:0xABCD];
+    [expected replaceBytesInRange:NSMakeRange(0, 4) withLittleEndianInt16:0xABCD];
+    
+    STAssertEqualObjects([writer data], expected, @"The writer should encode like NSMutableData+PSYDataWriter.");
+    STAssertFalse([writer hasOverflowed], @"A writer that grows should never overflow.");
+    
+    // Resetting keeps the buffer
+    const void *bytes = [writer bytes];
+    [writer reset];
+    [writer appendBigEndianInt32:1];
+    STAssertTrue([writer bytes] == bytes, @"The buffer should be kept across resets.");
+    STAssertEquals([writer length], (NSUInteger)4, @"The writer should only hold what was written since the reset.");
+    
+    // A writer into the memory of the caller fails instead of growing
+    uint8_t buffer[6];
+    PSYBufferWriter *fixed = [PSYBufferWriter writerWithBytesNoCopy:buffer capacity:sizeof(buffer)];
+    
+    [fixed appendBigEndianInt32:0x01020304];
+    [fixed appendBigEndianInt32:0x05060708];
+    [fixed appendInt8:9];
+    
+    STAssertTrue([fixed hasOverflowed], @"The value that doesn't fit should overflow the writer.");
+    STAssertEquals([fixed length], (NSUInteger)4, @"The values after the overflow should be dropped.");
+    STAssertTrue(memcmp(buffer, "\x01\x02\x03\x04", 4) == 0, @"The writer should write into the memory of the caller.");
+    
+    // A string the encoding can't represent is dropped like with NSMutableData, it doesn't overflow the writer
+    [fixed reset];
+    [fixed appendString:@"k\u00E9y" usingEncoding:NSASCIIStringEncoding];
+    [fixed appendString:@"key" usingEncoding:NSASCIIStringEncoding];
+    STAssertFalse([fixed hasOverflowed], @"A lossy conversion shouldn't overflow the writer.");
+    STAssertEquals([fixed length], (NSUInteger)3, @"Only the string that could be converted should be appended.");
+    
+    [fixed reset];
+    [fixed setOverflowPolicy:PSYBufferWriterOverflowGrow];
+    [fixed appendBigEndianInt64:1];
+    STAssertTrue([fixed bytes] != buffer, @"A writer made to grow should move to a buffer of the pool.");
+    STAssertEquals([fixed length], (NSUInteger)8, @"The value should have been written after growing.");
+    
+    // The buffer of a released writer goes back to the pool
+    const void *pooled = NULL;
+    @autoreleasepool
+    {
+        pooled = [[PSYBufferWriter writerWithCapacity:2000] bytes];
+    }
+    STAssertTrue([[PSYBufferWriter writerWithCapacity:2000] bytes] == pooled, @"The buffer should be reused from the pool.");
+}
+
+- (void)testLengthDelimitedSections
+{
+    NSMutableData *data = [NSMutableData data];
+    
+    [data beginLengthDelimitedSectionWithPrefix:PSYLengthPrefixVarint];
+    [data appendBigEndianInt32:1];
+    [data beginLengthDelimitedSectionWithPrefix:PSYLengthPrefixVarint];
+    [data increaseLengthBy:200];
+    [data endSection];
+    [data beginLengthDelimitedSectionWithPrefix:PSYLengthPrefixBigEndianInt16];
+    [data appendInt8:2];
+    [data endSection];
+    [data endSection];
+    [data beginLengthDelimitedSectionWithPrefix:PSYLengthPrefixPaddedVarint];
+    [data appendInt8:3];
+    [data endSection];
+    
+    // 2-byte outer varint of 209, 4, 2-byte inner varint, 200, 2, 1, then the padded varint and its byte
+    STAssertEquals([data length], (NSUInteger)(2 + 4 + 2 + 200 + 2 + 1 + 5 + 1), @"The bytes the varints didn't need should have been removed.");
+    STAssertEquals(((const uint8_t *)[data bytes])[0], (uint8_t)0xD1, @"The outer length should start with its low 7 bits.");
+    STAssertEquals(((const uint8_t *)[data bytes])[1], (uint8_t)0x01, @"The outer length should take 2 bytes.");
+    
+    PSYDataScanner *scanner = [PSYDataScanner scannerWithData:data];
+    uint32_t outer = 0, inner = 0, padded = 0, value = 0;
+    uint16_t fixed = 0;
+    
+    STAssertTrue([scanner scanLittleEndianVarint32:&outer], @"The outer length should be scanned.");
+    STAssertEquals(outer, (uint32_t)(4 + 2 + 200 + 2 + 1), @"The outer length shouldn't count the removed bytes.");
+    [scanner scanBigEndianInt32:&value];
+    STAssertTrue([scanner scanLittleEndianVarint32:&inner], @"The inner length should be scanned.");
+    STAssertEquals(inner, (uint32_t)200, @"The inner length should be back-patched.");
+    [scanner setScanLocation:[scanner scanLocation] + inner];
+    [scanner scanBigEndianInt16:&fixed];
+    STAssertEquals(fixed, (uint16_t)1, @"The fixed-width length should be back-patched.");
+    [scanner setScanLocation:[scanner scanLocation] + fixed];
+    STAssertTrue([scanner scanLittleEndianVarint32:&padded], @"The padded varint should be scanned like any varint.");
+    STAssertEquals(padded, (uint32_t)1, @"The padded varint should hold the length.");
+    STAssertEquals([scanner scanLocation], (unsigned long long)([data length] - 1), @"The padded varint should take 5 bytes.");
+    STAssertThrows([data endSection], @"Ending a section that wasn't begun should raise.");
+    
+    NSOutputStream  *stream    = [NSOutputStream outputStreamToMemory];
+    PSYStreamWriter *writer    = [PSYStreamWriter writerWithOutputStream:stream];
+    __block BOOL     completed = NO;
+    
+    [writer groupLengthDelimitedWrites:^(PSYStreamWriter *section) {
+        [section writeBigEndianInt32:1];
+        [section groupLengthDelimitedWrites:^(PSYStreamWriter *nested) {
+            [nested writeData:[NSMutableData dataWithLength:200]];
+            [nested groupLengthDelimitedWrites:^(PSYStreamWriter *group) { [group writeInt8:2]; } prefix:PSYLengthPrefixBigEndianInt16 completion:nil];
+        } prefix:PSYLengthPrefixVarint completion:^{ completed = YES; }];
+    } prefix:PSYLengthPrefixVarint completion:nil];
+    
+    // The last write flushes the group to the stream
+    [writer writeInt8:0];
+    
+    NSData *written = [stream propertyForKey:NSStreamDataWrittenToMemoryStreamKey];
+    // 2-byte outer varint of 209, 4, 2-byte nested varint of 203, 200, 2, 1, then the trailing byte
+    STAssertEquals([written length], (NSUInteger)(2 + 4 + 2 + 200 + 2 + 1 + 1), @"The writer should have written the compacted sections.");
+    STAssertEquals(((const uint8_t *)[written bytes])[0], (uint8_t)0xD1, @"The outer length should be written first.");
+    STAssertEquals(((const uint8_t *)[written bytes])[1], (uint8_t)0x01, @"The outer length should take 2 bytes.");
+    STAssertTrue(completed, @"The completion of the nested group should have been called.");
+}
+
+- (void)testStreamWriterStatistics
+{
+    NSOutputStream  *stream = [NSOutputStream outputStreamToMemory];
+    PSYStreamWriter *writer = [PSYStreamWriter writerWithOutputStream:stream];
+    NSData          *blob   = [NSData dataWithData:[NSMutableData dataWithLength:100000]];
+    
+    [writer setCollectsStatistics:YES];
+    
+    // The first write only opens the stream, the next ones write everything that's pending
+    [writer writeBigEndianInt32:(uint32_t)[blob length]];
+    [writer writeData:blob];
+    [writer groupWrites:^(PSYStreamWriter *group) { [group writeInt8:1]; } completion:nil];
+    [writer writeInt8:2];
+    
+    PSYStreamWriterStatistics statistics = [writer statistics];
+    STAssertEquals(statistics.bytesQueued, (unsigned long long)100006, @"Every byte handed to the writer and its groups should be counted.");
+    STAssertEquals(statistics.bytesCopied, (unsigned long long)6, @"The large data should be queued without being copied.");
+    STAssertEquals(statistics.bytesWritten, (unsigned long long)100006, @"Every byte should have been written to the stream.");
+    STAssertEquals(statistics.pendingBytes, (unsigned long long)0, @"Nothing should be left pending.");
+    STAssertTrue(statistics.pendingBytesHighWaterMark >= 100004, @"The header and the data should have been pending together.");
+    STAssertTrue(statistics.writeCount >= 3, @"Each buffer should have been written to the stream.");
+    STAssertTrue(statistics.queueDepthHighWaterMark >= 2, @"The group should have been queued after the buffer.");
+}
+
+- (void)testDispatchStreamWriter
+{
+    int descriptors[2];
+    STAssertEquals(pipe(descriptors), 0, @"The pipe should have been created.");
+    
+    PSYStreamWriter      *writer  = [PSYStreamWriter writerWithFileDescriptor:descriptors[1] closeOnDealloc:YES];
+    dispatch_semaphore_t  written = dispatch_semaphore_create(0);
+    
+    [writer setHighWaterMark:64 * 1024 lowWaterMark:16 * 1024];
+    
+    // Each thread writes its index one byte at a time in a group, the groups must not interleave
+    dispatch_apply(8, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t index) {
+        [writer groupWrites:^(PSYStreamWriter *group) {
+            for(NSUInteger i = 0; i < 1000; i++) [group writeInt8:(uint8_t)index];
+        } completion:^{
+            dispatch_semaphore_signal(written);
+        }];
+    });
+    
+    // Nobody reads the pipe yet, the data is pending as soon as it's queued
+    NSData *blob = [NSData dataWithData:[NSMutableData dataWithLength:256 * 1024]];
+    [writer writeData:blob];
+    STAssertFalse([writer hasSpaceAvailable], @"The pending bytes should have reached the high water mark.");
+    
+    NSMutableData *received = [NSMutableData dataWithLength:8000 + [blob length]];
+    for(NSUInteger length = 0; length < [received length];)
+    {
+        ssize_t count = read(descriptors[0], (uint8_t *)[received mutableBytes] + length, [received length] - length);
+        if(count <= 0) break;
+        length += count;
+    }
+    
+    for(NSUInteger i = 0; i < 8; i++)
+        STAssertEquals(dispatch_semaphore_wait(written, dispatch_time(DISPATCH_TIME_NOW, 5 * NSEC_PER_SEC)), 0L, @"Every group should have completed.");
+    
+    const uint8_t *bytes = [received bytes];
+    NSMutableIndexSet *indexes = [NSMutableIndexSet indexSet];
+    for(NSUInteger group = 0; group < 8; group++)
+    {
+        for(NSUInteger i = 1; i < 1000; i++)
+            STAssertEquals(bytes[group * 1000 + i], bytes[group * 1000], @"The bytes of a group should be written together.");
+        [indexes addIndex:bytes[group * 1000]];
+    }
+    STAssertEquals([indexes count], (NSUInteger)8, @"Every group should have been written once.");
+    STAssertEqualObjects([received subdataWithRange:NSMakeRange(8000, [blob length])], blob, @"The data should be written after the groups.");
+    
+    // The writer goes back under the low water mark once its queue wrote everything
+    for(NSUInteger i = 0; i < 500 && ![writer hasSpaceAvailable]; i++) usleep(10000);
+    STAssertTrue([writer hasSpaceAvailable], @"The writer should have drained below the low water mark.");
+    
+#if !__has_feature(objc_arc)
+    dispatch_release(written);
+#endif
+    close(descriptors[0]);
+}
+
+- (void)testStreamScannerMessages
+{
+    NSData           *input    = [@"noise<a>first</a>junk<b>second</b>skip<c>far too long</c><a>third</a>" dataUsingEncoding:NSUTF8StringEncoding];
+    NSInputStream    *stream   = [NSInputStream inputStreamWithData:input];
+    NSMutableArray   *received = [NSMutableArray array];
+    
+    [stream scheduleInRunLoop:[NSRunLoop currentRunLoop] forMode:NSDefaultRunLoopMode];
+    
+    PSYStreamScanner *scanner = [PSYStreamScanner scannerWithInputStream:stream closeOnDealloc:YES];
+    
+    void(^record)(PSYStreamScanner *) = ^(PSYStreamScanner *sender){
+        NSString *value = nil;
+        [sender scanString:&value ofLength:[sender dataLength] usingEncoding:NSUTF8StringEncoding];
+        [received addObject:value];
+    };
+    
+    // After <b> the next 4 bytes are expected whatever they are, then the default messages apply again
+    PSYStreamScannerMessage *next = PSYTestMessage(nil, nil, 4, 0, record);
+    
+    [scanner setDefaultMessages:[NSArray arrayWithObjects:
+                                 PSYTestMessage(@"<a>", @"</a>", 0, 0, record),
+                                 PSYTestMessage(@"<b>", @"</b>", 0, 0, ^(PSYStreamScanner *sender){ record(sender); [sender expectMessage:next]; }),
+                                 PSYTestMessage(@"<c>", @"</c>", 0, 10, record),
+                                 nil]];
+    
+    NSDate *limit = [NSDate dateWithTimeIntervalSinceNow:5];
+    while(![scanner isFinished] && [limit timeIntervalSinceNow] > 0)
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:limit];
+    
+    NSArray *expected = [NSArray arrayWithObjects:@"<a>first</a>", @"<b>second</b>", @"skip", @"<a>third</a>", nil];
+    
+    STAssertEqualObjects(received, expected, @"The messages should be delivered in order, the message longer than its maximum length should be skipped.");
+}
+
+- (void)testStreamScannerTimeout
+{
+    NSInputStream    *stream   = [NSInputStream inputStreamWithData:[@"<a>never stopped" dataUsingEncoding:NSUTF8StringEncoding]];
+    PSYStreamScanner *scanner  = [PSYStreamScanner scannerWithInputStream:stream closeOnDealloc:YES];
+    __block BOOL      matched  = NO;
+    __block BOOL      timedOut = NO;
+    
+    [stream scheduleInRunLoop:[NSRunLoop currentRunLoop] forMode:NSDefaultRunLoopMode];
+    
+    PSYMutableStreamScannerMessage *message = [[PSYMutableStreamScannerMessage alloc] init];
+    [message setStartData:[@"<a>" dataUsingEncoding:NSUTF8StringEncoding]];
+    [message setStopData:[@"</a>" dataUsingEncoding:NSUTF8StringEncoding]];
+    [message setPartialTimeoutInterval:0.05];
+    [message setCallbackBlock:^(PSYStreamScanner *sender){ matched = YES; }];
+    [message setTimeoutBlock:^(PSYStreamScanner *sender){ timedOut = YES; }];
+    
+    [scanner expectMessage:message];
+#if !__has_feature(objc_arc)
+    [message release];
+#endif
+    
+    NSDate *limit = [NSDate dateWithTimeIntervalSinceNow:5];
+    while(!timedOut && [limit timeIntervalSinceNow] > 0)
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:limit];
+    
+    STAssertTrue(timedOut, @"The partial timeout should expire when the stop data never arrives.");
+    STAssertFalse(matched, @"The message should not be delivered once timed out.");
+}
+
 - (void)testScanFloatEmptyData
 {
     NSData         *data    = [NSData data];
@@ -778,4 +1338,147 @@
     STAssertEqualObjects(read, expected, @"The scanned data should be equal to the data before the searched data.");
 }
 
+- (void)testEnumerateRecords
+{
+    NSData          *separator = [NSData dataWithBytes:"\r\n" length:2];
+    NSMutableData   *data      = [NSMutableData data];
+    NSMutableArray  *expected  = [NSMutableArray array];
+    
+    // Long enough to be split in several ranges, some of them start in the middle of a separator
+    for(NSUInteger i = 0; i < 100000; i++)
+    {
+        NSData *record = [[NSString stringWithFormat:@"record %lu", (unsigned long)i] dataUsingEncoding:NSUTF8StringEncoding];
+        
+        [expected addObject:record];
+        [data appendData:record];
+        [data appendData:separator];
+    }
+    
+    PSYDataScanner *scanner  = [PSYDataScanner scannerWithData:data];
+    NSMutableArray *records  = [NSMutableArray array];
+    __block BOOL    located  = YES;
+    
+    [scanner enumerateRecordsSeparatedByData:separator options:PSYDataScannerEnumerationConcurrent | PSYDataScannerEnumerationPreservingOrder usingBlock:^(NSData *record, unsigned long long loc, BOOL *stop) {
+        located = located && [[data subdataWithRange:NSMakeRange(loc, [record length])] isEqualToData:record];
+        [records addObject:record];
+    }];
+    
+    STAssertEqualObjects(records, expected, @"The records should be enumerated in order without their separator.");
+    STAssertTrue(located, @"The location of the records should be their location in the data.");
+    STAssertEquals([scanner scanLocation], (unsigned long long)0, @"The scan location should not have changed.");
+    
+    NSMutableSet *recordSet = [NSMutableSet set];
+    
+    [scanner enumerateRecordsSeparatedByData:separator options:PSYDataScannerEnumerationConcurrent usingBlock:^(NSData *record, unsigned long long loc, BOOL *stop) {
+        @synchronized(recordSet) { [recordSet addObject:record]; }
+    }];
+    
+    STAssertEqualObjects(recordSet, [NSSet setWithArray:expected], @"All the records should be enumerated concurrently.");
+    
+    // Empty records are enumerated except after the last separator
+    scanner = [PSYDataScanner scannerWithData:[NSData dataWithBytes:"a\r\n\r\nb\r\n" length:9]];
+    [records removeAllObjects];
+    
+    [scanner enumerateRecordsSeparatedByData:separator options:0 usingBlock:^(NSData *record, unsigned long long loc, BOOL *stop) {
+        [records addObject:record];
+    }];
+    
+    NSArray *shortRecords = [NSArray arrayWithObjects:[NSData dataWithBytes:"a" length:1], [NSData data], [NSData dataWithBytes:"b" length:1], nil];
+    STAssertEqualObjects(records, shortRecords, @"The empty record between two separators should be enumerated.");
+}
+
+- (void)testRecordLayout
+{
+    typedef struct
+    {
+        uint32_t  identifier;
+        uint16_t  flags;
+        int64_t   delta;
+        double    score;
+        NSString *name;
+        NSData   *payload;
+    } TestRecord;
+    
+    PSYRecordField fields[] = {
+        PSYMakeRecordField(PSYRecordFieldBigEndianInt32, offsetof(TestRecord, identifier)),
+        PSYMakeRecordField(PSYRecordFieldLittleEndianInt16, offsetof(TestRecord, flags)),
+        PSYMakeRecordField(PSYRecordFieldBigEndianZigZagVarint64, offsetof(TestRecord, delta)),
+        PSYMakeRecordField(PSYRecordFieldSwappedDouble, offsetof(TestRecord, score)),
+        PSYMakeRecordStringField(PSYRecordFieldLittleEndianVarint32, NSUTF8StringEncoding, offsetof(TestRecord, name)),
+        PSYMakeRecordDataField(PSYRecordFieldBigEndianInt16, offsetof(TestRecord, payload)),
+    };
+    
+    PSYRecordLayout *layout = [PSYRecordLayout layoutWithFields:fields count:sizeof(fields) / sizeof(*fields) recordSize:sizeof(TestRecord)];
+    STAssertEquals([layout fixedLength], (NSUInteger)6, @"The fixed-width prefix should stop at the first varint.");
+    STAssertFalse([layout hasFixedLength], @"A layout with varints and strings should not have a fixed length.");
+    
+    TestRecord records[2] = {
+        { 0xDEADBEEF, 0x0102, -300, 1.5, @"h\u00E9llo", [NSData dataWithBytes:"\x01\x02\x03" length:3] },
+        { 7, 0, 1LL << 40, -0.25, @"", nil },
+    };
+    
+    NSMutableData *data = [NSMutableData data];
+    [data appendRecords:records count:2 withLayout:layout];
+    
+    // The same records written field by field
+    NSMutableData *expected = [NSMutableData data];
+    for(NSUInteger i = 0; i < 2; i++)
+    {
+        NSData *name = [records[i].name dataUsingEncoding:NSUTF8StringEncoding];
+        
+        [expected appendBigEndianInt32:records[i].identifier];
+        [expected appendLittleEndianInt16:records[i].flags];
+        [expected appendBigEndianZigZagVarint64:records[i].delta];
+        [expected appendSwappedDouble:records[i].score];
+        [expected appendLittleEndianVarint32:(uint32_t)[name length]];
+        [expected appendData:name];
+        [expected appendBigEndianInt16:(uint16_t)[records[i].payload length]];
+        if(records[i].payload != nil) [expected appendData:records[i].payload];
+    }
+    
+    STAssertEqualObjects(data, expected, @"The records should be encoded like their fields written one after the other.");
+    
+    TestRecord      decoded[2] = { { 0 } };
+    PSYDataScanner *scanner    = [PSYDataScanner scannerWithData:data];
+    
+    STAssertTrue([scanner scanRecords:decoded count:2 withLayout:layout], @"The records should be scanned back.");
+    STAssertTrue([scanner isAtEnd], @"The records should have been scanned entirely.");
+    STAssertEquals(decoded[0].identifier, records[0].identifier, @"Big endian fields should be decoded.");
+    STAssertEquals(decoded[0].flags, records[0].flags, @"Little endian fields should be decoded.");
+    STAssertEquals(decoded[0].delta, records[0].delta, @"Zigzag varints should be decoded.");
+    STAssertEquals(decoded[1].delta, records[1].delta, @"Zigzag varints should be decoded.");
+    STAssertEquals(decoded[1].score, records[1].score, @"Swapped doubles should be decoded.");
+    STAssertEqualObjects(decoded[0].name, records[0].name, @"Strings should be decoded.");
+    STAssertEqualObjects(decoded[0].payload, records[0].payload, @"Data should be decoded.");
+    STAssertEqualObjects(decoded[1].payload, [NSData data], @"A nil data should be encoded empty.");
+    
+    // A truncated record fails without moving the scan location
+    scanner = [PSYDataScanner scannerWithData:[data subdataWithRange:NSMakeRange(0, [data length] - 3)]];
+    STAssertTrue([scanner scanRecord:decoded withLayout:layout], @"The first record should be complete.");
+    
+    unsigned long long loc = [scanner scanLocation];
+    STAssertFalse([scanner scanRecord:decoded withLayout:layout], @"The truncated record should not be scanned.");
+    STAssertEquals([scanner scanLocation], loc, @"A failed scan should not move the scan location.");
+    
+    // Contiguous fields in the host byte order are copied at once
+    typedef struct { uint32_t a; uint32_t b; float c; } FixedRecord;
+    PSYRecordField fixedFields[] = {
+        PSYMakeRecordField(PSYRecordFieldLittleEndianInt32, offsetof(FixedRecord, a)),
+        PSYMakeRecordField(PSYRecordFieldLittleEndianInt32, offsetof(FixedRecord, b)),
+        PSYMakeRecordField(PSYRecordFieldFloat, offsetof(FixedRecord, c)),
+    };
+    
+    PSYRecordLayout *fixedLayout = [PSYRecordLayout layoutWithFields:fixedFields count:3 recordSize:sizeof(FixedRecord)];
+    FixedRecord      fixed[3]    = { { 1, 2, 3.0f }, { 4, 5, 6.0f }, { 7, 8, 9.0f } };
+    FixedRecord      fixedOut[3] = { { 0 } };
+    
+    [data setLength:0];
+    [data appendRecords:fixed count:3 withLayout:fixedLayout];
+    STAssertEquals([data length], (NSUInteger)36, @"Fixed records should take their fixed length.");
+    
+    scanner = [PSYDataScanner scannerWithData:data];
+    STAssertTrue([scanner scanRecords:fixedOut count:3 withLayout:fixedLayout], @"Fixed records should be scanned back.");
+    STAssertTrue(memcmp(fixed, fixedOut, sizeof(fixed)) == 0, @"Fixed records should round trip.");
+}
+
 @end
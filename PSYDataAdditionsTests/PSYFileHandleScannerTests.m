@@ -25,6 +25,11 @@
 
 #import "PSYFileHandleScannerTests.h"
 #import "PSYDataScanner.h"
+#import "NSMutableData+PSYDataWriter.h"
+#import "PSYDataCursor.h"
+#import "PSYStreamWriter.h"
+
+#include <unistd.h>
 
 @interface PSYDataFileHandle : NSFileHandle
 - (id)initWithData:(NSData *)data;
@@ -107,6 +112,570 @@ static char testData[] = {
     STAssertEqualObjects(scan11, @"this is a sentence in the middle", @"The scanned value should be equal to the next bytes until the null terminator.");
 }
 
+- (void)testScanAlignedNullTerminator;
+{
+    // 0x00 0x00 at offset 1 straddles two UTF-16 characters and is not a terminator
+    static char utf16[] = { 'h', 0x00, 0x00, 0x01, 0x00, 0x00, 'x', 0x00 };
+    NSData *data = [NSData dataWithBytes:utf16 length:sizeof(utf16)];
+
+    NSArray *scanners = [NSArray arrayWithObjects:
+                         [PSYDataScanner scannerWithData:data],
+                         [PSYDataScanner scannerWithFileHandle:[[[PSYDataFileHandle alloc] initWithData:data maximumReadSize:3] autorelease]],
+                         nil];
+
+    for(PSYDataScanner *scanner in scanners)
+    {
+        NSString *scan1 = nil;
+        STAssertTrueNoThrow([scanner scanNullTerminatedString:&scan1 withEncoding:NSUTF16LittleEndianStringEncoding], @"The scanning of null-terminated string should succeed and not throw an exception");
+        STAssertEquals([scanner scanLocation], (unsigned long long)6, @"The scan location should have been advanced right after the aligned null terminator.");
+        STAssertEqualObjects(scan1, ([NSString stringWithFormat:@"h%C", (unichar)0x0100]), @"The scanned value should stop at the aligned null terminator.");
+
+        NSString *scan2 = nil;
+        STAssertFalseNoThrow([scanner scanNullTerminatedString:&scan2 withEncoding:NSUTF16LittleEndianStringEncoding], @"The scanning of an unterminated string should fail and not throw an exception");
+        STAssertEquals([scanner scanLocation], (unsigned long long)6, @"The scan location should not move when the terminator is missing.");
+
+        NSData *scan3 = nil;
+        [scanner setScanLocation:0];
+        STAssertTrueNoThrow([scanner scanUpToData:[NSData dataWithBytes:(char[]){ 0x00, 0x00, 'x' } length:3] intoData:&scan3], @"The scanning of data up to a specific data should succeed and not throw an exception");
+        STAssertEquals([scanner scanLocation], (unsigned long long)4, @"The scan location should have been advanced before the stop data.");
+    }
+}
+
+- (void)testScanVarintArray;
+{
+    uint64_t       values[64];
+    NSMutableData *data = [NSMutableData data];
+    
+    for(NSUInteger i = 0; i < 64; i++)
+    {
+        values[i] = ((uint64_t)1 << (i % 10 * 7)) + i;
+        [data appendLittleEndianVarint64:values[i]];
+    }
+    
+    // The file handle returns 3 bytes at a time so most varints straddle two reads
+    NSFileHandle   *handle  = [[[PSYDataFileHandle alloc] initWithData:data maximumReadSize:3] autorelease];
+    PSYDataScanner *scanner = [PSYDataScanner scannerWithFileHandle:handle];
+    
+    uint64_t scannedValues[65] = { 0 };
+    STAssertFalseNoThrow([scanner scanLittleEndianVarint64Array:scannedValues count:65], @"The scanning of more varints than available should fail and not throw an exception");
+    STAssertEquals([scanner scanLocation], (unsigned long long)0, @"The scan location should not have changed.");
+    
+    STAssertTrueNoThrow([scanner scanLittleEndianVarint64Array:scannedValues count:64], @"The scanning of an array of varints should succeed and not throw an exception");
+    STAssertEquals([scanner scanLocation], (unsigned long long)[data length], @"The scan location should have been advanced to the end of the file.");
+    STAssertTrue(memcmp(values, scannedValues, sizeof(values)) == 0, @"The scanned values should be equal to the varint encoded integers in the file.");
+}
+
+- (void)testScanArray;
+{
+    NSData         *data    = [NSData dataWithBytes:testData length:sizeof(testData)];
+    NSFileHandle   *handle  = [[[PSYDataFileHandle alloc] initWithData:data maximumReadSize:3] autorelease];
+    PSYDataScanner *scanner = [PSYDataScanner scannerWithFileHandle:handle];
+    
+    [scanner setScanLocation:1];
+    
+    // The elements straddle the 3 bytes reads of the file handle
+    uint16_t scan1[10] = { 0 };
+    STAssertTrueNoThrow([scanner scanBigEndianInt16Array:scan1 count:10], @"The scanning of an array of big endian uint16_t should succeed and not throw an exception");
+    STAssertEquals([scanner scanLocation], (unsigned long long)21, @"The scan location should have been advanced by 20.");
+    STAssertEquals(scan1[0], (uint16_t)0x0022, @"The scanned values should be equal to the bytes in the file.");
+    STAssertEquals(scan1[9], (uint16_t)0xEEFF, @"The scanned values should be equal to the bytes in the file.");
+}
+
+- (void)testDataCursor;
+{
+    NSData         *data    = [NSData dataWithBytes:testData length:sizeof(testData)];
+    NSFileHandle   *handle  = [[[PSYDataFileHandle alloc] initWithData:data maximumReadSize:3] autorelease];
+    PSYDataScanner *scanner = [PSYDataScanner scannerWithFileHandle:handle];
+    
+    [scanner setScanLocation:3];
+    
+    PSYDataCursor cursor = [scanner cursorWithMinimumLength:12];
+    STAssertTrue(PSYDataCursorRemainingLength(&cursor) >= 12, @"The cursor should cover at least the requested length.");
+    
+    uint32_t scan1 = 0;
+    STAssertTrue(PSYDataCursorReadBigEndianInt32(&cursor, &scan1), @"The reading of big endian uint32_t should succeed.");
+    STAssertEquals(scan1, (uint32_t)0x33445566, @"The read value should be equal to the next 4 bytes in the file.");
+    
+    uint64_t scan2 = 0;
+    STAssertTrue(PSYDataCursorReadBigEndianInt64(&cursor, &scan2), @"The reading of big endian uint64_t should succeed.");
+    STAssertEquals(scan2, (uint64_t)0x778899aabbccddee, @"The read value should be equal to the next 8 bytes in the file.");
+    
+    [scanner releaseCursor:&cursor];
+    STAssertEquals([scanner scanLocation], (unsigned long long)15, @"The scan location should be after the bytes read with the cursor.");
+    
+    uint32_t scan3 = 0;
+    STAssertTrueNoThrow([scanner scanBigEndianInt32:&scan3], @"The scanning after releasing the cursor should succeed and not throw an exception");
+    STAssertEquals(scan3, (uint32_t)0xffbbccdd, @"The scanned value should be equal to the next 4 bytes in the file.");
+}
+
+- (void)testScanReadAhead;
+{
+    NSString      *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"PSYReadAheadScannerTests.bin"];
+    NSMutableData *data = [NSMutableData data];
+    
+    for(uint32_t i = 0; i < 10000; i++) [data appendBigEndianInt32:i];
+    [data writeToFile:path atomically:NO];
+    
+    // The values straddle most of the windows
+    NSFileHandle   *handle  = [NSFileHandle fileHandleForReadingAtPath:path];
+    PSYDataScanner *scanner = [PSYDataScanner scannerWithFileHandle:handle readAheadWindowSize:1002 depth:3];
+    
+    uint32_t scan1 = 0;
+    BOOL     equal = YES;
+    for(uint32_t i = 0; i < 5000; i++) equal = equal && [scanner scanBigEndianInt32:&scan1] && scan1 == i;
+    
+    STAssertTrue(equal, @"The scanned values should be equal to the values in the file.");
+    STAssertEquals([scanner readAheadWindowCount], (NSUInteger)20, @"The scanner should have gone through the windows covering the scanned values.");
+    
+    NSData *scan2 = nil;
+    STAssertTrueNoThrow([scanner scanData:&scan2 ofLength:12000], @"The scanning of data over several windows should succeed and not throw an exception");
+    STAssertEqualObjects(scan2, [data subdataWithRange:NSMakeRange(20000, 12000)], @"The scanned data should be equal to the bytes in the file.");
+    
+    // Going back restarts the reads from the new location
+    [scanner setScanLocation:400];
+    STAssertTrueNoThrow([scanner scanBigEndianInt32:&scan1], @"The scanning after moving back should succeed and not throw an exception");
+    STAssertEquals(scan1, (uint32_t)100, @"The scanned value should be equal to the value at the new location.");
+    
+    STAssertTrueNoThrow([scanner setScanLocation:-4 relativeTo:PSYDataScannerLocationEnd], @"The scan location should be settable to the last value.");
+    STAssertTrueNoThrow([scanner scanBigEndianInt32:&scan1], @"The scanning of the last value should succeed and not throw an exception");
+    STAssertEquals(scan1, (uint32_t)9999, @"The scanned value should be equal to the last value in the file.");
+    STAssertTrue([scanner isAtEnd], @"The scanner should be at the end of the file.");
+    
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
+- (void)testScanBlockCache;
+{
+    NSString      *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"PSYBlockCacheScannerTests.bin"];
+    NSMutableData *data = [NSMutableData data];
+    
+    for(uint32_t i = 0; i < 10000; i++) [data appendBigEndianInt32:i];
+    [data writeToFile:path atomically:NO];
+    
+    // Room for 4 blocks of 1000 bytes
+    NSFileHandle   *handle  = [NSFileHandle fileHandleForReadingAtPath:path];
+    PSYDataScanner *scanner = [PSYDataScanner scannerWithFileHandle:handle blockSize:1000 memoryBudget:4000];
+    
+    uint32_t scan1 = 0;
+    BOOL     equal = YES;
+    for(uint32_t i = 0; i < 500; i++) equal = equal && [scanner scanBigEndianInt32:&scan1] && scan1 == i;
+    
+    STAssertTrue(equal, @"The scanned values should be equal to the values in the file.");
+    STAssertEquals([scanner blockCacheMissCount], (NSUInteger)2, @"The scanner should have read the blocks covering the scanned values.");
+    STAssertEquals([scanner blockCacheHitCount], (NSUInteger)0, @"The scanner should not have found any block in the cache yet.");
+    
+    // Going back to a block still in the cache doesn't read it again
+    [scanner setScanLocation:400];
+    STAssertTrueNoThrow([scanner scanBigEndianInt32:&scan1], @"The scanning after moving back should succeed and not throw an exception");
+    STAssertEquals(scan1, (uint32_t)100, @"The scanned value should be equal to the value at the new location.");
+    STAssertEquals([scanner blockCacheHitCount], (NSUInteger)1, @"The block should have been found in the cache.");
+    
+    NSData *scan2 = nil;
+    [scanner setScanLocation:996];
+    STAssertTrueNoThrow([scanner scanData:&scan2 ofLength:8], @"The scanning of data straddling two blocks should succeed and not throw an exception");
+    STAssertEqualObjects(scan2, [data subdataWithRange:NSMakeRange(996, 8)], @"The scanned data should be equal to the bytes in the file.");
+    STAssertEquals([scanner blockCacheHitCount], (NSUInteger)2, @"The following block should have been found in the cache.");
+    
+    STAssertTrueNoThrow([scanner setScanLocation:-4 relativeTo:PSYDataScannerLocationEnd], @"The scan location should be settable to the last value.");
+    STAssertTrueNoThrow([scanner scanBigEndianInt32:&scan1], @"The scanning of the last value should succeed and not throw an exception");
+    STAssertEquals(scan1, (uint32_t)9999, @"The scanned value should be equal to the last value in the file.");
+    STAssertTrue([scanner isAtEnd], @"The scanner should be at the end of the file.");
+    STAssertEquals([scanner blockCacheMissCount], (NSUInteger)3, @"The last block should have been read.");
+    
+    // Blocks 0, 1, 39 and 5 fill the cache, using block 1 again leaves block 0 as the least recently used
+    [scanner setScanLocation:5000];
+    [scanner scanBigEndianInt32:&scan1];
+    [scanner setScanLocation:1000];
+    [scanner scanBigEndianInt32:&scan1];
+    STAssertEquals(scan1, (uint32_t)250, @"The scanned value should be equal to the value at the new location.");
+    STAssertEquals([scanner blockCacheHitCount], (NSUInteger)3, @"The block should have been found in the cache.");
+    
+    [scanner setScanLocation:7000];
+    [scanner scanBigEndianInt32:&scan1];
+    [scanner setScanLocation:0];
+    [scanner scanBigEndianInt32:&scan1];
+    STAssertEquals(scan1, (uint32_t)0, @"The scanned value should be equal to the first value in the file.");
+    STAssertEquals([scanner blockCacheMissCount], (NSUInteger)6, @"The first block should have been evicted and read again.");
+    
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
+- (void)testScanStatistics;
+{
+    NSString      *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"PSYScannerStatisticsTests.bin"];
+    NSMutableData *data = [NSMutableData data];
+    
+    for(uint32_t i = 0; i < 10000; i++) [data appendBigEndianInt32:i];
+    [data writeToFile:path atomically:NO];
+    
+    NSFileHandle   *handle  = [NSFileHandle fileHandleForReadingAtPath:path];
+    PSYDataScanner *scanner = [PSYDataScanner scannerWithFileHandle:handle blockSize:1000 memoryBudget:4000];
+    
+    [scanner setCollectsStatistics:YES];
+    
+    uint32_t scan1 = 0;
+    for(uint32_t i = 0; i < 500; i++) [scanner scanBigEndianInt32:&scan1];
+    
+    [scanner setScanLocation:400];
+    [scanner scanBigEndianInt32:&scan1];
+    
+    PSYDataScannerStatistics statistics = [scanner statistics];
+    STAssertEquals(statistics.bytesScanned, (unsigned long long)2004, @"The bytes of the scanned values should be counted.");
+    STAssertEquals(statistics.bytesRead, (unsigned long long)2000, @"The two blocks should have been read once.");
+    STAssertEquals(statistics.cacheMissCount, (unsigned long long)2, @"The two blocks should have been read from the file.");
+    STAssertEquals(statistics.cacheHitCount, (unsigned long long)1, @"The first block should have been found in the cache the second time.");
+    STAssertEquals(statistics.refillCount, (unsigned long long)3, @"The scanner should have refilled its cache for each block.");
+    STAssertTrue(statistics.readCount >= 2, @"At least one read per block should have been counted.");
+    
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
+- (void)testChecksum;
+{
+    STAssertEquals(PSYCRC32CUpdate(0, "123456789", 9), (uint32_t)0xE3069283, @"The CRC-32C check value should match.");
+    STAssertEquals(PSYCRC32CUpdate(PSYCRC32CUpdate(0, "1234", 4), "56789", 5), (uint32_t)0xE3069283, @"Chained updates should match a single one.");
+    
+    NSOutputStream  *stream = [NSOutputStream outputStreamToMemory];
+    PSYStreamWriter *writer = [PSYStreamWriter writerWithOutputStream:stream];
+    NSMutableData   *blob   = [NSMutableData data];
+    
+    for(uint32_t i = 0; i < 50000; i++) [blob appendBigEndianInt32:i];
+    
+    [writer setChecksumAlgorithm:PSYChecksumCRC32C];
+    [writer writeBigEndianInt32:(uint32_t)[blob length]];
+    [writer writeData:[NSData dataWithData:blob]];
+    [writer groupWrites:^(PSYStreamWriter *group) { [group writeNullTerminatedString:@"end" usingEncoding:NSUTF8StringEncoding]; } completion:nil];
+    
+    // The last write flushes the group to the stream
+    [writer writeInt8:0];
+    
+    NSData *written = [stream propertyForKey:NSStreamDataWrittenToMemoryStreamKey];
+    STAssertEquals([writer checksum], PSYCRC32CUpdate(0, [written bytes], [written length]), @"The writer should have checksummed every byte it was handed.");
+    
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"PSYScannerChecksumTests.bin"];
+    [written writeToFile:path atomically:NO];
+    
+    PSYDataScanner *scanner = [PSYDataScanner scannerWithFileHandle:[NSFileHandle fileHandleForReadingAtPath:path] blockSize:1000 memoryBudget:4000];
+    [scanner setChecksumAlgorithm:PSYChecksumCRC32C];
+    
+    uint32_t length = 0;
+    [scanner scanBigEndianInt32:&length];
+    STAssertEquals([scanner checksum], PSYCRC32CUpdate(0, [written bytes], 4), @"The checksum should cover the scanned header.");
+    
+    // The frame is skipped past the cache, then a failed search goes through the end of the file and rolls back
+    [scanner resetChecksum];
+    [scanner setScanLocation:4 + length];
+    
+    uint32_t skipped = [scanner checksum];
+    STAssertFalse([scanner scanUpToData:[NSData dataWithBytes:"missing" length:7] intoData:NULL options:PSYDataScannerRequireStopData], @"The stop data shouldn't have been found.");
+    STAssertEquals([scanner checksum], skipped, @"A failed scan shouldn't add the searched bytes to the checksum.");
+    
+    NSString *end = nil;
+    STAssertTrue([scanner scanNullTerminatedString:&end withEncoding:NSUTF8StringEncoding], @"The string should have been scanned.");
+    STAssertEqualObjects(end, @"end", @"The string should follow the frame.");
+    
+    uint8_t last = 1;
+    [scanner scanInt8:&last];
+    STAssertEquals([scanner checksum], PSYCRC32CUpdate(0, (const uint8_t *)[written bytes] + 4, [written length] - 4), @"Skipped bytes should be checksummed once.");
+    
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
+- (void)testScanBytesNoCopy;
+{
+    NSData         *data    = [NSData dataWithBytes:testData length:sizeof(testData)];
+    NSFileHandle   *handle  = [[[PSYDataFileHandle alloc] initWithData:data maximumReadSize:3] autorelease];
+    PSYDataScanner *scanner = [PSYDataScanner scannerWithFileHandle:handle];
+    
+    const void *bytes  = NULL;
+    NSUInteger  length = 0;
+    
+    STAssertTrue([scanner scanBytesNoCopy:&bytes length:21], @"The scanning of borrowed bytes should succeed.");
+    STAssertTrue(memcmp(bytes, testData, 21) == 0, @"The borrowed bytes should be the bytes of the file.");
+    STAssertEquals([scanner scanLocation], (unsigned long long)21, @"The scan location should have been advanced by 21.");
+    
+    STAssertTrue([scanner scanUpToDataNoCopy:[NSData dataWithBytes:"\0" length:1] bytes:&bytes length:&length options:PSYDataScannerMoveAfterStopData], @"The scanning up to the null byte should succeed.");
+    STAssertEquals(length, (NSUInteger)32, @"The borrowed bytes should stop before the null byte.");
+    STAssertTrue(memcmp(bytes, "this is a sentence in the middle", 32) == 0, @"The borrowed bytes should be the sentence.");
+    STAssertEquals([scanner scanLocation], (unsigned long long)54, @"The scan location should be after the null byte.");
+    
+    STAssertFalse([scanner scanBytesNoCopy:&bytes length:100], @"The scanning of borrowed bytes past the end should fail.");
+    STAssertEquals([scanner scanLocation], (unsigned long long)54, @"A failed scan should not move the scan location.");
+    
+    STAssertTrue([scanner scanBytesNoCopy:&bytes length:sizeof(testData) - 54], @"The rest of the file should be borrowed.");
+    STAssertTrue(memcmp(bytes, testData + 54, sizeof(testData) - 54) == 0, @"The bytes up to the end of the cache should still be valid.");
+    STAssertTrue([scanner isAtEnd], @"The whole file should have been scanned.");
+}
+
+- (void)testScanClones;
+{
+    NSString      *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"PSYClonedScannerTests.bin"];
+    NSMutableData *data = [NSMutableData data];
+    
+    for(uint32_t i = 0; i < 40000; i++) [data appendBigEndianInt32:i];
+    [data writeToFile:path atomically:NO];
+    
+    NSFileHandle   *handle  = [NSFileHandle fileHandleForReadingAtPath:path];
+    PSYDataScanner *scanner = [PSYDataScanner scannerWithFileHandle:handle blockSize:4000 memoryBudget:0];
+    
+    uint32_t scan1 = 0;
+    STAssertTrueNoThrow([scanner scanBigEndianInt32:&scan1], @"The scanning of big endian uint32_t should succeed and not throw an exception");
+    
+    // Each clone scans a quarter of the file on its own thread, the quarters are made of whole blocks
+    BOOL  equal[4] = { NO, NO, NO, NO };
+    BOOL *results  = equal;
+    
+    dispatch_apply(4, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t index) {
+        PSYDataScanner *clone = [scanner scannerByCloningAtLocation:index * 40000];
+        uint32_t        value = 0;
+        BOOL            valid = YES;
+        
+        for(uint32_t i = 0; i < 10000; i++) valid = valid && [clone scanBigEndianInt32:&value] && value == index * 10000 + i;
+        
+        results[index] = valid && [clone scanLocation] == (index + 1) * 40000;
+    });
+    
+    for(NSUInteger i = 0; i < 4; i++) STAssertTrue(equal[i], @"The values scanned by each clone should be equal to the values in its region of the file.");
+    
+    STAssertEquals([scanner scanLocation], (unsigned long long)4, @"The clones should not move the scan location of the original scanner.");
+    STAssertTrueNoThrow([scanner scanBigEndianInt32:&scan1], @"The scanning after the clones should succeed and not throw an exception");
+    STAssertEquals(scan1, (uint32_t)1, @"The scanned value should follow the one scanned before cloning.");
+    STAssertEquals([scanner blockCacheMissCount], (NSUInteger)40, @"The blocks read by the clones should be in the shared cache.");
+    
+    [handle seekToFileOffset:100];
+    [[scanner scannerByCloningAtLocation:0] scanBigEndianInt32:&scan1];
+    STAssertEquals([handle offsetInFile], (unsigned long long)100, @"The clones should not move the offset of the file handle.");
+    
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
+- (void)testEnumerateRecordsInFile;
+{
+    NSString      *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"PSYEnumerateRecordsTests.bin"];
+    NSMutableData *data = [NSMutableData data];
+    
+    for(NSUInteger i = 0; i < 100000; i++)
+        [data appendData:[[NSString stringWithFormat:@"line %lu\n", (unsigned long)i] dataUsingEncoding:NSUTF8StringEncoding]];
+    
+    [data appendData:[@"last line" dataUsingEncoding:NSUTF8StringEncoding]];
+    [data writeToFile:path atomically:NO];
+    
+    NSFileHandle   *handle  = [NSFileHandle fileHandleForReadingAtPath:path];
+    PSYDataScanner *scanner = [PSYDataScanner scannerWithFileHandle:handle];
+    
+    // The first line is skipped
+    [scanner setScanLocation:7];
+    
+    __block NSUInteger count = 0;
+    __block BOOL       equal = YES;
+    __block BOOL       last  = NO;
+    
+    [scanner enumerateRecordsSeparatedByData:[NSData dataWithBytes:"\n" length:1] options:PSYDataScannerEnumerationConcurrent | PSYDataScannerEnumerationPreservingOrder usingBlock:^(NSData *record, unsigned long long location, BOOL *stop) {
+        NSString *line = [[NSString alloc] initWithData:record encoding:NSUTF8StringEncoding];
+        
+        equal = equal && (count == 99999 || [line isEqualToString:[NSString stringWithFormat:@"line %lu", (unsigned long)count + 1]]);
+        count++;
+        if(count == 100000) last = [record isEqualToData:[@"last line" dataUsingEncoding:NSUTF8StringEncoding]];
+        
+#if !__has_feature(objc_arc)
+        [line release];
+#endif
+    }];
+    
+    STAssertEquals(count, (NSUInteger)100000, @"All the lines after the scan location should be enumerated.");
+    STAssertTrue(equal, @"The lines should be enumerated in order.");
+    STAssertTrue(last, @"The line without a separator at the end should be enumerated.");
+    STAssertEquals([scanner scanLocation], (unsigned long long)7, @"The scan location should not have changed.");
+    
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
+- (void)testScanMappedFile;
+{
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"PSYMappedFileScannerTests.bin"];
+    NSData   *data = [NSData dataWithBytes:testData length:sizeof(testData)];
+    [data writeToFile:path atomically:NO];
+
+    PSYDataScanner *scanner = [PSYDataScanner scannerWithContentsOfMappedFile:path];
+    STAssertNotNil(scanner, @"Mapping an existing file should return a scanner.");
+    STAssertEquals([scanner dataLength], (unsigned long long)sizeof(testData), @"The length of the scanner should be the length of the file.");
+
+    uint32_t scan1 = 0;
+    STAssertTrueNoThrow([scanner scanBigEndianInt32:&scan1], @"The scanning of big endian uint32_t should succeed and not throw an exception");
+    STAssertEquals(scan1, (uint32_t)0x11002233, @"The scanned value should be equal to the first 4 bytes in the data.");
+
+    [scanner setScanLocation:21];
+    NSString *scan2 = nil;
+    STAssertTrueNoThrow([scanner scanNullTerminatedString:&scan2 withEncoding:NSUTF8StringEncoding], @"The scanning of null-terminated string should succeed and not throw an exception");
+    STAssertEqualObjects(scan2, @"this is a sentence in the middle", @"The scanned value should be equal to the next bytes until the null terminator.");
+
+    NSData *scan3 = nil;
+    STAssertTrueNoThrow([scanner scanData:&scan3 ofLength:4], @"The scanning of data of length should succeed and not throw an exception");
+    STAssertEqualObjects(scan3, [data subdataWithRange:NSMakeRange(54, 4)], @"The scanned data should be equal to the bytes in the file.");
+    STAssertTrue([scan3 bytes] == (const uint8_t *)[[scanner data] bytes] + 54, @"The scanned data should point into the mapping.");
+
+    STAssertNil([PSYDataScanner scannerWithContentsOfMappedFile:[path stringByAppendingString:@".missing"]], @"Mapping a missing file should return nil.");
+
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
+- (void)testScanPipe;
+{
+    NSPipe         *pipe    = [NSPipe pipe];
+    NSFileHandle   *input   = [pipe fileHandleForWriting];
+    PSYDataScanner *scanner = [PSYDataScanner scannerWithStreamFileHandle:[pipe fileHandleForReading] bufferCapacity:1];
+    
+    uint32_t scan1 = 0;
+    STAssertFalseNoThrow([scanner scanBigEndianInt32:&scan1], @"The scanning of an empty pipe should fail and not block.");
+    STAssertTrue([scanner needsMoreData], @"The scanner should ask for more data while the pipe is open.");
+    
+    [input writeData:[NSData dataWithBytes:testData length:2]];
+    STAssertEquals([scanner readAvailableData], (NSInteger)2, @"The bytes written to the pipe should have been read.");
+    STAssertFalseNoThrow([scanner scanBigEndianInt32:&scan1], @"The scanning of a partial value should fail.");
+    STAssertTrue([scanner needsMoreData], @"The scanner should ask for more data while the pipe is open.");
+    STAssertEquals([scanner scanLocation], (unsigned long long)0, @"The scan location should not have changed.");
+    
+    [input writeData:[NSData dataWithBytes:testData + 2 length:sizeof(testData) - 2]];
+    [scanner readAvailableData];
+    STAssertTrueNoThrow([scanner scanBigEndianInt32:&scan1], @"The scanning of big endian uint32_t should succeed once the data arrived.");
+    STAssertEquals(scan1, (uint32_t)0x11002233, @"The scanned value should be equal to the first 4 bytes in the data.");
+    
+    NSString *scan2 = nil;
+    [scanner setScanLocation:21];
+    STAssertTrueNoThrow([scanner scanNullTerminatedString:&scan2 withEncoding:NSUTF8StringEncoding], @"The scanning of null-terminated string should succeed and not throw an exception");
+    STAssertEqualObjects(scan2, @"this is a sentence in the middle", @"The scanned value should be equal to the next bytes until the null terminator.");
+    
+    // The buffer holds a single page, the values wrap around its end
+    NSUInteger     count  = (NSUInteger)getpagesize() / sizeof(uint32_t);
+    NSMutableData *values = [NSMutableData data];
+    for(uint32_t i = 0; i < count; i++) [values appendBigEndianInt32:i];
+    
+    [scanner setScanLocation:sizeof(testData)];
+    [input writeData:values];
+    [scanner readAvailableData];
+    STAssertTrueNoThrow([scanner scanData:NULL ofLength:count * 2], @"The scanning of data of length should succeed and not throw an exception");
+    
+    [input writeData:values];
+    [scanner readAvailableData];
+    
+    // Only the part of the values that fits in the buffer could be read
+    NSMutableData *scanned = [NSMutableData dataWithLength:count * sizeof(uint32_t)];
+    uint32_t      *scan3   = [scanned mutableBytes];
+    STAssertFalseNoThrow([scanner scanBigEndianInt32Array:scan3 count:count + count / 2], @"The scanning of more values than the buffer holds should fail.");
+    STAssertFalse([scanner needsMoreData], @"The scanner should not ask for more data than its buffer can hold.");
+    STAssertTrueNoThrow([scanner scanBigEndianInt32Array:scan3 count:count], @"The scanning of an array across the end of the buffer should succeed.");
+    STAssertEquals(scan3[0], (uint32_t)(count / 2), @"The scanned values should be equal to the values written to the pipe.");
+    STAssertEquals(scan3[count - 1], (uint32_t)(count / 2 - 1), @"The scanned values should be equal to the values written to the pipe.");
+    
+    [input closeFile];
+    [scanner readAvailableData];
+    STAssertTrueNoThrow([scanner scanBigEndianInt32Array:scan3 count:count / 2], @"The scanning of the rest of the values should succeed.");
+    STAssertEquals(scan3[count / 2 - 1], (uint32_t)(count - 1), @"The scanned values should be equal to the values written to the pipe.");
+    STAssertFalse([scanner needsMoreData], @"The scanner should not ask for more data once the pipe is closed.");
+    STAssertTrue([scanner isAtEnd], @"The scanner should be at end once the pipe is closed and everything was scanned.");
+}
+
+- (void)testScanCompressedPipe;
+{
+    NSPipe               *pipe       = [NSPipe pipe];
+    PSYStreamWriter      *writer     = [PSYStreamWriter writerWithFileDescriptor:[[pipe fileHandleForWriting] fileDescriptor] closeOnDealloc:NO];
+    PSYStreamWriter      *compressor = [PSYStreamWriter writerWithStreamWriter:writer compressionFormat:PSYCompressionFormatGzip level:PSYCompressionDefaultLevel];
+    PSYDataScanner       *scanner    = [PSYDataScanner scannerWithCompressedFileHandle:[pipe fileHandleForReading] format:PSYCompressionFormatGzip bufferCapacity:1];
+    dispatch_semaphore_t  written    = dispatch_semaphore_create(0);
+    
+    // The group is flushed when it ends, its values can be inflated before the compressed stream is finished
+    [compressor groupWrites:^(PSYStreamWriter *group) {
+        for(uint32_t i = 0; i < 1000; i++) [group writeBigEndianInt32:i];
+    } completion:^{
+        dispatch_semaphore_signal(written);
+    }];
+    STAssertEquals(dispatch_semaphore_wait(written, dispatch_time(DISPATCH_TIME_NOW, 5 * NSEC_PER_SEC)), 0L, @"The compressed group should have been written to the pipe.");
+    
+    uint32_t values[1000];
+    [scanner readAvailableData];
+    STAssertTrueNoThrow([scanner scanBigEndianInt32Array:values count:1000], @"The values of the group should have been inflated.");
+    STAssertEquals(values[999], (uint32_t)999, @"The scanned values should be equal to the values written to the compressor.");
+    
+    // An empty group of the writer completes once the end of the compressed stream has been written
+    [compressor writeNullTerminatedString:@"end" usingEncoding:NSUTF8StringEncoding];
+    [compressor finishCompression];
+    [writer groupWrites:^(PSYStreamWriter *group) {} completion:^{
+        dispatch_semaphore_signal(written);
+    }];
+    STAssertEquals(dispatch_semaphore_wait(written, dispatch_time(DISPATCH_TIME_NOW, 5 * NSEC_PER_SEC)), 0L, @"The end of the compressed stream should have been written to the pipe.");
+    
+    [[pipe fileHandleForWriting] closeFile];
+    [scanner readAvailableData];
+    
+    NSString *string = nil;
+    STAssertTrueNoThrow([scanner scanNullTerminatedString:&string withEncoding:NSUTF8StringEncoding], @"The string written after the group should have been inflated.");
+    STAssertEqualObjects(string, @"end", @"The scanned string should be equal to the string written to the compressor.");
+    
+    [scanner readAvailableData];
+    STAssertTrue([scanner isAtEnd], @"The scanner should be at end once the compressed stream ended.");
+    
+#if !__has_feature(objc_arc)
+    dispatch_release(written);
+#endif
+}
+
+- (void)testFileHandleWriter;
+{
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"PSYFileHandleWriterTests.bin"];
+    [[NSFileManager defaultManager] createFileAtPath:path contents:nil attributes:nil];
+    
+    NSFileHandle         *handle  = [NSFileHandle fileHandleForWritingAtPath:path];
+    PSYStreamWriter      *writer  = [PSYStreamWriter writerWithFileHandle:handle bufferSize:4096 preallocationLength:0 flushesInBackground:YES];
+    NSMutableData        *blob    = [NSMutableData data];
+    dispatch_semaphore_t  written = dispatch_semaphore_create(0);
+    
+    for(uint32_t i = 0; i < 50000; i++) [blob appendBigEndianInt32:i];
+    
+    // The count is written once the values are, the header is long gone from the buffers by then
+    [writer writeBigEndianInt32:0];
+    [writer groupWrites:^(PSYStreamWriter *group) {
+        for(uint32_t i = 0; i < 1000; i++) [group writeLittleEndianVarint32:i];
+        [group writeData:blob];
+        [group writeNullTerminatedString:@"end" usingEncoding:NSUTF8StringEncoding];
+    } completion:^{
+        dispatch_semaphore_signal(written);
+    }];
+    
+    unsigned long long length = [writer writeOffset];
+    [writer replaceBigEndianInt32AtOffset:0 withValue:50000];
+    [writer replaceInt8AtOffset:length - 4 withValue:'E'];
+    STAssertThrows([writer replaceBigEndianInt32AtOffset:length - 2 withValue:0], @"Bytes past the write offset can't be replaced.");
+    
+    [writer flushWrites];
+    STAssertEquals(dispatch_semaphore_wait(written, dispatch_time(DISPATCH_TIME_NOW, 5 * NSEC_PER_SEC)), 0L, @"The group should have completed once flushed.");
+    
+    NSData *data = [NSData dataWithContentsOfFile:path];
+    STAssertEquals((unsigned long long)[data length], length, @"The file should have every byte written and no preallocated bytes.");
+    
+    PSYDataScanner *scanner = [PSYDataScanner scannerWithData:data];
+    uint32_t        count   = 0;
+    uint32_t        varint  = 0;
+    NSData         *values  = nil;
+    NSString       *string  = nil;
+    
+    [scanner scanBigEndianInt32:&count];
+    STAssertEquals(count, (uint32_t)50000, @"The header should have been replaced in the file.");
+    
+    for(uint32_t i = 0; i < 1000; i++) [scanner scanLittleEndianVarint32:&varint];
+    STAssertEquals(varint, (uint32_t)999, @"The buffered writes should have been written in order.");
+    
+    [scanner scanData:&values ofLength:[blob length]];
+    STAssertEqualObjects(values, blob, @"The large data should have been written between the buffered writes.");
+    STAssertTrue([scanner scanNullTerminatedString:&string withEncoding:NSUTF8StringEncoding], @"The string should have been scanned.");
+    STAssertEqualObjects(string, @"End", @"The string should have been replaced while still buffered.");
+    
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+    
+#if !__has_feature(objc_arc)
+    dispatch_release(written);
+#endif
+}
+
 @end
 
 @implementation PSYDataFileHandle